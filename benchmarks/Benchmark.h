@@ -0,0 +1,100 @@
+#ifndef NETWORK_MONITOR_BENCHMARKS_BENCHMARK_H
+#define NETWORK_MONITOR_BENCHMARKS_BENCHMARK_H
+
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+namespace NetworkMonitor {
+
+/*! \brief Result of a benchmark run.
+ */
+struct BenchmarkResult {
+    std::string name {};
+    size_t nIterations {0};
+    size_t nBytes {0};
+    std::chrono::nanoseconds elapsed {0};
+};
+
+/*! \brief Prevent the compiler from optimizing away a computed value.
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink {nullptr};
+    sink = &value;
+#endif
+}
+
+/*! \brief Run a function repeatedly and measure its throughput.
+ *
+ *  The function is called in batches until the total run time exceeds
+ *  `minDuration`.
+ *
+ *  \param name                 The benchmark name, used in the report.
+ *  \param bytesPerIteration    The number of bytes processed by each call to
+ *                              `function`. Used to compute the throughput.
+ *  \param function             The function to benchmark.
+ *  \param minDuration          The minimum benchmark duration.
+ */
+template <typename Function>
+BenchmarkResult RunBenchmark(
+    const std::string& name,
+    const size_t bytesPerIteration,
+    Function&& function,
+    const std::chrono::milliseconds minDuration = std::chrono::milliseconds(200)
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up caches and allocators.
+    for (size_t idx {0}; idx < 16; ++idx) {
+        function();
+    }
+
+    size_t nIterations {0};
+    size_t batchSize {16};
+    auto start {Clock::now()};
+    auto elapsed {Clock::duration::zero()};
+    while (elapsed < minDuration) {
+        for (size_t idx {0}; idx < batchSize; ++idx) {
+            function();
+        }
+        nIterations += batchSize;
+        batchSize *= 2;
+        elapsed = Clock::now() - start;
+    }
+    return {
+        name,
+        nIterations,
+        nIterations * bytesPerIteration,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed),
+    };
+}
+
+/*! \brief Print a benchmark result as a single table row.
+ */
+inline std::ostream& operator<<(
+    std::ostream& os,
+    const BenchmarkResult& result
+)
+{
+    const double nsPerIteration {
+        static_cast<double>(result.elapsed.count()) / result.nIterations
+    };
+    const double mbPerSecond {
+        static_cast<double>(result.nBytes) / result.elapsed.count() * 1e3
+    };
+    return os << std::left << std::setw(48) << result.name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << nsPerIteration << " ns/op"
+              << std::setw(12) << mbPerSecond << " MB/s";
+}
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_BENCHMARKS_BENCHMARK_H
@@ -0,0 +1,272 @@
+#include <network-monitor/NetworkMonitor.h>
+#include <network-monitor/StompClient.h>
+#include <network-monitor/StompFrame.h>
+#include <network-monitor/WebsocketClient.h>
+#include <network-monitor/WebsocketServer.h>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using NetworkMonitor::BoostWebsocketClient;
+using NetworkMonitor::BoostWebsocketServer;
+using NetworkMonitor::NetworkMonitorConfig;
+using NetworkMonitor::NetworkMonitorError;
+using NetworkMonitor::StompClient;
+using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompFrameBuilder;
+using NetworkMonitor::StompHeader;
+
+// Stand-in for the network events server. It accepts the STOMP connection and
+// the subscription, then stays silent, so that the benchmark only measures the
+// quiet-route service.
+class IdleNetworkEventsClient {
+public:
+    IdleNetworkEventsClient(
+        const std::string& url,
+        const std::string& endpoint,
+        const std::string& port,
+        boost::asio::io_context& ioc,
+        boost::asio::ssl::context& ctx
+    ) : context_ {boost::asio::make_strand(ioc)}
+    {
+    }
+
+    void Connect(
+        std::function<void (boost::system::error_code)> onConnect = nullptr,
+        std::function<void (boost::system::error_code,
+                            std::string&&)> onMessage = nullptr,
+        std::function<void (boost::system::error_code)> onDisconnect = nullptr
+    )
+    {
+        onMessage_ = onMessage;
+        boost::asio::post(context_, [onConnect]() {
+            if (onConnect) {
+                onConnect({});
+            }
+        });
+    }
+
+    void Send(
+        const std::string& message,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
+    {
+        boost::asio::post(context_, [this, message, onSend]() {
+            if (onSend) {
+                onSend({});
+            }
+            Respond(message);
+        });
+    }
+
+    void Close(
+        std::function<void (boost::system::error_code)> onClose = nullptr
+    )
+    {
+        boost::asio::post(context_, [onClose]() {
+            if (onClose) {
+                onClose({});
+            }
+        });
+    }
+
+    void PauseReading()
+    {
+    }
+
+    void ResumeReading()
+    {
+    }
+
+    void Abort()
+    {
+    }
+
+    void SetCompression(
+        const NetworkMonitor::WebsocketCompressionOptions& options
+    )
+    {
+    }
+
+private:
+    boost::asio::strand<boost::asio::io_context::executor_type> context_;
+    std::function<void (boost::system::error_code,
+                        std::string&&)> onMessage_ {nullptr};
+
+    void Respond(
+        const std::string& message
+    )
+    {
+        StompError error {};
+        StompFrame frame {error, message};
+        if (error != StompError::kOk || !onMessage_) {
+            return;
+        }
+        std::string response {};
+        switch (frame.GetCommand()) {
+            case StompCommand::kConnect:
+            case StompCommand::kStomp: {
+                response = StompFrameBuilder {StompCommand::kConnected}
+                    .AddHeader(StompHeader::kVersion, "1.2")
+                    .Build(error);
+                break;
+            }
+            case StompCommand::kSubscribe: {
+                response = StompFrameBuilder {StompCommand::kReceipt}
+                    .AddHeader(
+                        StompHeader::kReceiptId,
+                        std::string(frame.GetHeaderValue(StompHeader::kReceipt))
+                    )
+                    .Build(error);
+                break;
+            }
+            default: {
+                return;
+            }
+        }
+        onMessage_({}, std::move(response));
+    }
+};
+
+// Serve quiet-route requests from many concurrent clients for a fixed time.
+// Each client sends its next request as soon as it gets the previous response.
+//
+// Returns the number of responses per second.
+static double RunQuietRouteClients(
+    const size_t nMonitorThreads,
+    const size_t nClients,
+    const size_t nClientThreads,
+    const std::chrono::seconds duration
+)
+{
+    NetworkMonitorConfig config {};
+    config.networkEventsUrl = "127.0.0.1";
+    config.networkEventsUsername = "username";
+    config.networkEventsPassword = "password";
+    config.caCertFile = TESTS_CACERT_PEM;
+    config.networkLayoutFile = TESTS_NETWORK_LAYOUT_JSON;
+    config.quietRouteHostname = "127.0.0.1";
+    config.nThreads = nMonitorThreads;
+    NetworkMonitor::NetworkMonitor<
+        IdleNetworkEventsClient,
+        BoostWebsocketServer
+    > monitor {};
+    if (monitor.Configure(config) != NetworkMonitorError::kOk) {
+        throw std::runtime_error("Could not configure the network monitor");
+    }
+    std::thread monitorThread {[&monitor]() {
+        monitor.Run();
+    }};
+
+    // The clients run on their own I/O context.
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    const std::string request {nlohmann::json {
+        {"start_station_id", "station_211"},
+        {"end_station_id", "station_119"},
+    }.dump()};
+    std::atomic<size_t> nResponses {0};
+    std::atomic<bool> measuring {false};
+    std::vector<std::unique_ptr<StompClient<BoostWebsocketClient>>> clients {};
+    for (size_t idx {0}; idx < nClients; ++idx) {
+        clients.push_back(std::make_unique<StompClient<BoostWebsocketClient>>(
+            "127.0.0.1",
+            "/quiet-route",
+            std::to_string(config.quietRoutePort),
+            ioc,
+            ctx
+        ));
+        auto& client {*clients.back()};
+        client.Connect(
+            "username",
+            "password",
+            [&client, &request](auto ec) {
+                if (ec == StompClientError::kOk) {
+                    client.Send("/quiet-route", request);
+                }
+            },
+            [&client, &request, &nResponses, &measuring](auto ec, auto dst,
+                                                         auto&& msg) {
+                if (measuring) {
+                    ++nResponses;
+                }
+                client.Send("/quiet-route", request);
+            }
+        );
+    }
+
+    // We give the clients time to connect before we start counting.
+    std::vector<std::thread> threads {};
+    for (size_t idx {0}; idx < nClientThreads; ++idx) {
+        threads.emplace_back([&ioc, duration]() {
+            ioc.run_for(duration + std::chrono::seconds {1});
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds {1});
+    measuring = true;
+    std::this_thread::sleep_for(duration);
+    measuring = false;
+    const auto nMeasured {nResponses.load()};
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    monitor.Stop();
+    monitorThread.join();
+    return static_cast<double>(nMeasured) / duration.count();
+}
+
+// Measure how the quiet-route throughput scales with the number of threads of
+// the network monitor I/O context.
+//
+// Each quiet-route request computes up to 20 paths on the full network, which
+// takes much longer than the network round trip. One client thread is enough
+// to keep all the monitor threads busy.
+int main()
+{
+    spdlog::set_level(spdlog::level::warn);
+    const size_t nCores {std::max(std::thread::hardware_concurrency(), 1u)};
+    const size_t nClients {32};
+    const size_t nClientThreads {1};
+    const std::chrono::seconds duration {10};
+    std::cout << "Quiet-route throughput, " << nClients << " clients, "
+              << nCores << " cores" << std::endl;
+    double baseline {0.0};
+    for (size_t nThreads {1}; nThreads <= nCores; nThreads *= 2) {
+        const auto throughput {RunQuietRouteClients(
+            nThreads,
+            nClients,
+            nClientThreads,
+            duration
+        )};
+        if (baseline == 0.0) {
+            baseline = throughput;
+        }
+        std::cout << std::left << std::setw(12)
+                  << (std::to_string(nThreads) + " thread(s)") << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << throughput << " req/s"
+                  << std::setw(8) << throughput / baseline << "x"
+                  << std::endl;
+    }
+    return 0;
+}
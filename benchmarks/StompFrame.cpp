@@ -0,0 +1,217 @@
+#include "Benchmark.h"
+
+#include <network-monitor/StompFrame.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using NetworkMonitor::DoNotOptimize;
+using NetworkMonitor::RunBenchmark;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompFrameBuilder;
+using NetworkMonitor::StompFrameParser;
+using NetworkMonitor::StompHeader;
+
+// A frame shape: the command, its headers and the size of its body.
+struct FrameShape {
+    std::string name {};
+    StompCommand command {StompCommand::kInvalid};
+    std::vector<std::pair<StompHeader, std::string>> headers {};
+    size_t bodySize {0};
+    bool withContentLength {false};
+};
+
+// A JSON-like body, like the passenger events and quiet-route responses.
+static std::string MakeBody(const size_t bodySize)
+{
+    std::string body {};
+    body.reserve(bodySize);
+    while (body.size() < bodySize) {
+        body += "{\"station_id\":\"station_211\",\"passenger_count\":42},";
+    }
+    body.resize(bodySize);
+    return body;
+}
+
+static std::vector<FrameShape> MakeShapes()
+{
+    std::vector<FrameShape> shapes {
+        {
+            "DISCONNECT",
+            StompCommand::kDisconnect,
+            {{StompHeader::kReceipt, "rcpt-0001"}},
+        },
+        {
+            "SUBSCRIBE",
+            StompCommand::kSubscribe,
+            {
+                {StompHeader::kDestination, "/passengers"},
+                {StompHeader::kId, "sub-0001"},
+                {StompHeader::kAck, "auto"},
+                {StompHeader::kReceipt, "rcpt-0001"},
+            },
+        },
+        {
+            "MESSAGE, all headers",
+            StompCommand::kMessage,
+            {
+                {StompHeader::kDestination, "/passengers"},
+                {StompHeader::kMessageId, "msg-00000000000042"},
+                {StompHeader::kSubscription, "sub-0001"},
+                {StompHeader::kAck, "ack-0001"},
+                {StompHeader::kContentType, "application/json"},
+                {StompHeader::kReceipt, "rcpt-0001"},
+                {StompHeader::kTransaction, "tx-0001"},
+                {StompHeader::kSession, "session-0001"},
+                {StompHeader::kServer, "network-monitor/1.0"},
+                {StompHeader::kId, "id-0001"},
+            },
+            100,
+            true,
+        },
+        {
+            "MESSAGE, escaped destination",
+            StompCommand::kMessage,
+            {
+                {StompHeader::kDestination,
+                 "/quiet-route/station:211/station:042"},
+                {StompHeader::kMessageId, "msg-00000000000042"},
+                {StompHeader::kSubscription, "sub-0001"},
+                {StompHeader::kContentType, "application/json"},
+            },
+            100,
+            true,
+        },
+    };
+    for (const auto command: {StompCommand::kMessage, StompCommand::kSend}) {
+        for (const size_t bodySize: {100, 1024, 16 * 1024, 64 * 1024}) {
+            for (const bool withContentLength: {true, false}) {
+                FrameShape shape {
+                    ToString(command) + " " + std::to_string(bodySize) +
+                        " B body" +
+                        (withContentLength ? ", content-length" : ""),
+                    command,
+                    {},
+                    bodySize,
+                    withContentLength,
+                };
+                if (command == StompCommand::kMessage) {
+                    shape.headers = {
+                        {StompHeader::kSubscription, "sub-0001"},
+                        {StompHeader::kMessageId, "msg-00000000000042"},
+                    };
+                } else {
+                    shape.headers = {
+                        {StompHeader::kReceipt, "rcpt-0001"},
+                    };
+                }
+                shape.headers.emplace_back(StompHeader::kDestination,
+                                           "/passengers");
+                shape.headers.emplace_back(StompHeader::kContentType,
+                                           "application/json");
+                shapes.push_back(std::move(shape));
+            }
+        }
+    }
+    return shapes;
+}
+
+// Build a frame from its shape. The builder only keeps views, so the body
+// and the content-length value must outlive it.
+static StompError WriteFrame(
+    const FrameShape& shape,
+    const std::string& body,
+    const std::string& contentLength,
+    std::string& buffer
+)
+{
+    StompFrameBuilder builder {shape.command};
+    for (const auto& [header, value]: shape.headers) {
+        builder.AddHeader(header, value);
+    }
+    if (shape.withContentLength) {
+        builder.AddHeader(StompHeader::kContentLength, contentLength);
+    }
+    builder.SetBody(body);
+    return builder.WriteTo(buffer);
+}
+
+// Measure the StompFrame codec on each frame shape:
+// - parse: From a shared buffer, as when a frame is passed around.
+// - parse (string copy): From a copy of the plain-text frame, as when a
+//   Websocket message arrives.
+// - stream parse: Ten frames batched in one chunk, through StompFrameParser.
+// - build: With StompFrameBuilder, into a reused buffer.
+// - build (components): With the StompFrame components constructor.
+int main()
+{
+    for (const auto& shape: MakeShapes()) {
+        const auto body {MakeBody(shape.bodySize)};
+        const auto contentLength {std::to_string(body.size())};
+        std::string plainString {};
+        auto error {WriteFrame(shape, body, contentLength, plainString)};
+        if (error != StompError::kOk) {
+            std::cerr << shape.name << ": Could not build frame: " << error
+                      << std::endl;
+            return 1;
+        }
+        const auto plain {
+            std::make_shared<const std::string>(std::move(plainString))
+        };
+        const auto size {plain->size()};
+        std::cout << shape.name << " (" << size << " bytes)" << std::endl;
+
+        std::cout << RunBenchmark("  parse", size, [&]() {
+            StompError error {};
+            StompFrame frame {error, plain};
+            DoNotOptimize(frame);
+        }) << std::endl;
+
+        std::cout << RunBenchmark("  parse (string copy)", size, [&]() {
+            StompError error {};
+            StompFrame frame {error, std::string {*plain}};
+            DoNotOptimize(frame);
+        }) << std::endl;
+
+        std::string stream {};
+        for (size_t idx {0}; idx < 10; ++idx) {
+            stream += *plain;
+            stream += '\n';
+        }
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        std::cout << RunBenchmark("  stream parse (10 frames)", stream.size(),
+                                  [&]() {
+            frames.clear();
+            parser.Parse(stream, frames);
+            DoNotOptimize(frames);
+        }) << std::endl;
+
+        std::string buffer {};
+        std::cout << RunBenchmark("  build", size, [&]() {
+            buffer.clear();
+            WriteFrame(shape, body, contentLength, buffer);
+            DoNotOptimize(buffer);
+        }) << std::endl;
+
+        std::unordered_map<StompHeader, std::string> headers {
+            shape.headers.begin(),
+            shape.headers.end()
+        };
+        if (shape.withContentLength) {
+            headers[StompHeader::kContentLength] = contentLength;
+        }
+        std::cout << RunBenchmark("  build (components)", size, [&]() {
+            StompError error {};
+            StompFrame frame {error, shape.command, headers, body};
+            DoNotOptimize(frame);
+        }) << std::endl;
+    }
+    return 0;
+}
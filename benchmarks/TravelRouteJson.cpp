@@ -0,0 +1,81 @@
+#include "Benchmark.h"
+
+#include <network-monitor/FileDownloader.h>
+#include <network-monitor/StompFrame.h>
+#include <network-monitor/TransportNetwork.h>
+
+#include <nlohmann/json.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+using NetworkMonitor::DoNotOptimize;
+using NetworkMonitor::GetJsonSize;
+using NetworkMonitor::ParseJsonFile;
+using NetworkMonitor::RunBenchmark;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompHeader;
+using NetworkMonitor::TravelRoute;
+using NetworkMonitor::WriteJson;
+
+// Compare the nlohmann::json serialization of a TravelRoute with the direct
+// writer, on the travel routes of the LTC test fixtures.
+int main()
+{
+    for (const auto& filename: {
+        "ltc_path1.result.json",
+        "ltc_path2.result.json",
+        "ltc_quiet1.result.route_000.json",
+        "ltc_quiet1.result.route_032.json",
+        "ltc_quiet2.result.route_049.json",
+        "ltc_quiet2.result.route_053.json",
+    }) {
+        auto travelRoute {ParseJsonFile(
+            std::filesystem::path(TEST_DATA) / filename
+        ).get<TravelRoute>()};
+        const auto size {GetJsonSize(travelRoute)};
+        std::cout << filename << " (" << travelRoute.steps.size()
+                  << " steps, " << size << " bytes)" << std::endl;
+
+        // JSON object, then dump.
+        std::cout << RunBenchmark("  nlohmann::json dump", size, [&]() {
+            nlohmann::json travelRouteJson = travelRoute;
+            auto plain {travelRouteJson.dump()};
+            DoNotOptimize(plain);
+        }) << std::endl;
+
+        // JSON object, dump, then copy into a SEND frame. This is what the
+        // quiet-route service used to do for each response.
+        std::cout << RunBenchmark("  nlohmann::json dump + StompFrame", size,
+                                  [&]() {
+            nlohmann::json travelRouteJson = travelRoute;
+            auto plain {travelRouteJson.dump()};
+            StompError error {};
+            StompFrame frame {
+                error,
+                StompCommand::kSend,
+                {
+                    {StompHeader::kId, "request_id"},
+                    {StompHeader::kDestination, "/quiet-route"},
+                    {StompHeader::kContentType, "application/json"},
+                    {StompHeader::kContentLength, std::to_string(plain.size())},
+                },
+                plain,
+            };
+            DoNotOptimize(frame);
+        }) << std::endl;
+
+        // Direct writer into a reused buffer.
+        std::string buffer {};
+        std::cout << RunBenchmark("  WriteJson (reused buffer)", size, [&]() {
+            buffer.clear();
+            buffer.reserve(GetJsonSize(travelRoute));
+            WriteJson(buffer, travelRoute);
+            DoNotOptimize(buffer);
+        }) << std::endl;
+    }
+    return 0;
+}
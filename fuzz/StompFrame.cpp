@@ -0,0 +1,141 @@
+#include <network-monitor/StompFrame.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using NetworkMonitor::kStompHeaderCount;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompFrameBuilder;
+using NetworkMonitor::StompFrameParser;
+using NetworkMonitor::StompHeader;
+
+// Abort on a broken invariant, so that the fuzzer records the input.
+#define FUZZ_CHECK(condition)                                                  \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            std::fprintf(stderr, "%s:%d: Check failed: %s\n",                  \
+                         __FILE__, __LINE__, #condition);                      \
+            std::abort();                                                      \
+        }                                                                      \
+    } while (false)
+
+// Check that two frames have the same command, headers and body.
+static void CheckSameFrame(const StompFrame& a, const StompFrame& b)
+{
+    FUZZ_CHECK(a.GetCommand() == b.GetCommand());
+    for (size_t idx {0}; idx < kStompHeaderCount; ++idx) {
+        const auto header {static_cast<StompHeader>(idx)};
+        FUZZ_CHECK(a.HasHeader(header) == b.HasHeader(header));
+        FUZZ_CHECK(a.GetHeaderValue(header) == b.GetHeaderValue(header));
+    }
+    FUZZ_CHECK(a.GetBody() == b.GetBody());
+}
+
+// Check that a view points inside a buffer.
+static bool IsViewInto(
+    const std::string_view view,
+    const std::string& buffer
+)
+{
+    return view.empty() || (
+        view.data() >= buffer.data() &&
+        view.data() + view.size() <= buffer.data() + buffer.size()
+    );
+}
+
+// Invariants for a valid frame:
+// - ToString() returns the input, unchanged.
+// - The body is a view into the frame buffer.
+// - Parsing ToString() gives the same frame.
+// - Writing the frame components with StompFrameBuilder, then parsing the
+//   result, gives the same frame.
+static void CheckValidFrame(const StompFrame& frame, const std::string& input)
+{
+    FUZZ_CHECK(frame.ToString() == input);
+    FUZZ_CHECK(IsViewInto(frame.GetBody(), *frame.GetBuffer()));
+
+    StompError error {};
+    StompFrame reparsed {error, frame.ToString()};
+    FUZZ_CHECK(error == StompError::kOk);
+    CheckSameFrame(frame, reparsed);
+
+    StompFrameBuilder builder {frame.GetCommand()};
+    for (size_t idx {0}; idx < kStompHeaderCount; ++idx) {
+        const auto header {static_cast<StompHeader>(idx)};
+        if (frame.HasHeader(header)) {
+            builder.AddHeader(header, frame.GetHeaderValue(header));
+        }
+    }
+    builder.SetBody(frame.GetBody());
+    auto built {builder.Build(error)};
+    FUZZ_CHECK(error == StompError::kOk);
+    FUZZ_CHECK(built.size() == builder.GetSize());
+    StompFrame rebuilt {error, std::move(built)};
+    FUZZ_CHECK(error == StompError::kOk);
+    CheckSameFrame(frame, rebuilt);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    const std::string input(reinterpret_cast<const char*>(data), size);
+
+    // One frame per input
+    StompError error {};
+    StompFrame frame {error, std::string {input}};
+    if (error == StompError::kOk) {
+        CheckValidFrame(frame, input);
+    }
+
+    // The same input as a stream, split in two chunks. Every frame the stream
+    // parser extracts must be valid on its own.
+    const auto split {size == 0 ? 0 : data[0] % (size + 1)};
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    error = parser.Parse(std::string_view {input}.substr(0, split), frames);
+    if (error == StompError::kOk) {
+        error = parser.Parse(std::string_view {input}.substr(split), frames);
+    }
+    for (const auto& streamFrame: frames) {
+        CheckValidFrame(streamFrame, streamFrame.ToString());
+    }
+    if (error != StompError::kOk) {
+        FUZZ_CHECK(parser.GetBufferedSize() == 0);
+    }
+    return 0;
+}
+
+#ifdef NETWORK_MONITOR_FUZZ_REPLAY
+
+// Without libFuzzer, run the harness once on each file passed on the command
+// line. Use this to replay a corpus or a crash with any compiler.
+int main(int argc, char** argv)
+{
+    for (int idx {1}; idx < argc; ++idx) {
+        std::ifstream file {argv[idx], std::ios::binary};
+        if (!file) {
+            std::cerr << "Could not open " << argv[idx] << std::endl;
+            return 1;
+        }
+        const std::string input {
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        };
+        LLVMFuzzerTestOneInput(
+            reinterpret_cast<const uint8_t*>(input.data()),
+            input.size()
+        );
+    }
+    std::cout << "Ran " << argc - 1 << " inputs" << std::endl;
+    return 0;
+}
+
+#endif // NETWORK_MONITOR_FUZZ_REPLAY
@@ -0,0 +1,114 @@
+#ifndef NETWORK_MONITOR_FILE_WATCHER_H
+#define NETWORK_MONITOR_FILE_WATCHER_H
+
+#include <boost/asio.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+
+namespace NetworkMonitor {
+
+/*! \brief Watch a local file and get notified when its content changes.
+ *
+ *  Bursts of changes are debounced: The user callback is called once, after
+ *  the file has not changed for a full debounce interval. This way we do not
+ *  act on a file that is still being written.
+ *
+ *  The watcher observes the parent directory of the file, so it detects both
+ *  in-place writes and atomic replacements (write to a temporary file, then
+ *  rename it over the watched one).
+ *
+ *  \note File watching is only supported on Linux, through inotify. On other
+ *        platforms, `Run` always fails.
+ */
+class FileWatcher {
+public:
+    /*! \brief Construct a file watcher.
+     *
+     *  \note This constructor does not start watching the file.
+     *
+     *  \param file     The file to watch. The parent directory must exist.
+     *  \param debounce The quiet interval after the last change before the
+     *                  user is notified.
+     *  \param ioc      The io_context object. The user takes care of calling
+     *                  ioc.run().
+     */
+    FileWatcher(
+        const std::filesystem::path& file,
+        const std::chrono::milliseconds debounce,
+        boost::asio::io_context& ioc
+    );
+
+    /*! \brief Destructor.
+     */
+    ~FileWatcher();
+
+    /*! \brief The copy constructor is deleted.
+     */
+    FileWatcher(const FileWatcher& other) = delete;
+
+    /*! \brief The copy assignment operator is deleted.
+     */
+    FileWatcher& operator=(const FileWatcher& other) = delete;
+
+    /*! \brief Start watching the file.
+     *
+     *  \returns false if the file watch could not be set up.
+     *
+     *  \param onChange Called when the file changed and the changes settled.
+     *                  The handler runs in the watcher execution context.
+     */
+    bool Run(
+        std::function<void ()> onChange
+    );
+
+    /*! \brief Stop watching the file.
+     *
+     *  This method can be called from any thread. The file watch is released
+     *  on the watcher strand.
+     *
+     *  \note No user callback starts after this method returns.
+     */
+    void Stop();
+
+private:
+    std::filesystem::path file_ {};
+    std::chrono::milliseconds debounce_ {};
+
+    // This strand handles all the watcher operations.
+    // We leave it uninitialized because it does not support a default
+    // constructor.
+    boost::asio::strand<boost::asio::io_context::executor_type> context_;
+    boost::asio::steady_timer timer_;
+#ifdef __linux__
+    boost::asio::posix::stream_descriptor stream_;
+    int watchDescriptor_ {-1};
+#endif
+
+    // inotify delivers one or more variable-length events on each read. The
+    // buffer must be large enough for at least one event with a file name.
+    alignas(8) std::array<char, 4096> buffer_ {};
+
+    // Set from any thread by Stop.
+    std::atomic<bool> stopped_ {true};
+
+    std::function<void ()> onChange_ {nullptr};
+
+    void ReadEvents();
+
+    void OnRead(
+        const boost::system::error_code& ec,
+        size_t nBytes
+    );
+
+    void OnDebounceTimer(
+        const boost::system::error_code& ec
+    );
+};
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_FILE_WATCHER_H
@@ -0,0 +1,85 @@
+#ifndef NETWORK_MONITOR_ID_GENERATOR_H
+#define NETWORK_MONITOR_ID_GENERATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace NetworkMonitor {
+
+/*! \brief How an `IdGenerator` makes its IDs.
+ */
+enum class IdGeneratorMode {
+    // Random version-4 UUIDs, such as 0b2c3a4e-59f1-4d3b-8a1e-7c2d9e0f1a2b.
+    kRandomUuid,
+
+    // A per-process random prefix and a process-wide counter, such as
+    // 3f9a1c7e-000000000000002a. These are shorter and cheaper to make.
+    kCounter,
+};
+
+/*! \brief Generate unique IDs for STOMP requests, subscriptions and
+ *         connections.
+ *
+ *  The random source is seeded once, when the generator is constructed. Each
+ *  ID is then formatted into a fixed-size buffer, without going through a
+ *  stream.
+ *
+ *  \note The IDs are unique, but they are not suitable as secrets: Given a few
+ *        IDs, the next ones can be predicted.
+ *
+ *  \note All methods are thread-safe.
+ */
+class IdGenerator {
+public:
+    /*! \brief Maximum length of a generated ID.
+     */
+    static constexpr size_t kMaxIdSize {36};
+
+    /*! \brief Fixed-size buffer that holds an ID.
+     */
+    using Buffer = std::array<char, kMaxIdSize>;
+
+    /*! \brief Construct an ID generator.
+     */
+    explicit IdGenerator(
+        const IdGeneratorMode mode = IdGeneratorMode::kRandomUuid
+    );
+
+    /*! \brief The copy constructor is deleted. A copy would repeat the IDs
+     *         of the original.
+     */
+    IdGenerator(const IdGenerator& other) = delete;
+
+    /*! \brief The copy assignment operator is deleted.
+     */
+    IdGenerator& operator=(const IdGenerator& other) = delete;
+
+    /*! \brief Get the ID generator mode.
+     */
+    IdGeneratorMode GetMode() const;
+
+    /*! \brief Generate an ID into a caller buffer.
+     *
+     *  \returns A view of the ID, inside the buffer.
+     */
+    std::string_view Generate(Buffer& buffer);
+
+    /*! \brief Generate an ID.
+     */
+    std::string Generate();
+
+private:
+    IdGeneratorMode mode_ {IdGeneratorMode::kRandomUuid};
+
+    // In kRandomUuid mode, each ID is derived from the next value of this
+    // sequence. The key and the starting value are random.
+    uint64_t key_ {0};
+    std::atomic<uint64_t> sequence_ {0};
+};
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_ID_GENERATOR_H
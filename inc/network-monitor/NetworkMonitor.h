@@ -2,10 +2,14 @@
 #define NETWORK_MONITOR_NETWORK_MONITOR_H
 
 #include <network-monitor/FileDownloader.h>
+#include <network-monitor/FileWatcher.h>
+#include <network-monitor/SpscQueue.h>
 #include <network-monitor/StompClient.h>
+#include <network-monitor/StompHeartBeat.h>
 #include <network-monitor/TransportNetwork.h>
 #include <network-monitor/StompServer.h>
 #include <network-monitor/TestServerCertificate.h>
+#include <network-monitor/WebsocketCompression.h>
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
@@ -15,19 +19,100 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <deque>
 #include <filesystem>
 #include <iomanip>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace NetworkMonitor {
 
+/*! \brief What to do with a new network event when the queue to the network
+ *         update stage is full.
+ *
+ *  - kBlockReads: Stop reading from the network events server until the
+ *    update stage catches up. No event is lost.
+ *  - kDropOldest: Only keep the newest events. The update stage processes at
+ *    most one queue worth of them.
+ *  - kCoalesce: Merge the waiting events of the same station and type. No
+ *    passenger is lost, but the update stage sees fewer, larger updates.
+ */
+enum class NetworkEventsOverflow {
+    kBlockReads,
+    kDropOldest,
+    kCoalesce,
+};
+
+/*! \brief Print operator for the `NetworkEventsOverflow` class.
+ */
+std::ostream& operator<<(
+    std::ostream& os,
+    const NetworkEventsOverflow& m
+);
+
+/*! \brief Convert `NetworkEventsOverflow` to string.
+ */
+std::string ToString(
+    const NetworkEventsOverflow& m
+);
+
+/*! \brief Metrics of the queue between the network events client and the
+ *         network update stage.
+ */
+struct NetworkEventsQueueStats {
+    // Events waiting for the update stage.
+    size_t depth {0};
+    size_t maxDepth {0};
+
+    // NetworkEventsOverflow::kDropOldest
+    size_t nDropped {0};
+
+    // NetworkEventsOverflow::kCoalesce: Events merged into a waiting one.
+    size_t nCoalesced {0};
+
+    // NetworkEventsOverflow::kBlockReads
+    size_t nReadPauses {0};
+};
+
+/*! \brief Metrics of the quiet-route subscriptions.
+ */
+struct QuietRouteSubscriptionStats {
+    // Origin/destination pairs with at least one subscriber.
+    size_t nRoutes {0};
+
+    // Recomputation batches.
+    size_t nBatches {0};
+
+    // Routes recomputed, and routes published because they changed.
+    size_t nRecomputed {0};
+    size_t nPublished {0};
+};
+
+/*! \brief Metrics of the quiet-route clients and requests that were turned
+ *         away.
+ */
+struct QuietRouteAdmissionStats {
+    // Connections over the limit, and clients closed for sending too fast.
+    size_t nRejectedConnections {0};
+    size_t nRateLimitedFrames {0};
+
+    // Requests dropped because too many routes were being computed.
+    size_t nRejectedBusy {0};
+};
+
 /*! \brief Configuration structure for the Live Transport Network Monitor
  *         process.
  */
@@ -44,6 +129,23 @@ struct NetworkMonitorConfig {
     double quietRouteMaxSlowdownPc {0.1};
     double quietRouteMinQuietnessPc {0.1};
     size_t quietRouteMaxNPaths {20};
+    bool networkLayoutHotReload {false};
+    std::chrono::milliseconds networkLayoutReloadDebounce {500};
+    StompClientReconnectPolicy networkEventsReconnect {};
+    StompHeartBeat networkEventsHeartBeat {};
+    StompHeartBeat quietRouteHeartBeat {};
+    StompClientAckMode networkEventsAckMode {StompClientAckMode::kAuto};
+    StompClientAckPolicy networkEventsAck {};
+    size_t networkEventsQueueCapacity {4096};
+    NetworkEventsOverflow networkEventsOverflow {
+        NetworkEventsOverflow::kBlockReads
+    };
+    size_t nThreads {1};
+    WebsocketCompressionOptions networkEventsCompression {};
+    WebsocketCompressionOptions quietRouteCompression {};
+    std::chrono::milliseconds quietRouteSubscriptionBatchInterval {100};
+    StompServerLimits quietRouteLimits {};
+    size_t quietRouteMaxInFlightRequests {0}; // 0 = unlimited
 };
 
 /*! \brief Error codes for the Live Transport Network Monitor process.
@@ -57,6 +159,7 @@ enum class NetworkMonitorError {
     kCouldNotRecordPassengerEvent,
     kCouldNotStartStompServer,
     kCouldNotSubscribeToPassengerEvents,
+    kCouldNotWatchNetworkLayoutFile,
     kFailedNetworkLayoutFileDownload,
     kFailedNetworkLayoutFileParsing,
     kFailedTransportNetworkConstruction,
@@ -81,6 +184,22 @@ std::string ToString(
 );
 
 /*! \brief Live Transport Network Monitor
+ *
+ *  The monitor runs its I/O context on `NetworkMonitorConfig::nThreads`
+ *  threads. The quiet-route requests are served in parallel. The network
+ *  updates (passenger events and layout reloads) are serialized on their own
+ *  strand, and they wait for the quiet-route computations in progress.
+ *
+ *  Clients can request a quiet route with a SEND frame to `/quiet-route`, or
+ *  subscribe to `/quiet-route/<start_station_id>/<end_station_id>`. A
+ *  subscriber receives the current route, then a new one each time it
+ *  changes. The subscriptions are recomputed in batches, at most every
+ *  `NetworkMonitorConfig::quietRouteSubscriptionBatchInterval`, and only when
+ *  a passenger event or a layout reload may have changed their route.
+ *
+ *  A quiet-route request that comes in while
+ *  `NetworkMonitorConfig::quietRouteMaxInFlightRequests` routes are being
+ *  computed is dropped. The client stays connected and can send it again.
  *
  *  \tparam WsClient Type compatible with WebsocketClient.
  *  \tparam WsServer Type compatible with WebsocketServer.
@@ -170,6 +289,11 @@ public:
             return NetworkMonitorError::kFailedTransportNetworkConstruction;
         }
 
+        // Network events queue
+        eventsQueue_ = std::make_unique<SpscQueue<NetworkEventsUpdate>>(
+            config.networkEventsQueueCapacity
+        );
+
         // STOMP client
         spdlog::info("NetworkMonitor: Constructing the STOMP client: {}:{}{}",
                      config.networkEventsUrl, config.networkEventsPort,
@@ -182,6 +306,10 @@ public:
             ioc_,
             clientCtx_
         );
+        client_->SetReconnectPolicy(config.networkEventsReconnect);
+        client_->SetHeartBeat(config.networkEventsHeartBeat);
+        client_->SetAckPolicy(config.networkEventsAck);
+        client_->SetCompression(config.networkEventsCompression);
         client_->Connect(
             config.networkEventsUsername,
             config.networkEventsPassword,
@@ -206,6 +334,9 @@ public:
             ioc_,
             serverCtx_
         );
+        server_->SetHeartBeat(config.quietRouteHeartBeat);
+        server_->SetCompression(config.quietRouteCompression);
+        server_->SetLimits(config.quietRouteLimits);
         auto serverEc {server_->Run(
             [this](auto ec, auto id) {
                 OnQuietRouteClientConnect(ec, id);
@@ -218,6 +349,12 @@ public:
             },
             [this](auto ec) {
                 OnQuietRouteDisconnect(ec);
+            },
+            [this](auto ec, auto id, auto dest) {
+                OnQuietRouteClientSubscribe(ec, id, dest);
+            },
+            [this](auto ec, auto id, auto dest) {
+                OnQuietRouteClientUnsubscribe(ec, id, dest);
             }
         )};
         if (serverEc != StompServerError::kOk) {
@@ -225,6 +362,34 @@ public:
             return NetworkMonitorError::kCouldNotStartStompServer;
         }
 
+        // Network layout hot reload
+        // We can only watch a local file. A downloaded layout file is never
+        // updated in place.
+        if (config.networkLayoutHotReload && !config.networkLayoutFile.empty()) {
+            spdlog::info("NetworkMonitor: Watching {} for changes",
+                         config.networkLayoutFile);
+            layoutWatcher_ = std::make_unique<FileWatcher>(
+                config.networkLayoutFile,
+                config.networkLayoutReloadDebounce,
+                ioc_
+            );
+            bool watching {layoutWatcher_->Run(
+                [this, networkLayoutFile]() {
+                    boost::asio::post(
+                        networkStrand_,
+                        [this, networkLayoutFile]() {
+                            OnNetworkLayoutFileChange(networkLayoutFile);
+                        }
+                    );
+                }
+            )};
+            if (!watching) {
+                spdlog::error("NetworkMonitor: Could not watch {}",
+                              config.networkLayoutFile);
+                return NetworkMonitorError::kCouldNotWatchNetworkLayoutFile;
+            }
+        }
+
         // Note: At this stage nothing runs until someone calls the run()
         //       function on the I/O context object.
         spdlog::info("NetworkMonitor: Successfully configured");
@@ -234,18 +399,29 @@ public:
 
     /*! \brief Run the I/O context.
      *
-     *  This function runs the I/O context in the current thread.
+     *  This function runs the I/O context in the current thread, and in
+     *  `NetworkMonitorConfig::nThreads - 1` additional threads. It returns
+     *  when all threads are done.
      */
     void Run()
     {
-        spdlog::info("NetworkMonitor: Running");
+        spdlog::info("NetworkMonitor: Running on {} thread(s)",
+                     GetNThreads());
         lastErrorCode_ = NetworkMonitorError::kOk;
-        ioc_.run();
+        RunOnThreads([this]() {
+            ioc_.run();
+        });
+        LogNetworkEventsQueueStats();
+        LogQuietRouteSubscriptionStats();
+        LogQuietRouteAdmissionStats();
+        LogCompressionStats();
     }
 
     /*! \brief Run the I/O context for a maximum amount of time.
      *
-     *  This function runs the I/O context in the current thread.
+     *  This function runs the I/O context in the current thread, and in
+     *  `NetworkMonitorConfig::nThreads - 1` additional threads. It returns
+     *  when all threads are done.
      *
      *  \param runFor   A time duration after which the I/O context stops, even
      *                  if it has outstanding work to dispatch.
@@ -255,9 +431,16 @@ public:
         std::chrono::duration<DurationRep, DurationRatio> runFor
     )
     {
-        spdlog::info("NetworkMonitor: Running for {}", runFor);
+        spdlog::info("NetworkMonitor: Running for {} on {} thread(s)",
+                     runFor, GetNThreads());
         lastErrorCode_ = NetworkMonitorError::kOk;
-        ioc_.run_for(runFor);
+        RunOnThreads([this, runFor]() {
+            ioc_.run_for(runFor);
+        });
+        LogNetworkEventsQueueStats();
+        LogQuietRouteSubscriptionStats();
+        LogQuietRouteAdmissionStats();
+        LogCompressionStats();
     }
 
     /*! \brief Stop any computation.
@@ -272,6 +455,9 @@ public:
         // know what was the last error code before the network monitor was
         // stoppped.
         spdlog::info("NetworkMonitor: Stopping");
+        if (layoutWatcher_ != nullptr) {
+            layoutWatcher_->Stop();
+        }
         ioc_.stop();
     }
 
@@ -291,13 +477,65 @@ public:
      */
     TravelRoute GetLastTravelRoute() const
     {
+        std::lock_guard<std::mutex> lock {lastTravelRouteMutex_};
         return lastTravelRoute_;
     }
 
+    /*! \brief Get the metrics of the network events queue.
+     *
+     *  This function can be called from any thread.
+     */
+    NetworkEventsQueueStats GetNetworkEventsQueueStats() const
+    {
+        NetworkEventsQueueStats stats {};
+        if (eventsQueue_ != nullptr) {
+            stats.depth = eventsQueue_->Size() + eventsOverflowSize_;
+        }
+        stats.maxDepth = eventsMaxDepth_;
+        stats.nDropped = eventsDropped_;
+        stats.nCoalesced = eventsCoalesced_;
+        stats.nReadPauses = eventsReadPauses_;
+        return stats;
+    }
+
+    /*! \brief Get the metrics of the quiet-route subscriptions.
+     *
+     *  This function can be called from any thread.
+     */
+    QuietRouteSubscriptionStats GetQuietRouteSubscriptionStats() const
+    {
+        QuietRouteSubscriptionStats stats {};
+        stats.nRoutes = nRouteSubscriptions_;
+        stats.nBatches = routeBatches_;
+        stats.nRecomputed = routesRecomputed_;
+        stats.nPublished = routesPublished_;
+        return stats;
+    }
+
+    /*! \brief Get the number of quiet-route clients and requests that were
+     *         turned away.
+     *
+     *  This function can be called from any thread.
+     */
+    QuietRouteAdmissionStats GetQuietRouteAdmissionStats() const
+    {
+        QuietRouteAdmissionStats stats {};
+        if (server_ != nullptr) {
+            const auto serverStats {server_->GetAdmissionStats()};
+            stats.nRejectedConnections = serverStats.nRejectedConnections;
+            stats.nRateLimitedFrames = serverStats.nRateLimitedFrames;
+        }
+        stats.nRejectedBusy = nRejectedBusyRequests_;
+        return stats;
+    }
+
     /*! \brief Access the internal network representation.
      *
      *  \returns a reference to the internal `TransportNetwork` object instance.
      *           The object has the same lifetime as the `NetworkMonitor` class.
+     *
+     *  \note The network is updated while the monitor runs. Only use this
+     *        reference before or after Run.
      */
     const TransportNetwork& GetNetworkRepresentation() const
     {
@@ -307,25 +545,34 @@ public:
     /*! \brief Set the network representation crowding..
      *
      *  This method can be used when testing to pre-seed the network with the
-     *  desired crowding.
+     *  desired crowding. It can be called from any thread.
      */
     void SetNetworkCrowding(
         const std::unordered_map<Id, int>& passengerCounts
     )
     {
-        for (const auto& [stationId, passengerCount]: passengerCounts) {
-            auto type {passengerCount > 0 ? PassengerEvent::Type::In :
-                                            PassengerEvent::Type::Out};
-            for (size_t _ {0}; _ < std::abs(passengerCount); ++_) {
-                network_.RecordPassengerEvent({stationId, type, {}});
+        std::unordered_set<Id> stations {};
+        {
+            std::unique_lock<std::shared_mutex> lock {networkMutex_};
+            for (const auto& [stationId, passengerCount]: passengerCounts) {
+                auto type {passengerCount > 0 ? PassengerEvent::Type::In :
+                                                PassengerEvent::Type::Out};
+                for (size_t _ {0}; _ < std::abs(passengerCount); ++_) {
+                    network_.RecordPassengerEvent({stationId, type, {}});
+                }
+                stations.insert(stationId);
             }
         }
+        MarkStationsChanged(stations);
     }
 
-    /*! \brief Access the list of connected clients.
+    /*! \brief Get the list of connected clients.
+     *
+     *  This function can be called from any thread.
      */
-    const std::unordered_set<std::string>& GetConnectedClients() const
+    std::unordered_set<std::string> GetConnectedClients() const
     {
+        std::lock_guard<std::mutex> lock {connectedClientsMutex_};
         return connectedClients_;
     }
 
@@ -346,12 +593,93 @@ private:
 
     NetworkMonitorConfig config_ {};
 
+    // The quiet-route computations read the network in parallel. The network
+    // updates only run on the network strand, one at a time, and they take
+    // the lock exclusively.
     TransportNetwork network_ {};
+    mutable std::shared_mutex networkMutex_ {};
+    boost::asio::strand<boost::asio::io_context::executor_type> networkStrand_ {
+        boost::asio::make_strand(ioc_)
+    };
+
+    // Network layout hot reload
+    // The new network is built on a dedicated background thread, so that
+    // passenger events and quiet-route requests keep flowing in the meantime.
+    // The reload state only lives on the network strand.
+    // The thread pool is declared after the I/O context: It is destroyed (and
+    // joined) first, so a reload that is still running can safely post its
+    // result back to the I/O context.
+    std::unique_ptr<FileWatcher> layoutWatcher_ {nullptr};
+    std::unique_ptr<boost::asio::thread_pool> reloadPool_ {nullptr};
+    bool reloadInProgress_ {false};
+    bool reloadPending_ {false};
+
+    // Network events ingestion
+    // The STOMP client message handler is the only producer, and the network
+    // update stage is the only consumer. The events only overflow when the
+    // queue is full: The overflow is shared by both sides, behind a mutex.
+    struct NetworkEventsUpdate {
+        PassengerEvent event {};
+        size_t count {1};
+    };
+    std::unique_ptr<SpscQueue<NetworkEventsUpdate>> eventsQueue_ {nullptr};
+    std::atomic<bool> eventsDrainScheduled_ {false};
+    std::atomic<bool> eventsOverflowing_ {false};
+    std::mutex eventsOverflowMutex_ {};
+    std::deque<NetworkEventsUpdate> eventsOverflow_ {};
+    std::unordered_map<std::string, size_t> eventsCoalesceIndex_ {};
+    bool eventsReadsPaused_ {false};
+    std::atomic<size_t> eventsOverflowSize_ {0};
+    std::atomic<size_t> eventsMaxDepth_ {0};
+    std::atomic<size_t> eventsDropped_ {0};
+    std::atomic<size_t> eventsCoalesced_ {0};
+    std::atomic<size_t> eventsReadPauses_ {0};
+
+    // Quiet-route subscriptions
+    // All the clients that subscribe to the same origin/destination pair share
+    // one route subscription. Each subscription is indexed by the stations
+    // along its candidate paths: Only the passenger events at these stations
+    // can change its route. The changed subscriptions are recomputed in
+    // batches, one batch at a time.
+    struct RouteSubscription {
+        Id startStationId {};
+        Id endStationId {};
+        size_t nSubscribers {0};
+        std::vector<Id> dependencies {};
+        bool hasRoute {false};
+        TravelRoute route {};
+    };
+    std::mutex routeSubscriptionsMutex_ {};
+    std::unordered_map<std::string, RouteSubscription> routeSubscriptions_ {};
+    std::unordered_map<
+        Id,
+        std::unordered_set<std::string>
+    > routeSubscriptionsByStation_ {};
+    std::unordered_set<std::string> dirtyRouteSubscriptions_ {};
+    bool routeBatchScheduled_ {false};
+    boost::asio::steady_timer routeBatchTimer_ {ioc_};
+    std::atomic<size_t> nRouteSubscriptions_ {0};
+    std::atomic<size_t> routeBatches_ {0};
+    std::atomic<size_t> routesRecomputed_ {0};
+    std::atomic<size_t> routesPublished_ {0};
+
+    // The stations touched by the network events drain. Only accessed on the
+    // network strand.
+    std::unordered_set<Id> eventsChangedStations_ {};
 
     std::unordered_set<std::string> connectedClients_ {};
+    mutable std::mutex connectedClientsMutex_ {};
 
-    NetworkMonitorError lastErrorCode_ {NetworkMonitorError::kUndefinedError};
+    // Quiet-route requests being computed, and requests rejected because
+    // there were too many.
+    std::atomic<size_t> nInFlightRequests_ {0};
+    std::atomic<size_t> nRejectedBusyRequests_ {0};
+
+    std::atomic<NetworkMonitorError> lastErrorCode_ {
+        NetworkMonitorError::kUndefinedError
+    };
     TravelRoute lastTravelRoute_ {};
+    mutable std::mutex lastTravelRouteMutex_ {};
 
     // Remote endpoints
     const std::string networkEventsEndpoint_ {"/network-events"};
@@ -386,7 +714,8 @@ private:
             },
             [this](auto ec, auto&& msg) {
                 OnNetworkEventsMessage(ec, std::move(msg));
-            }
+            },
+            config_.networkEventsAckMode
         )};
         if (id.empty()) {
             spdlog::error(
@@ -426,13 +755,13 @@ private:
 
     void OnNetworkEventsMessage(
         StompClientError ec,
-        std::string&& msg
+        StompBody&& msg
     )
     {
         using Error = NetworkMonitorError;
         PassengerEvent event {};
         try {
-            event = nlohmann::json::parse(msg);
+            event = nlohmann::json::parse(msg.GetView());
         } catch (...) {
             spdlog::error(
                 "NetworkMonitor: Could not parse passenger event:\n{}{}",
@@ -441,23 +770,272 @@ private:
             lastErrorCode_ = Error::kCouldNotParsePassengerEvent;
             return;
         }
-        auto ok {network_.RecordPassengerEvent(event)};
         spdlog::debug("NetworkMonitor: Message:\n{}{}", std::setw(4), msg);
-        if (!ok) {
-            spdlog::error(
-                "NetworkMonitor: Could not record new passenger event:\n{}{}",
-                std::setw(4), msg
-            );
-            lastErrorCode_ = Error::kCouldNotRecordPassengerEvent;
+        EnqueueNetworkEvent(std::move(event));
+    }
+
+    // This is the only producer of the network events queue.
+    void EnqueueNetworkEvent(
+        PassengerEvent&& event
+    )
+    {
+        NetworkEventsUpdate update {std::move(event)};
+        if (eventsOverflowing_ || !eventsQueue_->TryPush(std::move(update))) {
+            OverflowNetworkEvent(std::move(update));
+        }
+        const auto depth {eventsQueue_->Size() + eventsOverflowSize_};
+        if (depth > eventsMaxDepth_) {
+            eventsMaxDepth_ = depth;
+        }
+        ScheduleNetworkEventsDrain();
+    }
+
+    // Once an event overflows, the next ones overflow too, until the update
+    // stage has processed all of them. This keeps the events in order.
+    void OverflowNetworkEvent(
+        NetworkEventsUpdate&& update
+    )
+    {
+        std::lock_guard<std::mutex> lock {eventsOverflowMutex_};
+        eventsOverflowing_ = true;
+        switch (config_.networkEventsOverflow) {
+            case NetworkEventsOverflow::kBlockReads: {
+                // The messages that the client already read still come in.
+                eventsOverflow_.push_back(std::move(update));
+                if (!eventsReadsPaused_) {
+                    spdlog::warn("NetworkMonitor: Network events queue full. "
+                                 "Pausing reads");
+                    eventsReadsPaused_ = true;
+                    ++eventsReadPauses_;
+                    client_->PauseReading();
+                }
+                break;
+            }
+            case NetworkEventsOverflow::kDropOldest: {
+                // The update stage drops as many of the queued events.
+                eventsOverflow_.push_back(std::move(update));
+                if (eventsOverflow_.size() > eventsQueue_->Capacity()) {
+                    eventsOverflow_.pop_front();
+                    ++eventsDropped_;
+                }
+                break;
+            }
+            case NetworkEventsOverflow::kCoalesce: {
+                const auto key {update.event.stationId + (
+                    update.event.type == PassengerEvent::Type::In ? "/in" :
+                                                                    "/out"
+                )};
+                auto [indexIt, inserted] {eventsCoalesceIndex_.try_emplace(
+                    key,
+                    eventsOverflow_.size()
+                )};
+                if (inserted) {
+                    eventsOverflow_.push_back(std::move(update));
+                } else {
+                    eventsOverflow_[indexIt->second].count += update.count;
+                    ++eventsCoalesced_;
+                }
+                break;
+            }
+        }
+        eventsOverflowSize_ = eventsOverflow_.size();
+    }
+
+    // This is the only consumer of the network events queue. It runs on the
+    // network strand.
+    void DrainNetworkEvents()
+    {
+        // An event that comes in from now on schedules another drain.
+        eventsDrainScheduled_ = false;
+
+        // The overflowing events take the place of the oldest queued ones.
+        if (eventsOverflowing_ &&
+            config_.networkEventsOverflow == NetworkEventsOverflow::kDropOldest) {
+            size_t nOverflowing {0};
+            {
+                std::lock_guard<std::mutex> lock {eventsOverflowMutex_};
+                nOverflowing = eventsOverflow_.size();
+            }
+            NetworkEventsUpdate dropped {};
+            for (size_t idx {0}; idx < nOverflowing; ++idx) {
+                if (!eventsQueue_->TryPop(dropped)) {
+                    break;
+                }
+                ++eventsDropped_;
+            }
+        }
+
+        // We process at most one queue worth of events in one go, so that the
+        // other handlers get a turn.
+        NetworkEventsUpdate update {};
+        size_t budget {eventsQueue_->Capacity()};
+        {
+            std::unique_lock<std::shared_mutex> lock {networkMutex_};
+            while (budget > 0 && eventsQueue_->TryPop(update)) {
+                RecordNetworkEvent(update);
+                --budget;
+            }
+        }
+        MarkStationsChanged(eventsChangedStations_);
+        eventsChangedStations_.clear();
+        if (budget == 0) {
+            ScheduleNetworkEventsDrain();
+            return;
+        }
+        if (!eventsOverflowing_) {
             return;
         }
+
+        // The queue is empty, and the producer does not push to it while the
+        // events overflow. The overflowing events are next in line.
+        std::deque<NetworkEventsUpdate> overflow {};
+        {
+            std::lock_guard<std::mutex> lock {eventsOverflowMutex_};
+            overflow.swap(eventsOverflow_);
+            eventsCoalesceIndex_.clear();
+            eventsOverflowSize_ = 0;
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock {networkMutex_};
+            for (const auto& overflowing: overflow) {
+                RecordNetworkEvent(overflowing);
+            }
+        }
+        MarkStationsChanged(eventsChangedStations_);
+        eventsChangedStations_.clear();
+        {
+            std::lock_guard<std::mutex> lock {eventsOverflowMutex_};
+            if (eventsOverflow_.empty()) {
+                eventsOverflowing_ = false;
+                if (eventsReadsPaused_) {
+                    spdlog::info("NetworkMonitor: Network events queue "
+                                 "drained. Resuming reads");
+                    eventsReadsPaused_ = false;
+                    client_->ResumeReading();
+                }
+                return;
+            }
+        }
+        ScheduleNetworkEventsDrain();
+    }
+
+    void ScheduleNetworkEventsDrain()
+    {
+        if (!eventsDrainScheduled_.exchange(true)) {
+            boost::asio::post(
+                networkStrand_,
+                [this]() {
+                    DrainNetworkEvents();
+                }
+            );
+        }
+    }
+
+    // Call this with the network lock held exclusively.
+    void RecordNetworkEvent(
+        const NetworkEventsUpdate& update
+    )
+    {
+        using Error = NetworkMonitorError;
+        for (size_t idx {0}; idx < update.count; ++idx) {
+            if (!network_.RecordPassengerEvent(update.event)) {
+                spdlog::error(
+                    "NetworkMonitor: Could not record new passenger event at "
+                    "station {}",
+                    update.event.stationId
+                );
+                lastErrorCode_ = Error::kCouldNotRecordPassengerEvent;
+                return;
+            }
+        }
         spdlog::debug(
             "NetworkMonitor: New event: {}",
-            boost::posix_time::to_iso_extended_string(event.timestamp)
+            boost::posix_time::to_iso_extended_string(update.event.timestamp)
         );
+        if (nRouteSubscriptions_ > 0) {
+            eventsChangedStations_.insert(update.event.stationId);
+        }
         lastErrorCode_ = Error::kOk;
     }
 
+    size_t GetNThreads() const
+    {
+        return std::max(config_.nThreads, size_t {1});
+    }
+
+    // The calling thread is one of the I/O context threads.
+    template <typename Function>
+    void RunOnThreads(
+        Function&& run
+    )
+    {
+        std::vector<std::thread> threads {};
+        threads.reserve(GetNThreads() - 1);
+        for (size_t idx {1}; idx < GetNThreads(); ++idx) {
+            threads.emplace_back(run);
+        }
+        run();
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    void LogNetworkEventsQueueStats() const
+    {
+        const auto stats {GetNetworkEventsQueueStats()};
+        spdlog::info("NetworkMonitor: Network events queue: depth {}, max "
+                     "depth {}, dropped {}, coalesced {}, read pauses {}",
+                     stats.depth, stats.maxDepth, stats.nDropped,
+                     stats.nCoalesced, stats.nReadPauses);
+    }
+
+    void LogQuietRouteSubscriptionStats() const
+    {
+        const auto stats {GetQuietRouteSubscriptionStats()};
+        if (stats.nBatches == 0) {
+            return;
+        }
+        spdlog::info("NetworkMonitor: Quiet-route subscriptions: {} routes, "
+                     "{} batches, {} recomputed, {} published",
+                     stats.nRoutes, stats.nBatches, stats.nRecomputed,
+                     stats.nPublished);
+    }
+
+    void LogQuietRouteAdmissionStats() const
+    {
+        const auto stats {GetQuietRouteAdmissionStats()};
+        if (stats.nRejectedConnections == 0 &&
+            stats.nRateLimitedFrames == 0 &&
+            stats.nRejectedBusy == 0) {
+            return;
+        }
+        spdlog::info("NetworkMonitor: Quiet-route admission: {} connections "
+                     "rejected, {} clients rate-limited, {} requests dropped "
+                     "(busy)",
+                     stats.nRejectedConnections, stats.nRateLimitedFrames,
+                     stats.nRejectedBusy);
+    }
+
+    void LogCompressionStats() const
+    {
+        for (const auto& [name, options]: {
+            std::make_pair("Network events", &config_.networkEventsCompression),
+            std::make_pair("Quiet route", &config_.quietRouteCompression),
+        }) {
+            if (!options->enabled || options->stats == nullptr) {
+                continue;
+            }
+            const auto report {options->stats->GetReport()};
+            spdlog::info("NetworkMonitor: {} compression: {} messages, {} "
+                         "compressible, ratio {:.3f}, {} ns per message "
+                         "({} sampled)",
+                         name, report.nMessages, report.nCompressible,
+                         report.GetRatio(),
+                         report.GetCpuTimePerMessage().count(),
+                         report.nSampled);
+        }
+    }
+
     void OnQuietRouteClientConnect(
         StompServerError ec,
         const std::string& connectionId
@@ -465,7 +1043,10 @@ private:
     {
         spdlog::info("NetworkMonitor: [{}] Connected to quiet-route",
                      connectionId);
-        connectedClients_.insert(connectionId);
+        {
+            std::lock_guard<std::mutex> lock {connectedClientsMutex_};
+            connectedClients_.insert(connectionId);
+        }
         lastErrorCode_ = NetworkMonitorError::kOk;
     }
 
@@ -474,24 +1055,63 @@ private:
         const std::string& connectionId,
         const std::string& destination,
         const std::string& requestId,
-        std::string&& message
+        StompBody&& message
     )
     {
-        using Error = NetworkMonitorError;
         if (destination != quietRouteDestination) {
             spdlog::error("NetworkMonitor: [{}] Unsupported destination: {}",
                           connectionId, destination);
-            server_->Close(connectionId);
-            connectedClients_.erase(connectionId);
+            CloseQuietRouteClient(connectionId);
             return;
         }
         spdlog::info("NetworkMonitor: [{}] New message to {}",
                      connectionId, destination);
         spdlog::debug("NetworkMonitor: Message:\n{}{}", std::setw(4), message);
+
+        // We only check the limit here, on the STOMP server strand: The count
+        // can only go down in the meantime.
+        if (config_.quietRouteMaxInFlightRequests > 0 &&
+            nInFlightRequests_ >= config_.quietRouteMaxInFlightRequests) {
+            spdlog::warn("NetworkMonitor: [{}] Dropping request {}: {} routes "
+                         "in flight",
+                         connectionId, requestId, nInFlightRequests_.load());
+            ++nRejectedBusyRequests_;
+            return;
+        }
+        ++nInFlightRequests_;
+
+        // The STOMP server calls us on a single strand. We compute the travel
+        // routes outside of it, so that the requests are served in parallel.
+        boost::asio::post(
+            ioc_,
+            [
+                this,
+                connectionId,
+                requestId,
+                message = std::move(message)
+            ]() mutable {
+                HandleQuietRouteRequest(
+                    connectionId,
+                    requestId,
+                    std::move(message)
+                );
+                --nInFlightRequests_;
+            }
+        );
+    }
+
+    // This function runs on any I/O context thread.
+    void HandleQuietRouteRequest(
+        const std::string& connectionId,
+        const std::string& requestId,
+        StompBody&& message
+    )
+    {
+        using Error = NetworkMonitorError;
         Id startStationId {};
         Id endStationId {};
         try {
-            auto messageJson = nlohmann::json::parse(message);
+            auto messageJson = nlohmann::json::parse(message.GetView());
             startStationId = messageJson.at("start_station_id").get<Id>();
             endStationId = messageJson.at("end_station_id").get<Id>();
         } catch (...) {
@@ -500,27 +1120,43 @@ private:
                 std::setw(4), message
             );
             lastErrorCode_ = Error::kCouldNotParseQuietRouteRequest;
-            server_->Close(connectionId);
-            connectedClients_.erase(connectionId);
+            CloseQuietRouteClient(connectionId);
             return;
         }
-        auto travelRoute {network_.GetQuietTravelRoute(
-            startStationId,
-            endStationId,
-            config_.quietRouteMaxSlowdownPc,
-            config_.quietRouteMinQuietnessPc,
-            config_.quietRouteMaxNPaths
-        )};
-        nlohmann::json travelRouteJson = travelRoute;
+        TravelRoute travelRoute {};
+        {
+            std::shared_lock<std::shared_mutex> lock {networkMutex_};
+            travelRoute = network_.GetQuietTravelRoute(
+                startStationId,
+                endStationId,
+                config_.quietRouteMaxSlowdownPc,
+                config_.quietRouteMinQuietnessPc,
+                config_.quietRouteMaxNPaths
+            );
+        }
+        // We serialize the travel route straight into the outbound frame.
         server_->Send(
             connectionId,
             quietRouteDestination,
-            travelRouteJson.dump(),
+            GetJsonSize(travelRoute),
+            [&travelRoute](auto& buffer) {
+                WriteJson(buffer, travelRoute);
+            },
             nullptr,
             requestId
         );
         lastErrorCode_ = Error::kOk;
-        lastTravelRoute_ = travelRoute;
+        std::lock_guard<std::mutex> lock {lastTravelRouteMutex_};
+        lastTravelRoute_ = std::move(travelRoute);
+    }
+
+    void CloseQuietRouteClient(
+        const std::string& connectionId
+    )
+    {
+        server_->Close(connectionId);
+        std::lock_guard<std::mutex> lock {connectedClientsMutex_};
+        connectedClients_.erase(connectionId);
     }
 
     void OnQuietRouteClientDisconnect(
@@ -530,10 +1166,356 @@ private:
     {
         spdlog::info("NetworkMonitor: [{}] Disconnected from quiet-route",
                      connectionId);
-        connectedClients_.erase(connectionId);
+        {
+            std::lock_guard<std::mutex> lock {connectedClientsMutex_};
+            connectedClients_.erase(connectionId);
+        }
         lastErrorCode_ = NetworkMonitorError::kStompServerClientDisconnected;
     }
 
+    void OnQuietRouteClientSubscribe(
+        StompServerError ec,
+        const std::string& connectionId,
+        const std::string& destination
+    )
+    {
+        Id startStationId {};
+        Id endStationId {};
+        if (!ParseQuietRouteDestination(
+            destination,
+            startStationId,
+            endStationId
+        )) {
+            spdlog::error("NetworkMonitor: [{}] Unsupported subscription: {}",
+                          connectionId, destination);
+            lastErrorCode_ = NetworkMonitorError::kCouldNotParseQuietRouteRequest;
+            CloseQuietRouteClient(connectionId);
+            return;
+        }
+        spdlog::info("NetworkMonitor: [{}] Subscribed to {}",
+                     connectionId, destination);
+        std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+        auto [subscriptionIt, _] {routeSubscriptions_.try_emplace(
+            destination,
+            RouteSubscription {startStationId, endStationId}
+        )};
+        auto& subscription {subscriptionIt->second};
+        ++subscription.nSubscribers;
+        nRouteSubscriptions_ = routeSubscriptions_.size();
+
+        // The other subscribers already have the current route. If it is not
+        // known yet, all subscribers receive it when it is.
+        if (subscription.hasRoute) {
+            PublishRoute(destination, subscription.route, connectionId);
+        } else {
+            dirtyRouteSubscriptions_.insert(destination);
+            ScheduleRouteSubscriptionsBatch();
+        }
+        lastErrorCode_ = NetworkMonitorError::kOk;
+    }
+
+    void OnQuietRouteClientUnsubscribe(
+        StompServerError ec,
+        const std::string& connectionId,
+        const std::string& destination
+    )
+    {
+        std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+        auto subscriptionIt {routeSubscriptions_.find(destination)};
+        if (subscriptionIt == routeSubscriptions_.end()) {
+            return;
+        }
+        spdlog::info("NetworkMonitor: [{}] Unsubscribed from {}",
+                     connectionId, destination);
+        auto& subscription {subscriptionIt->second};
+        if (--subscription.nSubscribers > 0) {
+            return;
+        }
+        SetRouteDependencies(destination, subscription, {});
+        routeSubscriptions_.erase(subscriptionIt);
+        dirtyRouteSubscriptions_.erase(destination);
+        nRouteSubscriptions_ = routeSubscriptions_.size();
+    }
+
+    // The destination is quietRouteDestination/<start>/<end>.
+    bool ParseQuietRouteDestination(
+        const std::string& destination,
+        Id& startStationId,
+        Id& endStationId
+    ) const
+    {
+        const auto prefix {quietRouteDestination + "/"};
+        if (destination.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        const auto separator {destination.find('/', prefix.size())};
+        if (separator == std::string::npos ||
+            separator == prefix.size() ||
+            separator + 1 == destination.size() ||
+            destination.find('/', separator + 1) != std::string::npos) {
+            return false;
+        }
+        startStationId = destination.substr(
+            prefix.size(),
+            separator - prefix.size()
+        );
+        endStationId = destination.substr(separator + 1);
+        return true;
+    }
+
+    // This function can be called from any thread.
+    void MarkStationsChanged(
+        const std::unordered_set<Id>& stations
+    )
+    {
+        if (stations.empty() || nRouteSubscriptions_ == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+        for (const auto& stationId: stations) {
+            auto stationIt {routeSubscriptionsByStation_.find(stationId)};
+            if (stationIt == routeSubscriptionsByStation_.end()) {
+                continue;
+            }
+            dirtyRouteSubscriptions_.insert(
+                stationIt->second.begin(),
+                stationIt->second.end()
+            );
+        }
+        ScheduleRouteSubscriptionsBatch();
+    }
+
+    void MarkAllRouteSubscriptionsChanged()
+    {
+        std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+        for (const auto& [destination, _]: routeSubscriptions_) {
+            dirtyRouteSubscriptions_.insert(destination);
+        }
+        ScheduleRouteSubscriptionsBatch();
+    }
+
+    // Call this with the route subscriptions lock held.
+    void ScheduleRouteSubscriptionsBatch()
+    {
+        if (routeBatchScheduled_ || dirtyRouteSubscriptions_.empty()) {
+            return;
+        }
+        routeBatchScheduled_ = true;
+        routeBatchTimer_.expires_after(
+            config_.quietRouteSubscriptionBatchInterval
+        );
+        routeBatchTimer_.async_wait([this](auto ec) {
+            if (ec) {
+                return;
+            }
+            RunRouteSubscriptionsBatch();
+        });
+    }
+
+    // This function runs on any I/O context thread. Only one batch runs at a
+    // time, so the routes of a subscription are published in order.
+    void RunRouteSubscriptionsBatch()
+    {
+        std::vector<std::pair<std::string, RouteSubscription>> batch {};
+        {
+            std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+            for (const auto& destination: dirtyRouteSubscriptions_) {
+                const auto& subscription {routeSubscriptions_.at(destination)};
+                batch.emplace_back(destination, RouteSubscription {
+                    subscription.startStationId,
+                    subscription.endStationId,
+                });
+            }
+            dirtyRouteSubscriptions_.clear();
+        }
+        ++routeBatches_;
+        spdlog::info("NetworkMonitor: Recomputing {} quiet-route "
+                     "subscription(s)",
+                     batch.size());
+
+        // A passenger event that comes in while we compute a route marks it
+        // again for the next batch.
+        for (auto& [destination, computed]: batch) {
+            {
+                std::shared_lock<std::shared_mutex> lock {networkMutex_};
+                computed.route = network_.GetQuietTravelRoute(
+                    computed.startStationId,
+                    computed.endStationId,
+                    config_.quietRouteMaxSlowdownPc,
+                    config_.quietRouteMinQuietnessPc,
+                    config_.quietRouteMaxNPaths,
+                    computed.dependencies
+                );
+            }
+            ++routesRecomputed_;
+            std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+            auto subscriptionIt {routeSubscriptions_.find(destination)};
+            if (subscriptionIt == routeSubscriptions_.end()) {
+                continue;
+            }
+            auto& subscription {subscriptionIt->second};
+            SetRouteDependencies(
+                destination,
+                subscription,
+                std::move(computed.dependencies)
+            );
+            if (subscription.hasRoute && subscription.route == computed.route) {
+                continue;
+            }
+            subscription.route = std::move(computed.route);
+            subscription.hasRoute = true;
+            PublishRoute(destination, subscription.route);
+            ++routesPublished_;
+            std::lock_guard<std::mutex> routeLock {lastTravelRouteMutex_};
+            lastTravelRoute_ = subscription.route;
+        }
+
+        std::lock_guard<std::mutex> lock {routeSubscriptionsMutex_};
+        routeBatchScheduled_ = false;
+        ScheduleRouteSubscriptionsBatch();
+    }
+
+    // Call this with the route subscriptions lock held.
+    void SetRouteDependencies(
+        const std::string& destination,
+        RouteSubscription& subscription,
+        std::vector<Id>&& dependencies
+    )
+    {
+        for (const auto& stationId: subscription.dependencies) {
+            auto stationIt {routeSubscriptionsByStation_.find(stationId)};
+            stationIt->second.erase(destination);
+            if (stationIt->second.empty()) {
+                routeSubscriptionsByStation_.erase(stationIt);
+            }
+        }
+        subscription.dependencies = std::move(dependencies);
+        for (const auto& stationId: subscription.dependencies) {
+            routeSubscriptionsByStation_[stationId].insert(destination);
+        }
+    }
+
+    // Call this with the route subscriptions lock held, so that the routes of
+    // a subscription are published in order.
+    void PublishRoute(
+        const std::string& destination,
+        const TravelRoute& route,
+        const std::string& connectionId = ""
+    )
+    {
+        // We serialize the travel route straight into the shared frame.
+        server_->Publish(
+            destination,
+            GetJsonSize(route),
+            [&route](auto& buffer) {
+                WriteJson(buffer, route);
+            },
+            connectionId
+        );
+    }
+
+    void OnNetworkLayoutFileChange(
+        const std::filesystem::path& networkLayoutFile
+    )
+    {
+        // We only build one network at a time. If the file changes again while
+        // we are building, we rebuild once the current build is done.
+        if (reloadInProgress_) {
+            reloadPending_ = true;
+            return;
+        }
+        reloadInProgress_ = true;
+        reloadPending_ = false;
+        if (reloadPool_ == nullptr) {
+            reloadPool_ = std::make_unique<boost::asio::thread_pool>(1);
+        }
+        boost::asio::post(*reloadPool_, [this, networkLayoutFile]() {
+            BuildNetworkLayout(networkLayoutFile);
+        });
+    }
+
+    // This function runs on the reload thread. It must not touch any member
+    // other than the network strand.
+    void BuildNetworkLayout(
+        const std::filesystem::path& networkLayoutFile
+    )
+    {
+        using Error = NetworkMonitorError;
+        spdlog::info("NetworkMonitor: Reloading the network layout file");
+        const auto start {std::chrono::steady_clock::now()};
+        auto ec {Error::kOk};
+        TransportNetwork network {};
+        auto parsed = ParseJsonFile(networkLayoutFile);
+        if (parsed.empty()) {
+            spdlog::error("NetworkMonitor: Could not parse {}. Keeping the "
+                          "current network",
+                          networkLayoutFile);
+            ec = Error::kFailedNetworkLayoutFileParsing;
+        } else {
+            try {
+                if (!network.FromJson(std::move(parsed))) {
+                    spdlog::error("NetworkMonitor: Could not construct the "
+                                  "TransportNetwork. Keeping the current "
+                                  "network");
+                    ec = Error::kFailedTransportNetworkConstruction;
+                }
+            } catch (const std::exception& e) {
+                spdlog::error("NetworkMonitor: Exception while constructing "
+                              "the TransportNetwork: {}. Keeping the current "
+                              "network",
+                              e.what());
+                ec = Error::kFailedTransportNetworkConstruction;
+            }
+        }
+        const std::chrono::duration<double, std::milli> buildTime {
+            std::chrono::steady_clock::now() - start
+        };
+        if (ec == Error::kOk) {
+            spdlog::info("NetworkMonitor: Built the new network in {:.1}",
+                         buildTime);
+        }
+        boost::asio::post(
+            networkStrand_,
+            [this, ec, network = std::move(network)]() mutable {
+                OnNetworkLayoutBuilt(ec, std::move(network));
+            }
+        );
+    }
+
+    void OnNetworkLayoutBuilt(
+        NetworkMonitorError ec,
+        TransportNetwork&& network
+    )
+    {
+        reloadInProgress_ = false;
+        if (ec != NetworkMonitorError::kOk) {
+            lastErrorCode_ = ec;
+        } else {
+            // We carry over the passenger counts recorded so far, including
+            // the ones recorded while the new network was being built.
+            // The old network is destroyed after we release the lock.
+            const auto start {std::chrono::steady_clock::now()};
+            size_t nCopied {0};
+            {
+                std::unique_lock<std::shared_mutex> lock {networkMutex_};
+                nCopied = network.CopyPassengerCounts(network_);
+                std::swap(network_, network);
+            }
+            const std::chrono::duration<double, std::milli> swapTime {
+                std::chrono::steady_clock::now() - start
+            };
+            spdlog::info("NetworkMonitor: Swapped in the new network in {:.3} "
+                         "({} station counts carried over)",
+                         swapTime, nCopied);
+
+            // The travel times may have changed: All routes are affected.
+            MarkAllRouteSubscriptionsChanged();
+        }
+        if (reloadPending_) {
+            OnNetworkLayoutFileChange(config_.networkLayoutFile);
+        }
+    }
+
     void OnQuietRouteDisconnect(
         StompServerError ec
     )
@@ -0,0 +1,142 @@
+#ifndef NETWORK_MONITOR_SPSC_QUEUE_H
+#define NETWORK_MONITOR_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace NetworkMonitor {
+
+/*! \brief Bounded, lock-free, single-producer/single-consumer queue.
+ *
+ *  The items live in a ring of pre-allocated slots. A push never allocates.
+ *
+ *  \note One thread (or strand) at a time may push, and one thread (or strand)
+ *        at a time may pop. Size, Empty and Capacity may be called from
+ *        anywhere.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /*! \brief Construct a queue.
+     *
+     *  \param capacity The maximum number of items. It is rounded up to a
+     *                  power of two, and it is at least 1.
+     */
+    explicit SpscQueue(
+        const size_t capacity
+    ) : capacity_ {RoundUpToPowerOfTwo(capacity)},
+        mask_ {capacity_ - 1},
+        slots_ {std::make_unique<T[]>(capacity_)}
+    {
+    }
+
+    /*! \brief The copy constructor is deleted.
+     */
+    SpscQueue(const SpscQueue& other) = delete;
+
+    /*! \brief The copy assignment operator is deleted.
+     */
+    SpscQueue& operator=(const SpscQueue& other) = delete;
+
+    /*! \brief Push an item at the back of the queue. Producer only.
+     *
+     *  \returns false if the queue is full. The item is left untouched.
+     */
+    bool TryPush(
+        T&& item
+    )
+    {
+        const auto tail {tail_.load(std::memory_order_relaxed)};
+        if (tail - headCache_ == capacity_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*! \brief Pop the item at the front of the queue. Consumer only.
+     *
+     *  \returns false if the queue is empty.
+     */
+    bool TryPop(
+        T& item
+    )
+    {
+        const auto head {head_.load(std::memory_order_relaxed)};
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) {
+                return false;
+            }
+        }
+
+        // We reset the slot, so that it does not hold on to resources.
+        item = std::exchange(slots_[head & mask_], T {});
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*! \brief Get the number of items in the queue.
+     *
+     *  This is a snapshot: The producer and the consumer may change it right
+     *  away.
+     */
+    size_t Size() const
+    {
+        const auto head {head_.load(std::memory_order_acquire)};
+        const auto tail {tail_.load(std::memory_order_acquire)};
+        return tail - head;
+    }
+
+    /*! \brief Check if the queue is empty. This is a snapshot.
+     */
+    bool Empty() const
+    {
+        return Size() == 0;
+    }
+
+    /*! \brief Get the maximum number of items in the queue.
+     */
+    size_t Capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    // The producer and the consumer indices sit on separate cache lines, so
+    // that the two sides do not invalidate each other on every operation.
+    // Each side also caches the other index, and only reloads it when the
+    // queue looks full or empty.
+    static constexpr size_t kCacheLineSize {64};
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    // The indices only grow. The slot is the index modulo the capacity.
+    alignas(kCacheLineSize) std::atomic<size_t> head_ {0};
+    size_t tailCache_ {0};
+    alignas(kCacheLineSize) std::atomic<size_t> tail_ {0};
+    size_t headCache_ {0};
+
+    static size_t RoundUpToPowerOfTwo(
+        const size_t value
+    )
+    {
+        size_t result {1};
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+};
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_SPSC_QUEUE_H
@@ -1,24 +1,32 @@
 #ifndef NETWORK_MONITOR_STOMP_CLIENT_H
 #define NETWORK_MONITOR_STOMP_CLIENT_H
 
+#include <network-monitor/IdGenerator.h>
 #include <network-monitor/StompFrame.h>
+#include <network-monitor/StompHeartBeat.h>
+#include <network-monitor/TimerWheel.h>
+#include <network-monitor/WebsocketCompression.h>
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
-#include <boost/uuid/uuid.hpp>
-#include <boost/uuid/uuid_generators.hpp>
-#include <boost/uuid/uuid_io.hpp>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ostr.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <ostream>
-#include <sstream>
+#include <random>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
 namespace NetworkMonitor {
 
@@ -33,6 +41,7 @@ enum class StompClientError {
     kCouldNotSendMessage,
     kCouldNotSendStompFrame,
     kCouldNotSendSubscribeFrame,
+    kReceiptTimeout,
     kUnexpectedCouldNotCreateValidFrame,
     kUnexpectedMessageContentType,
     kUnexpectedSubscriptionMismatch,
@@ -47,6 +56,106 @@ std::ostream& operator<<(std::ostream& os, const StompClientError& m);
  */
 std::string ToString(const StompClientError& m);
 
+/*! \brief How the client acknowledges the messages of a subscription.
+ *
+ *  - kAuto: The server considers a message acknowledged as soon as it sends
+ *    it.
+ *  - kClient: One ACK frame acknowledges a message and all the previous ones
+ *    of the subscription.
+ *  - kClientIndividual: Each message needs its own ACK frame.
+ */
+enum class StompClientAckMode {
+    kAuto,
+    kClient,
+    kClientIndividual,
+};
+
+/*! \brief Print operator for the StompClientAckMode class.
+ */
+std::ostream& operator<<(std::ostream& os, const StompClientAckMode& m);
+
+/*! \brief Convert StompClientAckMode to its ack header value.
+ */
+std::string ToString(const StompClientAckMode& m);
+
+/*! \brief Policy to acknowledge the subscription messages, and to limit the
+ *         messages that are not yet acknowledged.
+ *
+ *  A message is acknowledged once its handler returns. The client collects
+ *  the ACK frames and sends them in one Websocket message, when batchSize
+ *  messages are pending or batchDelay after the first one, whichever comes
+ *  first.
+ *
+ *  With maxUnacked messages received but not yet acknowledged, the client
+ *  stops reading from the server until the handlers catch up. In kAuto mode,
+ *  this still bounds the messages that wait for their handler.
+ */
+struct StompClientAckPolicy {
+    size_t batchSize {64};
+    std::chrono::milliseconds batchDelay {100};
+
+    // 0 = no limit
+    size_t maxUnacked {0};
+};
+
+/*! \brief Policy to reconnect a StompClient after an unexpected
+ *         disconnection.
+ *
+ *  The delay before each attempt grows exponentially from initialDelay to
+ *  maxDelay. A random fraction of the delay, up to jitter, is taken off, so
+ *  that many clients do not reconnect in lockstep after an outage.
+ */
+struct StompClientReconnectPolicy {
+    bool enabled {false};
+    std::chrono::milliseconds initialDelay {500};
+    std::chrono::milliseconds maxDelay {30000};
+    double multiplier {2.0};
+    double jitter {0.5};
+
+    // 0 = retry forever
+    size_t maxAttempts {0};
+};
+
+/*! \brief Reconnection metrics of a StompClient.
+ *
+ *  - The reconnect latency goes from the disconnection to the new STOMP
+ *    session.
+ *  - The gap goes from the last subscription message before the
+ *    disconnection to the first one after it. This is how long we were not
+ *    receiving data.
+ */
+struct StompClientReconnectStats {
+    size_t nDisconnections {0};
+    size_t nReconnections {0};
+    size_t nFailedAttempts {0};
+    std::chrono::steady_clock::duration lastReconnectLatency {0};
+    std::chrono::steady_clock::duration lastGap {0};
+    std::chrono::steady_clock::duration totalGap {0};
+};
+
+/*! \brief Metrics of the messages sent with a receipt request.
+ *
+ *  The round-trip time goes from the Send call to the RECEIPT frame.
+ */
+struct StompClientReceiptStats {
+    size_t nReceipts {0};
+    size_t nTimeouts {0};
+    std::chrono::steady_clock::duration lastRtt {0};
+    std::chrono::steady_clock::duration maxRtt {0};
+    std::chrono::steady_clock::duration totalRtt {0};
+};
+
+/*! \brief Get the delay before a reconnection attempt.
+ *
+ *  \param attempt The attempt number, starting from 0.
+ *  \param random  A random number in [0, 1), to apply the jitter.
+ */
+std::chrono::milliseconds GetReconnectDelay(
+    const StompClientReconnectPolicy& policy,
+    size_t attempt,
+    double random
+);
+
 /*! \brief STOMP client implementing the subset of commands needed by the
  *         network-events service.
  *
@@ -68,16 +177,23 @@ public:
      *  \param ioc      The io_context object. The user takes care of calling
      *                  ioc.run().
      *  \param ctx      The TLS context to setup a TLS socket stream.
+     *  \param idMode   How to generate the subscription and request IDs.
      */
     StompClient(
         const std::string& url,
         const std::string& endpoint,
         const std::string& port,
         boost::asio::io_context& ioc,
-        boost::asio::ssl::context& ctx
+        boost::asio::ssl::context& ctx,
+        const IdGeneratorMode idMode = IdGeneratorMode::kRandomUuid
     ) : ws_ {url, endpoint, port, ioc, ctx},
         url_ {url},
-        context_ {boost::asio::make_strand(ioc)}
+        context_ {boost::asio::make_strand(ioc)},
+        ids_ {idMode},
+        reconnectTimer_ {context_},
+        heartBeatTimer_ {context_},
+        ackTimer_ {context_},
+        receiptTimer_ {context_}
     {
         spdlog::info("StompClient: Creating STOMP client for {}:{}{}",
                      url, port, endpoint);
@@ -113,14 +229,16 @@ public:
      *  \param onMessage    This handler is called when the connected client
      *                      or server sends us a message as a SEND frame. The
      *                      handler contains an error code, the message
-     *                      destination and content. Ownership of the
-     *                      message content is passed to the receiver. It is
+     *                      destination and content. The content shares the
+     *                      received frame buffer and is never copied. It is
      *                      assumed that the message is received with
      *                      application/json content type.
      *  \param onDisconnect This handler is called when the STOMP or the
      *                      Websocket connection is suddenly closed. In the
      *                      STOMP protocol, this may happen also in response to
-     *                      bad inputs (authentication, subscription).
+     *                      bad inputs (authentication, subscription). With a
+     *                      reconnect policy, it is only called when the client
+     *                      gives up reconnecting.
      *
      *  All handlers run in a separate I/O execution context from the Websocket
      *  one.
@@ -130,7 +248,7 @@ public:
         const std::string& password,
         std::function<void (StompClientError)> onConnect = nullptr,
         std::function<
-            void (StompClientError, const std::string&, std::string&&)
+            void (StompClientError, const std::string&, StompBody&&)
         > onMessage = nullptr,
         std::function<void (StompClientError)> onDisconnect = nullptr
     )
@@ -141,17 +259,123 @@ public:
         onConnect_ = onConnect;
         onMessage_ = onMessage;
         onDisconnect_ = onDisconnect;
-        ws_.Connect(
-            [this](auto ec) {
-                OnWsConnect(ec);
-            },
-            [this](auto ec, auto&& msg) {
-                OnWsMessage(ec, std::move(msg));
-            },
-            [this](auto ec) {
-                OnWsDisconnect(ec);
-            }
-        );
+        closing_ = false;
+        reconnecting_ = false;
+        reconnectAttempt_ = 0;
+        ConnectWs();
+    }
+
+    /*! \brief Set the policy to reconnect after an unexpected disconnection.
+     *
+     *  On reconnection, the client sends the STOMP frame again and renews all
+     *  the active subscriptions, with their original IDs. The user handlers
+     *  are not called again for the new connection and subscriptions.
+     *
+     *  \note Call this before Connect.
+     */
+    void SetReconnectPolicy(
+        const StompClientReconnectPolicy& policy
+    )
+    {
+        reconnectPolicy_ = policy;
+    }
+
+    /*! \brief Set the heart-beat intervals to offer to the server.
+     *
+     *  The client sends the intervals in the STOMP frame and negotiates them
+     *  with the ones in the CONNECTED frame. If the server goes silent for
+     *  longer than kStompHeartBeatGraceFactor receive intervals, the client
+     *  drops the connection and handles it as a disconnection.
+     *
+     *  \note Call this before Connect. By default, heart-beating is disabled.
+     */
+    void SetHeartBeat(
+        const StompHeartBeat& heartBeat
+    )
+    {
+        heartBeat_ = heartBeat;
+    }
+
+    /*! \brief Set the policy to acknowledge the subscription messages.
+     *
+     *  \note Call this before Connect.
+     */
+    void SetAckPolicy(
+        const StompClientAckPolicy& policy
+    )
+    {
+        ackPolicy_ = policy;
+    }
+
+    /*! \brief Offer the Websocket permessage-deflate extension to the server.
+     *
+     *  \note Call this before Connect. By default, compression is disabled.
+     */
+    void SetCompression(
+        const WebsocketCompressionOptions& options
+    )
+    {
+        ws_.SetCompression(options);
+    }
+
+    /*! \brief Get the number of messages received but not yet acknowledged.
+     */
+    size_t GetUnackedCount() const
+    {
+        return unacked_;
+    }
+
+    /*! \brief Stop reading messages from the server, until ResumeReading is
+     *         called.
+     *
+     *  Use this to push back on the server when the messages come in faster
+     *  than they can be processed. The messages that were already read are
+     *  still delivered.
+     *
+     *  Pauses nest: Every call must be matched by a ResumeReading call. A
+     *  pause lasts across reconnections.
+     */
+    void PauseReading()
+    {
+        ++readPauses_;
+        ws_.PauseReading();
+    }
+
+    /*! \brief Resume reading messages from the server after PauseReading.
+     */
+    void ResumeReading()
+    {
+        // The server could not reach us while we were not reading.
+        lastReadAt_ = GetTicks();
+        --readPauses_;
+        ws_.ResumeReading();
+    }
+
+    /*! \brief Set how long to wait for the receipt of a message.
+     *
+     *  The deadlines have a resolution of kReceiptTick.
+     */
+    void SetReceiptTimeout(
+        const std::chrono::milliseconds timeout
+    )
+    {
+        receiptTimeout_ = timeout;
+    }
+
+    /*! \brief Get the metrics of the messages sent with a receipt request.
+     */
+    StompClientReceiptStats GetReceiptStats() const
+    {
+        std::lock_guard<std::mutex> lock {statsMutex_};
+        return receiptStats_;
+    }
+
+    /*! \brief Get the reconnection metrics.
+     */
+    StompClientReconnectStats GetReconnectStats() const
+    {
+        std::lock_guard<std::mutex> lock {statsMutex_};
+        return stats_;
     }
 
     /*! \brief Close the STOMP and Websocket connection.
@@ -167,7 +391,17 @@ public:
     )
     {
         spdlog::info("StompClient: Closing connection to STOMP server");
-        subscriptions_.clear();
+        closing_ = true;
+        boost::asio::post(
+            context_,
+            [this]() {
+                reconnectTimer_.cancel();
+                ackTimerArmed_ = false;
+                ackTimer_.cancel();
+                FailReceipts();
+            }
+        );
+        StopHeartBeat();
         ws_.Close(
             [this, onClose](auto ec) {
                 OnWsClose(ec, onClose);
@@ -190,9 +424,15 @@ public:
      *                      automatically closes the Websocket connection on a
      *                      STOMP protocol failure.
      *  \param onMessage    This handler is called on every new message from the
-     *                      subscription destination. It is assumed that the
-     *                      message is received with application/json content
-     *                      type.
+     *                      subscription destination. The message shares the
+     *                      received frame buffer and is never copied. It is
+     *                      assumed that the message is received with
+     *                      application/json content type. With a client ACK
+     *                      mode, the message is acknowledged when the handler
+     *                      returns.
+     *  \param ackMode      How to acknowledge the messages. Messages that are
+     *                      not acknowledged before a disconnection are sent
+     *                      again by the server.
      *
      *  All handlers run in a separate I/O execution context from the Websocket
      *  one.
@@ -200,7 +440,8 @@ public:
     std::string Subscribe(
         const std::string& destination,
         std::function<void (StompClientError, std::string&&)> onSubscribe,
-        std::function<void (StompClientError, std::string&&)> onMessage
+        std::function<void (StompClientError, StompBody&&)> onMessage,
+        const StompClientAckMode ackMode = StompClientAckMode::kAuto
     )
     {
         spdlog::info("StompClient: Subscribing to {}", destination);
@@ -209,22 +450,17 @@ public:
             destination,
             onSubscribe,
             onMessage,
+            ackMode,
         };
 
         // Assemble the SUBSCRIBE frame.
-        // We use the subscription ID to also request a receipt, so the server
-        // will confirm if we are subscribed.
         StompError error {};
-        StompFrame frame {
-            error,
-            StompCommand::kSubscribe,
-            {
-                {StompHeader::kId, subscriptionId},
-                {StompHeader::kDestination, destination},
-                {StompHeader::kAck, "auto"},
-                {StompHeader::kReceipt, subscriptionId},
-            }
-        };
+        auto frame {MakeSubscribeFrame(
+            subscriptionId,
+            destination,
+            ackMode,
+            error
+        )};
         if (error != StompError::kOk) {
             spdlog::error("StompClient: Could not create a valid frame: {}",
                           error);
@@ -232,8 +468,8 @@ public:
         }
 
         // Send the Websocket message.
-        ws_.Send(
-            frame.ToString(),
+        SendWs(
+            std::move(frame),
             [
                 this,
                 subscriptionId,
@@ -257,9 +493,7 @@ public:
      *  \param messageContent   A string containing the message content. We do
      *                          not check if this string is compatible with the
      *                          content type. We assume the content type is
-     *                          application/json. The caller must ensure that
-     *                          this string stays in scope until the onSend
-     *                          handler is called.
+     *                          application/json.
      *  \param onSend           This handler is called when the Websocket
      *                          client terminates the Send operation. On
      *                          success, we cannot guarantee that the message
@@ -267,6 +501,11 @@ public:
      *                          correctly sent at the Websocket level. The
      *                          handler contains an error code and the message
      *                          request ID.
+     *  \param onReceipt        If set, the frame requests a receipt from the
+     *                          server. This handler is called when the receipt
+     *                          arrives, or with kReceiptTimeout if it does not
+     *                          arrive in time. It receives the message request
+     *                          ID and the round-trip time from this call.
      *
      *  All handlers run in a separate I/O execution context from the Websocket
      *  one.
@@ -274,49 +513,88 @@ public:
     std::string Send(
         const std::string& destination,
         const std::string& messageContent,
-        std::function<void (StompClientError, std::string&&)> onSend = nullptr
+        std::function<void (StompClientError, std::string&&)> onSend = nullptr,
+        std::function<void (
+            StompClientError,
+            std::string&&,
+            std::chrono::steady_clock::duration
+        )> onReceipt = nullptr
     )
     {
         spdlog::info("StompClient: Sending message to {}", destination);
 
         auto requestId {GenerateId()};
-        auto messageSize {messageContent.size()};
+        const auto contentLength {std::to_string(messageContent.size())};
 
         // Assemble the SEND frame.
         StompError error {};
-        StompFrame frame {
-            error,
-            StompCommand::kSend,
-            {
-                {StompHeader::kId, requestId},
-                {StompHeader::kDestination, destination},
-                {StompHeader::kContentType, "application/json"},
-                {StompHeader::kContentLength, std::to_string(messageSize)},
-            },
-            messageContent,
-        };
+        StompFrameBuilder builder {StompCommand::kSend};
+        builder
+            .AddHeader(StompHeader::kId, requestId)
+            .AddHeader(StompHeader::kDestination, destination)
+            .AddHeader(StompHeader::kContentType, "application/json")
+            .AddHeader(StompHeader::kContentLength, contentLength)
+            .SetBody(messageContent);
+        if (onReceipt) {
+            builder.AddHeader(StompHeader::kReceipt, requestId);
+        }
+        auto frame {builder.Build(error)};
         if (error != StompError::kOk) {
             spdlog::error("StompClient: Could not create a valid frame: {}",
                           error);
             return "";
         }
 
+        // We track the receipt before the frame leaves, so that the receipt
+        // always finds it.
+        if (onReceipt) {
+            boost::asio::post(
+                context_,
+                [
+                    this,
+                    requestId,
+                    onReceipt,
+                    sentAt = std::chrono::steady_clock::now()
+                ]() mutable {
+                    TrackReceipt(requestId, std::move(onReceipt), sentAt);
+                }
+            );
+        }
+
         // Send the Websocket message.
-        if (onSend == nullptr) {
-            ws_.Send(frame.ToString());
+        if (onSend == nullptr && onReceipt == nullptr) {
+            SendWs(std::move(frame));
         } else {
-            ws_.Send(
-                frame.ToString(),
-                [requestId, onSend](auto ec) mutable {
+            const bool trackReceipt {onReceipt != nullptr};
+            SendWs(
+                std::move(frame),
+                [this, requestId, onSend, trackReceipt](auto ec) mutable {
                     auto error {ec ? StompClientError::kCouldNotSendMessage :
                                      StompClientError::kOk};
-                    onSend(error, std::move(requestId));
+                    if (ec && trackReceipt) {
+                        boost::asio::post(
+                            context_,
+                            [this, requestId]() {
+                                CompleteReceipt(
+                                    requestId,
+                                    StompClientError::kCouldNotSendMessage
+                                );
+                            }
+                        );
+                    }
+                    if (onSend) {
+                        onSend(error, std::move(requestId));
+                    }
                 }
             );
         }
         return requestId;
     }
 
+    /*! \brief The resolution of the receipt deadlines.
+     */
+    static constexpr std::chrono::milliseconds kReceiptTick {10};
+
 private:
     // This strand handles all the STOMP subscription messages. These operations
     // are decoupled from the Websocket operations.
@@ -332,12 +610,84 @@ private:
 
     std::function<void (StompClientError)> onConnect_ {nullptr};
     std::function<
-        void (StompClientError, const std::string&, std::string&&)
+        void (StompClientError, const std::string&, StompBody&&)
     > onMessage_ {nullptr};
     std::function<void (StompClientError)> onDisconnect_ {nullptr};
     std::string username_ {};
     std::string password_ {};
 
+    // Frames may be split across Websocket messages, or batched in one.
+    StompFrameParser parser_ {};
+
+    IdGenerator ids_ {};
+
+    // Reconnection
+    // The timer only runs on the context_ strand. The other reconnection
+    // state is only used in the Websocket callbacks, except for the closing
+    // flag, which the user sets.
+    StompClientReconnectPolicy reconnectPolicy_ {};
+    boost::asio::steady_timer reconnectTimer_;
+    std::minstd_rand random_ {std::random_device {}()};
+    std::atomic<bool> closing_ {false};
+    bool reconnecting_ {false};
+    size_t reconnectAttempt_ {0};
+    bool awaitingFirstMessage_ {false};
+    std::chrono::steady_clock::time_point disconnectedAt_ {};
+    std::chrono::steady_clock::time_point lastMessageAt_ {};
+    mutable std::mutex statsMutex_ {};
+    StompClientReconnectStats stats_ {};
+
+    // Heart-beating
+    // The timer and the negotiated intervals only live on the context_
+    // strand. The timestamps are also updated from the Websocket callbacks.
+    // We stop stale timer callbacks with a generation counter.
+    StompHeartBeat heartBeat_ {};
+    StompHeartBeat heartBeatIntervals_ {};
+    boost::asio::steady_timer heartBeatTimer_;
+    size_t heartBeatGeneration_ {0};
+    std::atomic<std::chrono::steady_clock::rep> lastReadAt_ {0};
+    std::atomic<std::chrono::steady_clock::rep> lastWriteAt_ {0};
+
+    // Acknowledgements
+    // The pending ACKs and their timer only live on the context_ strand. The
+    // counters are also updated from the Websocket callbacks. A new session
+    // starts on every disconnection, so that we drop the ACKs for the
+    // messages that the server sends again.
+    struct PendingAcks {
+        StompClientAckMode ackMode {StompClientAckMode::kAuto};
+        std::vector<std::string> ackIds {};
+    };
+    StompClientAckPolicy ackPolicy_ {};
+    boost::asio::steady_timer ackTimer_;
+    std::map<std::string, PendingAcks, std::less<>> pendingAcks_ {};
+    size_t nPendingAcks_ {0};
+    bool ackTimerArmed_ {false};
+    std::atomic<size_t> ackSession_ {0};
+    std::atomic<size_t> unacked_ {0};
+    std::atomic<bool> ackPaused_ {false};
+
+    // Receipts
+    // The outstanding receipts only live on the context_ strand. A single
+    // timer ticks the wheel, and only while some receipts are outstanding.
+    struct PendingReceipt {
+        std::function<void (
+            StompClientError,
+            std::string&&,
+            std::chrono::steady_clock::duration
+        )> onReceipt {nullptr};
+        std::chrono::steady_clock::time_point sentAt {};
+    };
+    static constexpr size_t kReceiptWheelSlots {512};
+    std::chrono::milliseconds receiptTimeout_ {5000};
+    std::map<std::string, PendingReceipt, std::less<>> pendingReceipts_ {};
+    TimerWheel receiptWheel_ {kReceiptTick, kReceiptWheelSlots};
+    boost::asio::steady_timer receiptTimer_;
+    bool receiptTimerArmed_ {false};
+    StompClientReceiptStats receiptStats_ {};
+
+    // Reads may be paused both by the ACK limit and by the user.
+    std::atomic<int> readPauses_ {0};
+
     struct Subscription {
         std::string destination {};
         std::function<void (
@@ -346,13 +696,253 @@ private:
         )> onSubscribe {nullptr};
         std::function<void (
             StompClientError,
-            std::string&&
+            StompBody&&
         )> onMessage {nullptr};
+        StompClientAckMode ackMode {StompClientAckMode::kAuto};
+
+        // Set on the first receipt. Receipts for a renewed subscription do not
+        // notify the user again.
+        bool confirmed {false};
     };
 
     // We store subscriptions in a map so we can retrieve the message
-    // handler for the right subscription when a message arrives.
-    std::unordered_map<std::string, Subscription> subscriptions_ {};
+    // handler for the right subscription when a message arrives. The map is
+    // only accessed from the Websocket callbacks.
+    // The comparator is transparent, so that we can look up a subscription
+    // with the header value of a frame without copying it into a string.
+    // We only hold a handful of subscriptions, so an ordered map does not
+    // cost us more than a hash map.
+    std::map<std::string, Subscription, std::less<>> subscriptions_ {};
+
+    void ConnectWs()
+    {
+        ws_.Connect(
+            [this](auto ec) {
+                OnWsConnect(ec);
+            },
+            [this](auto ec, auto&& msg) {
+                OnWsMessage(ec, std::move(msg));
+            },
+            [this](auto ec) {
+                OnWsDisconnect(ec);
+            }
+        );
+    }
+
+    // Every outbound frame counts as a heart-beat.
+    void SendWs(
+        std::string&& frame,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
+    {
+        lastWriteAt_ = GetTicks();
+        ws_.Send(std::move(frame), onSend);
+    }
+
+    static std::chrono::steady_clock::rep GetTicks()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    void StartHeartBeat(
+        const StompHeartBeat& intervals
+    )
+    {
+        const auto now {GetTicks()};
+        lastReadAt_ = now;
+        lastWriteAt_ = now;
+        boost::asio::post(
+            context_,
+            [this, intervals]() {
+                ++heartBeatGeneration_;
+                heartBeatTimer_.cancel();
+                heartBeatIntervals_ = intervals;
+                if (GetHeartBeatCheckInterval(intervals).count() > 0) {
+                    spdlog::info("StompClient: Heart-beat: {}", intervals);
+                    WaitHeartBeat(heartBeatGeneration_);
+                }
+            }
+        );
+    }
+
+    void StopHeartBeat()
+    {
+        boost::asio::post(
+            context_,
+            [this]() {
+                ++heartBeatGeneration_;
+                heartBeatTimer_.cancel();
+            }
+        );
+    }
+
+    // A single timer both sends our heart-beats and checks the server ones.
+    void WaitHeartBeat(
+        const size_t generation
+    )
+    {
+        heartBeatTimer_.expires_after(
+            GetHeartBeatCheckInterval(heartBeatIntervals_)
+        );
+        heartBeatTimer_.async_wait([this, generation](auto ec) {
+            if (ec || generation != heartBeatGeneration_) {
+                return;
+            }
+            CheckHeartBeat(generation);
+        });
+    }
+
+    void CheckHeartBeat(
+        const size_t generation
+    )
+    {
+        using std::chrono::steady_clock;
+        const auto& intervals {heartBeatIntervals_};
+        const auto now {steady_clock::now()};
+
+        // A silent server may be gone without closing the TCP connection. We
+        // drop the connection, so that the disconnection is handled as usual.
+        const steady_clock::time_point lastRead {
+            steady_clock::duration {lastReadAt_}
+        };
+        // We cannot hear from the server while we are not reading.
+        if (intervals.receive.count() > 0 && readPauses_ <= 0 &&
+            now - lastRead > intervals.receive * kStompHeartBeatGraceFactor) {
+            spdlog::error("StompClient: No heart-beat from server in {} ms",
+                          std::chrono::duration_cast<
+                              std::chrono::milliseconds
+                          >(now - lastRead).count());
+            ++heartBeatGeneration_;
+            ws_.Abort();
+            return;
+        }
+
+        // Send a heart-beat when the interval expires. We allow for half a
+        // check interval, so that we do not depend on the timer precision.
+        const steady_clock::time_point lastWrite {
+            steady_clock::duration {lastWriteAt_}
+        };
+        if (intervals.send.count() > 0 &&
+            now - lastWrite + GetHeartBeatCheckInterval(intervals) / 2 >=
+                intervals.send) {
+            SendWs("\n", [](auto ec) {
+                if (ec) {
+                    spdlog::error("StompClient: Could not send heart-beat: {}",
+                                  ec.message());
+                }
+            });
+        }
+        WaitHeartBeat(generation);
+    }
+
+    // We use the subscription ID to also request a receipt, so the server
+    // will confirm if we are subscribed.
+    std::string MakeSubscribeFrame(
+        const std::string& subscriptionId,
+        const std::string& destination,
+        const StompClientAckMode ackMode,
+        StompError& error
+    )
+    {
+        const auto ack {ToString(ackMode)};
+        return StompFrameBuilder {StompCommand::kSubscribe}
+            .AddHeader(StompHeader::kId, subscriptionId)
+            .AddHeader(StompHeader::kDestination, destination)
+            .AddHeader(StompHeader::kAck, ack)
+            .AddHeader(StompHeader::kReceipt, subscriptionId)
+            .Build(error);
+    }
+
+    // Schedule the next reconnection attempt, or give up and notify the user.
+    void ScheduleReconnect()
+    {
+        const auto& policy {reconnectPolicy_};
+        if (policy.maxAttempts > 0 && reconnectAttempt_ >= policy.maxAttempts) {
+            spdlog::error("StompClient: Giving up after {} reconnect attempts",
+                          reconnectAttempt_);
+            reconnecting_ = false;
+            if (onDisconnect_) {
+                boost::asio::post(
+                    context_,
+                    [onDisconnect = onDisconnect_]() {
+                        onDisconnect(
+                            StompClientError::kWebsocketServerDisconnected
+                        );
+                    }
+                );
+            }
+            return;
+        }
+        const auto delay {GetReconnectDelay(
+            policy,
+            reconnectAttempt_,
+            std::uniform_real_distribution<double> {0.0, 1.0}(random_)
+        )};
+        ++reconnectAttempt_;
+        spdlog::info("StompClient: Reconnect attempt {} in {} ms",
+                     reconnectAttempt_, delay.count());
+        boost::asio::post(
+            context_,
+            [this, delay]() {
+                if (closing_) {
+                    return;
+                }
+                reconnectTimer_.expires_after(delay);
+                reconnectTimer_.async_wait([this](auto ec) {
+                    if (!ec && !closing_) {
+                        ConnectWs();
+                    }
+                });
+            }
+        );
+    }
+
+    // A failed attempt while reconnecting is retried, instead of being
+    // reported to the user.
+    bool RetryReconnect()
+    {
+        if (!reconnecting_ || closing_) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock {statsMutex_};
+            ++stats_.nFailedAttempts;
+        }
+        ScheduleReconnect();
+        return true;
+    }
+
+    // Renew the active subscriptions on a new connection.
+    void Resubscribe()
+    {
+        for (const auto& [subscriptionId, subscription]: subscriptions_) {
+            spdlog::info("StompClient: Renewing subscription {} to {}",
+                         subscriptionId, subscription.destination);
+            StompError error {};
+            auto frame {MakeSubscribeFrame(
+                subscriptionId,
+                subscription.destination,
+                subscription.ackMode,
+                error
+            )};
+            if (error != StompError::kOk) {
+                spdlog::error("StompClient: Could not create a valid frame: {}",
+                              error);
+                continue;
+            }
+            SendWs(
+                std::move(frame),
+                [subscriptionId = subscriptionId](auto ec) {
+                    if (ec) {
+                        spdlog::error(
+                            "StompClient: Could not renew subscription {}: {}",
+                            subscriptionId, ec.message()
+                        );
+                    }
+                }
+            );
+        }
+    }
 
     void OnWsConnect(
         boost::system::error_code ec
@@ -360,10 +950,17 @@ private:
     {
         using Error = StompClientError;
 
+        // A new connection starts with no partial frame. We reset the parser
+        // here, as it only lives on the Websocket strand.
+        parser_.Reset();
+
         // We cannot continue if the connection was not established correctly.
         if (ec) {
             spdlog::error("StompClient: Could not connect to server: {}",
                           ec.message());
+            if (RetryReconnect()) {
+                return;
+            }
             if (onConnect_) {
                 boost::asio::post(
                     context_,
@@ -377,16 +974,17 @@ private:
 
         // Assemble and send the STOMP frame.
         StompError error {};
-        StompFrame frame {
-            error,
-            StompCommand::kStomp,
-            {
-                {StompHeader::kAcceptVersion, "1.2"},
-                {StompHeader::kHost, url_},
-                {StompHeader::kLogin, username_},
-                {StompHeader::kPasscode, password_},
-            }
-        };
+        StompFrameBuilder builder {StompCommand::kStomp};
+        builder
+            .AddHeader(StompHeader::kAcceptVersion, "1.2")
+            .AddHeader(StompHeader::kHost, url_)
+            .AddHeader(StompHeader::kLogin, username_)
+            .AddHeader(StompHeader::kPasscode, password_);
+        const auto heartBeat {ToString(heartBeat_)};
+        if (heartBeat_ != StompHeartBeat {}) {
+            builder.AddHeader(StompHeader::kHeartBeat, heartBeat);
+        }
+        auto frame {builder.Build(error)};
         if (error != StompError::kOk) {
             spdlog::error("StompClient: Could not create a valid frame: {}",
                           error);
@@ -400,8 +998,8 @@ private:
             }
             return;
         }
-        ws_.Send(
-            frame.ToString(),
+        SendWs(
+            std::move(frame),
             [this](auto ec) {
                 OnWsSendStomp(ec);
             }
@@ -418,6 +1016,9 @@ private:
         if (ec) {
             spdlog::error("StompClient: Could not send STOMP frame: {}",
                           ec.message());
+            if (RetryReconnect()) {
+                return;
+            }
             if (onConnect_) {
                 boost::asio::post(
                     context_,
@@ -466,9 +1067,15 @@ private:
         std::string&& msg
     )
     {
-        // Parse the message.
-        StompError error {};
-        StompFrame frame {error, std::move(msg)};
+        // Any message from the server counts as a heart-beat.
+        lastReadAt_ = GetTicks();
+
+        // Parse the message. It may complete any number of frames.
+        std::vector<StompFrame> frames {};
+        auto error {parser_.Parse(std::move(msg), frames)};
+        for (auto& frame: frames) {
+            HandleFrame(std::move(frame));
+        }
         if (error != StompError::kOk) {
             spdlog::error(
                 "StompClient: Could not parse message as STOMP frame: {}",
@@ -484,9 +1091,13 @@ private:
                     }
                 );
             }
-            return;
         }
+    }
 
+    void HandleFrame(
+        StompFrame&& frame
+    )
+    {
         // Decide what to do based on the STOMP command.
         spdlog::debug("StompClient: Received {}", frame.GetCommand());
         switch (frame.GetCommand()) {
@@ -503,7 +1114,7 @@ private:
                 break;
             }
             case StompCommand::kReceipt: {
-                HandleSubscriptionReceipt(std::move(frame));
+                HandleReceipt(std::move(frame));
                 break;
             }
             case StompCommand::kSend: {
@@ -522,9 +1133,34 @@ private:
         boost::system::error_code ec
     )
     {
-        // Notify the user.
         spdlog::info("StompClient: Websocket connection disconnected: {}",
                      ec.message());
+        StopHeartBeat();
+        ResetAcks();
+        boost::asio::post(
+            context_,
+            [this]() {
+                FailReceipts();
+            }
+        );
+
+        // Reconnect, if the user did not close the connection.
+        if (ec && reconnectPolicy_.enabled && !closing_) {
+            if (!reconnecting_) {
+                reconnecting_ = true;
+                reconnectAttempt_ = 0;
+                disconnectedAt_ = std::chrono::steady_clock::now();
+                std::lock_guard<std::mutex> lock {statsMutex_};
+                ++stats_.nDisconnections;
+            } else {
+                std::lock_guard<std::mutex> lock {statsMutex_};
+                ++stats_.nFailedAttempts;
+            }
+            ScheduleReconnect();
+            return;
+        }
+
+        // Notify the user.
         if (onDisconnect_) {
             auto error {ec ? StompClientError::kWebsocketServerDisconnected :
                              StompClientError::kOk};
@@ -542,6 +1178,10 @@ private:
         std::function<void (StompClientError)> onClose = nullptr
     )
     {
+        // We drop the subscriptions here, on the Websocket strand, where all
+        // the other accesses happen.
+        subscriptions_.clear();
+
         // Notify the user.
         if (onClose) {
             auto error {ec ?
@@ -561,6 +1201,40 @@ private:
         StompFrame&& frame
     )
     {
+        // Negotiate the heart-beat. A malformed header disables it.
+        StompError error {};
+        const auto remoteHeartBeat {ParseHeartBeat(
+            error,
+            frame.GetHeaderValue(StompHeader::kHeartBeat)
+        )};
+        if (error != StompError::kOk) {
+            spdlog::warn("StompClient: Invalid heart-beat from server: {}",
+                         frame.GetHeaderValue(StompHeader::kHeartBeat));
+        }
+        StartHeartBeat(NegotiateHeartBeat(heartBeat_, remoteHeartBeat));
+
+        // On a reconnection, we renew the subscriptions instead of notifying
+        // the user.
+        if (reconnecting_) {
+            reconnecting_ = false;
+            reconnectAttempt_ = 0;
+            awaitingFirstMessage_ = true;
+            const auto latency {
+                std::chrono::steady_clock::now() - disconnectedAt_
+            };
+            {
+                std::lock_guard<std::mutex> lock {statsMutex_};
+                ++stats_.nReconnections;
+                stats_.lastReconnectLatency = latency;
+            }
+            spdlog::info("StompClient: Reconnected to STOMP server in {} ms",
+                         std::chrono::duration_cast<
+                             std::chrono::milliseconds
+                         >(latency).count());
+            Resubscribe();
+            return;
+        }
+
         // Notify the user of the susccessful connection.
         spdlog::info("StompClient: Successfully connected to STOMP server");
         if (onConnect_) {
@@ -588,7 +1262,7 @@ private:
     {
         // Find the subscription.
         auto subscriptionId {frame.GetHeaderValue(StompHeader::kSubscription)};
-        auto subscriptionIt {subscriptions_.find(std::string(subscriptionId))};
+        auto subscriptionIt {subscriptions_.find(subscriptionId)};
         if (subscriptionIt == subscriptions_.end()) {
             spdlog::error("StompClient: Cannot find subscription {}",
                           subscriptionId);
@@ -615,39 +1289,313 @@ private:
             return;
         }
 
+        // Measure the gap in the data caused by the last disconnection.
+        if (reconnectPolicy_.enabled) {
+            const auto now {std::chrono::steady_clock::now()};
+            if (awaitingFirstMessage_) {
+                awaitingFirstMessage_ = false;
+                const auto gapStart {
+                    lastMessageAt_ == std::chrono::steady_clock::time_point {} ?
+                        disconnectedAt_ : lastMessageAt_
+                };
+                std::lock_guard<std::mutex> lock {statsMutex_};
+                stats_.lastGap = now - gapStart;
+                stats_.totalGap += stats_.lastGap;
+            }
+            lastMessageAt_ = now;
+        }
+
+        // The message is pending until its handler returns and we
+        // acknowledge it. Past the limit, we stop reading from the server, so
+        // that TCP pushes back on it until the handlers catch up.
+        // In auto mode there is nothing to acknowledge, so we do not copy the
+        // IDs out of the frame.
+        const auto ackMode {subscription.ackMode};
+        std::string ackId {};
+        std::string ackSubscriptionId {};
+        if (ackMode != StompClientAckMode::kAuto) {
+            ackId = frame.GetHeaderValue(StompHeader::kAck);
+            if (ackId.empty()) {
+                ackId = frame.GetHeaderValue(StompHeader::kMessageId);
+            }
+            ackSubscriptionId = subscriptionId;
+        }
+        const auto nUnacked {++unacked_};
+        if (ackPolicy_.maxUnacked > 0 && nUnacked >= ackPolicy_.maxUnacked &&
+            !ackPaused_.exchange(true)) {
+            spdlog::warn("StompClient: {} messages not acknowledged. "
+                         "Pausing reads", nUnacked);
+            PauseReading();
+        }
+
         // Send the message to the user handler.
-        if (subscription.onMessage) {
-            boost::asio::post(
-                context_,
-                [
-                    onMessage = subscription.onMessage,
-                    message = std::string(frame.GetBody())
-                ]() mutable {
+        boost::asio::post(
+            context_,
+            [
+                this,
+                onMessage = subscription.onMessage,
+                message = StompBody {frame},
+                session = ackSession_.load(),
+                subscriptionId = std::move(ackSubscriptionId),
+                ackMode,
+                ackId = std::move(ackId)
+            ]() mutable {
+                if (onMessage) {
                     onMessage(StompClientError::kOk, std::move(message));
                 }
+                QueueAck(session, subscriptionId, ackMode, std::move(ackId));
+            }
+        );
+    }
+
+    // Run on the context_ strand.
+    void QueueAck(
+        const size_t session,
+        const std::string& subscriptionId,
+        const StompClientAckMode ackMode,
+        std::string&& ackId
+    )
+    {
+        if (session != ackSession_) {
+            return;
+        }
+        if (ackMode == StompClientAckMode::kAuto || ackId.empty()) {
+            ReleaseUnacked(1);
+            return;
+        }
+        auto& acks {pendingAcks_[subscriptionId]};
+        acks.ackMode = ackMode;
+        acks.ackIds.push_back(std::move(ackId));
+        ++nPendingAcks_;
+
+        // While the reads are paused, we acknowledge as soon as possible.
+        if (nPendingAcks_ >= ackPolicy_.batchSize || ackPaused_) {
+            FlushAcks();
+            return;
+        }
+        if (!ackTimerArmed_) {
+            ackTimerArmed_ = true;
+            ackTimer_.expires_after(ackPolicy_.batchDelay);
+            ackTimer_.async_wait([this](auto ec) {
+                if (ec) {
+                    return;
+                }
+                ackTimerArmed_ = false;
+                FlushAcks();
+            });
+        }
+    }
+
+    // Run on the context_ strand.
+    // All the pending ACK frames go out in a single Websocket message. In
+    // client mode, one ACK for the last message covers the previous ones.
+    void FlushAcks()
+    {
+        if (ackTimerArmed_) {
+            ackTimerArmed_ = false;
+            ackTimer_.cancel();
+        }
+        if (nPendingAcks_ == 0) {
+            return;
+        }
+        std::string batch {};
+        for (auto& [subscriptionId, acks]: pendingAcks_) {
+            if (acks.ackIds.empty()) {
+                continue;
+            }
+            const size_t first {acks.ackMode == StompClientAckMode::kClient ?
+                acks.ackIds.size() - 1 : 0};
+            for (size_t idx {first}; idx < acks.ackIds.size(); ++idx) {
+                auto error {StompFrameBuilder {StompCommand::kAck}
+                    .AddHeader(StompHeader::kId, acks.ackIds[idx])
+                    .WriteTo(batch)};
+                if (error != StompError::kOk) {
+                    spdlog::error("StompClient: Could not create a valid "
+                                  "ACK frame: {}", error);
+                }
+            }
+            acks.ackIds.clear();
+        }
+        const auto nAcked {nPendingAcks_};
+        nPendingAcks_ = 0;
+        if (!batch.empty()) {
+            SendWs(std::move(batch), [](auto ec) {
+                if (ec) {
+                    spdlog::error("StompClient: Could not send ACK: {}",
+                                  ec.message());
+                }
+            });
+        }
+        ReleaseUnacked(nAcked);
+    }
+
+    // We resume the reads at half of the limit, so that we do not pause again
+    // on the very next message.
+    void ReleaseUnacked(
+        const size_t n
+    )
+    {
+        const auto nUnacked {unacked_ -= n};
+        if (ackPolicy_.maxUnacked > 0 &&
+            nUnacked <= ackPolicy_.maxUnacked / 2 &&
+            ackPaused_.exchange(false)) {
+            spdlog::info("StompClient: Resuming reads");
+            ResumeReading();
+        }
+    }
+
+    // The server sends again the messages that we did not acknowledge before
+    // a disconnection.
+    void ResetAcks()
+    {
+        ++ackSession_;
+        boost::asio::post(
+            context_,
+            [this]() {
+                if (ackTimerArmed_) {
+                    ackTimerArmed_ = false;
+                    ackTimer_.cancel();
+                }
+                pendingAcks_.clear();
+                nPendingAcks_ = 0;
+                unacked_ = 0;
+                if (ackPaused_.exchange(false)) {
+                    ResumeReading();
+                }
+            }
+        );
+    }
+
+    // Run on the context_ strand.
+    void TrackReceipt(
+        const std::string& requestId,
+        std::function<void (
+            StompClientError,
+            std::string&&,
+            std::chrono::steady_clock::duration
+        )>&& onReceipt,
+        const std::chrono::steady_clock::time_point sentAt
+    )
+    {
+        pendingReceipts_[requestId] = {std::move(onReceipt), sentAt};
+        receiptWheel_.Schedule(requestId, sentAt + receiptTimeout_);
+        if (!receiptTimerArmed_) {
+            receiptTimerArmed_ = true;
+            WaitReceipts();
+        }
+    }
+
+    // Run on the context_ strand.
+    void WaitReceipts()
+    {
+        receiptTimer_.expires_after(kReceiptTick);
+        receiptTimer_.async_wait([this](auto ec) {
+            if (ec) {
+                return;
+            }
+            std::vector<std::string> expired {};
+            receiptWheel_.Advance(std::chrono::steady_clock::now(), expired);
+            for (const auto& requestId: expired) {
+                spdlog::warn("StompClient: No receipt for {} after {} ms",
+                             requestId, receiptTimeout_.count());
+                CompleteReceipt(requestId, StompClientError::kReceiptTimeout);
+            }
+            if (receiptWheel_.Empty()) {
+                receiptTimerArmed_ = false;
+                return;
+            }
+            WaitReceipts();
+        });
+    }
+
+    // Run on the context_ strand.
+    void CompleteReceipt(
+        std::string_view requestId,
+        const StompClientError error,
+        const std::chrono::steady_clock::time_point completedAt =
+            std::chrono::steady_clock::now()
+    )
+    {
+        auto receiptIt {pendingReceipts_.find(requestId)};
+        if (receiptIt == pendingReceipts_.end()) {
+            // This may be the late receipt of a message that timed out.
+            spdlog::warn("StompClient: Unexpected receipt {}", requestId);
+            return;
+        }
+        // We take the node out of the map, so the ID goes to the user without
+        // a copy.
+        auto node {pendingReceipts_.extract(receiptIt)};
+        auto& receipt {node.mapped()};
+        receiptWheel_.Cancel(node.key());
+        const auto rtt {completedAt - receipt.sentAt};
+        {
+            std::lock_guard<std::mutex> lock {statsMutex_};
+            if (error == StompClientError::kOk) {
+                ++receiptStats_.nReceipts;
+                receiptStats_.lastRtt = rtt;
+                receiptStats_.maxRtt = std::max(receiptStats_.maxRtt, rtt);
+                receiptStats_.totalRtt += rtt;
+            } else if (error == StompClientError::kReceiptTimeout) {
+                ++receiptStats_.nTimeouts;
+            }
+        }
+        receipt.onReceipt(error, std::move(node.key()), rtt);
+    }
+
+    // Run on the context_ strand.
+    // The receipts cannot arrive once the connection is gone.
+    void FailReceipts()
+    {
+        receiptTimerArmed_ = false;
+        receiptTimer_.cancel();
+        receiptWheel_.Clear();
+        auto receipts {std::move(pendingReceipts_)};
+        pendingReceipts_.clear();
+        const auto now {std::chrono::steady_clock::now()};
+        for (auto& [requestId, receipt]: receipts) {
+            receipt.onReceipt(
+                StompClientError::kWebsocketServerDisconnected,
+                std::string(requestId),
+                now - receipt.sentAt
             );
         }
     }
 
-    void HandleSubscriptionReceipt(
+    // A receipt is either for a subscription or for a sent message.
+    void HandleReceipt(
         StompFrame&& frame
     )
     {
-        // Find the subscription.
-        // When we send the SUBSCRIBE frame, we request a receipt with the same
-        // ID of the subscription so that it's easier to retrieve it here.
-        auto subscriptionId {frame.GetHeaderValue(StompHeader::kReceiptId)};
-        auto subscriptionIt {subscriptions_.find(std::string(subscriptionId))};
-        if (subscriptionIt == subscriptions_.end()) {
-            spdlog::error("StompClient: Cannot find subscription {}",
-                          subscriptionId);
+        const auto receivedAt {std::chrono::steady_clock::now()};
+        auto receiptId {frame.GetHeaderValue(StompHeader::kReceiptId)};
+        auto subscriptionIt {subscriptions_.find(receiptId)};
+        if (subscriptionIt != subscriptions_.end()) {
+            HandleSubscriptionReceipt(subscriptionIt->second,
+                                      subscriptionIt->first);
             return;
         }
-        const auto& subscription {subscriptionIt->second};
+        boost::asio::post(
+            context_,
+            [this, receiptId = std::string(receiptId), receivedAt]() {
+                CompleteReceipt(receiptId, StompClientError::kOk, receivedAt);
+            }
+        );
+    }
 
+    // When we send the SUBSCRIBE frame, we request a receipt with the same ID
+    // of the subscription so that it's easier to retrieve it here.
+    void HandleSubscriptionReceipt(
+        Subscription& subscription,
+        const std::string& subscriptionId
+    )
+    {
         // Notify the user of the susccessful subscription.
         spdlog::info("StompClient: Successfully subscribed to {}",
                      subscriptionId);
+        if (subscription.confirmed) {
+            return;
+        }
+        subscription.confirmed = true;
         if (subscription.onSubscribe) {
             boost::asio::post(
                 context_,
@@ -675,7 +1623,7 @@ private:
                     destination = std::string(frame.GetHeaderValue(
                         StompHeader::kDestination
                     )),
-                    message = std::string(frame.GetBody())
+                    message = StompBody {frame}
                 ]() mutable {
                     onMessage(
                         StompClientError::kOk,
@@ -689,9 +1637,7 @@ private:
 
     std::string GenerateId()
     {
-        std::stringstream ss {};
-        ss << boost::uuids::random_generator()();
-        return ss.str();
+        return ids_.Generate();
     }
 };
 
@@ -1,10 +1,15 @@
 #ifndef NETWORK_MONITOR_STOMP_FRAME_H
 #define NETWORK_MONITOR_STOMP_FRAME_H
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace NetworkMonitor {
 
@@ -37,6 +42,10 @@ std::ostream& operator<<(std::ostream& os, const StompCommand& command);
  */
 std::string ToString(const StompCommand& command);
 
+/*! \brief Get the `StompCommand` name without allocating a string.
+ */
+std::string_view ToStringView(const StompCommand& command);
+
 /*! \brief Available STOMP headers, from the STOMP protocol v1.2.
  */
 enum class StompHeader {
@@ -62,6 +71,14 @@ enum class StompHeader {
     kVersion,
 };
 
+/*! \brief Number of values in the `StompHeader` enum, including `kInvalid`.
+ *
+ *  \note Keep this in sync with the last value of the `StompHeader` enum.
+ */
+constexpr size_t kStompHeaderCount {
+    static_cast<size_t>(StompHeader::kVersion) + 1
+};
+
 /*! \brief Print operator for the `StompHeader` class.
  */
 std::ostream& operator<<(std::ostream& os, const StompHeader& header);
@@ -70,6 +87,10 @@ std::ostream& operator<<(std::ostream& os, const StompHeader& header);
  */
 std::string ToString(const StompHeader& header);
 
+/*! \brief Get the `StompHeader` name without allocating a string.
+ */
+std::string_view ToStringView(const StompHeader& header);
+
 /*! \brief Error codes for the STOMP protocol
  *
  * The error codes in this enum cover:
@@ -83,7 +104,9 @@ enum class StompError {
     kUndefinedError,
     kParsingEmptyHeaderValue,
     kParsingContentLengthExceedsFrameLength,
+    kParsingFrameTooLarge,
     kParsingInvalidContentLength,
+    kParsingInvalidHeaderEscape,
     kParsingJunkAfterBody,
     kParsingMissingBlankLineAfterHeaders,
     kParsingMissingColonInHeader,
@@ -95,7 +118,9 @@ enum class StompError {
     kValidationContentLengthMismatch,
     kValidationInvalidCommand,
     kValidationInvalidContentLength,
+    kValidationInvalidHeaderValue,
     kValidationMissingHeader,
+    kValidationUnexpectedNullInBody,
 };
 
 /*! \brief Print operator for the `StompError` class.
@@ -107,11 +132,19 @@ std::ostream& operator<<(std::ostream& os, const StompError& error);
 std::string ToString(const StompError& error);
 
 /* \brief STOMP frame representation, supporting STOMP v1.2.
+ *
+ *  The plain-text frame is stored in an immutable, reference-counted buffer.
+ *  The command, header values and body are views into that buffer. Copying a
+ *  frame shares the buffer: It does not copy the frame content or parse it
+ *  again.
  */
 class StompFrame {
 public:
     // Type aliases
-    using Headers = std::unordered_map<StompHeader, std::string_view>;
+    // Headers are stored in a fixed slot per `StompHeader` value. A bit in the
+    // header mask records whether the slot is set.
+    using Headers = std::array<std::string_view, kStompHeaderCount>;
+    using HeaderMask = uint32_t;
 
     /*! \brief Default constructor. Corresponds to an empty, invalid STOMP
      *         frame.
@@ -137,6 +170,32 @@ public:
         std::string&& frame
     );
 
+    /*! \brief Construct the STOMP frame from a shared plain-text buffer. The
+     *         buffer is not copied.
+     *
+     *  The result of the operation is stored in the error code.
+     */
+    StompFrame(
+        StompError& ec,
+        std::shared_ptr<const std::string> frame
+    );
+
+    /*! \brief Construct the STOMP frame from a slice of a shared plain-text
+     *         buffer. The buffer is not copied.
+     *
+     *  Use this for frames received in a batch: All frames share the batch
+     *  buffer.
+     *
+     *  \param frame A view into buffer.
+     *
+     *  The result of the operation is stored in the error code.
+     */
+    StompFrame(
+        StompError& ec,
+        std::shared_ptr<const std::string> buffer,
+        const std::string_view frame
+    );
+
     /*! \brief Construct the STOMP frame from its individual components.
      */
     StompFrame(
@@ -146,7 +205,7 @@ public:
         const std::string& body = ""
     );
 
-    /*! \brief Copy constructor.
+    /*! \brief Copy constructor. The copy shares the frame buffer.
      */
     StompFrame(const StompFrame& other);
 
@@ -154,7 +213,7 @@ public:
      */
     StompFrame(StompFrame&& other);
 
-    /*! \brief Copy assignment operator.
+    /*! \brief Copy assignment operator. The copy shares the frame buffer.
      */
     StompFrame& operator=(const StompFrame& other);
 
@@ -184,13 +243,32 @@ public:
      */
     std::string ToString() const;
 
+    /*! \brief Get the shared plain-text frame buffer.
+     *
+     *  Use this to pass the same frame to multiple consumers without copying
+     *  it. For a frame received in a batch, the buffer also holds the other
+     *  frames of the batch; use ToString() to get this frame alone.
+     *
+     *  \returns nullptr for a default-constructed frame.
+     */
+    std::shared_ptr<const std::string> GetBuffer() const;
+
 private:
-    std::string plain_ {};
+    std::shared_ptr<const std::string> plain_ {nullptr};
+
+    // The frame inside plain_. This is all of plain_, unless the frame was
+    // received in a batch.
+    std::string_view frame_ {};
+
+    // Decoded values of the headers that use escape sequences. It is only
+    // allocated if the frame has any.
+    std::shared_ptr<const std::string> escaped_ {nullptr};
 
     // These are mostly views into the plain data; the storage overhead is
     // limited.
     StompCommand command_ {StompCommand::kInvalid};
     Headers headers_ {};
+    HeaderMask headerMask_ {0};
     std::string_view body_ {};
 
     // Helper function to parse and validate a STOMP frame.
@@ -205,6 +283,225 @@ private:
     StompError ValidateFrame();
 };
 
+/*! \brief A STOMP frame body that keeps the frame buffer alive.
+ *
+ *  Use it to hand a received body to a user callback without copying it. The
+ *  body shares the plain-text buffer of the frame it comes from, which is
+ *  released when the last frame or body that refers to it goes away.
+ */
+class StompBody {
+public:
+    /*! \brief Default constructor. The body is empty.
+     */
+    StompBody() = default;
+
+    /*! \brief Construct the body of a STOMP frame. The frame buffer is shared,
+     *         not copied.
+     */
+    explicit StompBody(const StompFrame& frame);
+
+    /*! \brief Get a view of the body.
+     *
+     *  The view is valid for as long as this object, or a copy of it, is in
+     *  scope.
+     */
+    const std::string_view& GetView() const;
+
+    /*! \brief Get the body size.
+     */
+    size_t GetSize() const;
+
+    /*! \brief Get a view of the body.
+     */
+    operator std::string_view() const;
+
+private:
+    std::shared_ptr<const std::string> buffer_ {nullptr};
+    std::string_view view_ {};
+};
+
+/*! \brief Compare the content of a STOMP frame body.
+ */
+bool operator==(const StompBody& body, const std::string_view other);
+
+/*! \brief Compare the content of a STOMP frame body.
+ */
+bool operator!=(const StompBody& body, const std::string_view other);
+
+/*! \brief Print the content of a STOMP frame body.
+ */
+std::ostream& operator<<(std::ostream& os, const StompBody& body);
+
+/*! \brief Write a STOMP frame from its individual components straight into a
+ *         caller buffer.
+ *
+ *  The builder computes the exact frame size up front and validates the frame
+ *  components directly, so the frame is never parsed back. Use it for
+ *  outbound frames, which are only ever sent as plain text.
+ *
+ *  Headers are written in the order they are added. If a header is added
+ *  more than once, only the first value is kept.
+ *
+ *  \note The builder stores views into the header values and body. The caller
+ *        must keep them in scope until the frame is written.
+ */
+class StompFrameBuilder {
+public:
+    /*! \brief Start building a frame for a STOMP command.
+     */
+    explicit StompFrameBuilder(
+        const StompCommand& command
+    );
+
+    /*! \brief Add a header to the frame.
+     */
+    StompFrameBuilder& AddHeader(
+        const StompHeader& header,
+        const std::string_view value
+    );
+
+    /*! \brief Set the frame body.
+     */
+    StompFrameBuilder& SetBody(
+        const std::string_view body
+    );
+
+    /*! \brief Set a frame body that is serialized straight into the frame
+     *         buffer.
+     *
+     *  \param bodySize     The exact size of the body, in bytes.
+     *  \param writeBody    Called with the frame buffer, positioned right after
+     *                      the frame headers. It must append exactly
+     *                      `bodySize` bytes to the buffer.
+     */
+    StompFrameBuilder& SetBody(
+        const size_t bodySize,
+        std::function<void (std::string&)> writeBody
+    );
+
+    /*! \brief Check the frame components against the protocol requirements.
+     */
+    StompError Validate() const;
+
+    /*! \brief Get the exact size of the frame, including the NULL octet.
+     */
+    size_t GetSize() const;
+
+    /*! \brief Append the frame to a buffer.
+     *
+     *  Pass a cleared buffer from a previous frame to reuse its memory. The
+     *  buffer is left unchanged if the frame is not valid.
+     */
+    StompError WriteTo(
+        std::string& buffer
+    ) const;
+
+    /*! \brief Write the frame to a new string.
+     *
+     *  \returns An empty string if the frame is not valid. The result of the
+     *           operation is stored in the error code.
+     */
+    std::string Build(
+        StompError& ec
+    ) const;
+
+private:
+    using HeaderMask = StompFrame::HeaderMask;
+
+    StompCommand command_ {StompCommand::kInvalid};
+    StompFrame::Headers headers_ {};
+    HeaderMask headerMask_ {0};
+    std::array<StompHeader, kStompHeaderCount> headerOrder_ {};
+    size_t nHeaders_ {0};
+    std::string_view body_ {};
+    size_t bodySize_ {0};
+    std::function<void (std::string&)> writeBody_ {nullptr};
+};
+
+/*! \brief Extract STOMP frames from a stream of data chunks.
+ *
+ *  The chunks can have any size. A chunk may hold part of a frame, exactly one
+ *  frame, or several frames. Partial frames are kept across chunks. EOLs
+ *  between frames, which STOMP uses as heart-beats, are skipped.
+ *
+ *  A frame ends at the NULL octet after its body. If the frame has a
+ *  content-length header, the parser skips the specified number of body bytes
+ *  to find it.
+ *
+ *  The parser can be given a maximum frame size, so that a peer cannot make
+ *  it buffer an endless partial frame.
+ */
+class StompFrameParser {
+public:
+    /*! \brief Limit the size of a frame, including its command, headers and
+     *         NULL octet.
+     *
+     *  A frame, or a partial frame, that goes over the limit fails with
+     *  StompError::kParsingFrameTooLarge. A frame whose content-length header
+     *  goes over the limit fails as soon as its headers are complete.
+     *
+     *  \param maxFrameSize The limit in bytes. The default, 0, means no limit.
+     */
+    void SetMaxFrameSize(
+        const size_t maxFrameSize
+    );
+
+    /*! \brief Add a chunk of data and extract all the frames it completes.
+     *
+     *  The complete frames are appended to `frames`, in order. On a parsing
+     *  error, the frames before the invalid one are still appended, and all
+     *  buffered data is discarded.
+     */
+    StompError Parse(
+        const std::string_view chunk,
+        std::vector<StompFrame>& frames
+    );
+
+    /*! \brief Add a chunk of data and extract all the frames it completes.
+     *
+     *  If nothing is buffered and the chunk holds exactly one frame, the chunk
+     *  is moved into the frame without copying it.
+     */
+    StompError Parse(
+        std::string&& chunk,
+        std::vector<StompFrame>& frames
+    );
+
+    /*! \brief Discard all buffered data.
+     */
+    void Reset();
+
+    /*! \brief Get the number of bytes buffered for the next partial frame.
+     */
+    size_t GetBufferedSize() const;
+
+private:
+    std::string buffer_ {};
+    size_t maxFrameSize_ {0};
+
+    // State of the next frame. Positions are relative to the frame start. We
+    // keep them across chunks, so that we never scan the same bytes twice.
+    size_t commandEnd_ {std::string::npos};
+    size_t headersSearchFrom_ {0};
+    size_t headersEnd_ {std::string::npos};
+    size_t bodyEnd_ {std::string::npos};
+    size_t nullSearchFrom_ {0};
+
+    StompError ParseBuffer(std::vector<StompFrame>& frames);
+
+    StompError FindFrameEnd(
+        const size_t frameStart,
+        size_t& frameEnd
+    );
+
+    bool IsFrameTooLarge(
+        const size_t frameStart,
+        const size_t frameEnd
+    ) const;
+
+    void ResetFrameState();
+};
+
 } // namespace NetworkMonitor
 
 #endif // NETWORK_MONITOR_STOMP_FRAME_H
\ No newline at end of file
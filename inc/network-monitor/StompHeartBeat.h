@@ -0,0 +1,82 @@
+#ifndef NETWORK_MONITOR_STOMP_HEART_BEAT_H
+#define NETWORK_MONITOR_STOMP_HEART_BEAT_H
+
+#include <network-monitor/StompFrame.h>
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace NetworkMonitor {
+
+/*! \brief STOMP heart-beat intervals, as in the `heart-beat` header.
+ *
+ *  - send: We can send a heart-beat at least every `send` ms.
+ *  - receive: We want to receive a heart-beat every `receive` ms.
+ *
+ *  0 means that we cannot send, or do not want to receive, heart-beats.
+ */
+struct StompHeartBeat {
+    std::chrono::milliseconds send {0};
+    std::chrono::milliseconds receive {0};
+};
+
+/*! \brief A peer is considered dead after this many receive intervals without
+ *         any data from it.
+ */
+constexpr int kStompHeartBeatGraceFactor {2};
+
+/*! \brief Equality operator for the StompHeartBeat class.
+ */
+bool operator==(const StompHeartBeat& lhs, const StompHeartBeat& rhs);
+
+/*! \brief Inequality operator for the StompHeartBeat class.
+ */
+bool operator!=(const StompHeartBeat& lhs, const StompHeartBeat& rhs);
+
+/*! \brief Print operator for the StompHeartBeat class.
+ */
+std::ostream& operator<<(std::ostream& os, const StompHeartBeat& heartBeat);
+
+/*! \brief Convert StompHeartBeat to a `heart-beat` header value.
+ */
+std::string ToString(const StompHeartBeat& heartBeat);
+
+/*! \brief Parse a `heart-beat` header value, in the form `<send>,<receive>`.
+ *
+ *  An empty value is the same as a missing header, which means `0,0`.
+ *
+ *  \param error On a malformed value, this is set to
+ *               StompError::kValidationInvalidHeaderValue.
+ */
+StompHeartBeat ParseHeartBeat(StompError& error, std::string_view value);
+
+/*! \brief Negotiate the heart-beat intervals with a peer.
+ *
+ *  \param local  Our own heart-beat settings.
+ *  \param remote The heart-beat settings that the peer sent us.
+ *
+ *  \returns The intervals at which we must send heart-beats and we expect to
+ *  receive them. 0 means that the heart-beat is disabled in that direction.
+ */
+StompHeartBeat NegotiateHeartBeat(
+    const StompHeartBeat& local,
+    const StompHeartBeat& remote
+);
+
+/*! \brief Get the interval of a timer that checks the heart-beats.
+ *
+ *  The timer runs at half of the shortest interval, so that a heart-beat is
+ *  never sent late and a dead peer is detected within
+ *  kStompHeartBeatGraceFactor receive intervals, plus one timer interval.
+ *
+ *  \returns 0 if the heart-beat is disabled in both directions.
+ */
+std::chrono::milliseconds GetHeartBeatCheckInterval(
+    const StompHeartBeat& heartBeat
+);
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_STOMP_HEART_BEAT_H
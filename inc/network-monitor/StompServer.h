@@ -1,24 +1,32 @@
 #ifndef NETWORK_MONITOR_STOMP_SERVER_H
 #define NETWORK_MONITOR_STOMP_SERVER_H
 
+#include <network-monitor/IdGenerator.h>
 #include <network-monitor/StompFrame.h>
+#include <network-monitor/StompHeartBeat.h>
+#include <network-monitor/WebsocketCompression.h>
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
-#include <boost/uuid/uuid.hpp>
-#include <boost/uuid/uuid_generators.hpp>
-#include <boost/uuid/uuid_io.hpp>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ostr.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <ostream>
-#include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace NetworkMonitor {
 
@@ -32,8 +40,17 @@ enum class StompServerError {
     kCouldNotParseFrame,
     kCouldNotSendMessage,
     kCouldNotStartWebsocketServer,
+    kFrameTooLarge,
+    kHeartBeatTimeout,
     kInvalidHeaderValueAcceptVersion,
+    kInvalidHeaderValueAck,
+    kInvalidHeaderValueHeartBeat,
     kInvalidHeaderValueHost,
+    kSendRateExceeded,
+    kServerBusy,
+    kSubscriptionIdInUse,
+    kTooManyConnections,
+    kUnrecognizedSubscription,
     kUnsupportedFrame,
     kWebsocketSessionDisconnected,
     kWebsocketServerDisconnected,
@@ -47,9 +64,47 @@ std::ostream& operator<<(std::ostream& os, const StompServerError& m);
  */
 std::string ToString(const StompServerError& m);
 
+/*! \brief Admission limits of the STOMP server.
+ *
+ *  A value of 0 disables a limit.
+ */
+struct StompServerLimits {
+    // Websocket connections open at the same time, STOMP or pending.
+    size_t maxConnections {0};
+
+    // SEND frames per second and per connection, with bursts of up to
+    // sendBurst frames. Each connection has its own token bucket. A burst of
+    // 0 is the same as a burst of 1. A client that sends faster breaks the
+    // contract, so it is closed with StompServerError::kSendRateExceeded.
+    double sendRate {0.0};
+    size_t sendBurst {1};
+
+    // Bytes of a single frame sent by a client, including a partial frame
+    // that is still growing. The client is closed with
+    // StompServerError::kFrameTooLarge.
+    size_t maxFrameSize {1024 * 1024};
+};
+
+/*! \brief Metrics of the connections and frames rejected by the STOMP server.
+ */
+struct StompServerAdmissionStats {
+    size_t nRejectedConnections {0};
+    size_t nRateLimitedFrames {0};
+};
+
 /*! \brief STOMP server implementing the subset of commands needed by the
  *         quiet-route service.
  *
+ *  Clients can send requests with SEND frames and subscribe to destinations
+ *  with SUBSCRIBE frames. Only the `auto` acknowledgement mode is supported.
+ *
+ *  The server can run on an io_context with many threads. Send, Publish and
+ *  Close can be called from any thread.
+ *
+ *  The server rejects the connections over `StompServerLimits::maxConnections`
+ *  and closes the clients that send faster than their token bucket allows. A
+ *  rejected client receives an ERROR frame, then the connection is closed.
+ *
  *  \tparam WsServer    Websocket server class. This type must have the same
  *                      interface of `WebsocketServer`.
  */
@@ -77,9 +132,9 @@ public:
      *  - The message destination endpoint.
      *  - The message request ID (optional, non-standard). The user may re-use
      *    this request ID to send a response back to the client.
-     *  - The message content.
-     *  Owenship of the message content is passed to the caller. The assumption is
-     *  that the message content type is application/json.
+     *  - The message content. It shares the received frame buffer and is never
+     *    copied.
+     *  The assumption is that the message content type is application/json.
      */
     using ClientMsgHandler = std::function<
         void (
@@ -87,7 +142,22 @@ public:
             const std::string& clientConnectionId,
             const std::string& destination,
             const std::string& requestId,
-            std::string&& msgContent
+            StompBody&& msgContent
+        )
+    >;
+
+    /*! \brief Subscription callback type for a connection, with an attached
+     *         error code.
+     *
+     *  The user receives:
+     *  - The ID of the connection that subscribed or unsubscribed.
+     *  - The subscription destination.
+     */
+    using ClientSubscriptionHandler = std::function<
+        void (
+            StompServerError ec,
+            const std::string& clientConnectionId,
+            const std::string& destination
         )
     >;
 
@@ -103,16 +173,20 @@ public:
      *  \param ioc  The io_context object. The user takes care of calling
      *              ioc.run().
      *  \param ctx  The TLS context to setup a TLS socket stream.
+     *  \param idMode How to generate the connection and request IDs.
      */
     StompServer(
         const std::string& host,
         const std::string& ip,
         const unsigned short port,
         boost::asio::io_context& ioc,
-        boost::asio::ssl::context& ctx
+        boost::asio::ssl::context& ctx,
+        const IdGeneratorMode idMode = IdGeneratorMode::kRandomUuid
     ) : kHost_ {host},
         ws_ {ip, port, ioc, ctx},
-        context_ {boost::asio::make_strand(ioc)}
+        context_ {boost::asio::make_strand(ioc)},
+        ids_ {idMode},
+        heartBeatTimer_ {context_}
     {
         spdlog::info("StompServer: New server on port {}", port);
     }
@@ -133,6 +207,59 @@ public:
      */
     StompServer& operator=(StompServer&& other) = default;
 
+    /*! \brief Set the heart-beat intervals to offer to the clients.
+     *
+     *  The intervals are negotiated with each client when it connects. One
+     *  timer for the whole server sends the heart-beats and checks the
+     *  clients. A client that goes silent for longer than
+     *  kStompHeartBeatGraceFactor receive intervals is disconnected with
+     *  StompServerError::kHeartBeatTimeout.
+     *
+     *  \note Call this before Run. By default, heart-beating is disabled.
+     */
+    void SetHeartBeat(
+        const StompHeartBeat& heartBeat
+    )
+    {
+        heartBeat_ = heartBeat;
+    }
+
+    /*! \brief Accept the Websocket permessage-deflate extension if a client
+     *         offers it.
+     *
+     *  \note Call this before Run. By default, compression is disabled.
+     */
+    void SetCompression(
+        const WebsocketCompressionOptions& options
+    )
+    {
+        ws_.SetCompression(options);
+    }
+
+    /*! \brief Set the admission limits.
+     *
+     *  The frame size limit also applies before the client is connected.
+     *
+     *  \note Call this before Run. By default, only the frame size is limited.
+     */
+    void SetLimits(
+        const StompServerLimits& limits
+    )
+    {
+        limits_ = limits;
+        limits_.sendBurst = std::max<size_t>(limits_.sendBurst, 1);
+    }
+
+    /*! \brief Get the number of connections and frames rejected so far.
+     *
+     *  This function can be called from any thread.
+     */
+    StompServerAdmissionStats GetAdmissionStats()
+    {
+        std::lock_guard<std::mutex> lock {connectionsMutex_};
+        return admissionStats_;
+    }
+
     /*! \brief Start the STOMP server.
      *
      *  This method starts the Websocket server. Every new incoming connection
@@ -158,6 +285,12 @@ public:
      *  \param onDisconnect         Called when the STOMP server itself is
      *                              disconnected. All connected clients are
      *                              disconnected automatically.
+     *  \param onClientSubscribe    Called when a connected STOMP client
+     *                              subscribes to a destination.
+     *  \param onClientUnsubscribe  Called when a subscription ends, because
+     *                              the client unsubscribed or because its
+     *                              connection was closed. The error code is
+     *                              kOk for an UNSUBSCRIBE frame.
      *
      *  All handlers run in a separate I/O execution context from the Websocket
      *  one.
@@ -166,13 +299,17 @@ public:
         ClientHandler onClientConnect = nullptr,
         ClientMsgHandler onClientMessage = nullptr,
         ClientHandler onClientDisconnect = nullptr,
-        ServerHandler onDisconnect = nullptr
+        ServerHandler onDisconnect = nullptr,
+        ClientSubscriptionHandler onClientSubscribe = nullptr,
+        ClientSubscriptionHandler onClientUnsubscribe = nullptr
     )
     {
         onClientConnect_ = onClientConnect;
         onClientMessage_ = onClientMessage;
         onClientDisconnect_ = onClientDisconnect;
         onDisconnect_ = onDisconnect;
+        onClientSubscribe_ = onClientSubscribe;
+        onClientUnsubscribe_ = onClientUnsubscribe;
         auto ec {ws_.Run(
             [this](auto ec, auto wsSession) {
                 OnWsSessionConnect(ec, wsSession);
@@ -193,6 +330,15 @@ public:
             return StompServerError::kCouldNotStartWebsocketServer;
         } else {
             spdlog::info("StompServer: Websocket server started");
+            if (GetHeartBeatCheckInterval(heartBeat_).count() > 0) {
+                boost::asio::post(
+                    context_,
+                    [this]() {
+                        sweeping_ = true;
+                        WaitHeartBeats();
+                    }
+                );
+            }
             return StompServerError::kOk;
         }
     }
@@ -233,52 +379,103 @@ public:
         const std::string& userRequestId = ""
     )
     {
-        // The connection should exist to begin with.
-        auto sessionIt {sessions_.find(connectionId)};
-        if (sessionIt == sessions_.end()) {
-            spdlog::error("StompServer: Unrecognized STOMP connection: {}",
-                          connectionId);
+        auto wsSession {GetConnectedSession(connectionId)};
+        if (wsSession == nullptr) {
             return "";
         }
-        auto& wsSession {sessionIt->second};
-        auto connectionIt {connections_.find(wsSession)};
-        if (connectionIt == connections_.end()) {
-            spdlog::error("StompServer: Unrecognized Websocket connection: {}",
-                          wsSession);
-            // Close the Websocket connection here, as this is not a
-            // valid STOMP connection.
-            wsSession->Close();
+
+        auto requestId {userRequestId.empty() ? GenerateId() : userRequestId};
+        const auto contentLength {std::to_string(messageContent.size())};
+
+        // Assemble the SEND frame.
+        StompError error {};
+        auto frame {StompFrameBuilder {StompCommand::kSend}
+            .AddHeader(StompHeader::kId, requestId)
+            .AddHeader(StompHeader::kDestination, destination)
+            .AddHeader(StompHeader::kContentType, "application/json")
+            .AddHeader(StompHeader::kContentLength, contentLength)
+            .SetBody(messageContent)
+            .Build(error)
+        };
+        if (error != StompError::kOk) {
+            spdlog::error("StompServer: Could not create a valid frame: {}",
+                          error);
             return "";
         }
-        const auto& connection {connectionIt->second};
 
-        // The client must be connected.
-        if (connection.status != ConnectionStatus::kConnected) {
-            spdlog::error("StompServer: [{}] Could not send message: "
-                          "STOMP not yet connected",
-                          connectionId);
+        // Send the Websocket message.
+        spdlog::info("StompServer: [{}] Sending message to {}",
+                     connectionId, destination);
+        if (onSend == nullptr) {
+            wsSession->Send(std::move(frame));
+        } else {
+            wsSession->Send(
+                std::move(frame),
+                [this, requestId, onSend](auto ec) mutable {
+                    auto error {ec ? StompServerError::kCouldNotSendMessage :
+                                     StompServerError::kOk};
+                    boost::asio::post(
+                        context_,
+                        [onSend, error, requestId]() mutable {
+                            onSend(error, std::move(requestId));
+                        }
+                    );
+                }
+            );
+        }
+        return requestId;
+    }
+
+    /*! \brief Send a JSON message to a connected STOMP client, serializing the
+     *         message content straight into the outbound frame.
+     *
+     *  This overload does not need the message content as a separate string.
+     *  The frame headers are written first, then `writeMessage` appends the
+     *  message content right after them, in the same buffer that is sent over
+     *  the Websocket connection.
+     *
+     *  \returns The request ID. If empty, we failed to send the message.
+     *
+     *  \param messageSize      The exact size of the message content, in bytes.
+     *  \param writeMessage     Called once with the frame buffer, positioned
+     *                          right after the frame headers. It must append
+     *                          exactly `messageSize` bytes to the buffer.
+     *
+     *  All other parameters are the same as in the `Send` overload that takes
+     *  the message content as a string.
+     */
+    std::string Send(
+        const std::string& connectionId,
+        const std::string& destination,
+        const size_t messageSize,
+        const std::function<void (std::string&)>& writeMessage,
+        std::function<void (StompServerError, std::string&&)> onSend = nullptr,
+        const std::string& userRequestId = ""
+    )
+    {
+        auto wsSession {GetConnectedSession(connectionId)};
+        if (wsSession == nullptr) {
             return "";
         }
 
         auto requestId {userRequestId.empty() ? GenerateId() : userRequestId};
-        auto messageSize {messageContent.size()};
+        const auto contentLength {std::to_string(messageSize)};
 
-        // Assemble the SEND frame.
+        // Assemble the SEND frame. The message content is serialized right
+        // after the headers, in the same buffer.
         StompError error {};
-        StompFrame frame {
-            error,
-            StompCommand::kSend,
-            {
-                {StompHeader::kId, requestId},
-                {StompHeader::kDestination, destination},
-                {StompHeader::kContentType, "application/json"},
-                {StompHeader::kContentLength, std::to_string(messageSize)},
-            },
-            messageContent,
+        auto frame {StompFrameBuilder {StompCommand::kSend}
+            .AddHeader(StompHeader::kId, requestId)
+            .AddHeader(StompHeader::kDestination, destination)
+            .AddHeader(StompHeader::kContentType, "application/json")
+            .AddHeader(StompHeader::kContentLength, contentLength)
+            .SetBody(messageSize, writeMessage)
+            .Build(error)
         };
         if (error != StompError::kOk) {
-            spdlog::error("StompServer: Could not create a valid frame: {}",
-                          error);
+            spdlog::error("StompServer: [{}] Could not create a valid frame: "
+                          "{}",
+                          connectionId, error);
             return "";
         }
 
@@ -286,20 +483,120 @@ public:
         spdlog::info("StompServer: [{}] Sending message to {}",
                      connectionId, destination);
         if (onSend == nullptr) {
-            wsSession->Send(frame.ToString());
+            wsSession->Send(std::move(frame));
         } else {
             wsSession->Send(
-                frame.ToString(),
-                [requestId, onSend](auto ec) mutable {
+                std::move(frame),
+                [this, requestId, onSend](auto ec) mutable {
                     auto error {ec ? StompServerError::kCouldNotSendMessage :
                                      StompServerError::kOk};
-                    onSend(error, std::move(requestId));
+                    boost::asio::post(
+                        context_,
+                        [onSend, error, requestId]() mutable {
+                            onSend(error, std::move(requestId));
+                        }
+                    );
                 }
             );
         }
         return requestId;
     }
 
+    /*! \brief Publish a JSON message to all the clients subscribed to a
+     *         destination.
+     *
+     *  The MESSAGE frame is serialized once and shared by the write queues of
+     *  all the subscribers. Only the frame head, with the subscription ID
+     *  picked by each client, is different for each subscriber. The head is
+     *  serialized when the client subscribes.
+     *
+     *  \returns The number of subscribers the message was queued for.
+     *
+     *  \param destination      The subscription destination.
+     *  \param messageContent   A string containing the message content. Do
+     *                          not check if this string is compatible with the
+     *                          content type. The assumption is that the content
+     *                          type is application/json. The string is copied
+     *                          into the frame.
+     *  \param connectionId     If not empty, only publish to the subscriptions
+     *                          of this connection, for example to bring a new
+     *                          subscriber up to date.
+     */
+    size_t Publish(
+        const std::string& destination,
+        const std::string& messageContent,
+        const std::string& connectionId = ""
+    )
+    {
+        if (GetSubscriberCount(destination) == 0) {
+            return 0;
+        }
+        const auto messageId {GenerateId()};
+        const auto contentLength {std::to_string(messageContent.size())};
+        StompFrameBuilder builder {StompCommand::kMessage};
+        AddMessageHeaders(
+            builder,
+            kMessageHeadPlaceholder_,
+            destination,
+            messageId,
+            contentLength
+        ).SetBody(messageContent);
+        return Fanout(destination, builder, connectionId);
+    }
+
+    /*! \brief Publish a JSON message to all the clients subscribed to a
+     *         destination, serializing the message content straight into the
+     *         shared frame.
+     *
+     *  \returns The number of subscribers the message was queued for.
+     *
+     *  \param messageSize      The exact size of the message content, in bytes.
+     *  \param writeMessage     Called at most once with the frame buffer,
+     *                          positioned right after the frame headers. It
+     *                          must append exactly `messageSize` bytes to the
+     *                          buffer. It is not called if the destination has
+     *                          no subscribers.
+     *
+     *  All other parameters are the same as in the `Publish` overload that
+     *  takes the message content as a string.
+     */
+    size_t Publish(
+        const std::string& destination,
+        const size_t messageSize,
+        const std::function<void (std::string&)>& writeMessage,
+        const std::string& connectionId = ""
+    )
+    {
+        if (GetSubscriberCount(destination) == 0) {
+            return 0;
+        }
+        const auto messageId {GenerateId()};
+        const auto contentLength {std::to_string(messageSize)};
+        StompFrameBuilder builder {StompCommand::kMessage};
+        AddMessageHeaders(
+            builder,
+            kMessageHeadPlaceholder_,
+            destination,
+            messageId,
+            contentLength
+        ).SetBody(messageSize, writeMessage);
+        return Fanout(destination, builder, connectionId);
+    }
+
+    /*! \brief Get the number of active subscriptions to a destination.
+     */
+    size_t GetSubscriberCount(
+        const std::string& destination
+    )
+    {
+        std::lock_guard<std::mutex> lock {connectionsMutex_};
+        auto destinationIt {subscribers_.find(destination)};
+        if (destinationIt == subscribers_.end()) {
+            return 0;
+        }
+        return destinationIt->second.size();
+    }
+
     /*! \brief Close a connection.
      *
      *  This method closes an individual client connection asynchronously.
@@ -311,54 +608,57 @@ public:
         const std::string& connectionId,
         ClientHandler onClientClose = nullptr
     )
+    {
+        Close(connectionId, StompServerError::kUndefinedError, onClientClose);
+    }
+
+    /*! \brief Close a connection with an ERROR frame.
+     *
+     *  This method sends an ERROR frame that carries the error, then closes
+     *  the client connection asynchronously. Use it to reject a client, for
+     *  example with StompServerError::kServerBusy.
+     *
+     *  \param error            The reason for closing the connection. With
+     *                          StompServerError::kUndefinedError, no ERROR
+     *                          frame is sent.
+     *  \param onClientClose    If provided, this handler is called after the
+     *                          client connection has been closed.
+     */
+    void Close(
+        const std::string& connectionId,
+        const StompServerError error,
+        ClientHandler onClientClose = nullptr
+    )
     {
         // The connection should exist to begin with.
-        auto sessionIt {sessions_.find(connectionId)};
-        if (sessionIt == sessions_.end()) {
+        std::shared_ptr<typename WsServer::Session> wsSession {nullptr};
+        auto connection {FindConnection(connectionId, wsSession)};
+        if (connection == nullptr) {
             spdlog::error("StompServer: Unrecognized STOMP connection: {}",
                           connectionId);
             return;
         }
-        auto& wsSession {sessionIt->second};
-        auto connectionIt {connections_.find(wsSession)};
-        if (connectionIt == connections_.end()) {
-            spdlog::error("StompServer: Unrecognized Websocket connection: {}",
-                          wsSession);
-            // Close the Websocket connection here, as this is not a
-            // valid STOMP connection.
-            if (onClientClose) {
-                wsSession->Close(
-                    [onClientClose, connectionId](auto ec) {
-                        StompServerError error {ec ?
-                            StompServerError::kCouldNotCloseClientConnection :
-                            StompServerError::kOk
-                        };
-                        onClientClose(error, connectionId);
-                    }
-                );
-            } else {
-                wsSession->Close();
-            }
-            return;
-        }
-        const auto& connection {connectionIt->second};
 
-        // Close the connection without reason.
         if (onClientClose) {
             CloseConnection(
-                connection,
+                *connection,
                 wsSession,
-                StompServerError::kUndefinedError,
-                [onClientClose, connectionId](auto ec) {
+                error,
+                [this, onClientClose, connectionId](auto ec) {
                     StompServerError error {ec ?
                         StompServerError::kCouldNotCloseClientConnection :
                         StompServerError::kOk
                     };
-                    onClientClose(error, connectionId);
+                    boost::asio::post(
+                        context_,
+                        [onClientClose, error, connectionId]() {
+                            onClientClose(error, connectionId);
+                        }
+                    );
                 }
             );
         } else {
-            CloseConnection(connection, wsSession);
+            CloseConnection(*connection, wsSession, error);
         }
     }
 
@@ -374,11 +674,27 @@ public:
     {
         spdlog::info("StompServer: Stopping server");
         ws_.Stop();
-        for (auto& [wsSession, _]: connections_) {
+        boost::asio::post(
+            context_,
+            [this]() {
+                sweeping_ = false;
+                heartBeatTimer_.cancel();
+            }
+        );
+        decltype(connections_) connections {};
+        {
+            std::lock_guard<std::mutex> lock {connectionsMutex_};
+            for (auto& [_, connection]: connections_) {
+                connection->closed = true;
+                connection->subscriptions.clear();
+            }
+            connections.swap(connections_);
+            sessions_.clear();
+            subscribers_.clear();
+        }
+        for (auto& [wsSession, _]: connections) {
             wsSession->Close();
         }
-        connections_.clear();
-        sessions_.clear();
     }
 
 private:
@@ -388,14 +704,70 @@ private:
         kConnected,
     };
 
+    struct Connection;
+
+    // A subscriber keeps the head of the MESSAGE frames for its subscription.
+    struct Subscriber {
+        std::shared_ptr<typename WsServer::Session> wsSession {nullptr};
+        std::shared_ptr<Connection> connection {nullptr};
+        std::shared_ptr<const std::string> messageHead {nullptr};
+    };
+
+    // The list iterators stay valid when other subscribers are added or
+    // removed, so a connection can drop its own subscriptions in O(1).
+    using Subscribers = std::list<Subscriber>;
+
+    struct Subscription {
+        std::string destination {};
+        typename Subscribers::iterator subscriberIt {};
+    };
+
+    // The frames of a connection are handled on the strand of its Websocket
+    // session, which owns the parser, the heart-beat intervals and the token
+    // bucket. The fields that other threads read or write are atomic. The
+    // subscriptions are part of the subscribers index, so they are protected
+    // by the connections mutex.
     struct Connection {
         std::string id {};
-        ConnectionStatus status {ConnectionStatus::kInvalid};
+        std::atomic<ConnectionStatus> status {ConnectionStatus::kInvalid};
+
+        // Set, under the connections mutex, when the connection is removed
+        // from the maps. The frames that follow are dropped.
+        std::atomic<bool> closed {false};
+
+        // Set when we drop a silent client. The connection stays in the maps
+        // until its Websocket session is closed, but we ignore its frames.
+        std::atomic<bool> closing {false};
+
+        // Frames may be split across Websocket messages, or batched in one.
+        StompFrameParser parser {};
+
+        // The negotiated heart-beat intervals, and when we last heard from and
+        // wrote to the client. The intervals are set before the status becomes
+        // kConnected.
+        StompHeartBeat heartBeat {};
+        std::atomic<std::chrono::steady_clock::time_point> lastReadAt {};
+        std::atomic<std::chrono::steady_clock::time_point> lastWriteAt {};
+
+        // The active subscriptions, by subscription ID. The comparator is
+        // transparent, so that we can look up the ID header of a frame
+        // without copying it into a string.
+        std::map<std::string, Subscription, std::less<>> subscriptions {};
+
+        // The token bucket of the SEND frames.
+        double sendTokens {0.0};
+        std::chrono::steady_clock::time_point sendTokensAt {};
     };
 
     const std::string kVersion_ {"1.2"};
     const std::string kHost_ {""};
 
+    const std::string kHeartBeatEol_ {"\n"};
+
+    // The subscription ID of the shared part of a MESSAGE frame. It is cut
+    // away with the frame head.
+    const std::string kMessageHeadPlaceholder_ {"0"};
+
     // This strand handles all the STOMP-specific callbacks. These operations
     // are decoupled from the Websocket operations.
     // Leave it uninitialized because it does not support a default
@@ -410,20 +782,109 @@ private:
     ClientMsgHandler onClientMessage_ {nullptr};
     ClientHandler onClientDisconnect_ {nullptr};
     ServerHandler onDisconnect_ {nullptr};
+    ClientSubscriptionHandler onClientSubscribe_ {nullptr};
+    ClientSubscriptionHandler onClientUnsubscribe_ {nullptr};
 
     // Maintain two maps of all active sessions to make sure that they are
     // properly connected according to the STOMP protocol.
     // Unfortunately we need to keep a mapping in both directions:
     // connections <--> sessions
+    // The Websocket callbacks run on the strand of each session, and the user
+    // may send from any thread, so the maps are only accessed behind the
+    // mutex. The mutex only covers the lookups and the updates of the maps:
+    // Frames are parsed and handled, and Websocket messages are sent, after
+    // releasing it.
+    std::mutex connectionsMutex_ {};
     std::unordered_map<
         std::shared_ptr<typename WsServer::Session>,
-        Connection
+        std::shared_ptr<Connection>
     > connections_ {};
     std::unordered_map<
         std::string,
         std::shared_ptr<typename WsServer::Session>
     > sessions_ {};
 
+    // The subscribers of each destination. This index is protected by the
+    // same mutex as the connections.
+    std::unordered_map<std::string, Subscribers> subscribers_ {};
+
+    IdGenerator ids_ {};
+
+    // Admission control
+    // The stats are protected by the connections mutex.
+    StompServerLimits limits_ {};
+    StompServerAdmissionStats admissionStats_ {};
+
+    // Heart-beating
+    // A single timer sweeps all the connections. It runs on the context_
+    // strand, on a copy of the connection map.
+    StompHeartBeat heartBeat_ {};
+    boost::asio::steady_timer heartBeatTimer_;
+    bool sweeping_ {false};
+
+    // Find the connection and the Websocket session of a STOMP client.
+    // Returns nullptr if the connection does not exist.
+    std::shared_ptr<Connection> FindConnection(
+        const std::string& connectionId,
+        std::shared_ptr<typename WsServer::Session>& wsSession
+    )
+    {
+        std::lock_guard<std::mutex> lock {connectionsMutex_};
+        auto sessionIt {sessions_.find(connectionId)};
+        if (sessionIt == sessions_.end()) {
+            return nullptr;
+        }
+        wsSession = sessionIt->second;
+        return connections_.at(wsSession);
+    }
+
+    // Find the connection of a Websocket session.
+    // Returns nullptr if the connection does not exist.
+    std::shared_ptr<Connection> FindConnection(
+        const std::shared_ptr<typename WsServer::Session>& wsSession
+    )
+    {
+        std::lock_guard<std::mutex> lock {connectionsMutex_};
+        auto connectionIt {connections_.find(wsSession)};
+        if (connectionIt == connections_.end()) {
+            return nullptr;
+        }
+        return connectionIt->second;
+    }
+
+    // Find the Websocket session for a connected STOMP client.
+    // Returns nullptr if the connection does not exist or is not connected.
+    // The caller is about to send a frame, which also counts as a heart-beat.
+    std::shared_ptr<typename WsServer::Session> GetConnectedSession(
+        const std::string& connectionId
+    )
+    {
+        // The connection should exist to begin with.
+        std::shared_ptr<typename WsServer::Session> wsSession {nullptr};
+        auto connection {FindConnection(connectionId, wsSession)};
+        if (connection == nullptr) {
+            spdlog::error("StompServer: Unrecognized STOMP connection: {}",
+                          connectionId);
+            return nullptr;
+        }
+
+        // The client must be connected.
+        if (connection->status != ConnectionStatus::kConnected) {
+            spdlog::error("StompServer: [{}] Could not send message: "
+                          "STOMP not yet connected",
+                          connectionId);
+            return nullptr;
+        }
+        if (connection->closing) {
+            spdlog::info("StompServer: [{}] Could not send message: "
+                         "Closing connection",
+                         connectionId);
+            return nullptr;
+        }
+        connection->lastWriteAt = std::chrono::steady_clock::now();
+        return wsSession;
+    }
+
     void OnWsSessionConnect(
         boost::system::error_code ec,
         std::shared_ptr<typename WsServer::Session> wsSession
@@ -444,14 +905,40 @@ private:
         // A new Websocket connection only becomes a STOMP connection after a
         // successful STOMP frame from the client. Save the new connection
         // as pending.
-        Connection connection {
-            GenerateId(),
-            ConnectionStatus::kPending,
-        };
+        auto connection {std::make_shared<Connection>()};
+        connection->id = GenerateId();
+        connection->status = ConnectionStatus::kPending;
+        connection->parser.SetMaxFrameSize(limits_.maxFrameSize);
+        size_t nConnections {0};
+        bool rejected {false};
+        {
+            std::lock_guard<std::mutex> lock {connectionsMutex_};
+
+            // The pending connections count too: They already hold a socket
+            // and a TLS session.
+            nConnections = connections_.size();
+            rejected = limits_.maxConnections > 0 &&
+                       nConnections >= limits_.maxConnections;
+            if (rejected) {
+                ++admissionStats_.nRejectedConnections;
+            } else {
+                sessions_[connection->id] = wsSession;
+                connections_[wsSession] = connection;
+            }
+        }
+        if (rejected) {
+            spdlog::warn("StompServer: [{}] Rejecting connection: {}/{} "
+                         "connections open",
+                         connection->id, nConnections,
+                         limits_.maxConnections);
+            wsSession->Send(MakeErrorFrame(
+                StompServerError::kTooManyConnections
+            ));
+            wsSession->Close();
+            return;
+        }
         spdlog::info("StompServer: [{}] STOMP status: Pending",
-                     connection.id);
-        sessions_[connection.id] = wsSession;
-        connections_[wsSession] = std::move(connection);
+                     connection->id);
     }
 
     void OnWsSessionMessage(
@@ -461,8 +948,8 @@ private:
     )
     {
         // The connection should exist to begin with.
-        auto connectionIt {connections_.find(wsSession)};
-        if (connectionIt == connections_.end()) {
+        auto connection {FindConnection(wsSession)};
+        if (connection == nullptr) {
             spdlog::error("StompServer: Unrecognized Websocket connection: {}",
                           wsSession);
             // Close the Websocket connection here, as this is not a
@@ -470,25 +957,53 @@ private:
             wsSession->Close();
             return;
         }
-        auto& connection {connectionIt->second};
+        if (connection->closing) {
+            return;
+        }
+
+        // Any message from the client counts as a heart-beat.
+        connection->lastReadAt = std::chrono::steady_clock::now();
 
         // On error (Websockets)
         if (ec) {
             spdlog::error("StompServer: [{}] Invalid Websocket message",
-                          connection.id);
+                          connection->id);
             return;
         }
 
-        // Parse the message.
-        StompError error {};
-        StompFrame frame {error, std::move(msg)};
+        // Parse the message. It may complete any number of frames. We are on
+        // the session strand, which owns the parser.
+        std::vector<StompFrame> frames {};
+        auto error {connection->parser.Parse(std::move(msg), frames)};
+        for (auto& frame: frames) {
+            // A frame handler may close the connection. We drop the frames
+            // that follow it.
+            if (!HandleFrame(wsSession, *connection, std::move(frame))) {
+                return;
+            }
+        }
         if (error != StompError::kOk) {
+            spdlog::error("StompServer: [{}] Could not parse frame: {}",
+                          connection->id, error);
             CloseConnection(
-                connection,
+                *connection,
                 wsSession,
-                StompServerError::kCouldNotParseFrame
+                error == StompError::kParsingFrameTooLarge ?
+                    StompServerError::kFrameTooLarge :
+                    StompServerError::kCouldNotParseFrame
             );
-            return;
+        }
+    }
+
+    // Returns false if the connection was closed while handling the frame.
+    bool HandleFrame(
+        std::shared_ptr<typename WsServer::Session> wsSession,
+        Connection& connection,
+        StompFrame&& frame
+    )
+    {
+        if (connection.closed) {
+            return false;
         }
 
         // Decide what to do based on the STOMP command.
@@ -504,15 +1019,24 @@ private:
                 HandleSend(wsSession, connection, std::move(frame));
                 break;
             }
+            case StompCommand::kSubscribe: {
+                HandleSubscribe(wsSession, connection, std::move(frame));
+                break;
+            }
+            case StompCommand::kUnsubscribe: {
+                HandleUnsubscribe(wsSession, connection, std::move(frame));
+                break;
+            }
             default: {
                 CloseConnection(
                     connection,
                     wsSession,
                     StompServerError::kUnsupportedFrame
                 );
-                return;
+                return false;
             }
         }
+        return !connection.closed;
     }
 
     void OnWsSessionDisconnect(
@@ -521,23 +1045,37 @@ private:
     )
     {
         // The connection should exist to begin with.
-        auto connectionIt {connections_.find(wsSession)};
-        if (connectionIt == connections_.end()) {
+        spdlog::info("StompServer:: [{}] Websocket session disconnected: {}",
+                     wsSession, ec.message());
+        auto error {ec ? StompServerError::kWebsocketSessionDisconnected :
+                         StompServerError::kOk};
+        if (!DropConnection(wsSession, error)) {
             spdlog::error("StompServer: [{}] Unrecognized Websocket connection",
                           wsSession);
-            return;
         }
-        const auto id {connectionIt->second.id};
-        const auto status {connectionIt->second.status};
+    }
+
+    // Remove the connection of a Websocket session that is gone and tell the
+    // user.
+    // Returns false if the connection was already removed.
+    bool DropConnection(
+        const std::shared_ptr<typename WsServer::Session>& wsSession,
+        const StompServerError error
+    )
+    {
+        std::vector<std::string> destinations {};
+        auto connection {RemoveConnection(wsSession, destinations)};
+        if (connection == nullptr) {
+            return false;
+        }
+        const auto& id {connection->id};
 
         // Call the user callback, but only if the STOMP connection
         // was successfully established.
-        spdlog::info("StompServer:: [{}] Disconnected: {}", id, ec.message());
-        sessions_.erase(id);
-        connections_.erase(wsSession);
-        if (status == ConnectionStatus::kConnected && onClientDisconnect_) {
-            auto error {ec ? StompServerError::kWebsocketSessionDisconnected :
-                             StompServerError::kOk};
+        spdlog::info("StompServer:: [{}] Disconnected: {}", id, error);
+        NotifyUnsubscribes(id, destinations, error);
+        if (connection->status == ConnectionStatus::kConnected &&
+            onClientDisconnect_) {
             boost::asio::post(
                 context_,
                 [onClientDisconnect = onClientDisconnect_, error, id]() {
@@ -545,6 +1083,7 @@ private:
                 }
             );
         }
+        return true;
     }
 
     void OnWsDisconnect(
@@ -568,27 +1107,55 @@ private:
         }
     }
 
-    void CloseConnection(
+    // Remove a connection from the maps and drop its subscriptions.
+    // Returns nullptr if the connection was already removed, for example by a
+    // concurrent call to Close.
+    std::shared_ptr<Connection> RemoveConnection(
+        const std::shared_ptr<typename WsServer::Session>& wsSession,
+        std::vector<std::string>& destinations
+    )
+    {
+        std::lock_guard<std::mutex> lock {connectionsMutex_};
+        auto connectionIt {connections_.find(wsSession)};
+        if (connectionIt == connections_.end()) {
+            return nullptr;
+        }
+        auto connection {connectionIt->second};
+        connection->closed = true;
+        for (const auto& [_, subscription]: connection->subscriptions) {
+            RemoveSubscriber(subscription);
+            destinations.push_back(subscription.destination);
+        }
+        connection->subscriptions.clear();
+        sessions_.erase(connection->id);
+        connections_.erase(connectionIt);
+        return connection;
+    }
+
+    // Returns false if the connection was already closed.
+    bool CloseConnection(
         const Connection& connection,
         std::shared_ptr<typename WsServer::Session> wsSession,
         const StompServerError error = StompServerError::kUndefinedError,
         std::function<void (boost::system::error_code)> onClose = nullptr
     )
     {
+        std::vector<std::string> destinations {};
+        if (RemoveConnection(wsSession, destinations) == nullptr) {
+            return false;
+        }
         spdlog::info(
             "StompServer: [{}] Closing connection{}{}",
             connection.id,
             error == StompServerError::kUndefinedError ? "" : ": ",
             error == StompServerError::kUndefinedError ? "" : ToString(error)
         );
-        sessions_.erase(connection.id);
-        connections_.erase(wsSession);
+        NotifyUnsubscribes(connection.id, destinations, error);
         if (error != StompServerError::kUndefinedError) {
-            wsSession->Send(MakeErrorFrame(
-                StompServerError::kUnsupportedFrame
-            ).ToString());
+            wsSession->Send(MakeErrorFrame(error));
         }
         wsSession->Close(onClose);
+        return true;
     }
 
     void HandleStomp(
@@ -617,6 +1184,20 @@ private:
             return;
         }
 
+        StompError error {};
+        const auto heartBeat {ParseHeartBeat(
+            error,
+            frame.GetHeaderValue(StompHeader::kHeartBeat)
+        )};
+        if (error != StompError::kOk) {
+            CloseConnection(
+                connection,
+                wsSession,
+                StompServerError::kInvalidHeaderValueHeartBeat
+            );
+            return;
+        }
+
         // Do not support a re-connection.
         if (connection.status != ConnectionStatus::kPending) {
             spdlog::error("StompServer: [{}] Connection was not pending",
@@ -632,26 +1213,32 @@ private:
         // Officially connected.
         spdlog::info("StompServer: [{}] STOMP status: Connected",
                      connection.id);
+        const auto now {std::chrono::steady_clock::now()};
+        connection.heartBeat = NegotiateHeartBeat(heartBeat_, heartBeat);
+        connection.lastReadAt = now;
+        connection.lastWriteAt = now;
+        connection.sendTokens = static_cast<double>(limits_.sendBurst);
+        connection.sendTokensAt = now;
         connection.status = ConnectionStatus::kConnected;
 
         // Send a CONNECTED frame.
-        StompError error {};
-        StompFrame response {
-            error,
-            StompCommand::kConnected,
-            {
-                {StompHeader::kVersion, "1.2"},
-                {StompHeader::kSession, connection.id},
-            }
-        };
+        StompFrameBuilder builder {StompCommand::kConnected};
+        builder
+            .AddHeader(StompHeader::kVersion, "1.2")
+            .AddHeader(StompHeader::kSession, connection.id);
+        const auto serverHeartBeat {ToString(heartBeat_)};
+        if (heartBeat_ != StompHeartBeat {}) {
+            builder.AddHeader(StompHeader::kHeartBeat, serverHeartBeat);
+        }
+        auto response {builder.Build(error)};
         if (error != StompError::kOk) {
             spdlog::error(
                 "StompServer: [{}] Unexpected: Could not create frame: {}",
-                error
+                connection.id, error
             );
             return;
         }
-        wsSession->Send(response.ToString());
+        wsSession->Send(std::move(response));
 
         // Call the user callback.
         if (onClientConnect_) {
@@ -684,6 +1271,22 @@ private:
             return;
         }
 
+        // The client must respect the SEND rate.
+        if (!TakeSendToken(connection)) {
+            spdlog::warn("StompServer: [{}] SEND rate exceeded",
+                         connection.id);
+            {
+                std::lock_guard<std::mutex> lock {connectionsMutex_};
+                ++admissionStats_.nRateLimitedFrames;
+            }
+            CloseConnection(
+                connection,
+                wsSession,
+                StompServerError::kSendRateExceeded
+            );
+            return;
+        }
+
         // Call the user callback.
         if (onClientMessage_) {
             boost::asio::post(
@@ -697,7 +1300,7 @@ private:
                     requestId = std::string(frame.GetHeaderValue(
                         StompHeader::kId
                     )),
-                    message = std::string(frame.GetBody())
+                    message = StompBody {frame}
                 ]() mutable {
                     onClientMessage(
                         StompServerError::kOk,
@@ -711,24 +1314,433 @@ private:
         }
     }
 
-    StompFrame MakeErrorFrame(
+    // Refill the token bucket of the connection, then take a token from it.
+    // Returns false if the bucket is empty.
+    bool TakeSendToken(
+        Connection& connection
+    )
+    {
+        if (limits_.sendRate <= 0.0) {
+            return true;
+        }
+        const auto now {std::chrono::steady_clock::now()};
+        const std::chrono::duration<double> elapsed {
+            now - connection.sendTokensAt
+        };
+        connection.sendTokens = std::min(
+            connection.sendTokens + elapsed.count() * limits_.sendRate,
+            static_cast<double>(limits_.sendBurst)
+        );
+        connection.sendTokensAt = now;
+        if (connection.sendTokens < 1.0) {
+            return false;
+        }
+        connection.sendTokens -= 1.0;
+        return true;
+    }
+
+    void HandleSubscribe(
+        std::shared_ptr<typename WsServer::Session> wsSession,
+        Connection& connection,
+        StompFrame&& frame
+    )
+    {
+        // The client must be connected.
+        if (connection.status != ConnectionStatus::kConnected) {
+            spdlog::error("StompServer: [{}] Received SUBSCRIBE frame from "
+                          "invalid STOMP connection",
+                          connection.id);
+            CloseConnection(
+                connection,
+                wsSession
+            );
+            return;
+        }
+
+        // All subscribers of a destination share the same MESSAGE frames, so
+        // we cannot wait for per-client acknowledgements.
+        auto ack {frame.GetHeaderValue(StompHeader::kAck)};
+        if (!ack.empty() && ack != "auto") {
+            CloseConnection(
+                connection,
+                wsSession,
+                StompServerError::kInvalidHeaderValueAck
+            );
+            return;
+        }
+
+        // Serialize the head of the MESSAGE frames for this subscription.
+        auto subscriptionId {std::string(
+            frame.GetHeaderValue(StompHeader::kId)
+        )};
+        auto destination {std::string(
+            frame.GetHeaderValue(StompHeader::kDestination)
+        )};
+        StompError error {};
+        StompFrameBuilder builder {StompCommand::kMessage};
+        auto messageHead {AddMessageHeaders(
+            builder,
+            subscriptionId,
+            destination,
+            kMessageHeadPlaceholder_,
+            "0"
+        ).Build(error)};
+        if (error != StompError::kOk) {
+            spdlog::error(
+                "StompServer: [{}] Unexpected: Could not create frame: {}",
+                connection.id, error
+            );
+            return;
+        }
+        messageHead.resize(GetMessageHeadSize(messageHead));
+
+        // Add the subscription to the index. The subscription ID must be
+        // unique within the connection.
+        bool idInUse {false};
+        {
+            std::lock_guard<std::mutex> lock {connectionsMutex_};
+            if (connection.closed) {
+                return;
+            }
+            idInUse = connection.subscriptions.find(subscriptionId) !=
+                      connection.subscriptions.end();
+            if (!idInUse) {
+                auto& subscribers {subscribers_[destination]};
+                auto subscriberIt {subscribers.insert(
+                    subscribers.end(),
+                    Subscriber {
+                        wsSession,
+                        connections_.at(wsSession),
+                        std::make_shared<const std::string>(
+                            std::move(messageHead)
+                        )
+                    }
+                )};
+                connection.subscriptions[subscriptionId] = {
+                    destination,
+                    subscriberIt
+                };
+            }
+        }
+        if (idInUse) {
+            CloseConnection(
+                connection,
+                wsSession,
+                StompServerError::kSubscriptionIdInUse
+            );
+            return;
+        }
+        spdlog::info("StompServer: [{}] Subscribed to {}",
+                     connection.id, destination);
+        SendReceipt(wsSession, connection, frame);
+
+        // Call the user callback.
+        if (onClientSubscribe_) {
+            boost::asio::post(
+                context_,
+                [
+                    onClientSubscribe = onClientSubscribe_,
+                    id = connection.id,
+                    destination
+                ]() {
+                    onClientSubscribe(StompServerError::kOk, id, destination);
+                }
+            );
+        }
+    }
+
+    void HandleUnsubscribe(
+        std::shared_ptr<typename WsServer::Session> wsSession,
+        Connection& connection,
+        StompFrame&& frame
+    )
+    {
+        // The client must be connected.
+        if (connection.status != ConnectionStatus::kConnected) {
+            spdlog::error("StompServer: [{}] Received UNSUBSCRIBE frame from "
+                          "invalid STOMP connection",
+                          connection.id);
+            CloseConnection(
+                connection,
+                wsSession
+            );
+            return;
+        }
+
+        // The subscription must exist.
+        std::string destination {};
+        bool found {false};
+        {
+            std::lock_guard<std::mutex> lock {connectionsMutex_};
+            if (connection.closed) {
+                return;
+            }
+            auto subscriptionIt {connection.subscriptions.find(
+                frame.GetHeaderValue(StompHeader::kId)
+            )};
+            found = subscriptionIt != connection.subscriptions.end();
+            if (found) {
+                destination = subscriptionIt->second.destination;
+                RemoveSubscriber(subscriptionIt->second);
+                connection.subscriptions.erase(subscriptionIt);
+            }
+        }
+        if (!found) {
+            CloseConnection(
+                connection,
+                wsSession,
+                StompServerError::kUnrecognizedSubscription
+            );
+            return;
+        }
+        spdlog::info("StompServer: [{}] Unsubscribed from {}",
+                     connection.id, destination);
+        SendReceipt(wsSession, connection, frame);
+
+        // Call the user callback.
+        if (onClientUnsubscribe_) {
+            boost::asio::post(
+                context_,
+                [
+                    onClientUnsubscribe = onClientUnsubscribe_,
+                    id = connection.id,
+                    destination
+                ]() {
+                    onClientUnsubscribe(StompServerError::kOk, id, destination);
+                }
+            );
+        }
+    }
+
+    // Tell the user about the subscriptions of a connection that was closed.
+    void NotifyUnsubscribes(
+        const std::string& connectionId,
+        const std::vector<std::string>& destinations,
+        const StompServerError error
+    )
+    {
+        if (!onClientUnsubscribe_) {
+            return;
+        }
+        for (const auto& destination: destinations) {
+            boost::asio::post(
+                context_,
+                [
+                    onClientUnsubscribe = onClientUnsubscribe_,
+                    id = connectionId,
+                    destination,
+                    error
+                ]() {
+                    onClientUnsubscribe(error, id, destination);
+                }
+            );
+        }
+    }
+
+    void RemoveSubscriber(
+        const Subscription& subscription
+    )
+    {
+        auto destinationIt {subscribers_.find(subscription.destination)};
+        if (destinationIt == subscribers_.end()) {
+            return;
+        }
+        destinationIt->second.erase(subscription.subscriberIt);
+        if (destinationIt->second.empty()) {
+            subscribers_.erase(destinationIt);
+        }
+    }
+
+    // A MESSAGE frame is sent in two parts: The head, with the command and the
+    // subscription header, and the tail, with all the other headers and the
+    // body. Both parts are cut from frames built with the same headers, so
+    // they are escaped in the same way.
+    StompFrameBuilder& AddMessageHeaders(
+        StompFrameBuilder& builder,
+        const std::string& subscriptionId,
+        const std::string& destination,
+        const std::string& messageId,
+        const std::string& contentLength
+    )
+    {
+        return builder
+            .AddHeader(StompHeader::kSubscription, subscriptionId)
+            .AddHeader(StompHeader::kMessageId, messageId)
+            .AddHeader(StompHeader::kDestination, destination)
+            .AddHeader(StompHeader::kContentType, "application/json")
+            .AddHeader(StompHeader::kContentLength, contentLength);
+    }
+
+    // The head ends with the first header line. Header values never contain
+    // a raw EOL, as it is escaped.
+    static size_t GetMessageHeadSize(
+        const std::string& frame
+    )
+    {
+        return frame.find('\n', frame.find('\n') + 1) + 1;
+    }
+
+    size_t Fanout(
+        const std::string& destination,
+        const StompFrameBuilder& builder,
+        const std::string& connectionId
+    )
+    {
+        // Serialize the shared tail outside of the lock.
+        StompError error {};
+        auto frame {builder.Build(error)};
+        if (error != StompError::kOk) {
+            spdlog::error("StompServer: Could not create a valid frame: {}",
+                          error);
+            return 0;
+        }
+        frame.erase(0, GetMessageHeadSize(frame));
+        const auto tail {std::make_shared<const std::string>(std::move(frame))};
+
+        // Take a snapshot of the subscribers, then queue the same tail on all
+        // of them after releasing the lock. Publishing also counts as a
+        // heart-beat.
+        std::vector<Subscriber> subscribers {};
+        {
+            std::lock_guard<std::mutex> lock {connectionsMutex_};
+            auto destinationIt {subscribers_.find(destination)};
+            if (destinationIt == subscribers_.end()) {
+                return 0;
+            }
+            std::shared_ptr<typename WsServer::Session> onlySession {nullptr};
+            if (!connectionId.empty()) {
+                auto sessionIt {sessions_.find(connectionId)};
+                if (sessionIt == sessions_.end()) {
+                    return 0;
+                }
+                onlySession = sessionIt->second;
+            }
+            subscribers.reserve(destinationIt->second.size());
+            for (const auto& subscriber: destinationIt->second) {
+                if (onlySession == nullptr ||
+                    subscriber.wsSession == onlySession) {
+                    subscribers.push_back(subscriber);
+                }
+            }
+        }
+        const auto now {std::chrono::steady_clock::now()};
+        for (const auto& subscriber: subscribers) {
+            subscriber.wsSession->Send(subscriber.messageHead, tail);
+            subscriber.connection->lastWriteAt = now;
+        }
+        const auto nSubscribers {subscribers.size()};
+        spdlog::info("StompServer: Published {}-byte message to {}: {} "
+                     "subscriber(s)",
+                     tail->size(), destination, nSubscribers);
+        return nSubscribers;
+    }
+
+    void SendReceipt(
+        std::shared_ptr<typename WsServer::Session> wsSession,
+        const Connection& connection,
+        const StompFrame& frame
+    )
+    {
+        const auto& receiptId {frame.GetHeaderValue(StompHeader::kReceipt)};
+        if (receiptId.empty()) {
+            return;
+        }
+        StompError error {};
+        auto receipt {StompFrameBuilder {StompCommand::kReceipt}
+            .AddHeader(StompHeader::kReceiptId, receiptId)
+            .Build(error)
+        };
+        if (error != StompError::kOk) {
+            spdlog::error(
+                "StompServer: [{}] Unexpected: Could not create frame: {}",
+                connection.id, error
+            );
+            return;
+        }
+        wsSession->Send(std::move(receipt));
+    }
+
+    void WaitHeartBeats()
+    {
+        heartBeatTimer_.expires_after(GetHeartBeatCheckInterval(heartBeat_));
+        heartBeatTimer_.async_wait([this](auto ec) {
+            if (ec || !sweeping_) {
+                return;
+            }
+            SweepHeartBeats();
+            WaitHeartBeats();
+        });
+    }
+
+    // Send the heart-beats that are due and disconnect the silent clients.
+    void SweepHeartBeats()
+    {
+        const auto now {std::chrono::steady_clock::now()};
+        const auto slack {GetHeartBeatCheckInterval(heartBeat_) / 2};
+        std::vector<std::pair<
+            std::shared_ptr<typename WsServer::Session>,
+            std::shared_ptr<Connection>
+        >> connections {};
+        {
+            std::lock_guard<std::mutex> lock {connectionsMutex_};
+            connections.assign(connections_.begin(), connections_.end());
+        }
+        for (auto& [wsSession, connection]: connections) {
+            if (connection->status != ConnectionStatus::kConnected ||
+                connection->closing) {
+                continue;
+            }
+
+            // While we do not read a slow client, its heart-beats wait in the
+            // socket. It gets a full interval once we read it again.
+            if (wsSession->IsReadingPaused()) {
+                connection->lastReadAt = now;
+            }
+            const auto& heartBeat {connection->heartBeat};
+            if (heartBeat.receive.count() > 0 &&
+                now - connection->lastReadAt.load() >
+                    heartBeat.receive * kStompHeartBeatGraceFactor) {
+                spdlog::error("StompServer: [{}] No heart-beat from client",
+                              connection->id);
+
+                // The connection is removed once, when its session is closed.
+                connection->closing = true;
+                wsSession->Send(MakeErrorFrame(
+                    StompServerError::kHeartBeatTimeout
+                ));
+                wsSession->Close([this, wsSession = wsSession](auto) {
+                    DropConnection(
+                        wsSession,
+                        StompServerError::kHeartBeatTimeout
+                    );
+                });
+                continue;
+            }
+            if (heartBeat.send.count() > 0 &&
+                now - connection->lastWriteAt.load() + slack >=
+                    heartBeat.send) {
+                connection->lastWriteAt = now;
+                wsSession->Send(kHeartBeatEol_);
+            }
+        }
+    }
+
+    std::string MakeErrorFrame(
         const StompServerError error
     )
     {
         StompError frameError {};
-        StompFrame frame {
-            frameError,
-            StompCommand::kError,
-            {
-                {StompHeader::kContentType, "text/plain"},
-                {StompHeader::kVersion, kVersion_},
-            },
-            ToString(error)
+        const auto message {ToString(error)};
+        auto frame {StompFrameBuilder {StompCommand::kError}
+            .AddHeader(StompHeader::kContentType, "text/plain")
+            .AddHeader(StompHeader::kVersion, kVersion_)
+            .SetBody(message)
+            .Build(frameError)
         };
         if (frameError != StompError::kOk) {
             spdlog::error(
-                "StompServer: [{}] Unexpected: Could not create frame: {}",
-                error
+                "StompServer: Unexpected: Could not create frame: {}",
+                frameError
             );
         }
         return frame;
@@ -736,9 +1748,7 @@ private:
 
     std::string GenerateId()
     {
-        std::stringstream ss {};
-        ss << boost::uuids::random_generator()();
-        return ss.str();
+        return ids_.Generate();
     }
 };
 
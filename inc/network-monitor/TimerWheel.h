@@ -0,0 +1,121 @@
+#ifndef NETWORK_MONITOR_TIMER_WHEEL_H
+#define NETWORK_MONITOR_TIMER_WHEEL_H
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace NetworkMonitor {
+
+/*! \brief Track many deadlines with a single clock tick.
+ *
+ *  Each deadline is stored in the slot of the tick at which it expires. A
+ *  deadline further away than one revolution of the wheel waits in its slot
+ *  for the next revolutions. Scheduling and cancelling a deadline are O(1).
+ *  Advancing the wheel visits the slots of the ticks that have elapsed.
+ *
+ *  Deadlines expire with the resolution of one tick: Never early, and at most
+ *  one tick late if the wheel is advanced on every tick.
+ *
+ *  \note This class is not thread-safe.
+ */
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /*! \brief Construct a timer wheel.
+     *
+     *  \param tick     The wheel resolution. It must be greater than 0.
+     *  \param nSlots   The number of ticks in one revolution of the wheel. It
+     *                  is at least 1.
+     *  \param start    The time of tick 0.
+     */
+    TimerWheel(
+        const Clock::duration tick,
+        const size_t nSlots,
+        const Clock::time_point start = Clock::now()
+    );
+
+    /*! \brief Schedule a deadline.
+     *
+     *  A key that is already scheduled is moved to the new deadline.
+     */
+    void Schedule(
+        const std::string& key,
+        const Clock::time_point deadline
+    );
+
+    /*! \brief Cancel a deadline.
+     *
+     *  \returns false if the key was not scheduled.
+     */
+    bool Cancel(
+        const std::string& key
+    );
+
+    /*! \brief Move the wheel forward to the given time.
+     *
+     *  \param expired  The keys whose deadline is not after `now` are appended
+     *                  to this vector, and they are no longer scheduled.
+     *
+     *  \returns The number of expired keys.
+     */
+    size_t Advance(
+        const Clock::time_point now,
+        std::vector<std::string>& expired
+    );
+
+    /*! \brief Cancel all the deadlines.
+     */
+    void Clear();
+
+    /*! \brief Get the number of scheduled deadlines.
+     */
+    size_t Size() const;
+
+    /*! \brief Check if there are no scheduled deadlines.
+     */
+    bool Empty() const;
+
+    /*! \brief Get the wheel resolution.
+     */
+    Clock::duration GetTick() const;
+
+private:
+    struct Entry {
+        std::string key {};
+        Clock::time_point deadline {};
+    };
+    using Slot = std::list<Entry>;
+
+    Clock::duration tick_ {};
+    Clock::time_point start_ {};
+    std::vector<Slot> slots_ {};
+
+    // The last tick whose slot has been visited.
+    size_t currentTick_ {0};
+
+    // Where each key lives, so that it can be cancelled in O(1).
+    std::unordered_map<
+        std::string,
+        std::pair<size_t, Slot::iterator>
+    > index_ {};
+
+    size_t GetTickIndex(
+        const Clock::time_point time,
+        const bool roundUp
+    ) const;
+
+    void ExpireSlot(
+        const size_t slotIdx,
+        const Clock::time_point now,
+        std::vector<std::string>& expired
+    );
+};
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_TIMER_WHEEL_H
@@ -168,6 +168,26 @@ void from_json(
     TravelRoute& dst
 );
 
+/*! \brief Get the size in bytes of the JSON serialization of a TravelRoute.
+ *
+ *  The size matches the output of `WriteJson` and of
+ *  `nlohmann::json(src).dump()`.
+ */
+size_t GetJsonSize(
+    const TravelRoute& src
+);
+
+/*! \brief Serialize TravelRoute to JSON, appending the output to a buffer.
+ *
+ *  The output is identical to `nlohmann::json(src).dump()`, but it is written
+ *  directly into `dst`, without building an intermediate JSON object. Use
+ *  `GetJsonSize` to reserve the buffer space in advance.
+ */
+void WriteJson(
+    std::string& dst,
+    const TravelRoute& src
+);
+
 /*! \brief Underground network representation
  */
 class TransportNetwork {
@@ -269,6 +289,18 @@ public:
         const Id& station
     ) const;
 
+    /*! \brief Copy the passenger counts recorded in another network.
+     *
+     *  Use this when replacing a network with an updated layout, to carry over
+     *  the crowding information recorded so far. Only the stations present in
+     *  both networks are updated. The others keep their current count.
+     *
+     *  \returns the number of stations whose count was copied.
+     */
+    size_t CopyPassengerCounts(
+        const TransportNetwork& other
+    );
+
     /*! \brief Get list of routes serving a given station.
      *
      *  \returns An empty vector if there was an error getting the list of
@@ -358,6 +390,30 @@ public:
         const size_t maxNPaths = std::numeric_limits<size_t>::max()
     ) const;
 
+    /*! \brief Get a quiet travel route alternative to the fastest route, from
+     *         station A to station B, and the stations it depends on.
+     *
+     *  The candidate paths only depend on the travel times. Among them, the
+     *  quiet route only depends on the passenger counts of the stations along
+     *  the candidate paths: A passenger event at any other station cannot
+     *  change the result.
+     *
+     *  \param dependencies     Filled with the sorted IDs of the stations
+     *                          along the candidate paths. Empty if there is no
+     *                          choice to make.
+     *
+     *  All other parameters are the same as in the `GetQuietTravelRoute`
+     *  overload without dependencies.
+     */
+    TravelRoute GetQuietTravelRoute(
+        const Id& stationA,
+        const Id& stationB,
+        const double maxSlowdownPc,
+        const double minQuietnessPc,
+        const size_t maxNPaths,
+        std::vector<Id>& dependencies
+    ) const;
+
 private:
     // Forward-declare all internal structs.
     struct GraphNode;
@@ -494,6 +550,18 @@ private:
         const size_t maxNPaths = std::numeric_limits<size_t>::max()
     ) const;
 
+    // Internal version of GetQuietTravelRoute.
+    // If dependencies is not nullptr, we also collect the stations along the
+    // candidate paths.
+    TravelRoute GetQuietTravelRoute(
+        const Id& stationA,
+        const Id& stationB,
+        const double maxSlowdownPc,
+        const double minQuietnessPc,
+        const size_t maxNPaths,
+        std::vector<Id>* dependencies
+    ) const;
+
     // Get the total crowding over a given path.
     unsigned int GetPathCrowding(
         const Path& path
@@ -1,6 +1,8 @@
 #ifndef NETWORK_MONITOR_WEBSOCKET_CLIENT_H
 #define NETWORK_MONITOR_WEBSOCKET_CLIENT_H
 
+#include <network-monitor/WebsocketCompression.h>
+
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast.hpp>
@@ -12,11 +14,16 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ostr.h>
 
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace NetworkMonitor {
 
@@ -55,8 +62,10 @@ public:
     ) : url_ {url},
         endpoint_ {endpoint},
         port_ {port},
-        resolver_ {boost::asio::make_strand(ioc)},
-        ws_ {boost::asio::make_strand(ioc), ctx}
+        ctx_ {ctx},
+        context_ {boost::asio::make_strand(ioc)},
+        resolver_ {context_},
+        ws_ {std::in_place, context_, ctx}
     {
         spdlog::info("WebsocketClient: New client for {}:{}{}",
                      url_, port_, endpoint_);
@@ -67,6 +76,10 @@ public:
     ~WebsocketClient() = default;
 
     /*! \brief Connect to the server.
+     *
+     *  The client can connect again after it has been disconnected or closed.
+     *  The messages still queued for the previous connection fail with
+     *  operation_aborted.
      *
      *  \param onConnect     Called when the connection fails or succeeds.
      *  \param onMessage     Called only when a message is successfully
@@ -82,26 +95,48 @@ public:
         std::function<void (boost::system::error_code)> onDisconnect = nullptr
     )
     {
-        // Save the user callbacks for later use.
-        onConnect_ = onConnect;
-        onMessage_ = onMessage;
-        onDisconnect_ = onDisconnect;
-
-        // Start the chain of asynchronous callbacks.
-        closed_ = false;
-        spdlog::info("WebsocketClient: Attempting to resolve {}:{}",
-                     url_, port_);
-        resolver_.async_resolve(url_, port_,
-            [this](auto ec, auto resolverIt) {
-                OnResolve(ec, resolverIt);
+        // The stream is replaced on the Websocket strand, as the other
+        // threads only ever reach it through that strand.
+        boost::asio::dispatch(context_,
+            [this, onConnect, onMessage, onDisconnect]() {
+                // Save the user callbacks for later use.
+                onConnect_ = onConnect;
+                onMessage_ = onMessage;
+                onDisconnect_ = onDisconnect;
+
+                // A Websocket stream cannot be reused once it has been
+                // connected, so we start from a fresh one when connecting
+                // again.
+                if (hasConnected_) {
+                    ResetStream();
+                }
+                hasConnected_ = true;
+                ws_->set_option(ToPermessageDeflate(compression_));
+
+                // Start the chain of asynchronous callbacks.
+                closed_ = false;
+                closing_ = false;
+                readStalled_ = false;
+                spdlog::info("WebsocketClient: Attempting to resolve {}:{}",
+                             url_, port_);
+                resolver_.async_resolve(url_, port_,
+                    [this, generation = generation_](auto ec, auto resolverIt) {
+                        if (generation != generation_) {
+                            return;
+                        }
+                        OnResolve(ec, resolverIt);
+                    }
+                );
             }
         );
     }
 
     /*! \brief Send a text message to the Websocket server.
      *
-     *  \param message The message to send. The caller must ensure that this
-     *                 string stays in scope until the onSend handler is called.
+     *  Messages are queued and written one at a time, in the order they are
+     *  sent. This function can be called from any thread.
+     *
+     *  \param message The message to send. The client keeps its own copy.
      *  \param onSend  Called when a message is sent successfully or if it
      *                 failed to send.
      */
@@ -110,17 +145,112 @@ public:
         std::function<void (boost::system::error_code)> onSend = nullptr
     )
     {
-        spdlog::info("WebsocketClient: Sending message");
-        ws_.async_write(boost::asio::buffer(message),
-            [onSend](auto ec, auto) {
-                if (onSend) {
-                    onSend(ec);
+        Send(std::make_shared<const std::string>(message), onSend);
+    }
+
+    /*! \brief Send a text message to the Websocket server.
+     *
+     *  \param message The message to send. Ownership is passed to the client.
+     *  \param onSend  Called when a message is sent successfully or if it
+     *                 failed to send.
+     */
+    void Send(
+        std::string&& message,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
+    {
+        Send(std::make_shared<const std::string>(std::move(message)), onSend);
+    }
+
+    /*! \brief Send a text message to the Websocket server.
+     *
+     *  Use this overload to send the same buffer to many clients without
+     *  copying it.
+     *
+     *  \param message The message to send. The client holds a reference to it
+     *                 until the onSend handler is called.
+     *  \param onSend  Called when a message is sent successfully or if it
+     *                 failed to send.
+     */
+    void Send(
+        std::shared_ptr<const std::string> message,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
+    {
+        spdlog::debug("WebsocketClient: Queueing {}-byte message",
+                      message->size());
+        queueDepth_ += 1;
+        queuedBytes_ += message->size();
+        boost::asio::dispatch(context_,
+            [this, message {std::move(message)}, onSend]() mutable {
+                // The close frame may already be on its way.
+                if (closing_) {
+                    queueDepth_ -= 1;
+                    queuedBytes_ -= message->size();
+                    if (onSend) {
+                        onSend(boost::asio::error::operation_aborted);
+                    }
+                    return;
                 }
+                outbox_.push_back({std::move(message), std::move(onSend)});
+                WriteNext();
             }
         );
     }
 
+    /*! \brief Write the pending messages in batches.
+     *
+     *  When a write completes, the messages that were queued in the meantime
+     *  are concatenated into a single Websocket message, up to maxBatchSize
+     *  bytes. Messages larger than maxBatchSize are always sent on their own.
+     *
+     *  \note Only enable this if the server can split a Websocket message into
+     *        the original messages, like a STOMP server does with batched
+     *        frames. The default, 0, sends one Websocket message per call to
+     *        Send.
+     */
+    void SetMaxBatchSize(
+        const size_t maxBatchSize
+    )
+    {
+        maxBatchSize_ = maxBatchSize;
+    }
+
+    /*! \brief Offer the permessage-deflate extension to the server.
+     *
+     *  \note Call this before Connect. By default, compression is disabled.
+     */
+    void SetCompression(
+        const WebsocketCompressionOptions& options
+    )
+    {
+        compression_ = options;
+    }
+
+    /*! \brief Get the number of messages waiting to be sent, including the
+     *         ones being written.
+     */
+    size_t GetQueueDepth() const
+    {
+        return queueDepth_;
+    }
+
+    /*! \brief Get the number of bytes waiting to be sent, including the ones
+     *         being written.
+     *
+     *  Use this to apply backpressure on a publisher.
+     */
+    size_t GetQueuedBytes() const
+    {
+        return queuedBytes_;
+    }
+
     /*! \brief Close the Websocket connection.
+     *
+     *  The connection is closed after the messages that are already queued
+     *  have been sent. The messages sent after this call fail with
+     *  boost::asio::error::operation_aborted, until the client connects
+     *  again.
      *
      *  \param onClose Called when the connection is closed, successfully or
      *                 not.
@@ -131,35 +261,164 @@ public:
     {
         spdlog::info("WebsocketClient: Closing connection");
         closed_ = true;
-        ws_.async_close(
-            boost::beast::websocket::close_code::none,
-            [onClose](auto ec) {
-                if (onClose) {
-                    onClose(ec);
+        boost::asio::dispatch(context_,
+            [this, onClose]() {
+                closing_ = true;
+                pendingClose_ = true;
+                onClose_ = onClose;
+                if (inFlight_.empty()) {
+                    CloseNow();
                 }
             }
         );
     }
 
+    /*! \brief Stop reading incoming messages until ResumeReading is called.
+     *
+     *  The messages wait in the socket buffers, and TCP flow control slows the
+     *  server down. Use this to apply backpressure on the server.
+     *
+     *  Pauses nest: Reading resumes once every PauseReading call has been
+     *  matched by a ResumeReading call. A pause lasts across reconnections.
+     *
+     *  \note While reading is paused, a disconnection is only noticed once
+     *        reading resumes.
+     */
+    void PauseReading()
+    {
+        boost::asio::dispatch(context_,
+            [this]() {
+                ++readPauses_;
+            }
+        );
+    }
+
+    /*! \brief Resume reading incoming messages after PauseReading.
+     */
+    void ResumeReading()
+    {
+        boost::asio::dispatch(context_,
+            [this]() {
+                --readPauses_;
+                if (readPauses_ <= 0 && readStalled_) {
+                    readStalled_ = false;
+                    ListenToIncomingMessage({});
+                }
+            }
+        );
+    }
+
+    /*! \brief Drop the connection right away, without the Websocket closing
+     *         handshake.
+     *
+     *  Use this when the server stopped responding: A closing handshake would
+     *  wait for a reply that may never come. The pending operations fail and
+     *  the onDisconnect handler passed to Connect is called.
+     */
+    void Abort()
+    {
+        spdlog::info("WebsocketClient: Aborting connection");
+        boost::asio::dispatch(context_,
+            [this]() {
+                boost::beast::get_lowest_layer(*ws_).close();
+            }
+        );
+    }
+
 private:
     std::string url_ {};
     std::string endpoint_ {};
     std::string port_ {};
 
+    boost::asio::ssl::context& ctx_;
+
+    // The stream is replaced on every new connection, so we keep its strand
+    // apart. All the client state is only accessed from this strand, except
+    // for the atomic members.
     // We leave these uninitialized because they do not support a default
     // constructor.
+    boost::asio::strand<boost::asio::io_context::executor_type> context_;
     Resolver resolver_;
-    WebsocketStream ws_;
+    std::optional<WebsocketStream> ws_;
+
+    // The handlers of a replaced stream, or of a superseded connection
+    // attempt, are stale: We tell them apart with a generation counter.
+    size_t generation_ {0};
 
     boost::beast::flat_buffer rBuffer_ {};
 
-    bool closed_ {true};
+    // Close sets this flag right away, so that the read loop does not report
+    // the disconnection it causes.
+    std::atomic<bool> closed_ {true};
+    bool hasConnected_ {false};
+
+    WebsocketCompressionOptions compression_ {};
+
+    // While reading is paused, the read loop stalls instead of starting the
+    // next read. Pause and resume calls may come from different strands, so
+    // they can reach us in any order: Only the count matters.
+    int readPauses_ {0};
+    bool readStalled_ {false};
+
+    struct OutboundMessage {
+        std::shared_ptr<const std::string> message {};
+        std::function<void (boost::system::error_code)> onSend {nullptr};
+    };
+
+    // The outbound queue is only accessed from the Websocket strand. The
+    // messages in inFlight_ and the buffers in wBuffers_ stay alive until
+    // their write completes.
+    std::deque<OutboundMessage> outbox_ {};
+    std::vector<OutboundMessage> inFlight_ {};
+    std::vector<boost::asio::const_buffer> wBuffers_ {};
+    std::atomic<size_t> maxBatchSize_ {0};
+    std::atomic<size_t> queueDepth_ {0};
+    std::atomic<size_t> queuedBytes_ {0};
+
+    // A close waits for the write in flight, if any. The messages that reach
+    // the strand after the close are not queued.
+    bool closing_ {false};
+    bool pendingClose_ {false};
+    std::function<void (boost::system::error_code)> onClose_ {nullptr};
 
     std::function<void (boost::system::error_code)> onConnect_ {nullptr};
     std::function<void (boost::system::error_code,
                         std::string&&)> onMessage_ {nullptr};
     std::function<void (boost::system::error_code)> onDisconnect_ {nullptr};
 
+    void ResetStream()
+    {
+        ++generation_;
+        ws_.emplace(context_, ctx_);
+        rBuffer_.consume(rBuffer_.size());
+
+        // The old stream cannot send anything anymore.
+        auto dropped {std::move(inFlight_)};
+        inFlight_.clear();
+        wBuffers_.clear();
+        while (!outbox_.empty()) {
+            dropped.push_back(std::move(outbox_.front()));
+            outbox_.pop_front();
+        }
+        for (const auto& message: dropped) {
+            queueDepth_ -= 1;
+            queuedBytes_ -= message.message->size();
+        }
+        pendingClose_ = false;
+        auto onClose {std::move(onClose_)};
+        onClose_ = nullptr;
+
+        // The handlers may call Send, so we call them last.
+        for (const auto& message: dropped) {
+            if (message.onSend) {
+                message.onSend(boost::asio::error::operation_aborted);
+            }
+        }
+        if (onClose) {
+            onClose(boost::asio::error::operation_aborted);
+        }
+    }
+
     void OnResolve(
         const boost::system::error_code& ec,
         boost::asio::ip::tcp::resolver::iterator resolverIt
@@ -180,15 +439,18 @@ private:
         // the TCP socket. We will reset the timeout to a sensible default
         // after we are connected.
         // Note: The TCP layer is the lowest layer (Websocket -> TLS -> TCP).
-        boost::beast::get_lowest_layer(ws_).expires_after(
+        boost::beast::get_lowest_layer(*ws_).expires_after(
             std::chrono::seconds(5)
         );
 
         // Connect to the TCP socket.
         // Note: The TCP layer is the lowest layer (Websocket -> TLS -> TCP).
         spdlog::info("WebsocketClient: Attempting connection to server");
-        boost::beast::get_lowest_layer(ws_).async_connect(*resolverIt,
-            [this](auto ec) {
+        boost::beast::get_lowest_layer(*ws_).async_connect(*resolverIt,
+            [this, generation = generation_](auto ec) {
+                if (generation != generation_) {
+                    return;
+                }
                 OnConnect(ec);
             }
         );
@@ -211,8 +473,8 @@ private:
         // Now that the TCP socket is connected, we can reset the timeout to
         // whatever Boost.Beast recommends.
         // Note: The TCP layer is the lowest layer (Websocket -> TLS -> TCP).
-        boost::beast::get_lowest_layer(ws_).expires_never();
-        ws_.set_option(
+        boost::beast::get_lowest_layer(*ws_).expires_never();
+        ws_->set_option(
             boost::beast::websocket::stream_base::timeout::suggested(
                 boost::beast::role_type::client
             )
@@ -222,15 +484,18 @@ private:
         // handshake or the connection will fail. We use an OpenSSL function
         // for that.
         SSL_set_tlsext_host_name(
-            ws_.next_layer().native_handle(),
+            ws_->next_layer().native_handle(),
             url_.c_str()
         );
 
         // Attempt a TLS handshake.
         // Note: The TLS layer is the next layer (Websocket -> TLS -> TCP).
         spdlog::info("WebsocketClient: Wait for TLS handshake");
-        ws_.next_layer().async_handshake(boost::asio::ssl::stream_base::client,
-            [this](auto ec) {
+        ws_->next_layer().async_handshake(boost::asio::ssl::stream_base::client,
+            [this, generation = generation_](auto ec) {
+                if (generation != generation_) {
+                    return;
+                }
                 OnTlsHandshake(ec);
             }
         );
@@ -254,8 +519,11 @@ private:
 
         // Attempt a Websocket handshake.
         spdlog::info("WebsocketClient: Wait for Websocket handshake");
-        ws_.async_handshake(url_, endpoint_,
-            [this](auto ec) {
+        ws_->async_handshake(url_, endpoint_,
+            [this, generation = generation_](auto ec) {
+                if (generation != generation_) {
+                    return;
+                }
                 OnHandshake(ec);
             }
         );
@@ -278,7 +546,7 @@ private:
         spdlog::info("WebsocketClient: Websocket handshake completed");
 
         // Tell the Websocket object to exchange messages in text format.
-        ws_.text(true);
+        ws_->text(true);
 
         // Now that we are connected, set up a recursive asynchronous listener
         // to receive messages.
@@ -292,6 +560,92 @@ private:
         }
     }
 
+    void WriteNext()
+    {
+        // Keep exactly one write in flight.
+        if (!inFlight_.empty()) {
+            return;
+        }
+
+        // Take the first message, then as many of the following ones as fit in
+        // a batch.
+        const size_t maxBatchSize {maxBatchSize_};
+        size_t batchSize {0};
+        while (!outbox_.empty()) {
+            const auto size {outbox_.front().message->size()};
+            if (!inFlight_.empty() && batchSize + size > maxBatchSize) {
+                break;
+            }
+            batchSize += size;
+            wBuffers_.push_back(boost::asio::buffer(*outbox_.front().message));
+            inFlight_.push_back(std::move(outbox_.front()));
+            outbox_.pop_front();
+        }
+        if (inFlight_.empty()) {
+            if (pendingClose_) {
+                CloseNow();
+            }
+            return;
+        }
+        spdlog::info("WebsocketClient: Sending {} message(s), {} bytes",
+                     inFlight_.size(), batchSize);
+        if (compression_.enabled && compression_.stats != nullptr) {
+            compression_.stats->RecordMessage(wBuffers_);
+        }
+        ws_->async_write(wBuffers_,
+            [this, batchSize, generation = generation_](auto ec, auto) {
+                if (generation != generation_) {
+                    return;
+                }
+                OnWrite(ec, batchSize);
+            }
+        );
+    }
+
+    void OnWrite(
+        const boost::system::error_code& ec,
+        const size_t batchSize
+    )
+    {
+        // Move the callbacks out before calling them, as they may call Send.
+        auto written {std::move(inFlight_)};
+        inFlight_.clear();
+        wBuffers_.clear();
+        queueDepth_ -= written.size();
+        queuedBytes_ -= batchSize;
+
+        // After a failed write the stream cannot be used anymore, so we fail
+        // the messages that are still queued, too.
+        if (ec) {
+            while (!outbox_.empty()) {
+                queueDepth_ -= 1;
+                queuedBytes_ -= outbox_.front().message->size();
+                written.push_back(std::move(outbox_.front()));
+                outbox_.pop_front();
+            }
+        }
+        for (const auto& message: written) {
+            if (message.onSend) {
+                message.onSend(ec);
+            }
+        }
+        WriteNext();
+    }
+
+    void CloseNow()
+    {
+        pendingClose_ = false;
+        ws_->async_close(
+            boost::beast::websocket::close_code::none,
+            [onClose = std::move(onClose_)](auto ec) {
+                if (onClose) {
+                    onClose(ec);
+                }
+            }
+        );
+        onClose_ = nullptr;
+    }
+
     void ListenToIncomingMessage(
         const boost::system::error_code& ec
     )
@@ -307,11 +661,19 @@ private:
             return;
         }
 
+        if (readPauses_ > 0) {
+            readStalled_ = true;
+            return;
+        }
+
         // Read a message asynchronously. On a successful read, process the
         // message and recursively call this function again to process the next
         // message.
-        ws_.async_read(rBuffer_,
-            [this](auto ec, auto nBytes) {
+        ws_->async_read(rBuffer_,
+            [this, generation = generation_](auto ec, auto nBytes) {
+                if (generation != generation_) {
+                    return;
+                }
                 OnRead(ec, nBytes);
                 ListenToIncomingMessage(ec);
             }
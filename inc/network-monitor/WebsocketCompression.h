@@ -0,0 +1,132 @@
+#ifndef NETWORK_MONITOR_WEBSOCKET_COMPRESSION_H
+#define NETWORK_MONITOR_WEBSOCKET_COMPRESSION_H
+
+#include <boost/asio.hpp>
+#include <boost/beast/websocket/option.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace NetworkMonitor {
+
+class WebsocketCompressionStats;
+
+/*! \brief Options of the Websocket permessage-deflate extension (RFC 7692).
+ *
+ *  Both peers offer the extension in the Websocket handshake. Messages are
+ *  only compressed if both sides enable it.
+ */
+struct WebsocketCompressionOptions {
+    bool enabled {false};
+
+    // Size of the LZ77 window, as a power of 2, from 9 to 15. A smaller window
+    // saves memory on both sides, at the cost of a worse ratio.
+    int windowBits {15};
+
+    // Memory used by the compressor, from 1 to 9.
+    int memLevel {4};
+
+    // From 0 (no compression) to 9 (best compression, most CPU).
+    int compressionLevel {8};
+
+    // Messages smaller than this are sent uncompressed.
+    // Note: Only supported from Boost 1.77. Older versions compress all the
+    //       messages, and a warning is logged.
+    size_t minMessageSize {0};
+
+    // If set, the metrics of the compressed messages are recorded here. One
+    // object can be shared by many connections.
+    std::shared_ptr<WebsocketCompressionStats> stats {nullptr};
+};
+
+/*! \brief Convert the compression options to the Boost.Beast option.
+ *
+ *  The values out of range are clamped.
+ */
+boost::beast::websocket::permessage_deflate ToPermessageDeflate(
+    const WebsocketCompressionOptions& options
+);
+
+/*! \brief Compression metrics of the messages sent on one or more Websocket
+ *         connections.
+ */
+struct WebsocketCompressionReport {
+    // All the messages sent.
+    size_t nMessages {0};
+
+    // The messages that are large enough to be compressed.
+    size_t nCompressible {0};
+
+    // The compressible messages that were measured.
+    size_t nSampled {0};
+    size_t sampledBytes {0};
+    size_t sampledCompressedBytes {0};
+    std::chrono::nanoseconds sampledCpuTime {0};
+
+    /*! \brief Get the compressed size over the original size of the sampled
+     *         messages.
+     *
+     *  \returns 1.0 if no message has been sampled.
+     */
+    double GetRatio() const;
+
+    /*! \brief Get the average time to compress a sampled message.
+     */
+    std::chrono::nanoseconds GetCpuTimePerMessage() const;
+};
+
+/*! \brief Measure the permessage-deflate compression of the sent messages.
+ *
+ *  Boost.Beast does not report the size of the compressed messages. Instead, a
+ *  sample of the messages is compressed again with the same settings and
+ *  timed. Each sample is compressed on its own, while a connection reuses the
+ *  compression context of the previous messages: The real ratio is the same
+ *  or better.
+ *
+ *  The metrics assume that the peer accepted the extension.
+ *
+ *  \note This class is thread-safe.
+ */
+class WebsocketCompressionStats {
+public:
+    /*! \brief Construct the metrics for the given compression settings.
+     *
+     *  \param options      The settings of the connections that record their
+     *                      messages here.
+     *  \param sampleEvery  Measure one compressible message out of
+     *                      sampleEvery. Sampling doubles the compression cost
+     *                      of the sampled messages.
+     */
+    WebsocketCompressionStats(
+        const WebsocketCompressionOptions& options,
+        const size_t sampleEvery = 1
+    );
+
+    /*! \brief Record a sent message.
+     *
+     *  \param message The buffers of a single Websocket message.
+     */
+    void RecordMessage(
+        const std::vector<boost::asio::const_buffer>& message
+    );
+
+    /*! \brief Get the metrics recorded so far.
+     */
+    WebsocketCompressionReport GetReport() const;
+
+private:
+    int windowBits_ {15};
+    int memLevel_ {4};
+    int compressionLevel_ {8};
+    size_t minMessageSize_ {0};
+    size_t sampleEvery_ {1};
+
+    mutable std::mutex mutex_ {};
+    WebsocketCompressionReport report_ {};
+};
+
+} // namespace NetworkMonitor
+
+#endif // NETWORK_MONITOR_WEBSOCKET_COMPRESSION_H
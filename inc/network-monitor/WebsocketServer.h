@@ -1,6 +1,8 @@
 #ifndef NETWORK_MONITOR_WEBSOCKET_SERVER_H
 #define NETWORK_MONITOR_WEBSOCKET_SERVER_H
 
+#include <network-monitor/WebsocketCompression.h>
+
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast.hpp>
@@ -12,14 +14,24 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ostr.h>
 
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace NetworkMonitor {
 
+/*! \brief What a Websocket session does when the bytes waiting to be sent to
+ *         the client go above the high-water mark.
+ */
+enum class SlowConsumerPolicy {
+    kPauseReading,
+    kDisconnect,
+};
 
 /*! \brief Object representing a single connection to a Websocket client.
  *
@@ -75,8 +87,10 @@ public:
 
     /*! \brief Send a text message to the connected Websocket client.
      *
-     *  \param message The message to send. The caller must ensure that this
-     *                 string stays in scope until the onSend handler is called.
+     *  This function can be called from any thread. The messages are queued
+     *  and written in order on the session strand, one write at a time.
+     *
+     *  \param message The message to send. The session keeps its own copy.
      *  \param onSend  Called when a message is sent successfully or if it
      *                 failed to send.
      */
@@ -84,21 +98,141 @@ public:
         const std::string& message,
         std::function<void (boost::system::error_code)> onSend = nullptr
     )
+    {
+        Send(std::make_shared<const std::string>(message), onSend);
+    }
+
+    /*! \brief Send a text message to the connected Websocket client.
+     *
+     *  \param message The message to send. Ownership is passed to the session.
+     *  \param onSend  Called when a message is sent successfully or if it
+     *                 failed to send.
+     */
+    void Send(
+        std::string&& message,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
+    {
+        Send(std::make_shared<const std::string>(std::move(message)), onSend);
+    }
+
+    /*! \brief Send a text message to the connected Websocket client.
+     *
+     *  Use this overload to send the same message to many sessions without
+     *  copying it.
+     *
+     *  \param message The message to send. The session shares ownership of it
+     *                 until the write completes.
+     *  \param onSend  Called when a message is sent successfully or if it
+     *                 failed to send. If the session is disconnected because
+     *                 the client is too slow, the queued messages fail with
+     *                 boost::asio::error::no_buffer_space.
+     */
+    void Send(
+        std::shared_ptr<const std::string> message,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
+    {
+        Send(nullptr, std::move(message), onSend);
+    }
+
+    /*! \brief Send a text message made of two parts to the connected
+     *         Websocket client.
+     *
+     *  The two parts are written back to back in the same Websocket message.
+     *  Use this overload to send a message that is mostly the same for many
+     *  sessions: Each session has its own head and shares the tail.
+     *
+     *  \param head    The first part of the message. If nullptr, the message
+     *                 is just the tail.
+     *  \param tail    The rest of the message.
+     *  \param onSend  Called when a message is sent successfully or if it
+     *                 failed to send.
+     *
+     *  \note This method can be called from any thread. The message is queued
+     *        on the session strand, and only one write is in flight at a time,
+     *        so the session can be shared by the threads that run the
+     *        io_context.
+     */
+    void Send(
+        std::shared_ptr<const std::string> head,
+        std::shared_ptr<const std::string> tail,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    )
     {
         auto self {this->shared_from_this()};
-        spdlog::info("WebsocketSession: [{}] Sending message", self);
-        ws_.async_write(boost::asio::buffer(message),
-            [onSend](auto ec, auto) {
-                if (onSend) {
-                    onSend(ec);
+        OutboundMessage message {std::move(head), std::move(tail), onSend};
+        const auto size {message.GetSize()};
+        spdlog::debug("WebsocketSession: [{}] Queueing {}-byte message",
+                      self, size);
+        queueDepth_ += 1;
+        queuedBytes_ += size;
+        boost::asio::dispatch(ws_.get_executor(),
+            [self, message {std::move(message)}]() mutable {
+                // The close frame may already be on its way.
+                if (self->closed_) {
+                    self->queueDepth_ -= 1;
+                    self->queuedBytes_ -= message.GetSize();
+                    if (message.onSend) {
+                        message.onSend(boost::asio::error::operation_aborted);
+                    }
+                    return;
                 }
-        });
+                self->outbox_.push_back(std::move(message));
+                if (self->overflowed_) {
+                    self->FailQueued(boost::asio::error::no_buffer_space);
+                    return;
+                }
+                if (self->IsAboveHighWaterMark() &&
+                    self->slowConsumerPolicy_ ==
+                        SlowConsumerPolicy::kDisconnect) {
+                    self->DisconnectSlowConsumer();
+                    return;
+                }
+                self->WriteNext();
+            }
+        );
+    }
+
+    /*! \brief Get the number of messages waiting to be sent, including the
+     *         ones being written.
+     */
+    size_t GetQueueDepth() const
+    {
+        return queueDepth_;
+    }
+
+    /*! \brief Get the number of bytes waiting to be sent, including the ones
+     *         being written.
+     */
+    size_t GetQueuedBytes() const
+    {
+        return queuedBytes_;
+    }
+
+    /*! \brief Check if the session has stopped reading the client, because
+     *         the client is too slow to take our messages.
+     *
+     *  This only happens with SlowConsumerPolicy::kPauseReading. While paused,
+     *  the messages of the client wait in the socket.
+     */
+    bool IsReadingPaused() const
+    {
+        return readStalled_;
     }
 
     /*! \brief Close the Websocket connection.
+     *
+     *  The connection is closed after the messages that are already queued
+     *  have been sent. The messages sent after this call fail with
+     *  boost::asio::error::operation_aborted.
      *
      *  \param onClose Called when the connection is closed, successfully or
-     *                 not.
+     *                 not. If the session was already closing, it is called
+     *                 with boost::asio::error::operation_aborted.
+     *
+     *  \note This method can be called from any thread. The close runs on the
+     *        session strand.
      */
     void Close(
         std::function<void (boost::system::error_code)> onClose = nullptr
@@ -106,15 +240,29 @@ public:
     {
         auto self {this->shared_from_this()};
         spdlog::info("WebsocketSession: [{}] Closing session", self);
-        closed_ = true;
-        ws_.async_close(
-            boost::beast::websocket::close_code::none,
-            [onClose](auto ec) {
+        boost::asio::dispatch(ws_.get_executor(), [self, onClose]() {
+            // Only the first call closes the connection.
+            if (self->closed_) {
                 if (onClose) {
-                    onClose(ec);
+                    onClose(boost::asio::error::operation_aborted);
                 }
+                return;
             }
-        );
+            self->closed_ = true;
+
+            // A slow client has already been disconnected.
+            if (self->overflowed_) {
+                if (onClose) {
+                    onClose(boost::asio::error::operation_aborted);
+                }
+                return;
+            }
+            self->pendingClose_ = true;
+            self->onClose_ = onClose;
+            if (self->inFlight_.empty()) {
+                self->WriteNext();
+            }
+        });
     }
 
 private:
@@ -132,6 +280,41 @@ private:
 
     bool closed_ {false};
 
+    // Set by the WebsocketServer before the session connects.
+    size_t maxBatchSize_ {0};
+    size_t highWaterMark_ {0};
+    SlowConsumerPolicy slowConsumerPolicy_ {SlowConsumerPolicy::kPauseReading};
+    WebsocketCompressionOptions compression_ {};
+
+    struct OutboundMessage {
+        std::shared_ptr<const std::string> head {};
+        std::shared_ptr<const std::string> message {};
+        std::function<void (boost::system::error_code)> onSend {nullptr};
+
+        size_t GetSize() const
+        {
+            return (head == nullptr ? 0 : head->size()) + message->size();
+        }
+    };
+
+    // The outbound queue is only accessed from the session strand. The
+    // messages in inFlight_ and the buffers in wBuffers_ stay alive until
+    // their write completes.
+    std::deque<OutboundMessage> outbox_ {};
+    std::vector<OutboundMessage> inFlight_ {};
+    std::vector<boost::asio::const_buffer> wBuffers_ {};
+    std::atomic<size_t> queueDepth_ {0};
+    std::atomic<size_t> queuedBytes_ {0};
+
+    // While the client is too slow to take our messages, we stop reading its
+    // requests, or we drop it.
+    std::atomic<bool> readStalled_ {false};
+    bool overflowed_ {false};
+
+    // A close waits for the queued messages to be written.
+    bool pendingClose_ {false};
+    std::function<void (boost::system::error_code)> onClose_ {nullptr};
+
     // The connection method is kept private, because we expect the
     // WebsocketServer class to initiate the connection.
     void Connect(
@@ -206,6 +389,7 @@ private:
             boost::beast::role_type::server
         )};
         ws_.set_option(option);
+        ws_.set_option(ToPermessageDeflate(compression_));
 
         // Wait for and accept the Websocket handshake.
         // Note: Here we copy `self` (std::shared_ptr) into the lambda,
@@ -270,6 +454,17 @@ private:
             return;
         }
 
+        // Stop reading while the client does not keep up with our messages.
+        // Reading resumes once the queue has drained to half the high-water
+        // mark.
+        if (IsAboveHighWaterMark() &&
+            slowConsumerPolicy_ == SlowConsumerPolicy::kPauseReading) {
+            spdlog::warn("WebsocketSession: [{}] Client is slow: {} bytes "
+                         "queued. Pausing reads", self, queuedBytes_.load());
+            readStalled_ = true;
+            return;
+        }
+
         // Read a message asynchronously. On a successful read, process the
         // message and recursively call this function again to process the next
         // message.
@@ -304,6 +499,134 @@ private:
             onMessage_(ec, self, std::move(message));
         }
     }
+
+    bool IsAboveHighWaterMark() const
+    {
+        return highWaterMark_ > 0 && queuedBytes_ > highWaterMark_;
+    }
+
+    void WriteNext()
+    {
+        // Keep exactly one write in flight.
+        if (!inFlight_.empty()) {
+            return;
+        }
+
+        // Take the first message, then as many of the following ones as fit in
+        // a batch.
+        size_t batchSize {0};
+        while (!outbox_.empty()) {
+            const auto& message {outbox_.front()};
+            const auto size {message.GetSize()};
+            if (!inFlight_.empty() && batchSize + size > maxBatchSize_) {
+                break;
+            }
+            batchSize += size;
+            if (message.head != nullptr) {
+                wBuffers_.push_back(boost::asio::buffer(*message.head));
+            }
+            wBuffers_.push_back(boost::asio::buffer(*message.message));
+            inFlight_.push_back(std::move(outbox_.front()));
+            outbox_.pop_front();
+        }
+        if (inFlight_.empty()) {
+            if (pendingClose_) {
+                CloseNow(boost::beast::websocket::close_code::none);
+            }
+            return;
+        }
+        auto self {this->shared_from_this()};
+        spdlog::info("WebsocketSession: [{}] Sending {} message(s), {} bytes",
+                     self, inFlight_.size(), batchSize);
+        if (compression_.enabled && compression_.stats != nullptr) {
+            compression_.stats->RecordMessage(wBuffers_);
+        }
+        ws_.async_write(wBuffers_,
+            [self, batchSize](auto ec, auto) {
+                self->OnWrite(ec, batchSize);
+            }
+        );
+    }
+
+    void OnWrite(
+        const boost::system::error_code& ec,
+        const size_t batchSize
+    )
+    {
+        // Move the callbacks out before calling them, as they may call Send.
+        auto written {std::move(inFlight_)};
+        inFlight_.clear();
+        wBuffers_.clear();
+        queueDepth_ -= written.size();
+        queuedBytes_ -= batchSize;
+        for (const auto& message: written) {
+            if (message.onSend) {
+                message.onSend(ec);
+            }
+        }
+
+        // After a failed write the stream cannot be used anymore, so we fail
+        // the messages that are still queued, too.
+        if (ec) {
+            FailQueued(ec);
+        }
+        if (readStalled_ && (ec || queuedBytes_ <= highWaterMark_ / 2)) {
+            spdlog::info("WebsocketSession: [{}] Resuming reads",
+                         this->shared_from_this());
+            readStalled_ = false;
+            ListenToIncomingMessage({});
+        }
+        WriteNext();
+    }
+
+    void FailQueued(
+        const boost::system::error_code& ec
+    )
+    {
+        auto failed {std::move(outbox_)};
+        outbox_.clear();
+        for (const auto& message: failed) {
+            queueDepth_ -= 1;
+            queuedBytes_ -= message.GetSize();
+        }
+        for (const auto& message: failed) {
+            if (message.onSend) {
+                message.onSend(ec);
+            }
+        }
+    }
+
+    void DisconnectSlowConsumer()
+    {
+        auto self {this->shared_from_this()};
+        spdlog::warn("WebsocketSession: [{}] Client is slow: {} bytes queued. "
+                     "Disconnecting", self, queuedBytes_.load());
+        overflowed_ = true;
+        FailQueued(boost::asio::error::no_buffer_space);
+
+        // The close frame waits for the write in flight, which may never
+        // complete if the client stopped reading: We give it a deadline.
+        boost::beast::get_lowest_layer(ws_).expires_after(
+            std::chrono::seconds(5)
+        );
+        CloseNow(boost::beast::websocket::close_code::policy_error);
+    }
+
+    void CloseNow(
+        const boost::beast::websocket::close_code code
+    )
+    {
+        pendingClose_ = false;
+        ws_.async_close(
+            code,
+            [onClose = std::move(onClose_)](auto ec) {
+                if (onClose) {
+                    onClose(ec);
+                }
+            }
+        );
+        onClose_ = nullptr;
+    }
 };
 
 /*! \brief Websocket server class
@@ -439,9 +762,67 @@ public:
         return ec;
     }
 
+    /*! \brief Write the pending messages of each session in batches.
+     *
+     *  When a write completes, the messages that were queued in the meantime
+     *  are concatenated into a single Websocket message, up to maxBatchSize
+     *  bytes. Messages larger than maxBatchSize are always sent on their own.
+     *
+     *  \note Only enable this if the client can split a Websocket message into
+     *        the original messages, like a STOMP client does with batched
+     *        frames. The default, 0, sends one Websocket message per call to
+     *        Send.
+     *
+     *  \note Call this before Run. It applies to the sessions accepted after
+     *        the call.
+     */
+    void SetMaxBatchSize(
+        const size_t maxBatchSize
+    )
+    {
+        sessionMaxBatchSize_ = maxBatchSize;
+    }
+
+    /*! \brief Limit the bytes waiting to be sent to each client.
+     *
+     *  When the messages queued for a client go above highWaterMark bytes, the
+     *  session either stops reading the client messages until the queue has
+     *  drained to half the high-water mark, or it drops the connection and
+     *  fails the queued messages.
+     *
+     *  \param highWaterMark   The limit in bytes. The default, 0, means no
+     *                         limit.
+     *  \param policy          What to do with a client that goes above the
+     *                         limit.
+     *
+     *  \note Call this before Run. It applies to the sessions accepted after
+     *        the call.
+     */
+    void SetHighWaterMark(
+        const size_t highWaterMark,
+        const SlowConsumerPolicy policy = SlowConsumerPolicy::kPauseReading
+    )
+    {
+        sessionHighWaterMark_ = highWaterMark;
+        slowConsumerPolicy_ = policy;
+    }
+
+    /*! \brief Accept the permessage-deflate extension if a client offers it.
+     *
+     *  \note Call this before Run. It applies to the sessions accepted after
+     *        the call. By default, compression is disabled.
+     */
+    void SetCompression(
+        const WebsocketCompressionOptions& options
+    )
+    {
+        sessionCompression_ = options;
+    }
+
     /*! \brief Stop listening to new incoming connections.
      *
-     *  \note This action is synchronous and has immediate effect.
+     *  \note This method can be called from any thread. The acceptor is
+     *        closed on its strand.
      *
      *  \note This method stops the server but it does not kill any existing
      *        active connection.
@@ -450,7 +831,10 @@ public:
     {
         spdlog::info("WebsocketServer: Stopping accepting connections");
         stopped_ = true;
-        acceptor_.close();
+        boost::asio::dispatch(acceptor_.get_executor(), [this]() {
+            boost::system::error_code ec {};
+            acceptor_.close(ec);
+        });
     }
 
 private:
@@ -463,7 +847,12 @@ private:
     boost::asio::ssl::context& ctx_;
     Acceptor acceptor_;
 
-    bool stopped_ {false};
+    std::atomic<bool> stopped_ {false};
+
+    size_t sessionMaxBatchSize_ {0};
+    size_t sessionHighWaterMark_ {0};
+    SlowConsumerPolicy slowConsumerPolicy_ {SlowConsumerPolicy::kPauseReading};
+    WebsocketCompressionOptions sessionCompression_ {};
 
     typename Session::Handler onSessionConnect_ {nullptr};
     typename Session::MsgHandler onSessionMessage_ {nullptr};
@@ -511,6 +900,10 @@ private:
         // the new Websocket session.
         auto session {std::make_shared<Session>(std::move(socket), ctx_)};
         spdlog::info("WebsocketServer: Creating new session: [{}]", session);
+        session->maxBatchSize_ = sessionMaxBatchSize_;
+        session->highWaterMark_ = sessionHighWaterMark_;
+        session->slowConsumerPolicy_ = slowConsumerPolicy_;
+        session->compression_ = sessionCompression_;
         session->Connect(
             onSessionConnect_,
             onSessionMessage_,
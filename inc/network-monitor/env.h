@@ -15,6 +15,19 @@ std::string GetEnvVar(
     const std::optional<std::string>& defaultValue = std::nullopt
 );
 
+/*! \brief Get a numeric environment variable, or return a default value.
+ *
+ *  \tparam T  int, size_t or double.
+ *
+ *  \throws std::runtime_error if the environment variable cannot be found, or
+ *          if its value is not a number of type T.
+ */
+template <typename T>
+T GetEnvVarNumber(
+    const std::string& envVar,
+    const std::optional<std::string>& defaultValue = std::nullopt
+);
+
 } // namespace NetworkMonitor
 
 #endif // NETWORK_MONITOR_ENV_H
\ No newline at end of file
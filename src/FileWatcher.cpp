@@ -0,0 +1,166 @@
+#include <network-monitor/FileWatcher.h>
+
+#include <boost/asio.hpp>
+
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+
+using NetworkMonitor::FileWatcher;
+
+// FileWatcher — Public methods
+
+FileWatcher::FileWatcher(
+    const std::filesystem::path& file,
+    const std::chrono::milliseconds debounce,
+    boost::asio::io_context& ioc
+) : file_ {std::filesystem::absolute(file)},
+    debounce_ {debounce},
+    context_ {boost::asio::make_strand(ioc)},
+    timer_ {context_}
+#ifdef __linux__
+    , stream_ {context_}
+#endif
+{
+}
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::Run(
+    std::function<void ()> onChange
+)
+{
+#ifdef __linux__
+    onChange_ = onChange;
+
+    // We watch the parent directory rather than the file itself. A watch on
+    // the file would be lost as soon as the file is replaced with a rename.
+    int fd {inotify_init1(IN_NONBLOCK | IN_CLOEXEC)};
+    if (fd < 0) {
+        spdlog::error("FileWatcher: Could not initialize inotify");
+        return false;
+    }
+    const auto directory {file_.parent_path()};
+    watchDescriptor_ = inotify_add_watch(
+        fd,
+        directory.c_str(),
+        IN_CLOSE_WRITE | IN_CREATE | IN_MODIFY | IN_MOVED_TO
+    );
+    if (watchDescriptor_ < 0) {
+        spdlog::error("FileWatcher: Could not watch {}", directory.string());
+        close(fd);
+        return false;
+    }
+    stream_.assign(fd);
+
+    spdlog::info("FileWatcher: Watching {}", file_.string());
+    stopped_ = false;
+    boost::asio::dispatch(context_, [this]() {
+        ReadEvents();
+    });
+    return true;
+#else
+    spdlog::error("FileWatcher: File watching is not supported on this "
+                  "platform");
+    return false;
+#endif
+}
+
+void FileWatcher::Stop()
+{
+    spdlog::info("FileWatcher: Stop watching {}", file_.string());
+    stopped_ = true;
+
+    // The timer and the stream are only accessed on the watcher strand.
+    boost::asio::dispatch(context_, [this]() {
+        timer_.cancel();
+#ifdef __linux__
+        boost::system::error_code ec {};
+        stream_.close(ec);
+#endif
+    });
+}
+
+// FileWatcher — Private methods
+
+void FileWatcher::ReadEvents()
+{
+#ifdef __linux__
+    stream_.async_read_some(
+        boost::asio::buffer(buffer_),
+        [this](auto ec, auto nBytes) {
+            OnRead(ec, nBytes);
+        }
+    );
+#endif
+}
+
+void FileWatcher::OnRead(
+    const boost::system::error_code& ec,
+    size_t nBytes
+)
+{
+#ifdef __linux__
+    if (stopped_ || ec == boost::asio::error::operation_aborted) {
+        return;
+    }
+    if (ec) {
+        spdlog::error("FileWatcher: Could not read file events: {}",
+                      ec.message());
+        return;
+    }
+
+    // A single read may contain multiple events. We only care about the ones
+    // that refer to our file.
+    const auto filename {file_.filename().string()};
+    bool fileChanged {false};
+    size_t offset {0};
+    while (offset + sizeof(inotify_event) <= nBytes) {
+        const auto* event {
+            reinterpret_cast<const inotify_event*>(buffer_.data() + offset)
+        };
+        if (event->mask & IN_Q_OVERFLOW) {
+            // We lost some events. Assume that our file was among them.
+            fileChanged = true;
+        } else if (event->len > 0 && std::string_view {event->name} == filename) {
+            fileChanged = true;
+        }
+        offset += sizeof(inotify_event) + event->len;
+    }
+
+    // Every new change restarts the debounce interval.
+    if (fileChanged) {
+        spdlog::debug("FileWatcher: {} changed", file_.string());
+        timer_.expires_after(debounce_);
+        timer_.async_wait([this](auto ec) {
+            OnDebounceTimer(ec);
+        });
+    }
+
+    ReadEvents();
+#endif
+}
+
+void FileWatcher::OnDebounceTimer(
+    const boost::system::error_code& ec
+)
+{
+    // The timer is cancelled every time a new change comes in before the
+    // debounce interval expires.
+    if (stopped_ || ec == boost::asio::error::operation_aborted) {
+        return;
+    }
+    spdlog::info("FileWatcher: {} changed", file_.string());
+    if (onChange_) {
+        onChange_();
+    }
+}
@@ -0,0 +1,113 @@
+#include <network-monitor/IdGenerator.h>
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+using NetworkMonitor::IdGenerator;
+using NetworkMonitor::IdGeneratorMode;
+
+// Get a 64-bit value from the OS entropy source.
+static uint64_t GetRandomSeed()
+{
+    std::random_device device {};
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+// SplitMix64 finalizer. It maps each value of a sequence to a well-mixed
+// pseudo-random value. It is a bijection, so distinct inputs never collide.
+static uint64_t Mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Write `nDigits` hex digits of `value`, most significant first.
+static char* WriteHex(char* out, const uint64_t value, const int nDigits)
+{
+    static constexpr char digits[] {"0123456789abcdef"};
+    for (int idx {nDigits - 1}; idx >= 0; --idx) {
+        *out++ = digits[(value >> (idx * 4)) & 0xF];
+    }
+    return out;
+}
+
+// All kCounter generators in a process share the prefix and the counter, so
+// that their IDs never collide.
+static uint32_t GetProcessPrefix()
+{
+    static const auto prefix {static_cast<uint32_t>(GetRandomSeed())};
+    return prefix;
+}
+
+static std::atomic<uint64_t> gProcessCounter {0};
+
+// IdGenerator — Public methods
+
+IdGenerator::IdGenerator(
+    const IdGeneratorMode mode
+) : mode_ {mode}
+{
+    if (mode_ == IdGeneratorMode::kRandomUuid) {
+        key_ = GetRandomSeed();
+        sequence_ = GetRandomSeed();
+    }
+}
+
+IdGeneratorMode IdGenerator::GetMode() const
+{
+    return mode_;
+}
+
+std::string_view IdGenerator::Generate(Buffer& buffer)
+{
+    char* out {buffer.data()};
+    switch (mode_) {
+        case IdGeneratorMode::kCounter: {
+            out = WriteHex(out, GetProcessPrefix(), 8);
+            *out++ = '-';
+            out = WriteHex(out, ++gProcessCounter, 16);
+            break;
+        }
+        case IdGeneratorMode::kRandomUuid:
+        default: {
+            // 0x9E37... is the SplitMix64 increment. It walks the whole 64-bit
+            // range before repeating.
+            const auto step {
+                sequence_.fetch_add(0x9E3779B97F4A7C15ULL) +
+                0x9E3779B97F4A7C15ULL
+            };
+            auto high {Mix(step)};
+            auto low {Mix(step ^ key_)};
+
+            // Version 4 (random), variant 1 (RFC 4122)
+            high = (high & 0xFFFFFFFFFFFF0FFFULL) | 0x0000000000004000ULL;
+            low = (low & 0x3FFFFFFFFFFFFFFFULL) | 0x8000000000000000ULL;
+
+            // xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx
+            out = WriteHex(out, high >> 32, 8);
+            *out++ = '-';
+            out = WriteHex(out, high >> 16, 4);
+            *out++ = '-';
+            out = WriteHex(out, high, 4);
+            *out++ = '-';
+            out = WriteHex(out, low >> 48, 4);
+            *out++ = '-';
+            out = WriteHex(out, low, 12);
+            break;
+        }
+    }
+    return std::string_view {
+        buffer.data(),
+        static_cast<size_t>(out - buffer.data())
+    };
+}
+
+std::string IdGenerator::Generate()
+{
+    Buffer buffer {};
+    return std::string {Generate(buffer)};
+}
@@ -7,6 +7,7 @@
 #include <string>
 #include <string_view>
 
+using NetworkMonitor::NetworkEventsOverflow;
 using NetworkMonitor::NetworkMonitorError;
 
 // Utility function to generate a boost::bimap.
@@ -38,6 +39,8 @@ static const auto gNetworkMonitorErrorStrings {
                               "CouldNotStartStompServer"          },
         {NetworkMonitorError::kCouldNotSubscribeToPassengerEvents,
                               "CouldNotSubscribeToPassengerEvents"},
+        {NetworkMonitorError::kCouldNotWatchNetworkLayoutFile    ,
+                              "CouldNotWatchNetworkLayoutFile"    },
         {NetworkMonitorError::kFailedNetworkLayoutFileDownload   ,
                               "FailedNetworkLayoutFileDownload"   },
         {NetworkMonitorError::kFailedNetworkLayoutFileParsing    ,
@@ -83,4 +86,33 @@ std::string NetworkMonitor::ToString(
         return undefinedError;
     }
     return std::string(errorIt->second);
-}
\ No newline at end of file
+}
+
+// NetworkEventsOverflow
+
+static const auto gNetworkEventsOverflowStrings {
+    MakeBimap<NetworkEventsOverflow, std::string_view>({
+        {NetworkEventsOverflow::kBlockReads, "BlockReads"},
+        {NetworkEventsOverflow::kDropOldest, "DropOldest"},
+        {NetworkEventsOverflow::kCoalesce  , "Coalesce"  },
+    })
+};
+
+std::ostream& NetworkMonitor::operator<<(
+    std::ostream& os,
+    const NetworkEventsOverflow& overflow
+)
+{
+    return os << ToString(overflow);
+}
+
+std::string NetworkMonitor::ToString(
+    const NetworkEventsOverflow& overflow
+)
+{
+    auto overflowIt {gNetworkEventsOverflowStrings.left.find(overflow)};
+    if (overflowIt == gNetworkEventsOverflowStrings.left.end()) {
+        return "Undefined";
+    }
+    return std::string(overflowIt->second);
+}
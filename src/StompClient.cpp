@@ -2,12 +2,17 @@
 
 #include <boost/bimap.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <initializer_list>
 #include <ostream>
 #include <string>
 #include <string_view>
 
+using NetworkMonitor::StompClientAckMode;
 using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompClientReconnectPolicy;
 
 // Utility function to generate a boost::bimap.
 template <typename L, typename R>
@@ -38,6 +43,8 @@ static const auto gStompClientErrorStrings {
                            "CouldNotSendMessage"               },
         {StompClientError::kCouldNotSendSubscribeFrame        ,
                            "CouldNotSendSubscribeFrame"        },
+        {StompClientError::kReceiptTimeout                    ,
+                           "ReceiptTimeout"                    },
         {StompClientError::kUnexpectedCouldNotCreateValidFrame,
                            "UnexpectedCouldNotCreateValidFrame"},
         {StompClientError::kUnexpectedMessageContentType      ,
@@ -75,4 +82,54 @@ std::string NetworkMonitor::ToString(const StompClientError& error)
         return undefinedError;
     }
     return std::string(errorIt->second);
-}
\ No newline at end of file
+}
+
+// StompClientAckMode
+
+static const auto gStompClientAckModeStrings {
+    MakeBimap<StompClientAckMode, std::string_view>({
+        {StompClientAckMode::kAuto            , "auto"             },
+        {StompClientAckMode::kClient          , "client"           },
+        {StompClientAckMode::kClientIndividual, "client-individual"},
+    })
+};
+
+std::ostream& NetworkMonitor::operator<<(
+    std::ostream& os,
+    const StompClientAckMode& m
+)
+{
+    os << ToString(m);
+    return os;
+}
+
+std::string NetworkMonitor::ToString(const StompClientAckMode& m)
+{
+    auto modeIt {gStompClientAckModeStrings.left.find(m)};
+    if (modeIt == gStompClientAckModeStrings.left.end()) {
+        return "auto";
+    }
+    return std::string(modeIt->second);
+}
+
+// Reconnection
+
+std::chrono::milliseconds NetworkMonitor::GetReconnectDelay(
+    const StompClientReconnectPolicy& policy,
+    size_t attempt,
+    double random
+)
+{
+    // We cap the exponent, as the delay hits maxDelay long before the power
+    // overflows.
+    const auto exponent {static_cast<double>(std::min<size_t>(attempt, 64))};
+    const auto maxDelay {static_cast<double>(policy.maxDelay.count())};
+    const auto delay {std::min(
+        maxDelay,
+        policy.initialDelay.count() * std::pow(policy.multiplier, exponent)
+    )};
+    const auto jitter {std::clamp(policy.jitter, 0.0, 1.0)};
+    return std::chrono::milliseconds {
+        static_cast<long long>(delay * (1.0 - jitter * random))
+    };
+}
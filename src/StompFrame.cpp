@@ -2,20 +2,36 @@
 
 #include <boost/bimap.hpp>
 
+#include <array>
 #include <charconv>
 #include <initializer_list>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <utility>
 
+using NetworkMonitor::StompBody;
 using NetworkMonitor::StompCommand;
 using NetworkMonitor::StompError;
 using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompFrameBuilder;
+using NetworkMonitor::StompFrameParser;
 using NetworkMonitor::StompHeader;
+using NetworkMonitor::kStompHeaderCount;
 
 using Headers = StompFrame::Headers;
+using HeaderMask = StompFrame::HeaderMask;
+
+static_assert(kStompHeaderCount <= sizeof(HeaderMask) * 8,
+              "The header mask must have a bit for each STOMP header");
+
+// Utility function to get the header mask bit for a STOMP header.
+static constexpr HeaderMask ToMask(const StompHeader header)
+{
+    return HeaderMask {1} << static_cast<size_t>(header);
+}
 
 // Utility function to generate a boost::bimap.
 template <typename L, typename R>
@@ -27,129 +43,198 @@ static boost::bimap<L, R> MakeBimap(
 }
 
 // Utility function to convert a std::string_view to a number.
-// Returns false if the conversion failed.
+// Returns false if the conversion failed, if the number is out of range, or
+// if the string has anything after the number.
 static bool StoI(const std::string_view string, size_t& result)
 {
-    auto conversionResult {std::from_chars(
-        string.data(),
-        string.data() + string.size(),
-        result
-    )};
-    return conversionResult.ec != std::errc::invalid_argument;
+    const auto end {string.data() + string.size()};
+    auto conversionResult {std::from_chars(string.data(), end, result)};
+    return conversionResult.ec == std::errc {} && conversionResult.ptr == end;
+}
+
+// Name lookup
+// Command and header names are resolved with a perfect hash that is built and
+// checked at compile time. The hash only looks at the name length and at its
+// first and last characters. A single comparison against the candidate name
+// confirms the match. Nothing is allocated.
+
+static constexpr size_t kNameHashSlots {64};
+
+static constexpr size_t NameHash(const std::string_view name)
+{
+    if (name.empty()) {
+        return 0;
+    }
+    return (
+        name.size() +
+        static_cast<unsigned char>(name.front()) * 15 +
+        static_cast<unsigned char>(name.back())
+    ) % kNameHashSlots;
+}
+
+// Map each hash slot to the index of the name that hashes to it. Index 0 is
+// reserved for the invalid value of the enum, and marks an empty slot.
+template <size_t N>
+static constexpr std::array<size_t, kNameHashSlots> MakeNameHashTable(
+    const std::array<std::string_view, N>& names
+)
+{
+    std::array<size_t, kNameHashSlots> slots {};
+    for (size_t idx {1}; idx < N; ++idx) {
+        slots[NameHash(names[idx])] = idx;
+    }
+    return slots;
+}
+
+// Check that no two names share a hash slot.
+template <size_t N>
+static constexpr bool IsPerfectNameHash(
+    const std::array<std::string_view, N>& names
+)
+{
+    const auto slots {MakeNameHashTable(names)};
+    for (size_t idx {1}; idx < N; ++idx) {
+        if (slots[NameHash(names[idx])] != idx) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns 0 if the name is not in the table.
+template <size_t N>
+static size_t FindName(
+    const std::array<std::string_view, N>& names,
+    const std::array<size_t, kNameHashSlots>& slots,
+    const std::string_view name
+)
+{
+    const auto idx {slots[NameHash(name)]};
+    return names[idx] == name ? idx : 0;
 }
 
 // StompCommand
 
-static const auto gStompCommandStrings {
-    MakeBimap<StompCommand, std::string_view>({
-        {StompCommand::kAbort      , "ABORT"      },
-        {StompCommand::kAck        , "ACK"        },
-        {StompCommand::kBegin      , "BEGIN"      },
-        {StompCommand::kCommit     , "COMMIT"     },
-        {StompCommand::kConnect    , "CONNECT"    },
-        {StompCommand::kConnected  , "CONNECTED"  },
-        {StompCommand::kDisconnect , "DISCONNECT" },
-        {StompCommand::kError      , "ERROR"      },
-        {StompCommand::kMessage    , "MESSAGE"    },
-        {StompCommand::kNack       , "NACK"       },
-        {StompCommand::kReceipt    , "RECEIPT"    },
-        {StompCommand::kSend       , "SEND"       },
-        {StompCommand::kStomp      , "STOMP"      },
-        {StompCommand::kSubscribe  , "SUBSCRIBE"  },
-        {StompCommand::kUnsubscribe, "UNSUBSCRIBE"},
-    })
+static constexpr size_t kStompCommandCount {
+    static_cast<size_t>(StompCommand::kUnsubscribe) + 1
+};
+
+// Names are indexed by the StompCommand value.
+static constexpr std::array<std::string_view, kStompCommandCount>
+    kStompCommandNames {
+        "StompCommand::kInvalid",
+        "ABORT",
+        "ACK",
+        "BEGIN",
+        "COMMIT",
+        "CONNECT",
+        "CONNECTED",
+        "DISCONNECT",
+        "ERROR",
+        "MESSAGE",
+        "NACK",
+        "RECEIPT",
+        "SEND",
+        "STOMP",
+        "SUBSCRIBE",
+        "UNSUBSCRIBE",
+    };
+
+static constexpr auto kStompCommandHashTable {
+    MakeNameHashTable(kStompCommandNames)
 };
+static_assert(
+    IsPerfectNameHash(kStompCommandNames),
+    "STOMP command names collide in the name hash table"
+);
 
 std::ostream& NetworkMonitor::operator<<(
     std::ostream& os,
     const StompCommand& command
 )
 {
-    auto commandIt {gStompCommandStrings.left.find(command)};
-    if (commandIt == gStompCommandStrings.left.end()) {
-        os << "StompCommand::kInvalid";
-    } else {
-        os << commandIt->second;
-    }
+    os << ToStringView(command);
     return os;
 }
 
 std::string NetworkMonitor::ToString(const StompCommand& command)
 {
-    auto commandIt {gStompCommandStrings.left.find(command)};
-    if (commandIt == gStompCommandStrings.left.end()) {
-        return "StompCommand::kInvalid";
-    }
-    return std::string(commandIt->second);
+    return std::string(ToStringView(command));
 }
 
-static const StompCommand& ToCommand(const std::string_view command)
+std::string_view NetworkMonitor::ToStringView(const StompCommand& command)
 {
-    static const auto invalidCommand {StompCommand::kInvalid};
-    auto commandIt {gStompCommandStrings.right.find(command)};
-    if (commandIt == gStompCommandStrings.right.end()) {
-        return invalidCommand;
-    }
-    return commandIt->second;
+    const auto idx {static_cast<size_t>(command)};
+    return kStompCommandNames[idx < kStompCommandCount ? idx : 0];
+}
+
+static StompCommand ToCommand(const std::string_view command)
+{
+    return static_cast<StompCommand>(
+        FindName(kStompCommandNames, kStompCommandHashTable, command)
+    );
 }
 
 // StompHeader
 
-static const auto gStompHeaderStrings {
-    MakeBimap<StompHeader, std::string_view>({
-        {StompHeader::kAcceptVersion, "accept-version"},
-        {StompHeader::kAck          , "ack"           },
-        {StompHeader::kContentLength, "content-length"},
-        {StompHeader::kContentType  , "content-type"  },
-        {StompHeader::kDestination  , "destination"   },
-        {StompHeader::kHeartBeat    , "heart-beat"    },
-        {StompHeader::kHost         , "host"          },
-        {StompHeader::kId           , "id"            },
-        {StompHeader::kLogin        , "login"         },
-        {StompHeader::kMessage      , "message"       },
-        {StompHeader::kMessageId    , "message-id"    },
-        {StompHeader::kPasscode     , "passcode"      },
-        {StompHeader::kReceipt      , "receipt"       },
-        {StompHeader::kReceiptId    , "receipt-id"    },
-        {StompHeader::kSession      , "session"       },
-        {StompHeader::kSubscription , "subscription"  },
-        {StompHeader::kTransaction  , "transaction"   },
-        {StompHeader::kServer       , "server"        },
-        {StompHeader::kVersion      , "version"       },
-    })
+// Names are indexed by the StompHeader value.
+static constexpr std::array<std::string_view, kStompHeaderCount>
+    kStompHeaderNames {
+        "StompHeader::kInvalid",
+        "accept-version",
+        "ack",
+        "content-length",
+        "content-type",
+        "destination",
+        "heart-beat",
+        "host",
+        "id",
+        "login",
+        "message",
+        "message-id",
+        "passcode",
+        "receipt",
+        "receipt-id",
+        "session",
+        "subscription",
+        "transaction",
+        "server",
+        "version",
+    };
+
+static constexpr auto kStompHeaderHashTable {
+    MakeNameHashTable(kStompHeaderNames)
 };
+static_assert(
+    IsPerfectNameHash(kStompHeaderNames),
+    "STOMP header names collide in the name hash table"
+);
 
 std::ostream& NetworkMonitor::operator<<(
     std::ostream& os,
     const StompHeader& header
 )
 {
-    auto headerIt {gStompHeaderStrings.left.find(header)};
-    if (headerIt == gStompHeaderStrings.left.end()) {
-        os << "StompHeader::kInvalid";
-    } else {
-        os << headerIt->second;
-    }
+    os << ToStringView(header);
     return os;
 }
 
 std::string NetworkMonitor::ToString(const StompHeader& header)
 {
-    auto headerIt {gStompHeaderStrings.left.find(header)};
-    if (headerIt == gStompHeaderStrings.left.end()) {
-        return "StompHeader::kInvalid";
-    }
-    return std::string(headerIt->second);
+    return std::string(ToStringView(header));
 }
 
-static const StompHeader& ToHeader(const std::string_view header)
+std::string_view NetworkMonitor::ToStringView(const StompHeader& header)
 {
-    static const auto invalidHeader {StompHeader::kInvalid};
-    auto headerIt {gStompHeaderStrings.right.find(header)};
-    if (headerIt == gStompHeaderStrings.right.end()) {
-        return invalidHeader;
-    }
-    return headerIt->second;
+    const auto idx {static_cast<size_t>(header)};
+    return kStompHeaderNames[idx < kStompHeaderCount ? idx : 0];
+}
+
+static StompHeader ToHeader(const std::string_view header)
+{
+    return static_cast<StompHeader>(
+        FindName(kStompHeaderNames, kStompHeaderHashTable, header)
+    );
 }
 
 // StompError
@@ -164,8 +249,12 @@ static const auto gStompErrorStrings {
                      "ParsingEmptyHeaderValue"               },
         {StompError::kParsingContentLengthExceedsFrameLength,
                      "ParsingContentLengthExceedsFrameLength"},
+        {StompError::kParsingFrameTooLarge                  ,
+                     "ParsingFrameTooLarge"                  },
         {StompError::kParsingInvalidContentLength           ,
                      "ParsingInvalidContentLength"           },
+        {StompError::kParsingInvalidHeaderEscape            ,
+                     "ParsingInvalidHeaderEscape"            },
         {StompError::kParsingJunkAfterBody                  ,
                      "ParsingJunkAfterBody"                  },
         {StompError::kParsingMissingBlankLineAfterHeaders   ,
@@ -188,8 +277,12 @@ static const auto gStompErrorStrings {
                      "ValidationInvalidCommand"              },
         {StompError::kValidationInvalidContentLength        ,
                      "ValidationInvalidContentLength"        },
+        {StompError::kValidationInvalidHeaderValue          ,
+                     "ValidationInvalidHeaderValue"          },
         {StompError::kValidationMissingHeader               ,
                      "ValidationMissingHeader"               },
+        {StompError::kValidationUnexpectedNullInBody        ,
+                     "ValidationUnexpectedNullInBody"        },
     })
 };
 
@@ -232,6 +325,170 @@ static const StompError& StringToError(const std::string_view error)
     return errorIt->second;
 }
 
+// Header escapes
+// STOMP 1.2 escapes ':', '\n', '\r' and '\\' in header values. The CONNECT
+// and CONNECTED frames do not use escapes, for compatibility with STOMP 1.0.
+// We treat STOMP frames, the 1.2 name for CONNECT, in the same way.
+
+static bool UsesHeaderEscapes(const StompCommand command)
+{
+    return command != StompCommand::kConnect &&
+           command != StompCommand::kConnected &&
+           command != StompCommand::kStomp;
+}
+
+static bool NeedsEscape(const char c)
+{
+    return c == ':' || c == '\n' || c == '\r' || c == '\\';
+}
+
+// Get the size of a header value once escaped.
+static size_t GetEscapedSize(const std::string_view value)
+{
+    size_t size {value.size()};
+    for (const auto c: value) {
+        size += NeedsEscape(c) ? 1 : 0;
+    }
+    return size;
+}
+
+static void AppendEscaped(std::string& buffer, const std::string_view value)
+{
+    for (const auto c: value) {
+        switch (c) {
+            case ':':
+                buffer += "\\c";
+                break;
+            case '\n':
+                buffer += "\\n";
+                break;
+            case '\r':
+                buffer += "\\r";
+                break;
+            case '\\':
+                buffer += "\\\\";
+                break;
+            default:
+                buffer += c;
+                break;
+        }
+    }
+}
+
+// Decode the escaped header values into a new side buffer, and point the
+// headers to it.
+// Returns false on an undefined escape sequence, which is a fatal protocol
+// error.
+static bool DecodeEscapedHeaders(
+    Headers& headers,
+    const HeaderMask escapedMask,
+    std::shared_ptr<const std::string>& escaped
+)
+{
+    // Decoded values are never longer than the encoded ones. We reserve
+    // enough space up front, so that the views we take stay valid.
+    size_t size {0};
+    for (size_t idx {0}; idx < kStompHeaderCount; ++idx) {
+        if ((escapedMask & (HeaderMask {1} << idx)) != 0) {
+            size += headers[idx].size();
+        }
+    }
+    auto decoded {std::make_shared<std::string>()};
+    decoded->reserve(size);
+    for (size_t idx {0}; idx < kStompHeaderCount; ++idx) {
+        if ((escapedMask & (HeaderMask {1} << idx)) == 0) {
+            continue;
+        }
+        const auto value {headers[idx]};
+        const auto start {decoded->size()};
+        for (size_t pos {0}; pos < value.size(); ++pos) {
+            if (value[pos] != '\\') {
+                *decoded += value[pos];
+                continue;
+            }
+            if (++pos == value.size()) {
+                return false;
+            }
+            switch (value[pos]) {
+                case 'c':
+                    *decoded += ':';
+                    break;
+                case 'n':
+                    *decoded += '\n';
+                    break;
+                case 'r':
+                    *decoded += '\r';
+                    break;
+                case '\\':
+                    *decoded += '\\';
+                    break;
+                default:
+                    return false;
+            }
+        }
+        headers[idx] = std::string_view {decoded->data() + start,
+                                         decoded->size() - start};
+    }
+    escaped = std::move(decoded);
+    return true;
+}
+
+// Get the headers that a frame must have, based on the protocol
+// specification.
+// Returns false if the command is not valid.
+static bool GetRequiredHeaders(
+    const StompCommand command,
+    HeaderMask& required
+)
+{
+    required = 0;
+    switch (command) {
+        case StompCommand::kConnect:
+        case StompCommand::kStomp:
+            required = ToMask(StompHeader::kAcceptVersion) |
+                       ToMask(StompHeader::kHost);
+            break;
+        case StompCommand::kConnected:
+            required = ToMask(StompHeader::kVersion);
+            break;
+        case StompCommand::kSend:
+            required = ToMask(StompHeader::kDestination);
+            break;
+        case StompCommand::kSubscribe:
+            required = ToMask(StompHeader::kDestination) |
+                       ToMask(StompHeader::kId);
+            break;
+        case StompCommand::kUnsubscribe:
+            required = ToMask(StompHeader::kId);
+            break;
+        case StompCommand::kAck:
+        case StompCommand::kNack:
+            required = ToMask(StompHeader::kId);
+            break;
+        case StompCommand::kBegin:
+        case StompCommand::kCommit:
+        case StompCommand::kAbort:
+            required = ToMask(StompHeader::kTransaction);
+            break;
+        case StompCommand::kDisconnect:
+            break;
+        case StompCommand::kMessage:
+            required = ToMask(StompHeader::kDestination) |
+                       ToMask(StompHeader::kMessageId) |
+                       ToMask(StompHeader::kSubscription);
+            break;
+        case StompCommand::kReceipt:
+            required = ToMask(StompHeader::kReceiptId);
+            break;
+        case StompCommand::kError:
+            break;
+        case StompCommand::kInvalid:
+        default:
+            return false;
+    }
+    return true;
+}
+
 // StompFrame — Public methods
 
 StompFrame::StompFrame() = default;
@@ -239,19 +496,40 @@ StompFrame::StompFrame() = default;
 StompFrame::StompFrame(
     StompError& ec,
     const std::string& frame
-)
+) : plain_ {std::make_shared<const std::string>(frame)}
 {
-    plain_ = frame;
-    ec = ParseAndValidateFrame(plain_);
+    ec = ParseAndValidateFrame(*plain_);
 }
 
 StompFrame::StompFrame(
     StompError& ec,
     std::string&& frame
-)
+) : plain_ {std::make_shared<const std::string>(std::move(frame))}
+{
+    ec = ParseAndValidateFrame(*plain_);
+}
+
+StompFrame::StompFrame(
+    StompError& ec,
+    std::shared_ptr<const std::string> frame
+) : plain_ {std::move(frame)}
 {
-    plain_ = std::move(frame);
-    ec = ParseAndValidateFrame(plain_);
+    if (plain_ == nullptr) {
+        plain_ = std::make_shared<const std::string>();
+    }
+    ec = ParseAndValidateFrame(*plain_);
+}
+
+StompFrame::StompFrame(
+    StompError& ec,
+    std::shared_ptr<const std::string> buffer,
+    const std::string_view frame
+) : plain_ {std::move(buffer)}
+{
+    if (plain_ == nullptr) {
+        plain_ = std::make_shared<const std::string>();
+    }
+    ec = ParseAndValidateFrame(frame);
 }
 
 StompFrame::StompFrame(
@@ -261,48 +539,29 @@ StompFrame::StompFrame(
     const std::string& body
 )
 {
-    using namespace std::string_literals;
-
-    // Construct the frame as a string.
-    std::string plain {""};
-    plain += NetworkMonitor::ToString(command);
-    plain += "\n";
+    // The builder validates the frame components, so we only need to parse
+    // the frame to set up the views into the buffer.
+    StompFrameBuilder builder {command};
     for (const auto& [header, value]: headers) {
-        plain += NetworkMonitor::ToString(header);
-        plain += ":";
-        plain += value;
-        plain += "\n";
+        builder.AddHeader(header, value);
     }
-    plain += "\n";
-    plain += body;
-    plain += "\0"s;
-    plain_ = std::move(plain);
-
-    // This may be wasteful, but we re-parse the frame to make sure it is a
-    // valid one. We may optimize this later.
-    ec = ParseAndValidateFrame(plain_);
+    builder.SetBody(body);
+    auto plain {builder.Build(ec)};
+    if (ec != StompError::kOk) {
+        return;
+    }
+    plain_ = std::make_shared<const std::string>(std::move(plain));
+    ec = ParseFrame(*plain_);
 }
 
-// The copy constructor cannot copy the string views. Instead, we copy the
-// original plain-text frame and re-parse it.
-StompFrame::StompFrame(const StompFrame& other)
-{
-    plain_ = other.plain_;
-    ParseAndValidateFrame(plain_);
-}
+// The frame buffer is immutable and shared, so the string views of the copy
+// remain valid for as long as the copy holds on to the buffer. The same holds
+// for moved frames.
+StompFrame::StompFrame(const StompFrame& other) = default;
 
 StompFrame::StompFrame(StompFrame&& other) = default;
 
-// The copy assignment operator cannot copy the string views. Instead, we copy
-// the original plain-text frame and re-parse it.
-StompFrame& StompFrame::operator=(const StompFrame& other)
-{
-    if (this != &other) {
-        plain_ = other.plain_;
-        ParseAndValidateFrame(plain_);
-    }
-    return *this;
-}
+StompFrame& StompFrame::operator=(const StompFrame& other) = default;
 
 StompFrame& StompFrame::operator=(StompFrame&& other) = default;
 
@@ -313,19 +572,16 @@ StompCommand StompFrame::GetCommand() const
 
 const bool StompFrame::HasHeader(const StompHeader& header) const
 {
-    return headers_.find(header) != headers_.end();
+    return (headerMask_ & ToMask(header)) != 0;
 }
 
+// Slots for missing headers always hold an empty view, so we do not need to
+// check the header mask here.
 const std::string_view& StompFrame::GetHeaderValue(
     const StompHeader& header
 ) const
 {
-    static const std::string_view emptyHeaderValue {""};
-    auto headerValueIt {headers_.find(header)};
-    if (headerValueIt == headers_.end()) {
-        return emptyHeaderValue;
-    }
-    return headerValueIt->second;
+    return headers_[static_cast<size_t>(header)];
 }
 
 const std::string_view& StompFrame::GetBody() const
@@ -334,6 +590,11 @@ const std::string_view& StompFrame::GetBody() const
 }
 
 std::string StompFrame::ToString() const
+{
+    return std::string {frame_};
+}
+
+std::shared_ptr<const std::string> StompFrame::GetBuffer() const
 {
     return plain_;
 }
@@ -351,7 +612,9 @@ StompError StompFrame::ParseAndValidateFrame(const std::string_view frame)
 
 StompError StompFrame::ParseFrame(const std::string_view frame)
 {
+    frame_ = frame;
     const std::string_view plain {frame};
+    static constexpr auto npos {std::string_view::npos};
 
     // Frame delimiters
     static const char null {'\0'};
@@ -361,7 +624,7 @@ StompError StompFrame::ParseFrame(const std::string_view frame)
     // Command
     size_t commandStart {0};
     size_t commandEnd {plain.find(newLine, commandStart)};
-    if (commandEnd == std::string::npos) {
+    if (commandEnd == npos) {
         return StompError::kParsingMissingEolAfterCommand;
     }
     auto command {ToCommand(
@@ -374,11 +637,14 @@ StompError StompFrame::ParseFrame(const std::string_view frame)
     // Headers
     size_t headerLineStart {commandEnd + 1};
     Headers headers {};
+    HeaderMask headerMask {0};
+    HeaderMask escapedMask {0};
+    const bool usesEscapes {UsesHeaderEscapes(command)};
     while (headerLineStart < plain.size() &&
-           plain.at(headerLineStart) != newLine) {
+           plain[headerLineStart] != newLine) {
         size_t headerStart {headerLineStart};
         size_t headerEnd {plain.find(colon, headerStart)};
-        if (headerEnd == std::string::npos) {
+        if (headerEnd == npos) {
             return StompError::kParsingMissingColonInHeader;
         }
         auto header {ToHeader(
@@ -388,21 +654,22 @@ StompError StompFrame::ParseFrame(const std::string_view frame)
             return StompError::kParsingUnrecognizedHeader;
         };
         size_t valueStart {headerEnd + 1};
-        if (plain.at(valueStart) == newLine) {
+        if (valueStart < plain.size() && plain[valueStart] == newLine) {
             return StompError::kParsingEmptyHeaderValue;
         }
         size_t valueEnd {plain.find(newLine, valueStart)};
-        if (valueEnd == std::string::npos) {
+        if (valueEnd == npos) {
             return StompError::kParsingMissingEolAfterHeaderValue;
         }
         auto value {plain.substr(valueStart, valueEnd - valueStart)};
 
-        // Skip this header value if the header is already in the header map.
-        if (headers.find(header) == headers.end()) {
-            headers.emplace(std::make_pair(
-                std::move(header),
-                std::move(value))
-            );
+        // Skip this header value if the header is already in the frame.
+        if ((headerMask & ToMask(header)) == 0) {
+            headers[static_cast<size_t>(header)] = value;
+            headerMask |= ToMask(header);
+            if (usesEscapes && value.find('\\') != npos) {
+                escapedMask |= ToMask(header);
+            }
         }
 
         // Prepare for next line;
@@ -412,20 +679,30 @@ StompError StompFrame::ParseFrame(const std::string_view frame)
     // Blank line between headers and body
     size_t newLineBeforeBody {headerLineStart};
     if (newLineBeforeBody >= plain.size() ||
-        plain.at(newLineBeforeBody) != newLine) {
+        plain[newLineBeforeBody] != newLine) {
         return StompError::kParsingMissingBlankLineAfterHeaders;
     }
 
+    // Header escapes
+    // Values without escapes stay views into the frame buffer.
+    std::shared_ptr<const std::string> escaped {nullptr};
+    if (escapedMask != 0 &&
+        !DecodeEscapedHeaders(headers, escapedMask, escaped)) {
+        return StompError::kParsingInvalidHeaderEscape;
+    }
+
     // Body
     // Everything else that's left is potentially part of the body.
     size_t bodyStart {newLineBeforeBody + 1};
     size_t bodyEnd {0}; // The NULL octet
     size_t bodyLength {0};
-    auto contentLengthIt {headers.find(StompHeader::kContentLength)};
-    if (contentLengthIt != headers.end()) {
+    if ((headerMask & ToMask(StompHeader::kContentLength)) != 0) {
         // If the content-length header is present, we need to read the
         // specified number of bytes.
-        auto ok {StoI(contentLengthIt->second, bodyLength)};
+        auto ok {StoI(
+            headers[static_cast<size_t>(StompHeader::kContentLength)],
+            bodyLength
+        )};
         if (!ok) {
             return StompError::kParsingInvalidContentLength;
         }
@@ -436,80 +713,43 @@ StompError StompFrame::ParseFrame(const std::string_view frame)
             return StompError::kParsingContentLengthExceedsFrameLength;
         }
         bodyEnd = bodyStart + bodyLength;
-        if (plain.at(bodyEnd) != null) {
+        if (plain[bodyEnd] != null) {
             return StompError::kParsingMissingNullInBody;
         }
     } else {
         // If the content-length header is not present, we need to look for the
         // first NULL octet as a body delimiter.
         bodyEnd = plain.find(null, bodyStart);
-        if (bodyEnd == std::string::npos) {
+        if (bodyEnd == npos) {
             return StompError::kParsingMissingNullInBody;
         }
         bodyLength = bodyEnd - bodyStart;
     }
     for (size_t idx {bodyEnd + 1}; idx < plain.size(); ++idx) {
-        if (plain.at(idx) != newLine) {
+        if (plain[idx] != newLine) {
             return StompError::kParsingJunkAfterBody;
         }
     }
     auto body {plain.substr(bodyStart, bodyLength)};
 
     command_ = std::move(command);
-    headers_ = std::move(headers);
+    headers_ = headers;
+    headerMask_ = headerMask;
+    escaped_ = std::move(escaped);
     body_ = std::move(body);
     return StompError::kOk;
 }
 
 // We validate the headers in the frame based on the protocol specification.
+// Each command maps to a mask of required headers, which we check against the
+// frame header mask in one go.
 StompError StompFrame::ValidateFrame()
 {
-    bool hasAllHeaders {true};
-    switch (command_) {
-        case StompCommand::kConnect:
-        case StompCommand::kStomp:
-            hasAllHeaders &= HasHeader(StompHeader::kAcceptVersion);
-            hasAllHeaders &= HasHeader(StompHeader::kHost);
-            break;
-        case StompCommand::kConnected:
-            hasAllHeaders &= HasHeader(StompHeader::kVersion);
-            break;
-        case StompCommand::kSend:
-            hasAllHeaders &= HasHeader(StompHeader::kDestination);
-            break;
-        case StompCommand::kSubscribe:
-            hasAllHeaders &= HasHeader(StompHeader::kDestination);
-            hasAllHeaders &= HasHeader(StompHeader::kId);
-            break;
-        case StompCommand::kUnsubscribe:
-            hasAllHeaders &= HasHeader(StompHeader::kId);
-            break;
-        case StompCommand::kAck:
-        case StompCommand::kNack:
-            hasAllHeaders &= HasHeader(StompHeader::kId);
-            break;
-        case StompCommand::kBegin:
-        case StompCommand::kCommit:
-        case StompCommand::kAbort:
-            hasAllHeaders &= HasHeader(StompHeader::kTransaction);
-            break;
-        case StompCommand::kDisconnect:
-            break;
-        case StompCommand::kMessage:
-            hasAllHeaders &= HasHeader(StompHeader::kDestination);
-            hasAllHeaders &= HasHeader(StompHeader::kMessageId);
-            hasAllHeaders &= HasHeader(StompHeader::kSubscription);
-            break;
-        case StompCommand::kReceipt:
-            hasAllHeaders &= HasHeader(StompHeader::kReceiptId);
-            break;
-        case StompCommand::kError:
-            break;
-        case StompCommand::kInvalid:
-        default:
-            return StompError::kValidationInvalidCommand;
+    HeaderMask required {0};
+    if (!GetRequiredHeaders(command_, required)) {
+        return StompError::kValidationInvalidCommand;
     }
-    if (!hasAllHeaders) {
+    if ((headerMask_ & required) != required) {
         return StompError::kValidationMissingHeader;
     }
 
@@ -525,4 +765,442 @@ StompError StompFrame::ValidateFrame()
     }
 
     return StompError::kOk;
-}
\ No newline at end of file
+}
+// StompBody — Public methods
+
+StompBody::StompBody(const StompFrame& frame)
+    : buffer_ {frame.GetBuffer()},
+      view_ {frame.GetBody()}
+{
+}
+
+const std::string_view& StompBody::GetView() const
+{
+    return view_;
+}
+
+size_t StompBody::GetSize() const
+{
+    return view_.size();
+}
+
+StompBody::operator std::string_view() const
+{
+    return view_;
+}
+
+bool NetworkMonitor::operator==(
+    const StompBody& body,
+    const std::string_view other
+)
+{
+    return body.GetView() == other;
+}
+
+bool NetworkMonitor::operator!=(
+    const StompBody& body,
+    const std::string_view other
+)
+{
+    return body.GetView() != other;
+}
+
+std::ostream& NetworkMonitor::operator<<(
+    std::ostream& os,
+    const StompBody& body
+)
+{
+    os << body.GetView();
+    return os;
+}
+
+// StompFrameBuilder — Public methods
+
+StompFrameBuilder::StompFrameBuilder(
+    const StompCommand& command
+) : command_ {command}
+{
+}
+
+StompFrameBuilder& StompFrameBuilder::AddHeader(
+    const StompHeader& header,
+    const std::string_view value
+)
+{
+    // We keep the first value, like the parser does. Invalid headers are
+    // recorded in the mask too, so that Validate() can report them.
+    if ((headerMask_ & ToMask(header)) == 0) {
+        headers_[static_cast<size_t>(header)] = value;
+        headerMask_ |= ToMask(header);
+        headerOrder_[nHeaders_++] = header;
+    }
+    return *this;
+}
+
+StompFrameBuilder& StompFrameBuilder::SetBody(
+    const std::string_view body
+)
+{
+    body_ = body;
+    bodySize_ = body.size();
+    writeBody_ = nullptr;
+    return *this;
+}
+
+StompFrameBuilder& StompFrameBuilder::SetBody(
+    const size_t bodySize,
+    std::function<void (std::string&)> writeBody
+)
+{
+    body_ = {};
+    bodySize_ = bodySize;
+    writeBody_ = std::move(writeBody);
+    return *this;
+}
+
+StompError StompFrameBuilder::Validate() const
+{
+    HeaderMask required {0};
+    if (!GetRequiredHeaders(command_, required)) {
+        return StompError::kValidationInvalidCommand;
+    }
+    if ((headerMask_ & ToMask(StompHeader::kInvalid)) != 0) {
+        return StompError::kParsingUnrecognizedHeader;
+    }
+    if ((headerMask_ & required) != required) {
+        return StompError::kValidationMissingHeader;
+    }
+    // Without escapes, a value cannot contain an EOL.
+    const bool usesEscapes {UsesHeaderEscapes(command_)};
+    for (size_t idx {0}; idx < nHeaders_; ++idx) {
+        const auto& value {headers_[static_cast<size_t>(headerOrder_[idx])]};
+        if (value.empty() ||
+            (!usesEscapes && value.find('\n') != std::string_view::npos)) {
+            return StompError::kValidationInvalidHeaderValue;
+        }
+    }
+    if ((headerMask_ & ToMask(StompHeader::kContentLength)) != 0) {
+        size_t length {0};
+        auto ok {StoI(
+            headers_[static_cast<size_t>(StompHeader::kContentLength)],
+            length
+        )};
+        if (!ok) {
+            return StompError::kValidationInvalidContentLength;
+        }
+        if (length != bodySize_) {
+            return StompError::kValidationContentLengthMismatch;
+        }
+    } else if (body_.find('\0') != std::string_view::npos) {
+        // Without a content-length header, the first NULL octet terminates
+        // the body.
+        return StompError::kValidationUnexpectedNullInBody;
+    }
+    return StompError::kOk;
+}
+
+size_t StompFrameBuilder::GetSize() const
+{
+    // Command, EOL, headers, blank line, body, NULL octet
+    const bool usesEscapes {UsesHeaderEscapes(command_)};
+    size_t size {ToStringView(command_).size() + 1};
+    for (size_t idx {0}; idx < nHeaders_; ++idx) {
+        const auto header {headerOrder_[idx]};
+        const auto& value {headers_[static_cast<size_t>(header)]};
+        size += ToStringView(header).size() + 1 +
+                (usesEscapes ? GetEscapedSize(value) : value.size()) + 1;
+    }
+    return size + 1 + bodySize_ + 1;
+}
+
+StompError StompFrameBuilder::WriteTo(
+    std::string& buffer
+) const
+{
+    auto ec {Validate()};
+    if (ec != StompError::kOk) {
+        return ec;
+    }
+    const auto start {buffer.size()};
+    buffer.reserve(start + GetSize());
+    buffer += ToStringView(command_);
+    buffer += '\n';
+    const bool usesEscapes {UsesHeaderEscapes(command_)};
+    for (size_t idx {0}; idx < nHeaders_; ++idx) {
+        const auto header {headerOrder_[idx]};
+        const auto& value {headers_[static_cast<size_t>(header)]};
+        buffer += ToStringView(header);
+        buffer += ':';
+        if (usesEscapes && GetEscapedSize(value) != value.size()) {
+            AppendEscaped(buffer, value);
+        } else {
+            buffer += value;
+        }
+        buffer += '\n';
+    }
+    buffer += '\n';
+    if (writeBody_) {
+        const auto bodyStart {buffer.size()};
+        writeBody_(buffer);
+        if (buffer.size() - bodyStart != bodySize_) {
+            buffer.resize(start);
+            return StompError::kValidationContentLengthMismatch;
+        }
+
+        // Validate could not see this body. Without a content-length header,
+        // a NULL octet in it would end the frame early.
+        const bool hasContentLength {
+            (headerMask_ & ToMask(StompHeader::kContentLength)) != 0
+        };
+        if (!hasContentLength &&
+            std::string_view {buffer}.find('\0', bodyStart) !=
+                std::string_view::npos) {
+            buffer.resize(start);
+            return StompError::kValidationUnexpectedNullInBody;
+        }
+    } else {
+        buffer += body_;
+    }
+    buffer += '\0';
+    return StompError::kOk;
+}
+
+std::string StompFrameBuilder::Build(
+    StompError& ec
+) const
+{
+    std::string frame {};
+    ec = WriteTo(frame);
+    return frame;
+}
+
+// StompFrameParser — Public methods
+
+void StompFrameParser::SetMaxFrameSize(
+    const size_t maxFrameSize
+)
+{
+    maxFrameSize_ = maxFrameSize;
+}
+
+StompError StompFrameParser::Parse(
+    const std::string_view chunk,
+    std::vector<StompFrame>& frames
+)
+{
+    buffer_.append(chunk);
+    return ParseBuffer(frames);
+}
+
+StompError StompFrameParser::Parse(
+    std::string&& chunk,
+    std::vector<StompFrame>& frames
+)
+{
+    if (buffer_.empty()) {
+        buffer_ = std::move(chunk);
+    } else {
+        buffer_.append(chunk);
+    }
+    return ParseBuffer(frames);
+}
+
+void StompFrameParser::Reset()
+{
+    buffer_.clear();
+    ResetFrameState();
+}
+
+size_t StompFrameParser::GetBufferedSize() const
+{
+    return buffer_.size();
+}
+
+// StompFrameParser — Private methods
+
+// Check if the data from `start` onwards only holds EOLs.
+static bool IsOnlyNewLines(const std::string_view data, const size_t start)
+{
+    return data.find_first_not_of('\n', start) == std::string_view::npos;
+}
+
+StompError StompFrameParser::ParseBuffer(std::vector<StompFrame>& frames)
+{
+    // Find the complete frames first, so that they can all share one buffer.
+    std::vector<std::pair<size_t, size_t>> bounds {};
+    StompError error {StompError::kOk};
+    size_t frameStart {0};
+    while (true) {
+        // Skip the heart-beats between frames.
+        while (frameStart < buffer_.size()) {
+            if (buffer_[frameStart] == '\n') {
+                ++frameStart;
+            } else if (buffer_[frameStart] == '\r' &&
+                       frameStart + 1 < buffer_.size() &&
+                       buffer_[frameStart + 1] == '\n') {
+                frameStart += 2;
+            } else {
+                break;
+            }
+        }
+        if (frameStart == buffer_.size()) {
+            break;
+        }
+
+        size_t frameEnd {std::string::npos};
+        error = FindFrameEnd(frameStart, frameEnd);
+        if (error == StompError::kOk && IsFrameTooLarge(frameStart, frameEnd)) {
+            error = StompError::kParsingFrameTooLarge;
+        }
+        if (error != StompError::kOk || frameEnd == std::string::npos) {
+            break;
+        }
+        ResetFrameState();
+        bounds.emplace_back(frameStart, frameEnd + 1);
+        frameStart = frameEnd + 1;
+    }
+
+    if (bounds.size() == 1 && bounds[0].first == 0 &&
+        IsOnlyNewLines(buffer_, bounds[0].second)) {
+        // We hand the whole buffer over to the frame when it only holds this
+        // frame. StompFrame accepts EOLs after the NULL octet.
+        StompError frameError {};
+        frames.emplace_back(frameError, std::move(buffer_));
+        buffer_.clear();
+        frameStart = 0;
+        if (frameError != StompError::kOk) {
+            frames.pop_back();
+            error = frameError;
+        }
+    } else if (!bounds.empty()) {
+        // The frames are views into the batch buffer. Only the bytes after the
+        // last frame, if any, are copied back for the next chunk.
+        const auto batch {
+            std::make_shared<const std::string>(std::move(buffer_))
+        };
+        buffer_.assign(*batch, frameStart);
+        frameStart = 0;
+        const std::string_view plain {*batch};
+        for (const auto& [start, end]: bounds) {
+            StompError frameError {};
+            frames.emplace_back(frameError, batch,
+                                plain.substr(start, end - start));
+            if (frameError != StompError::kOk) {
+                frames.pop_back();
+                error = frameError;
+                break;
+            }
+        }
+    }
+    if (error != StompError::kOk) {
+        Reset();
+        return error;
+    }
+    buffer_.erase(0, frameStart);
+    return StompError::kOk;
+}
+
+StompError StompFrameParser::FindFrameEnd(
+    const size_t frameStart,
+    size_t& frameEnd
+)
+{
+    static constexpr auto npos {std::string_view::npos};
+    const auto frame {std::string_view {buffer_}.substr(frameStart)};
+
+    // We reject an unknown command as soon as we have the command line, rather
+    // than waiting for the rest of the frame.
+    if (commandEnd_ == npos) {
+        auto commandEnd {frame.find('\n', headersSearchFrom_)};
+        if (commandEnd == npos) {
+            headersSearchFrom_ = frame.size();
+            return StompError::kOk;
+        }
+        if (ToCommand(frame.substr(0, commandEnd)) == StompCommand::kInvalid) {
+            return StompError::kParsingUnrecognizedCommand;
+        }
+        commandEnd_ = commandEnd;
+        headersSearchFrom_ = commandEnd;
+    }
+
+    // Blank line after the headers
+    if (headersEnd_ == npos) {
+        auto blankLine {frame.find("\n\n", headersSearchFrom_)};
+        if (blankLine == npos) {
+            // The first EOL of the pair may be the last byte we have.
+            headersSearchFrom_ = frame.size() - 1;
+            return StompError::kOk;
+        }
+        headersEnd_ = blankLine + 1;
+        nullSearchFrom_ = headersEnd_ + 1;
+
+        // We only need the content-length header. As in StompFrame, the first
+        // value wins.
+        static constexpr std::string_view contentLength {"content-length:"};
+        auto lineStart {commandEnd_ + 1};
+        while (lineStart < headersEnd_) {
+            const auto lineEnd {frame.find('\n', lineStart)};
+            const auto line {frame.substr(lineStart, lineEnd - lineStart)};
+            if (line.substr(0, contentLength.size()) == contentLength) {
+                size_t bodyLength {0};
+                if (!StoI(line.substr(contentLength.size()), bodyLength)) {
+                    return StompError::kParsingInvalidContentLength;
+                }
+
+                // We check the length before we add it to the offsets, so
+                // that a huge value cannot wrap the end of the body around.
+                if (maxFrameSize_ > 0 && bodyLength > maxFrameSize_) {
+                    return StompError::kParsingFrameTooLarge;
+                }
+                if (bodyLength > npos - headersEnd_ - 2) {
+                    return StompError::kParsingInvalidContentLength;
+                }
+                bodyEnd_ = headersEnd_ + 1 + bodyLength;
+                break;
+            }
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    // NULL octet after the body
+    if (bodyEnd_ != npos) {
+        if (bodyEnd_ < frame.size()) {
+            frameEnd = frameStart + bodyEnd_;
+        }
+        return StompError::kOk;
+    }
+    auto null {frame.find('\0', nullSearchFrom_)};
+    if (null == npos) {
+        nullSearchFrom_ = frame.size();
+        return StompError::kOk;
+    }
+    frameEnd = frameStart + null;
+    return StompError::kOk;
+}
+
+bool StompFrameParser::IsFrameTooLarge(
+    const size_t frameStart,
+    const size_t frameEnd
+) const
+{
+    if (maxFrameSize_ == 0) {
+        return false;
+    }
+
+    // Without an end, the rest of the buffer is all part of this frame.
+    const auto frameSize {frameEnd == std::string::npos ?
+        buffer_.size() - frameStart :
+        frameEnd + 1 - frameStart
+    };
+    const auto declaredSize {bodyEnd_ == std::string::npos ? 0 : bodyEnd_ + 1};
+    return frameSize > maxFrameSize_ || declaredSize > maxFrameSize_;
+}
+
+void StompFrameParser::ResetFrameState()
+{
+    commandEnd_ = std::string::npos;
+    headersSearchFrom_ = 0;
+    headersEnd_ = std::string::npos;
+    bodyEnd_ = std::string::npos;
+    nullSearchFrom_ = 0;
+}
@@ -0,0 +1,124 @@
+#include <network-monitor/StompFrame.h>
+#include <network-monitor/StompHeartBeat.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompHeartBeat;
+
+// Parse a non-negative number of milliseconds. The whole value must be a
+// number.
+static bool ParseMilliseconds(
+    const std::string_view value,
+    std::chrono::milliseconds& ms
+)
+{
+    uint32_t count {0};
+    const auto end {value.data() + value.size()};
+    auto [ptr, ec] {std::from_chars(value.data(), end, count)};
+    if (value.empty() || ec != std::errc {} || ptr != end) {
+        return false;
+    }
+    ms = std::chrono::milliseconds {count};
+    return true;
+}
+
+// The interval of a heart-beat direction. Both sides must agree to it, and
+// the slowest one wins.
+static std::chrono::milliseconds Negotiate(
+    const std::chrono::milliseconds local,
+    const std::chrono::milliseconds remote
+)
+{
+    if (local.count() == 0 || remote.count() == 0) {
+        return std::chrono::milliseconds {0};
+    }
+    return std::max(local, remote);
+}
+
+bool NetworkMonitor::operator==(
+    const StompHeartBeat& lhs,
+    const StompHeartBeat& rhs
+)
+{
+    return lhs.send == rhs.send && lhs.receive == rhs.receive;
+}
+
+bool NetworkMonitor::operator!=(
+    const StompHeartBeat& lhs,
+    const StompHeartBeat& rhs
+)
+{
+    return !(lhs == rhs);
+}
+
+std::ostream& NetworkMonitor::operator<<(
+    std::ostream& os,
+    const StompHeartBeat& heartBeat
+)
+{
+    os << ToString(heartBeat);
+    return os;
+}
+
+std::string NetworkMonitor::ToString(const StompHeartBeat& heartBeat)
+{
+    return std::to_string(heartBeat.send.count()) + "," +
+           std::to_string(heartBeat.receive.count());
+}
+
+StompHeartBeat NetworkMonitor::ParseHeartBeat(
+    StompError& error,
+    const std::string_view value
+)
+{
+    error = StompError::kOk;
+    StompHeartBeat heartBeat {};
+    if (value.empty()) {
+        return heartBeat;
+    }
+    const auto comma {value.find(',')};
+    if (comma == std::string_view::npos ||
+        !ParseMilliseconds(value.substr(0, comma), heartBeat.send) ||
+        !ParseMilliseconds(value.substr(comma + 1), heartBeat.receive)) {
+        error = StompError::kValidationInvalidHeaderValue;
+        return {};
+    }
+    return heartBeat;
+}
+
+StompHeartBeat NetworkMonitor::NegotiateHeartBeat(
+    const StompHeartBeat& local,
+    const StompHeartBeat& remote
+)
+{
+    // We send at the pace the peer wants to receive, and the other way round.
+    return {
+        Negotiate(local.send, remote.receive),
+        Negotiate(local.receive, remote.send),
+    };
+}
+
+std::chrono::milliseconds NetworkMonitor::GetHeartBeatCheckInterval(
+    const StompHeartBeat& heartBeat
+)
+{
+    std::chrono::milliseconds interval {0};
+    for (const auto direction: {heartBeat.send, heartBeat.receive}) {
+        if (direction.count() > 0 &&
+            (interval.count() == 0 || direction < interval)) {
+            interval = direction;
+        }
+    }
+
+    // A 1 ms interval must not give a timer that never waits.
+    return interval.count() == 0 ? interval :
+        std::max(interval / 2, std::chrono::milliseconds {1});
+}
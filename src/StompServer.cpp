@@ -36,10 +36,28 @@ static const auto gStompServerErrorStrings {
                            "CouldNotSendMessage"               },
         {StompServerError::kCouldNotStartWebsocketServer      ,
                            "CouldNotStartWebsocketServer"      },
+        {StompServerError::kFrameTooLarge                     ,
+                           "FrameTooLarge"                     },
+        {StompServerError::kHeartBeatTimeout                  ,
+                           "HeartBeatTimeout"                  },
         {StompServerError::kInvalidHeaderValueAcceptVersion   ,
                            "InvalidHeaderValueAcceptVersion"   },
+        {StompServerError::kInvalidHeaderValueAck             ,
+                           "InvalidHeaderValueAck"             },
+        {StompServerError::kInvalidHeaderValueHeartBeat       ,
+                           "InvalidHeaderValueHeartBeat"       },
         {StompServerError::kInvalidHeaderValueHost            ,
                            "InvalidHeaderValueHost"            },
+        {StompServerError::kSendRateExceeded                  ,
+                           "SendRateExceeded"                  },
+        {StompServerError::kServerBusy                        ,
+                           "ServerBusy"                        },
+        {StompServerError::kSubscriptionIdInUse               ,
+                           "SubscriptionIdInUse"               },
+        {StompServerError::kTooManyConnections                ,
+                           "TooManyConnections"                },
+        {StompServerError::kUnrecognizedSubscription          ,
+                           "UnrecognizedSubscription"          },
         {StompServerError::kUnsupportedFrame                  ,
                            "UnsupportedFrame"                  },
         {StompServerError::kWebsocketSessionDisconnected      ,
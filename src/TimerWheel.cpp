@@ -0,0 +1,129 @@
+#include <network-monitor/TimerWheel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::TimerWheel;
+
+TimerWheel::TimerWheel(
+    const Clock::duration tick,
+    const size_t nSlots,
+    const Clock::time_point start
+) : tick_ {std::max(tick, Clock::duration {1})},
+    start_ {start},
+    slots_(std::max(nSlots, size_t {1}))
+{
+}
+
+void TimerWheel::Schedule(
+    const std::string& key,
+    const Clock::time_point deadline
+)
+{
+    Cancel(key);
+
+    // A deadline in the past expires on the next tick.
+    const auto tickIdx {std::max(
+        GetTickIndex(deadline, true),
+        currentTick_ + 1
+    )};
+    const auto slotIdx {tickIdx % slots_.size()};
+    auto& slot {slots_[slotIdx]};
+    slot.push_back({key, deadline});
+    index_.emplace(key, std::make_pair(slotIdx, std::prev(slot.end())));
+}
+
+bool TimerWheel::Cancel(
+    const std::string& key
+)
+{
+    auto indexIt {index_.find(key)};
+    if (indexIt == index_.end()) {
+        return false;
+    }
+    const auto& [slotIdx, entryIt] {indexIt->second};
+    slots_[slotIdx].erase(entryIt);
+    index_.erase(indexIt);
+    return true;
+}
+
+size_t TimerWheel::Advance(
+    const Clock::time_point now,
+    std::vector<std::string>& expired
+)
+{
+    const auto nExpired {expired.size()};
+    const auto targetTick {GetTickIndex(now, false)};
+    if (targetTick <= currentTick_) {
+        return 0;
+    }
+
+    // After a full revolution, every slot has been visited once.
+    const auto nTicks {std::min(targetTick - currentTick_, slots_.size())};
+    for (size_t idx {1}; idx <= nTicks && !index_.empty(); ++idx) {
+        ExpireSlot((targetTick - nTicks + idx) % slots_.size(), now, expired);
+    }
+    currentTick_ = targetTick;
+    return expired.size() - nExpired;
+}
+
+void TimerWheel::Clear()
+{
+    for (auto& slot: slots_) {
+        slot.clear();
+    }
+    index_.clear();
+}
+
+size_t TimerWheel::Size() const
+{
+    return index_.size();
+}
+
+bool TimerWheel::Empty() const
+{
+    return index_.empty();
+}
+
+TimerWheel::Clock::duration TimerWheel::GetTick() const
+{
+    return tick_;
+}
+
+size_t TimerWheel::GetTickIndex(
+    const Clock::time_point time,
+    const bool roundUp
+) const
+{
+    if (time <= start_) {
+        return 0;
+    }
+    const auto elapsed {time - start_};
+    auto tickIdx {static_cast<size_t>(elapsed / tick_)};
+    if (roundUp && elapsed % tick_ != Clock::duration::zero()) {
+        ++tickIdx;
+    }
+    return tickIdx;
+}
+
+void TimerWheel::ExpireSlot(
+    const size_t slotIdx,
+    const Clock::time_point now,
+    std::vector<std::string>& expired
+)
+{
+    // The deadlines of the next revolutions stay in the slot.
+    auto& slot {slots_[slotIdx]};
+    for (auto entryIt {slot.begin()}; entryIt != slot.end();) {
+        if (entryIt->deadline > now) {
+            ++entryIt;
+            continue;
+        }
+        index_.erase(entryIt->key);
+        expired.push_back(std::move(entryIt->key));
+        entryIt = slot.erase(entryIt);
+    }
+}
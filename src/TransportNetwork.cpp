@@ -7,11 +7,13 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <charconv>
 #include <memory>
 #include <queue>
 #include <unordered_map>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using NetworkMonitor::Id;
@@ -134,6 +136,150 @@ void NetworkMonitor::from_json(
     dst.steps = src.at("steps").get<std::vector<TravelRoute::Step>>();
 }
 
+// JSON writer utilities
+// These functions reproduce the compact output of nlohmann::json::dump()
+// without building a JSON object first.
+
+// Size of a string once escaped and quoted.
+static size_t GetJsonStringSize(const std::string_view string)
+{
+    size_t size {2}; // Quotes
+    for (const unsigned char c: string) {
+        switch (c) {
+            case '"':
+            case '\\':
+            case '\b':
+            case '\f':
+            case '\n':
+            case '\r':
+            case '\t':
+                size += 2;
+                break;
+            default:
+                size += c < 0x20 ? 6 : 1; // Control characters: \u00XX
+                break;
+        }
+    }
+    return size;
+}
+
+static void WriteJsonString(std::string& dst, const std::string_view string)
+{
+    static const char hexDigits[] {"0123456789abcdef"};
+    dst += '"';
+    for (const unsigned char c: string) {
+        switch (c) {
+            case '"' : dst += "\\\""; break;
+            case '\\': dst += "\\\\"; break;
+            case '\b': dst += "\\b"; break;
+            case '\f': dst += "\\f"; break;
+            case '\n': dst += "\\n"; break;
+            case '\r': dst += "\\r"; break;
+            case '\t': dst += "\\t"; break;
+            default: {
+                if (c < 0x20) {
+                    dst += "\\u00";
+                    dst += hexDigits[c >> 4];
+                    dst += hexDigits[c & 0x0f];
+                } else {
+                    dst += static_cast<char>(c);
+                }
+                break;
+            }
+        }
+    }
+    dst += '"';
+}
+
+static size_t GetJsonNumberSize(unsigned int number)
+{
+    size_t size {1};
+    while (number >= 10) {
+        number /= 10;
+        ++size;
+    }
+    return size;
+}
+
+static void WriteJsonNumber(std::string& dst, const unsigned int number)
+{
+    char digits[16];
+    auto result {std::to_chars(std::begin(digits), std::end(digits), number)};
+    dst.append(digits, result.ptr);
+}
+
+// The keys are written in lexicographical order, like nlohmann::json does.
+static size_t GetStepJsonSize(const TravelRoute::Step& src)
+{
+    return std::string_view {
+        "{\"end_station_id\":,\"line_id\":,\"route_id\":,"
+        "\"start_station_id\":,\"travel_time\":}"
+    }.size() +
+        GetJsonStringSize(src.endStationId) +
+        GetJsonStringSize(src.lineId) +
+        GetJsonStringSize(src.routeId) +
+        GetJsonStringSize(src.startStationId) +
+        GetJsonNumberSize(src.travelTime);
+}
+
+static void WriteStepJson(std::string& dst, const TravelRoute::Step& src)
+{
+    dst += "{\"end_station_id\":";
+    WriteJsonString(dst, src.endStationId);
+    dst += ",\"line_id\":";
+    WriteJsonString(dst, src.lineId);
+    dst += ",\"route_id\":";
+    WriteJsonString(dst, src.routeId);
+    dst += ",\"start_station_id\":";
+    WriteJsonString(dst, src.startStationId);
+    dst += ",\"travel_time\":";
+    WriteJsonNumber(dst, src.travelTime);
+    dst += '}';
+}
+
+size_t NetworkMonitor::GetJsonSize(
+    const TravelRoute& src
+)
+{
+    size_t size {
+        std::string_view {
+            "{\"end_station_id\":,\"start_station_id\":,\"steps\":[],"
+            "\"total_travel_time\":}"
+        }.size() +
+        GetJsonStringSize(src.endStationId) +
+        GetJsonStringSize(src.startStationId) +
+        GetJsonNumberSize(src.totalTravelTime)
+    };
+    for (const auto& step: src.steps) {
+        size += GetStepJsonSize(step);
+    }
+    if (!src.steps.empty()) {
+        size += src.steps.size() - 1; // Commas between steps
+    }
+    return size;
+}
+
+void NetworkMonitor::WriteJson(
+    std::string& dst,
+    const TravelRoute& src
+)
+{
+    dst += "{\"end_station_id\":";
+    WriteJsonString(dst, src.endStationId);
+    dst += ",\"start_station_id\":";
+    WriteJsonString(dst, src.startStationId);
+    dst += ",\"steps\":[";
+    for (size_t idx {0}; idx < src.steps.size(); ++idx) {
+        if (idx > 0) {
+            dst += ',';
+        }
+        WriteStepJson(dst, src.steps[idx]);
+    }
+    dst += "],\"total_travel_time\":";
+    WriteJsonNumber(dst, src.totalTravelTime);
+    dst += '}';
+}
+
 // TransportNetwork — Public methods
 
 TransportNetwork::TransportNetwork() = default;
@@ -299,6 +445,22 @@ long long int TransportNetwork::GetPassengerCount(
     return stationNode->passengerCount;
 }
 
+size_t TransportNetwork::CopyPassengerCounts(
+    const TransportNetwork& other
+)
+{
+    size_t nCopied {0};
+    for (const auto& [stationId, otherNode]: other.stations_) {
+        auto stationNode {GetStation(stationId)};
+        if (stationNode == nullptr) {
+            continue;
+        }
+        stationNode->passengerCount = otherNode->passengerCount;
+        ++nCopied;
+    }
+    return nCopied;
+}
+
 std::vector<Id> TransportNetwork::GetRoutesServingStation(
     const Id& station
 ) const
@@ -523,6 +685,47 @@ TravelRoute TransportNetwork::GetQuietTravelRoute(
     const double minQuietnessPc,
     const size_t maxNPaths
 ) const
+{
+    return GetQuietTravelRoute(
+        stationAId,
+        stationBId,
+        maxSlowdownPc,
+        minQuietnessPc,
+        maxNPaths,
+        nullptr
+    );
+}
+
+TravelRoute TransportNetwork::GetQuietTravelRoute(
+    const Id& stationAId,
+    const Id& stationBId,
+    const double maxSlowdownPc,
+    const double minQuietnessPc,
+    const size_t maxNPaths,
+    std::vector<Id>& dependencies
+) const
+{
+    dependencies.clear();
+    return GetQuietTravelRoute(
+        stationAId,
+        stationBId,
+        maxSlowdownPc,
+        minQuietnessPc,
+        maxNPaths,
+        &dependencies
+    );
+}
+
+// TransportNetwork — Private methods
+
+TravelRoute TransportNetwork::GetQuietTravelRoute(
+    const Id& stationAId,
+    const Id& stationBId,
+    const double maxSlowdownPc,
+    const double minQuietnessPc,
+    const size_t maxNPaths,
+    std::vector<Id>* dependencies
+) const
 {
     // Find the stations.
     const auto stationA {GetStation(stationAId)};
@@ -567,6 +770,20 @@ TravelRoute TransportNetwork::GetQuietTravelRoute(
         };
     }
 
+    // The result only depends on the crowding along the candidate paths.
+    if (dependencies != nullptr && paths.size() > 1) {
+        for (const auto& path: paths) {
+            for (const auto& [stop, _]: path) {
+                dependencies->push_back(stop.node->id);
+            }
+        }
+        std::sort(dependencies->begin(), dependencies->end());
+        dependencies->erase(
+            std::unique(dependencies->begin(), dependencies->end()),
+            dependencies->end()
+        );
+    }
+
     // Select the most quiet route among the fastest paths.
     // By definition, we only selected paths that have an acceptable travel
     // time, so here we can simply select the path with the lowest passenger
@@ -618,8 +835,6 @@ TravelRoute TransportNetwork::GetQuietTravelRoute(
     return travelRoute;
 }
 
-// TransportNetwork — Private methods
-
 std::vector<
     std::shared_ptr<TransportNetwork::GraphEdge>
 >::const_iterator TransportNetwork::GraphNode::FindEdgeForRoute(
@@ -0,0 +1,144 @@
+#include <network-monitor/WebsocketCompression.h>
+
+#include <boost/asio.hpp>
+#include <boost/beast/websocket/option.hpp>
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <boost/version.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+using NetworkMonitor::WebsocketCompressionOptions;
+using NetworkMonitor::WebsocketCompressionReport;
+using NetworkMonitor::WebsocketCompressionStats;
+
+// Boost.Beast only skips the small messages from Boost 1.77.
+static size_t GetMinMessageSize(
+    [[maybe_unused]] const WebsocketCompressionOptions& options
+)
+{
+#if BOOST_VERSION >= 107700
+    return options.minMessageSize;
+#else
+    return 0;
+#endif
+}
+
+boost::beast::websocket::permessage_deflate NetworkMonitor::ToPermessageDeflate(
+    const WebsocketCompressionOptions& options
+)
+{
+    const auto windowBits {std::clamp(options.windowBits, 9, 15)};
+    boost::beast::websocket::permessage_deflate pmd {};
+    pmd.client_enable = options.enabled;
+    pmd.server_enable = options.enabled;
+    pmd.client_max_window_bits = windowBits;
+    pmd.server_max_window_bits = windowBits;
+    pmd.compLevel = std::clamp(options.compressionLevel, 0, 9);
+    pmd.memLevel = std::clamp(options.memLevel, 1, 9);
+#if BOOST_VERSION >= 107700
+    pmd.msg_size_threshold = options.minMessageSize;
+#else
+    // Each stream calls us, so we only warn once.
+    if (options.enabled && options.minMessageSize > 0) {
+        static std::once_flag warned {};
+        std::call_once(warned, [&options]() {
+            spdlog::warn("WebsocketCompression: Ignoring minimum message size "
+                         "{}: Boost {}.{} compresses all the messages",
+                         options.minMessageSize, BOOST_VERSION / 100000,
+                         BOOST_VERSION / 100 % 1000);
+        });
+    }
+#endif
+    return pmd;
+}
+
+double WebsocketCompressionReport::GetRatio() const
+{
+    if (sampledBytes == 0) {
+        return 1.0;
+    }
+    return static_cast<double>(sampledCompressedBytes) / sampledBytes;
+}
+
+std::chrono::nanoseconds WebsocketCompressionReport::GetCpuTimePerMessage(
+) const
+{
+    if (nSampled == 0) {
+        return std::chrono::nanoseconds {0};
+    }
+    return sampledCpuTime / nSampled;
+}
+
+WebsocketCompressionStats::WebsocketCompressionStats(
+    const WebsocketCompressionOptions& options,
+    const size_t sampleEvery
+)
+{
+    const auto pmd {ToPermessageDeflate(options)};
+    windowBits_ = pmd.server_max_window_bits;
+    memLevel_ = pmd.memLevel;
+    compressionLevel_ = pmd.compLevel;
+    minMessageSize_ = GetMinMessageSize(options);
+    sampleEvery_ = std::max(sampleEvery, size_t {1});
+}
+
+void WebsocketCompressionStats::RecordMessage(
+    const std::vector<boost::asio::const_buffer>& message
+)
+{
+    const auto size {boost::asio::buffer_size(message)};
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        ++report_.nMessages;
+        if (size < minMessageSize_ || size == 0) {
+            return;
+        }
+        ++report_.nCompressible;
+        if ((report_.nCompressible - 1) % sampleEvery_ != 0) {
+            return;
+        }
+    }
+
+    // We compress the message like Boost.Beast does, outside of the lock.
+    // The sync flush marker at the end is not sent.
+    namespace zlib = boost::beast::zlib;
+    const auto start {std::chrono::steady_clock::now()};
+    zlib::deflate_stream deflate {};
+    deflate.reset(compressionLevel_, windowBits_, memLevel_,
+                  zlib::Strategy::normal);
+    std::vector<unsigned char> output(deflate.upper_bound(size) + 16);
+    zlib::z_params zs {};
+    zs.next_out = output.data();
+    zs.avail_out = output.size();
+    boost::system::error_code ec {};
+    for (const auto& buffer: message) {
+        zs.next_in = buffer.data();
+        zs.avail_in = buffer.size();
+        deflate.write(zs, zlib::Flush::none, ec);
+    }
+    zs.avail_in = 0;
+    deflate.write(zs, zlib::Flush::sync, ec);
+    const auto compressedSize {zs.total_out >= 4 ? zs.total_out - 4 : 0};
+    const auto cpuTime {std::chrono::steady_clock::now() - start};
+    if (ec && ec != zlib::error::need_buffers) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock {mutex_};
+    ++report_.nSampled;
+    report_.sampledBytes += size;
+    report_.sampledCompressedBytes += compressedSize;
+    report_.sampledCpuTime +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(cpuTime);
+}
+
+WebsocketCompressionReport WebsocketCompressionStats::GetReport() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return report_;
+}
@@ -1,9 +1,12 @@
 #include <network-monitor/env.h>
 
+#include <charconv>
 #include <cstdlib>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <type_traits>
 
 std::string NetworkMonitor::GetEnvVar(
     const std::string& envVar,
@@ -16,4 +19,47 @@ std::string NetworkMonitor::GetEnvVar(
                                  envVar);
     }
     return value != nullptr ? value : *defaultValue;
-}
\ No newline at end of file
+}
+
+template <typename T>
+T NetworkMonitor::GetEnvVarNumber(
+    const std::string& envVar,
+    const std::optional<std::string>& defaultValue
+)
+{
+    const auto value {GetEnvVar(envVar, defaultValue)};
+    const auto end {value.data() + value.size()};
+    T result {};
+    bool ok {false};
+    if constexpr (std::is_floating_point_v<T>) {
+        try {
+            size_t nParsed {0};
+            result = static_cast<T>(std::stod(value, &nParsed));
+            ok = nParsed == value.size();
+        } catch (const std::logic_error&) {
+            ok = false;
+        }
+    } else {
+        auto conversionResult {std::from_chars(value.data(), end, result)};
+        ok = conversionResult.ec == std::errc {} &&
+             conversionResult.ptr == end;
+    }
+    if (!ok) {
+        throw std::runtime_error("Invalid value for environment variable " +
+                                 envVar + ": " + value);
+    }
+    return result;
+}
+
+template int NetworkMonitor::GetEnvVarNumber<int>(
+    const std::string& envVar,
+    const std::optional<std::string>& defaultValue
+);
+template size_t NetworkMonitor::GetEnvVarNumber<size_t>(
+    const std::string& envVar,
+    const std::optional<std::string>& defaultValue
+);
+template double NetworkMonitor::GetEnvVarNumber<double>(
+    const std::string& envVar,
+    const std::optional<std::string>& defaultValue
+);
\ No newline at end of file
@@ -3,19 +3,124 @@
 #include <network-monitor/WebsocketClient.h>
 #include <network-monitor/WebsocketServer.h>
 
+#include <spdlog/spdlog.h>
+
 #include <chrono>
+#include <memory>
+#include <stdexcept>
 #include <string>
 
 using NetworkMonitor::BoostWebsocketClient;
 using NetworkMonitor::GetEnvVar;
+using NetworkMonitor::GetEnvVarNumber;
+using NetworkMonitor::NetworkEventsOverflow;
 using NetworkMonitor::NetworkMonitorError;
 using NetworkMonitor::NetworkMonitorConfig;
+using NetworkMonitor::StompClientAckMode;
+using NetworkMonitor::StompClientAckPolicy;
+using NetworkMonitor::StompClientReconnectPolicy;
+using NetworkMonitor::StompHeartBeat;
+using NetworkMonitor::StompServerLimits;
 using NetworkMonitor::BoostWebsocketServer;
+using NetworkMonitor::WebsocketCompressionOptions;
+using NetworkMonitor::WebsocketCompressionStats;
 
-int main()
+// Read the monitor configuration from the environment.
+// Throws std::runtime_error if a variable is missing or has an invalid value.
+static NetworkMonitorConfig GetConfig()
 {
+    // Heart-beat intervals. 0 = disabled
+    const std::chrono::milliseconds networkEventsHeartBeat {
+        GetEnvVarNumber<int>("LTNM_NETWORK_EVENTS_HEART_BEAT_MS", "10000")
+    };
+    const std::chrono::milliseconds quietRouteHeartBeat {
+        GetEnvVarNumber<int>("LTNM_QUIET_ROUTE_HEART_BEAT_MS", "10000")
+    };
+
+    // Acknowledgement of the network events
+    // Default: auto, at most 1000 events waiting for the update stage
+    const auto ackModeName {
+        GetEnvVar("LTNM_NETWORK_EVENTS_ACK_MODE", "auto")
+    };
+    const auto ackMode {
+        ackModeName == "client" ? StompClientAckMode::kClient :
+        ackModeName == "client-individual" ?
+            StompClientAckMode::kClientIndividual :
+            StompClientAckMode::kAuto
+    };
+    StompClientAckPolicy ackPolicy {};
+    ackPolicy.maxUnacked = GetEnvVarNumber<size_t>(
+        "LTNM_NETWORK_EVENTS_MAX_UNACKED", "1000"
+    );
+
+    // Network events queue
+    // Default: 4096 events; stop reading from the server when it is full
+    const auto queueCapacity {GetEnvVarNumber<size_t>(
+        "LTNM_NETWORK_EVENTS_QUEUE_CAPACITY", "4096"
+    )};
+    const auto overflowName {
+        GetEnvVar("LTNM_NETWORK_EVENTS_OVERFLOW", "block-reads")
+    };
+    const auto overflow {
+        overflowName == "drop-oldest" ? NetworkEventsOverflow::kDropOldest :
+        overflowName == "coalesce" ? NetworkEventsOverflow::kCoalesce :
+            NetworkEventsOverflow::kBlockReads
+    };
+
+    // I/O context threads
+    // Default: 1 thread
+    const auto nThreads {GetEnvVarNumber<size_t>("LTNM_N_THREADS", "1")};
+
+    // Websocket compression (permessage-deflate)
+    // Default: disabled; 15 window bits, memory level 4, level 8, compress
+    //          all messages. One message out of 16 is measured.
+    WebsocketCompressionOptions compression {};
+    compression.windowBits = GetEnvVarNumber<int>(
+        "LTNM_COMPRESSION_WINDOW_BITS", "15"
+    );
+    compression.memLevel = GetEnvVarNumber<int>(
+        "LTNM_COMPRESSION_MEM_LEVEL", "4"
+    );
+    compression.compressionLevel = GetEnvVarNumber<int>(
+        "LTNM_COMPRESSION_LEVEL", "8"
+    );
+    compression.minMessageSize = GetEnvVarNumber<size_t>(
+        "LTNM_COMPRESSION_MIN_SIZE", "0"
+    );
+    auto networkEventsCompression {compression};
+    networkEventsCompression.enabled =
+        GetEnvVar("LTNM_NETWORK_EVENTS_COMPRESSION", "0") == "1";
+    networkEventsCompression.stats =
+        std::make_shared<WebsocketCompressionStats>(compression, 16);
+    auto quietRouteCompression {compression};
+    quietRouteCompression.enabled =
+        GetEnvVar("LTNM_QUIET_ROUTE_COMPRESSION", "0") == "1";
+    quietRouteCompression.stats =
+        std::make_shared<WebsocketCompressionStats>(compression, 16);
+
+    // Quiet-route admission control
+    // Default: 1000 connections; 10 requests per second per client, with
+    //          bursts of 20; 64 KiB frames; 64 routes computed at the same
+    //          time.
+    StompServerLimits quietRouteLimits {};
+    quietRouteLimits.maxConnections = GetEnvVarNumber<size_t>(
+        "LTNM_QUIET_ROUTE_MAX_CONNECTIONS", "1000"
+    );
+    quietRouteLimits.sendRate = GetEnvVarNumber<double>(
+        "LTNM_QUIET_ROUTE_SEND_RATE", "10"
+    );
+    quietRouteLimits.sendBurst = GetEnvVarNumber<size_t>(
+        "LTNM_QUIET_ROUTE_SEND_BURST", "20"
+    );
+    quietRouteLimits.maxFrameSize = GetEnvVarNumber<size_t>(
+        "LTNM_QUIET_ROUTE_MAX_FRAME_SIZE", "65536"
+    );
+    const auto maxInFlightRequests {GetEnvVarNumber<size_t>(
+        "LTNM_QUIET_ROUTE_MAX_IN_FLIGHT", "64"
+    )};
+
     // Monitor configuration
-    NetworkMonitorConfig config {
+    return NetworkMonitorConfig {
         GetEnvVar("LTNM_SERVER_URL", "ltnm.learncppthroughprojects.com"),
         GetEnvVar("LTNM_SERVER_PORT", "443"),
         GetEnvVar("LTNM_USERNAME"),
@@ -30,11 +135,44 @@ int main()
         0.1,
         0.1,
         20,
+        GetEnvVar("LTNM_NETWORK_LAYOUT_HOT_RELOAD", "0") == "1",
+        std::chrono::milliseconds(GetEnvVarNumber<int>(
+            "LTNM_NETWORK_LAYOUT_RELOAD_DEBOUNCE_MS", "500"
+        )),
+        StompClientReconnectPolicy {
+            GetEnvVar("LTNM_NETWORK_EVENTS_RECONNECT", "1") == "1",
+        },
+        StompHeartBeat {networkEventsHeartBeat, networkEventsHeartBeat},
+        StompHeartBeat {quietRouteHeartBeat, quietRouteHeartBeat},
+        ackMode,
+        ackPolicy,
+        queueCapacity,
+        overflow,
+        nThreads,
+        networkEventsCompression,
+        quietRouteCompression,
+        std::chrono::milliseconds(GetEnvVarNumber<int>(
+            "LTNM_QUIET_ROUTE_SUBSCRIPTION_BATCH_MS", "100"
+        )),
+        quietRouteLimits,
+        maxInFlightRequests,
     };
+}
 
-    // Optional run timeout
-    // Default: Oms = run indefinitely
-    auto timeoutMs {std::stoi(GetEnvVar("LTNM_TIMEOUT_MS", "0"))};
+int main()
+{
+    NetworkMonitorConfig config {};
+    int timeoutMs {0};
+    try {
+        config = GetConfig();
+
+        // Optional run timeout
+        // Default: Oms = run indefinitely
+        timeoutMs = GetEnvVarNumber<int>("LTNM_TIMEOUT_MS", "0");
+    } catch (const std::runtime_error& e) {
+        spdlog::error("Invalid configuration: {}", e.what());
+        return -1;
+    }
 
     // Launch the monitor.
     NetworkMonitor::NetworkMonitor<
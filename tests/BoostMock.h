@@ -8,8 +8,10 @@
 #include <boost/beast.hpp>
 #include <boost/utility/string_view.hpp>
 
+#include <algorithm>
 #include <queue>
 #include <string>
+#include <vector>
 
 namespace NetworkMonitor {
 
@@ -181,6 +183,23 @@ public:
         acceptEc.push(boost::asio::error::operation_aborted);
     }
 
+    /*! \brief Mock for acceptor::close
+     */
+    void close(
+        boost::system::error_code& ec
+    )
+    {
+        close();
+        ec = {};
+    }
+
+    /*! \brief Mock for acceptor::get_executor
+     */
+    boost::asio::strand<boost::asio::io_context::executor_type> get_executor()
+    {
+        return context_;
+    }
+
     /*! \brief Mock for acceptor::async_accept
      */
     template <typename ExecutionContext, typename AcceptHandler>
@@ -374,6 +393,16 @@ public:
      */
     static boost::system::error_code closeEc;
 
+    /* \brief The messages written with async_write, in order. Each message is
+     *        the concatenation of the buffers passed to one async_write call.
+     */
+    static std::vector<std::string> writtenMessages;
+
+    /* \brief The largest number of async_write calls that were pending at the
+     *        same time on one stream.
+     */
+    static size_t maxWritesInFlight;
+
     /*! \brief Mock for websocket::stream::async_handshake
      */
     template <typename HandshakeHandler>
@@ -482,14 +511,27 @@ public:
                         )
                     );
                 } else {
+                    if (!MockWebsocketStream::writeEc) {
+                        MockWebsocketStream::writtenMessages.push_back(
+                            boost::beast::buffers_to_string(buffers)
+                        );
+                    }
+                    ++stream->writesInFlight_;
+                    MockWebsocketStream::maxWritesInFlight = std::max(
+                        MockWebsocketStream::maxWritesInFlight,
+                        stream->writesInFlight_
+                    );
+
                     // Call the user callback.
+                    auto ec {MockWebsocketStream::writeEc};
+                    auto nWritten {ec ? 0 : boost::asio::buffer_size(buffers)};
                     boost::asio::post(
                         stream->get_executor(),
-                        boost::beast::bind_handler(
-                            std::move(handler),
-                            MockWebsocketStream::writeEc,
-                            MockWebsocketStream::writeEc ? 0 : buffers.size()
-                        )
+                        [stream, handler = std::move(handler), ec, nWritten](
+                        ) mutable {
+                            --stream->writesInFlight_;
+                            handler(ec, nWritten);
+                        }
                     );
                 }
             },
@@ -546,6 +588,9 @@ private:
     // successful response.
     bool closed_ {true};
 
+    // The async_write calls whose handler has not run yet.
+    size_t writesInFlight_ {0};
+
     // This function mimicks a socket reading messages. It's the function we
     // call from async_read.
     template <typename DynamicBuffer, typename ReadHandler>
@@ -619,6 +664,14 @@ boost::system::error_code MockWebsocketStream<TransportStream>::writeEc = {};
 template <typename TransportStream>
 boost::system::error_code MockWebsocketStream<TransportStream>::closeEc = {};
 
+template <typename TransportStream>
+std::vector<std::string> MockWebsocketStream<
+    TransportStream
+>::writtenMessages = {};
+
+template <typename TransportStream>
+size_t MockWebsocketStream<TransportStream>::maxWritesInFlight = 0;
+
 /*! \brief Type alias for the mocked ssl_stream.
  */
 using MockTlsStream = MockSslStream<MockTcpStream>;
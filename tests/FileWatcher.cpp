@@ -0,0 +1,196 @@
+#include <network-monitor/FileWatcher.h>
+
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using NetworkMonitor::FileWatcher;
+
+using namespace std::chrono_literals;
+
+// Use this to set a timeout on tests that may hang.
+using timeout = boost::unit_test::timeout;
+
+// Write a file as operators do: Either in place, or by replacing it with a
+// temporary file.
+static void WriteFile(
+    const std::filesystem::path& file,
+    const std::string& content,
+    bool atomic = false
+)
+{
+    auto destination {atomic ? file.string() + ".tmp" : file.string()};
+    {
+        std::ofstream out {destination};
+        out << content;
+    }
+    if (atomic) {
+        std::filesystem::rename(destination, file);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+
+BOOST_AUTO_TEST_SUITE(class_FileWatcher);
+
+#ifdef __linux__
+
+BOOST_AUTO_TEST_CASE(debounced_changes, *timeout {3})
+{
+    const auto file {
+        std::filesystem::temp_directory_path() / "file-watcher-debounce.json"
+    };
+    WriteFile(file, "{}");
+
+    boost::asio::io_context ioc {};
+    FileWatcher watcher {file, 100ms, ioc};
+    size_t nChanges {0};
+    bool ok {watcher.Run([&nChanges]() {
+        ++nChanges;
+    })};
+    BOOST_REQUIRE(ok);
+
+    // A burst of writes results in a single notification.
+    boost::asio::steady_timer writer {ioc};
+    size_t nWrites {0};
+    std::function<void (boost::system::error_code)> write {};
+    write = [&](auto) {
+        WriteFile(file, "{\"write\": " + std::to_string(nWrites) + "}");
+        if (++nWrites < 5) {
+            writer.expires_after(10ms);
+            writer.async_wait(write);
+        }
+    };
+    writer.expires_after(10ms);
+    writer.async_wait(write);
+    ioc.run_for(500ms);
+    BOOST_CHECK_EQUAL(nWrites, 5);
+    BOOST_CHECK_EQUAL(nChanges, 1);
+
+    watcher.Stop();
+    std::filesystem::remove(file);
+}
+
+BOOST_AUTO_TEST_CASE(atomic_replace, *timeout {3})
+{
+    const auto file {
+        std::filesystem::temp_directory_path() / "file-watcher-replace.json"
+    };
+    WriteFile(file, "{}");
+
+    boost::asio::io_context ioc {};
+    FileWatcher watcher {file, 20ms, ioc};
+    size_t nChanges {0};
+    bool ok {watcher.Run([&nChanges]() {
+        ++nChanges;
+    })};
+    BOOST_REQUIRE(ok);
+
+    // Two replacements far apart result in two notifications. Changes to
+    // other files in the same directory are ignored.
+    boost::asio::steady_timer writer {ioc};
+    writer.expires_after(10ms);
+    writer.async_wait([&](auto) {
+        WriteFile(file, "{\"write\": 1}", true);
+        WriteFile(file.string() + ".other", "{}");
+        writer.expires_after(200ms);
+        writer.async_wait([&](auto) {
+            WriteFile(file, "{\"write\": 2}", true);
+        });
+    });
+    ioc.run_for(500ms);
+    BOOST_CHECK_EQUAL(nChanges, 2);
+
+    watcher.Stop();
+    std::filesystem::remove(file);
+    std::filesystem::remove(file.string() + ".other");
+}
+
+BOOST_AUTO_TEST_CASE(stop, *timeout {3})
+{
+    const auto file {
+        std::filesystem::temp_directory_path() / "file-watcher-stop.json"
+    };
+    WriteFile(file, "{}");
+
+    boost::asio::io_context ioc {};
+    FileWatcher watcher {file, 50ms, ioc};
+    size_t nChanges {0};
+    bool ok {watcher.Run([&nChanges]() {
+        ++nChanges;
+    })};
+    BOOST_REQUIRE(ok);
+
+    // We stop the watcher before the debounce interval expires.
+    boost::asio::steady_timer writer {ioc};
+    writer.expires_after(10ms);
+    writer.async_wait([&](auto) {
+        WriteFile(file, "{\"write\": 1}");
+        writer.expires_after(10ms);
+        writer.async_wait([&](auto) {
+            watcher.Stop();
+        });
+    });
+    ioc.run_for(300ms);
+    BOOST_CHECK_EQUAL(nChanges, 0);
+
+    std::filesystem::remove(file);
+}
+
+BOOST_AUTO_TEST_CASE(stop_from_other_thread, *timeout {3})
+{
+    const auto file {
+        std::filesystem::temp_directory_path() / "file-watcher-stop-thread.json"
+    };
+    WriteFile(file, "{}");
+
+    boost::asio::io_context ioc {};
+    FileWatcher watcher {file, 50ms, ioc};
+    size_t nChanges {0};
+    bool ok {watcher.Run([&nChanges]() {
+        ++nChanges;
+    })};
+    BOOST_REQUIRE(ok);
+
+    // The pending read keeps the io_context threads busy until the watcher
+    // releases the file watch.
+    std::vector<std::thread> threads {};
+    for (size_t idx {0}; idx < 2; ++idx) {
+        threads.emplace_back([&ioc]() {
+            ioc.run();
+        });
+    }
+    std::this_thread::sleep_for(20ms);
+    watcher.Stop();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(nChanges, 0);
+
+    std::filesystem::remove(file);
+}
+
+#endif // __linux__
+
+BOOST_AUTO_TEST_CASE(missing_directory)
+{
+    const auto file {
+        std::filesystem::temp_directory_path() / "file-watcher-missing" /
+        "network-layout.json"
+    };
+    boost::asio::io_context ioc {};
+    FileWatcher watcher {file, 50ms, ioc};
+    bool ok {watcher.Run([]() {})};
+    BOOST_CHECK(!ok);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_FileWatcher
+
+BOOST_AUTO_TEST_SUITE_END(); // network_monitor
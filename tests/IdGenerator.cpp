@@ -0,0 +1,95 @@
+#include <network-monitor/IdGenerator.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+
+using NetworkMonitor::IdGenerator;
+using NetworkMonitor::IdGeneratorMode;
+
+static bool IsHex(const std::string_view value)
+{
+    return value.find_first_not_of("0123456789abcdef") ==
+           std::string_view::npos;
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+
+BOOST_AUTO_TEST_SUITE(class_IdGenerator);
+
+BOOST_AUTO_TEST_CASE(random_uuid_format)
+{
+    IdGenerator ids {};
+    BOOST_CHECK(ids.GetMode() == IdGeneratorMode::kRandomUuid);
+    for (size_t idx {0}; idx < 100; ++idx) {
+        const auto id {ids.Generate()};
+        BOOST_REQUIRE_EQUAL(id.size(), 36);
+        BOOST_CHECK(IsHex(id.substr(0, 8)));
+        BOOST_CHECK_EQUAL(id[8], '-');
+        BOOST_CHECK(IsHex(id.substr(9, 4)));
+        BOOST_CHECK_EQUAL(id[13], '-');
+        BOOST_CHECK_EQUAL(id[14], '4');
+        BOOST_CHECK(IsHex(id.substr(15, 3)));
+        BOOST_CHECK_EQUAL(id[18], '-');
+        BOOST_CHECK(std::string_view {"89ab"}.find(id[19]) !=
+                    std::string_view::npos);
+        BOOST_CHECK(IsHex(id.substr(20, 3)));
+        BOOST_CHECK_EQUAL(id[23], '-');
+        BOOST_CHECK(IsHex(id.substr(24, 12)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(counter_format)
+{
+    IdGenerator ids {IdGeneratorMode::kCounter};
+    const auto first {ids.Generate()};
+    const auto second {ids.Generate()};
+    BOOST_REQUIRE_EQUAL(first.size(), 25);
+    BOOST_CHECK(IsHex(first.substr(0, 8)));
+    BOOST_CHECK_EQUAL(first[8], '-');
+    BOOST_CHECK(IsHex(first.substr(9)));
+
+    // Same prefix, increasing counter
+    BOOST_CHECK_EQUAL(first.substr(0, 9), second.substr(0, 9));
+    BOOST_CHECK(first < second);
+}
+
+BOOST_AUTO_TEST_CASE(generate_into_buffer)
+{
+    IdGenerator ids {};
+    IdGenerator::Buffer buffer {};
+    const auto id {ids.Generate(buffer)};
+    BOOST_CHECK_EQUAL(id.size(), 36);
+    BOOST_CHECK_EQUAL(id.data(), buffer.data());
+}
+
+BOOST_AUTO_TEST_CASE(unique)
+{
+    for (const auto mode: {
+        IdGeneratorMode::kRandomUuid,
+        IdGeneratorMode::kCounter,
+    }) {
+        // IDs are unique within a generator and across generators.
+        IdGenerator ids1 {mode};
+        IdGenerator ids2 {mode};
+        std::unordered_set<std::string> seen {};
+        for (size_t idx {0}; idx < 10000; ++idx) {
+            BOOST_REQUIRE(seen.insert(ids1.Generate()).second);
+            BOOST_REQUIRE(seen.insert(ids2.Generate()).second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(not_copyable)
+{
+    // A copy would repeat the IDs of the original.
+    BOOST_CHECK(!std::is_copy_constructible_v<IdGenerator>);
+    BOOST_CHECK(!std::is_copy_assignable_v<IdGenerator>);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_IdGenerator
+
+BOOST_AUTO_TEST_SUITE_END(); // network_monitor
@@ -13,10 +13,12 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <exception>
 #include <thread>
@@ -26,10 +28,13 @@ using NetworkMonitor::BoostWebsocketServer;
 using NetworkMonitor::GetEnvVar;
 using NetworkMonitor::GetMockSendFrame;
 using NetworkMonitor::GetMockStompFrame;
+using NetworkMonitor::GetMockSubscribeFrame;
 using NetworkMonitor::Id;
 using NetworkMonitor::MockWebsocketClientForStomp;
 using NetworkMonitor::MockWebsocketEvent;
 using NetworkMonitor::MockWebsocketServerForStomp;
+using NetworkMonitor::MockWebsocketSession;
+using NetworkMonitor::NetworkEventsOverflow;
 using NetworkMonitor::NetworkMonitorConfig;
 using NetworkMonitor::NetworkMonitorError;
 using NetworkMonitor::ParseJsonFile;
@@ -53,17 +58,60 @@ struct NetworkMonitorTestFixture {
         MockWebsocketClientForStomp::closeEc = {};
         MockWebsocketClientForStomp::triggerDisconnection = false;
         MockWebsocketClientForStomp::subscriptionMessages = {};
+        MockWebsocketClientForStomp::batchSubscriptionMessages = false;
+        MockWebsocketClientForStomp::nPauses = 0;
+        MockWebsocketClientForStomp::ignoreReceipts = false;
+        MockWebsocketClientForStomp::compression = {};
 
         MockWebsocketServerForStomp::triggerDisconnection = false;
         MockWebsocketServerForStomp::runEc = {};
         MockWebsocketServerForStomp::mockEvents = {};
+        MockWebsocketServerForStomp::compression = {};
+        MockWebsocketSession::splitMessages = {};
+        MockWebsocketSession::messages = {};
+        MockWebsocketSession::readingPaused = false;
     }
 };
 
+// Queue 12 passenger events in one Websocket message: 8 at station_0, then 4
+// at station_1.
+static void SetupBurstOfPassengerEvents()
+{
+    MockWebsocketClientForStomp::subscriptionMessages = {};
+    MockWebsocketClientForStomp::batchSubscriptionMessages = true;
+    for (size_t idx {0}; idx < 12; ++idx) {
+        nlohmann::json event {
+            {"datetime", "2020-11-01T07:18:50.234000Z"},
+            {"passenger_event", "in"},
+            {"station_id", idx < 8 ? "station_0" : "station_1"},
+        };
+        MockWebsocketClientForStomp::subscriptionMessages.push_back(
+            event.dump()
+        );
+    }
+}
+
 BOOST_AUTO_TEST_SUITE(network_monitor);
 
 BOOST_AUTO_TEST_SUITE(network_monitor);
 
+BOOST_AUTO_TEST_SUITE(enum_class_NetworkEventsOverflow);
+
+BOOST_AUTO_TEST_CASE(ostream)
+{
+    for (const auto& [overflow, value]: {
+        std::make_pair(NetworkEventsOverflow::kBlockReads, "BlockReads"),
+        std::make_pair(NetworkEventsOverflow::kDropOldest, "DropOldest"),
+        std::make_pair(NetworkEventsOverflow::kCoalesce, "Coalesce"),
+    }) {
+        std::stringstream ss {};
+        ss << overflow;
+        BOOST_CHECK_EQUAL(ss.str(), value);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // enum_class_NetworkEventsOverflow
+
 BOOST_AUTO_TEST_SUITE(enum_class_NetworkMonitorError);
 
 BOOST_AUTO_TEST_CASE(ostream)
@@ -79,6 +127,7 @@ BOOST_AUTO_TEST_CASE(ostream)
         NetworkMonitorError::kCouldNotRecordPassengerEvent,
         NetworkMonitorError::kCouldNotStartStompServer,
         NetworkMonitorError::kCouldNotSubscribeToPassengerEvents,
+        NetworkMonitorError::kCouldNotWatchNetworkLayoutFile,
         NetworkMonitorError::kFailedNetworkLayoutFileDownload,
         NetworkMonitorError::kFailedNetworkLayoutFileParsing,
         NetworkMonitorError::kFailedTransportNetworkConstruction,
@@ -116,6 +165,36 @@ BOOST_AUTO_TEST_CASE(ok)
     BOOST_CHECK_EQUAL(ec, NetworkMonitorError::kOk);
 }
 
+BOOST_AUTO_TEST_CASE(compression)
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        TESTS_NETWORK_LAYOUT_JSON,
+    };
+    config.networkEventsCompression.enabled = true;
+    config.networkEventsCompression.windowBits = 10;
+    config.quietRouteCompression.enabled = true;
+    config.quietRouteCompression.minMessageSize = 256;
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+
+    // The options reach the Websocket client and server.
+    const auto& clientCompression {MockWebsocketClientForStomp::compression};
+    BOOST_CHECK(clientCompression.enabled);
+    BOOST_CHECK_EQUAL(clientCompression.windowBits, 10);
+    const auto& serverCompression {MockWebsocketServerForStomp::compression};
+    BOOST_CHECK(serverCompression.enabled);
+    BOOST_CHECK_EQUAL(serverCompression.minMessageSize, 256);
+}
+
 BOOST_AUTO_TEST_CASE(ok_download_file, *timeout {3})
 {
     // Note: In this test we use a mock but we download the file for real.
@@ -559,6 +638,129 @@ BOOST_AUTO_TEST_CASE(record_2_passenger_events_different_station, *timeout {1})
     );
 }
 
+BOOST_AUTO_TEST_CASE(queue_overflow_block_reads, *timeout {1})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        std::filesystem::path(TEST_DATA) / "from_json_1line_1route.json",
+    };
+    config.networkEventsQueueCapacity = 1;
+    config.networkEventsOverflow = NetworkEventsOverflow::kBlockReads;
+
+    // Setup the mock.
+    // All the events come in one Websocket message, so they all reach the
+    // queue before the update stage runs.
+    SetupBurstOfPassengerEvents();
+
+    // We need to set a timeout otherwise the network monitor will run forever.
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+    monitor.Run(std::chrono::milliseconds(150));
+
+    // When we arrive here, the Run() function ran out of things to do.
+    BOOST_CHECK_EQUAL(monitor.GetLastErrorCode(), NetworkMonitorError::kOk);
+    const auto& network {monitor.GetNetworkRepresentation()};
+    const auto stats {monitor.GetNetworkEventsQueueStats()};
+    BOOST_CHECK_EQUAL(stats.depth, 0);
+    BOOST_CHECK_GT(stats.maxDepth, 1);
+    BOOST_CHECK_EQUAL(network.GetPassengerCount("station_0"), 8);
+    BOOST_CHECK_EQUAL(network.GetPassengerCount("station_1"), 4);
+    BOOST_CHECK_GE(stats.nReadPauses, 1);
+    BOOST_CHECK_GE(MockWebsocketClientForStomp::nPauses, 1);
+    BOOST_CHECK_EQUAL(stats.nDropped, 0);
+}
+
+BOOST_AUTO_TEST_CASE(queue_overflow_drop_oldest, *timeout {1})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        std::filesystem::path(TEST_DATA) / "from_json_1line_1route.json",
+    };
+    config.networkEventsQueueCapacity = 1;
+    config.networkEventsOverflow = NetworkEventsOverflow::kDropOldest;
+
+    // Setup the mock.
+    // All the events come in one Websocket message, so they all reach the
+    // queue before the update stage runs.
+    SetupBurstOfPassengerEvents();
+
+    // We need to set a timeout otherwise the network monitor will run forever.
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+    monitor.Run(std::chrono::milliseconds(150));
+
+    // When we arrive here, the Run() function ran out of things to do.
+    BOOST_CHECK_EQUAL(monitor.GetLastErrorCode(), NetworkMonitorError::kOk);
+    const auto& network {monitor.GetNetworkRepresentation()};
+    const auto stats {monitor.GetNetworkEventsQueueStats()};
+    BOOST_CHECK_EQUAL(stats.depth, 0);
+    BOOST_CHECK_GT(stats.maxDepth, 1);
+    const auto nRecorded {
+        network.GetPassengerCount("station_0") +
+        network.GetPassengerCount("station_1")
+    };
+    BOOST_CHECK_GT(stats.nDropped, 0);
+    BOOST_CHECK_EQUAL(nRecorded + stats.nDropped, 12);
+
+    // The newest event is never dropped.
+    BOOST_CHECK_GE(network.GetPassengerCount("station_1"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(queue_overflow_coalesce, *timeout {1})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        std::filesystem::path(TEST_DATA) / "from_json_1line_1route.json",
+    };
+    config.networkEventsQueueCapacity = 1;
+    config.networkEventsOverflow = NetworkEventsOverflow::kCoalesce;
+
+    // Setup the mock.
+    // All the events come in one Websocket message, so they all reach the
+    // queue before the update stage runs.
+    SetupBurstOfPassengerEvents();
+
+    // We need to set a timeout otherwise the network monitor will run forever.
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+    monitor.Run(std::chrono::milliseconds(150));
+
+    // When we arrive here, the Run() function ran out of things to do.
+    BOOST_CHECK_EQUAL(monitor.GetLastErrorCode(), NetworkMonitorError::kOk);
+    const auto& network {monitor.GetNetworkRepresentation()};
+    const auto stats {monitor.GetNetworkEventsQueueStats()};
+    BOOST_CHECK_EQUAL(stats.depth, 0);
+    BOOST_CHECK_GT(stats.maxDepth, 1);
+    BOOST_CHECK_EQUAL(network.GetPassengerCount("station_0"), 8);
+    BOOST_CHECK_EQUAL(network.GetPassengerCount("station_1"), 4);
+    BOOST_CHECK_GT(stats.nCoalesced, 0);
+    BOOST_CHECK_EQUAL(stats.nDropped, 0);
+}
+
 BOOST_AUTO_TEST_CASE(record_passenger_events_from_file, *timeout {3})
 {
     NetworkMonitorConfig config {
@@ -939,6 +1141,462 @@ BOOST_AUTO_TEST_CASE(quiet_route_ltc_quiet2, *timeout {5})
     BOOST_CHECK_EQUAL(travelRoute, golden);
 }
 
+BOOST_AUTO_TEST_CASE(quiet_route_threads, *timeout {30})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        TESTS_NETWORK_LAYOUT_JSON,
+        "localhost",
+        "127.0.0.1",
+        8042,
+        0.1,
+        0.1,
+        20,
+    };
+    config.nThreads = 4;
+
+    // Setup the mock.
+    // The passenger events come in while the requests are served. They cancel
+    // each other out, so that they do not change the quiet route.
+    MockWebsocketClientForStomp::subscriptionMessages = {};
+    for (size_t idx {0}; idx < 12; ++idx) {
+        nlohmann::json event {
+            {"datetime", "2020-11-01T07:18:50.234000Z"},
+            {"passenger_event", idx % 2 == 0 ? "in" : "out"},
+            {"station_id", "station_211"},
+        };
+        MockWebsocketClientForStomp::subscriptionMessages.push_back(
+            event.dump()
+        );
+    }
+    const size_t nConnections {3};
+    std::queue<MockWebsocketEvent> mockEvents {};
+    for (size_t idx {0}; idx < nConnections; ++idx) {
+        const auto id {"connection" + std::to_string(idx)};
+        mockEvents.push({id, MockWebsocketEvent::Type::kConnect});
+        mockEvents.push({
+            id,
+            MockWebsocketEvent::Type::kMessage,
+            {},
+            GetMockStompFrame("localhost")
+        });
+    }
+    for (size_t idx {0}; idx < nConnections; ++idx) {
+        mockEvents.push({
+            "connection" + std::to_string(idx),
+            MockWebsocketEvent::Type::kMessage,
+            {},
+            GetMockSendFrame("req" + std::to_string(idx), "/quiet-route",
+                             nlohmann::json {
+                {"start_station_id", "station_211"},
+                {"end_station_id", "station_119"},
+            }.dump())
+        });
+    }
+    MockWebsocketServerForStomp::mockEvents = std::move(mockEvents);
+
+    // We need to set a timeout otherwise the network monitor will run forever.
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+    // A passenger event waits for the routes being computed, which take about
+    // a second each and may share a single core.
+    monitor.Run(std::chrono::seconds(5));
+
+    // When we arrive here, all the threads ran out of things to do.
+    BOOST_CHECK_EQUAL(monitor.GetLastErrorCode(), NetworkMonitorError::kOk);
+    BOOST_CHECK_EQUAL(monitor.GetConnectedClients().size(), nConnections);
+    BOOST_CHECK_EQUAL(monitor.GetNetworkEventsQueueStats().depth, 0);
+    const auto& network {monitor.GetNetworkRepresentation()};
+    BOOST_CHECK_EQUAL(network.GetPassengerCount("station_211"), 0);
+    auto travelRoute {monitor.GetLastTravelRoute()};
+    BOOST_CHECK_EQUAL(travelRoute.startStationId, "station_211");
+    BOOST_CHECK_EQUAL(travelRoute.endStationId, "station_119");
+    BOOST_CHECK_EQUAL(travelRoute.totalTravelTime, 29);
+    BOOST_CHECK_EQUAL(travelRoute.steps.size(), 19);
+}
+
+BOOST_AUTO_TEST_CASE(quiet_route_subscription, *timeout {30})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        TESTS_NETWORK_LAYOUT_JSON,
+        "localhost",
+        "127.0.0.1",
+        8042,
+        0.1, // These configurations make route 049 the most quiet.
+        0.1,
+        20,
+    };
+    config.quietRouteSubscriptionBatchInterval = std::chrono::milliseconds(10);
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame("localhost")
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockSubscribeFrame("sub0", "/quiet-route/station_211/station_119")
+        },
+    }};
+
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+
+    // Find a station that cannot change the route.
+    std::vector<Id> dependencies {};
+    monitor.GetNetworkRepresentation().GetQuietTravelRoute(
+        "station_211", "station_119", 0.1, 0.1, 20, dependencies
+    );
+    const auto layout = ParseJsonFile(TESTS_NETWORK_LAYOUT_JSON);
+    Id unrelatedStationId {};
+    for (const auto& station: layout.at("stations")) {
+        const auto stationId {station.at("station_id").get<Id>()};
+        if (std::find(
+            dependencies.begin(),
+            dependencies.end(),
+            stationId
+        ) == dependencies.end()) {
+            unrelatedStationId = stationId;
+            break;
+        }
+    }
+    BOOST_REQUIRE(!unrelatedStationId.empty());
+    std::unordered_map<Id, int> passengerCounts {};
+    try {
+        passengerCounts = ParseJsonFile(
+            std::filesystem::path(TEST_DATA) / "ltc_quiet2.counts.json"
+        ).get<std::unordered_map<Id, int>>();
+    } catch (...) {
+        BOOST_FAIL("Failed to parse passenger counts file");
+    }
+
+    // Once the first route is published, we change the crowding twice: The
+    // first change does not affect the route, the second one does.
+    auto waitForPublished {[&monitor](size_t nPublished) {
+        while (monitor.GetQuietRouteSubscriptionStats().nPublished <
+               nPublished) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }};
+    std::thread crowding {[&]() {
+        waitForPublished(1);
+        monitor.SetNetworkCrowding({{unrelatedStationId, 1}});
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        monitor.SetNetworkCrowding(passengerCounts);
+        waitForPublished(2);
+        monitor.Stop();
+    }};
+    monitor.Run(std::chrono::seconds(20));
+    crowding.join();
+
+    BOOST_CHECK_EQUAL(monitor.GetLastErrorCode(), NetworkMonitorError::kOk);
+    const auto stats {monitor.GetQuietRouteSubscriptionStats()};
+    BOOST_CHECK_EQUAL(stats.nRoutes, 1);
+    BOOST_CHECK_EQUAL(stats.nBatches, 2);
+    BOOST_CHECK_EQUAL(stats.nRecomputed, 2);
+    BOOST_CHECK_EQUAL(stats.nPublished, 2);
+
+    // The last message carries the quiet route.
+    const auto& messages {MockWebsocketSession::splitMessages};
+    BOOST_REQUIRE_EQUAL(messages.size(), 2);
+    const auto& tail {*messages.back().second};
+    const auto bodyStart {tail.find("\n\n") + 2};
+    auto travelRoute {nlohmann::json::parse(
+        tail.substr(bodyStart, tail.size() - bodyStart - 1)
+    ).get<TravelRoute>()};
+    auto travelRouteJson = ParseJsonFile(
+        std::filesystem::path(TEST_DATA) / "ltc_quiet2.result.route_049.json"
+    );
+    TravelRoute golden {};
+    try {
+        golden = travelRouteJson.get<TravelRoute>();
+    } catch (...) {
+        BOOST_FAIL(std::string("Failed to parse result JSON file"));
+    }
+    BOOST_CHECK_EQUAL(travelRoute, golden);
+    BOOST_CHECK_EQUAL(monitor.GetLastTravelRoute(), golden);
+}
+
+BOOST_AUTO_TEST_CASE(quiet_route_subscription_bad_destination, *timeout {1})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        TESTS_NETWORK_LAYOUT_JSON,
+        "localhost",
+        "127.0.0.1",
+        8042,
+        0.1,
+        0.1,
+        20,
+    };
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame("localhost")
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockSubscribeFrame("sub0", "/quiet-route/station_211")
+        },
+    }};
+
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+
+    // We need to set a timeout otherwise the network monitor will run forever.
+    monitor.Run(std::chrono::milliseconds(100));
+
+    // When we arrive here, the Run() function ran out of things to do.
+    BOOST_CHECK_EQUAL(monitor.GetConnectedClients().size(), 0);
+    BOOST_CHECK_EQUAL(monitor.GetQuietRouteSubscriptionStats().nRoutes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(quiet_route_busy, *timeout {10})
+{
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        TESTS_NETWORK_LAYOUT_JSON,
+        "localhost",
+        "127.0.0.1",
+        8042,
+        0.1,
+        0.1,
+        20,
+    };
+    config.nThreads = 2;
+    config.quietRouteMaxInFlightRequests = 1;
+
+    // Setup the mock.
+    // The route of connection0 takes about a second to compute. The request
+    // of connection1 comes in meanwhile, and is dropped. Both clients stay
+    // connected.
+    std::queue<MockWebsocketEvent> mockEvents {};
+    for (const std::string id: {"connection0", "connection1"}) {
+        mockEvents.push({id, MockWebsocketEvent::Type::kConnect});
+        mockEvents.push({
+            id,
+            MockWebsocketEvent::Type::kMessage,
+            {},
+            GetMockStompFrame("localhost")
+        });
+    }
+    for (const std::string id: {"connection0", "connection1"}) {
+        mockEvents.push({
+            id,
+            MockWebsocketEvent::Type::kMessage,
+            {},
+            GetMockSendFrame("req-" + id, "/quiet-route", nlohmann::json {
+                {"start_station_id", "station_211"},
+                {"end_station_id", "station_119"},
+            }.dump())
+        });
+    }
+    MockWebsocketServerForStomp::mockEvents = std::move(mockEvents);
+
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+
+    // We need to set a timeout otherwise the network monitor will run forever.
+    monitor.Run(std::chrono::seconds(3));
+
+    // When we arrive here, all the threads ran out of things to do.
+    BOOST_CHECK_EQUAL(monitor.GetConnectedClients().size(), 2);
+    const auto stats {monitor.GetQuietRouteAdmissionStats()};
+    BOOST_CHECK_EQUAL(stats.nRejectedBusy, 1);
+    BOOST_CHECK_EQUAL(stats.nRejectedConnections, 0);
+    BOOST_CHECK_EQUAL(stats.nRateLimitedFrames, 0);
+    BOOST_CHECK_EQUAL(monitor.GetLastTravelRoute().startStationId,
+                      "station_211");
+    const auto& messages {MockWebsocketSession::messages};
+    BOOST_CHECK_EQUAL(std::count_if(
+        messages.begin(),
+        messages.end(),
+        [](const auto& message) {
+            return message.rfind("ERROR\n", 0) == 0;
+        }
+    ), 0);
+}
+
+#ifdef __linux__
+
+BOOST_AUTO_TEST_CASE(hot_reload_network_layout, *timeout {3})
+{
+    // We work on a copy of the layout file because we modify it.
+    const auto networkLayoutFile {
+        std::filesystem::temp_directory_path() / "hot-reload-layout.json"
+    };
+    std::filesystem::copy_file(
+        std::filesystem::path(TEST_DATA) / "from_json_1line_1route.json",
+        networkLayoutFile,
+        std::filesystem::copy_options::overwrite_existing
+    );
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        networkLayoutFile,
+    };
+    config.networkLayoutHotReload = true;
+    config.networkLayoutReloadDebounce = std::chrono::milliseconds(20);
+
+    // Setup the mock.
+    nlohmann::json event {
+        {"datetime", "2020-11-01T07:18:50.234000Z"},
+        {"passenger_event", "in"},
+        {"station_id", "station_0"},
+    };
+    MockWebsocketClientForStomp::subscriptionMessages = {
+        event.dump(),
+    };
+
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+    BOOST_CHECK_THROW(
+        monitor.GetNetworkRepresentation().GetPassengerCount("station_2"),
+        std::runtime_error
+    );
+
+    // We update the layout file in place while the monitor runs. The new
+    // layout has an extra station.
+    std::thread writer {[&networkLayoutFile]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::filesystem::copy_file(
+            std::filesystem::path(TEST_DATA) / "from_json_1line_2routes.json",
+            networkLayoutFile,
+            std::filesystem::copy_options::overwrite_existing
+        );
+    }};
+    monitor.Run(std::chrono::milliseconds(500));
+    writer.join();
+
+    // The passenger counts recorded before the reload are carried over.
+    BOOST_CHECK_EQUAL(monitor.GetLastErrorCode(), NetworkMonitorError::kOk);
+    BOOST_CHECK_EQUAL(
+        monitor.GetNetworkRepresentation().GetPassengerCount("station_0"),
+        1
+    );
+    BOOST_CHECK_EQUAL(
+        monitor.GetNetworkRepresentation().GetPassengerCount("station_2"),
+        0
+    );
+
+    std::filesystem::remove(networkLayoutFile);
+}
+
+BOOST_AUTO_TEST_CASE(hot_reload_bad_network_layout, *timeout {3})
+{
+    const auto networkLayoutFile {
+        std::filesystem::temp_directory_path() / "hot-reload-bad-layout.json"
+    };
+    std::filesystem::copy_file(
+        std::filesystem::path(TEST_DATA) / "from_json_1line_1route.json",
+        networkLayoutFile,
+        std::filesystem::copy_options::overwrite_existing
+    );
+    NetworkMonitorConfig config {
+        "ltnm.learncppthroughprojects.com",
+        "443",
+        "some_username",
+        "some_password_123",
+        TESTS_CACERT_PEM,
+        networkLayoutFile,
+    };
+    config.networkLayoutHotReload = true;
+    config.networkLayoutReloadDebounce = std::chrono::milliseconds(20);
+
+    NetworkMonitor::NetworkMonitor<
+        MockWebsocketClientForStomp,
+        MockWebsocketServerForStomp
+    > monitor {};
+    auto ec {monitor.Configure(config)};
+    BOOST_REQUIRE_EQUAL(ec, NetworkMonitorError::kOk);
+
+    // A bad layout file does not replace the current network.
+    std::thread writer {[&networkLayoutFile]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::filesystem::copy_file(
+            std::filesystem::path(TEST_DATA) / "bad_json_file.json",
+            networkLayoutFile,
+            std::filesystem::copy_options::overwrite_existing
+        );
+    }};
+    monitor.Run(std::chrono::milliseconds(500));
+    writer.join();
+
+    BOOST_CHECK_EQUAL(
+        monitor.GetLastErrorCode(),
+        NetworkMonitorError::kFailedNetworkLayoutFileParsing
+    );
+    BOOST_CHECK_EQUAL(
+        monitor.GetNetworkRepresentation().GetPassengerCount("station_0"),
+        0
+    );
+
+    std::filesystem::remove(networkLayoutFile);
+}
+
+#endif // __linux__
+
 BOOST_AUTO_TEST_CASE(live, *timeout {5})
 {
     // This test starts a live NetworkMonitor instance and then constructs a
@@ -1047,12 +1705,12 @@ BOOST_AUTO_TEST_CASE(live, *timeout {5})
             clientDidReceiveResp = true;
             spdlog::info("TestStompClient: Received /quiet-route response");
             try {
-                quietRoute = nlohmann::json::parse(msg);
+                quietRoute = nlohmann::json::parse(msg.GetView());
             } catch (const std::exception& e) {
                 spdlog::error("TestStompClient: Failed to parse response: {}",
                               e.what());
                 spdlog::error("TestStompClient: Response content:\n{}",
-                              nlohmann::json::parse(msg));
+                              nlohmann::json::parse(msg.GetView()));
                 BOOST_REQUIRE(false);
             }
             spdlog::info("TestStompClient: Closing the client connection");
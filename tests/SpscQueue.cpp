@@ -0,0 +1,95 @@
+#include <network-monitor/SpscQueue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+using NetworkMonitor::SpscQueue;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+
+BOOST_AUTO_TEST_SUITE(class_SpscQueue);
+
+BOOST_AUTO_TEST_CASE(capacity)
+{
+    BOOST_CHECK_EQUAL(SpscQueue<int> {0}.Capacity(), 1);
+    BOOST_CHECK_EQUAL(SpscQueue<int> {1}.Capacity(), 1);
+    BOOST_CHECK_EQUAL(SpscQueue<int> {5}.Capacity(), 8);
+    BOOST_CHECK_EQUAL(SpscQueue<int> {1024}.Capacity(), 1024);
+}
+
+BOOST_AUTO_TEST_CASE(push_pop)
+{
+    SpscQueue<std::string> queue {4};
+    BOOST_CHECK(queue.Empty());
+    std::string item {};
+    BOOST_CHECK(!queue.TryPop(item));
+
+    // Fill the queue. A push on a full queue leaves the item untouched.
+    for (const auto& value: {"a", "b", "c", "d"}) {
+        BOOST_REQUIRE(queue.TryPush(value));
+    }
+    BOOST_CHECK_EQUAL(queue.Size(), 4);
+    std::string extra {"e"};
+    BOOST_CHECK(!queue.TryPush(std::move(extra)));
+    BOOST_CHECK_EQUAL(extra, "e");
+
+    // Items come out in order, also after the indices wrap around.
+    BOOST_REQUIRE(queue.TryPop(item));
+    BOOST_CHECK_EQUAL(item, "a");
+    BOOST_REQUIRE(queue.TryPush(std::move(extra)));
+    for (const auto& value: {"b", "c", "d", "e"}) {
+        BOOST_REQUIRE(queue.TryPop(item));
+        BOOST_CHECK_EQUAL(item, value);
+    }
+    BOOST_CHECK(queue.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(pop_releases_item)
+{
+    SpscQueue<std::shared_ptr<int>> queue {2};
+    auto value {std::make_shared<int>(42)};
+    BOOST_REQUIRE(queue.TryPush(std::shared_ptr<int> {value}));
+    BOOST_CHECK_EQUAL(value.use_count(), 2);
+    std::shared_ptr<int> item {};
+    BOOST_REQUIRE(queue.TryPop(item));
+    item.reset();
+    BOOST_CHECK_EQUAL(value.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(two_threads)
+{
+    // The consumer must see every item, in order.
+    constexpr size_t nItems {200000};
+    SpscQueue<size_t> queue {64};
+    std::thread producer {[&queue]() {
+        for (size_t idx {0}; idx < nItems; ++idx) {
+            auto item {idx};
+            while (!queue.TryPush(std::move(item))) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+    size_t nReceived {0};
+    size_t nOutOfOrder {0};
+    size_t item {0};
+    while (nReceived < nItems) {
+        if (!queue.TryPop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item != nReceived) {
+            ++nOutOfOrder;
+        }
+        ++nReceived;
+    }
+    producer.join();
+    BOOST_CHECK_EQUAL(nOutOfOrder, 0);
+    BOOST_CHECK(queue.Empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_SpscQueue
+
+BOOST_AUTO_TEST_SUITE_END(); // network_monitor
@@ -10,16 +10,27 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using NetworkMonitor::BoostWebsocketClient;
 using NetworkMonitor::GetEnvVar;
 using NetworkMonitor::MockWebsocketClientForStomp;
 using NetworkMonitor::StompClient;
+using NetworkMonitor::StompClientAckMode;
+using NetworkMonitor::StompClientAckPolicy;
+using NetworkMonitor::GetReconnectDelay;
 using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompClientReconnectPolicy;
 using NetworkMonitor::StompCommand;
 using NetworkMonitor::StompError;
 using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompHeartBeat;
 
 using namespace std::string_literals;
 
@@ -40,6 +51,14 @@ struct StompClientTestFixture {
         MockWebsocketClientForStomp::triggerDisconnection = false;
         MockWebsocketClientForStomp::messageQueue = {};
         MockWebsocketClientForStomp::subscriptionMessages = {};
+        MockWebsocketClientForStomp::batchSubscriptionMessages = false;
+        MockWebsocketClientForStomp::heartBeat = "";
+        MockWebsocketClientForStomp::nHeartBeats = 0;
+        MockWebsocketClientForStomp::ackMode = "";
+        MockWebsocketClientForStomp::ackIds = {};
+        MockWebsocketClientForStomp::nAckMessages = 0;
+        MockWebsocketClientForStomp::nPauses = 0;
+        MockWebsocketClientForStomp::ignoreReceipts = false;
     }
 };
 
@@ -62,6 +81,7 @@ BOOST_AUTO_TEST_CASE(ostream)
         StompClientError::kCouldNotSendMessage,
         StompClientError::kCouldNotSendStompFrame,
         StompClientError::kCouldNotSendSubscribeFrame,
+        StompClientError::kReceiptTimeout,
         StompClientError::kUnexpectedCouldNotCreateValidFrame,
         StompClientError::kUnexpectedMessageContentType,
         StompClientError::kUnexpectedSubscriptionMismatch,
@@ -75,6 +95,65 @@ BOOST_AUTO_TEST_CASE(ostream)
 
 BOOST_AUTO_TEST_SUITE_END(); // enum_class_StompClientError
 
+BOOST_AUTO_TEST_SUITE(enum_class_StompClientAckMode);
+
+BOOST_AUTO_TEST_CASE(ostream)
+{
+    for (const auto& [mode, value]: {
+        std::make_pair(StompClientAckMode::kAuto, "auto"),
+        std::make_pair(StompClientAckMode::kClient, "client"),
+        std::make_pair(StompClientAckMode::kClientIndividual,
+                       "client-individual"),
+    }) {
+        std::stringstream ss {};
+        ss << mode;
+        BOOST_CHECK_EQUAL(ss.str(), value);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // enum_class_StompClientAckMode
+
+BOOST_AUTO_TEST_SUITE(function_GetReconnectDelay);
+
+BOOST_AUTO_TEST_CASE(exponential_backoff)
+{
+    using std::chrono::milliseconds;
+    StompClientReconnectPolicy policy {
+        true,
+        milliseconds {100},
+        milliseconds {1000},
+        2.0,
+        0.5,
+    };
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 0, 0.0).count(), 100);
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 1, 0.0).count(), 200);
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 3, 0.0).count(), 800);
+
+    // Capped at the maximum delay, even for a huge attempt number.
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 4, 0.0).count(), 1000);
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 10000, 0.0).count(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(jitter)
+{
+    using std::chrono::milliseconds;
+    StompClientReconnectPolicy policy {
+        true,
+        milliseconds {100},
+        milliseconds {1000},
+        2.0,
+        0.5,
+    };
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 1, 0.5).count(), 150);
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 4, 0.999).count(), 500);
+
+    // No jitter
+    policy.jitter = 0.0;
+    BOOST_CHECK_EQUAL(GetReconnectDelay(policy, 1, 0.5).count(), 200);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // function_GetReconnectDelay
+
 BOOST_FIXTURE_TEST_SUITE(class_StompClient, StompClientTestFixture);
 
 BOOST_AUTO_TEST_CASE(connect, *timeout {1})
@@ -463,6 +542,11 @@ BOOST_AUTO_TEST_CASE(subscribe_get_message, *timeout {1})
     client.Connect(username, password, onConnect);
     ioc.run();
     BOOST_CHECK(messageReceived);
+
+    // The default mode does not send ACK frames.
+    BOOST_CHECK_EQUAL(MockWebsocketClientForStomp::ackMode, "auto");
+    BOOST_CHECK(MockWebsocketClientForStomp::ackIds.empty());
+    BOOST_CHECK_EQUAL(client.GetUnackedCount(), 0);
 }
 
 BOOST_AUTO_TEST_CASE(subscribe_before_connect, *timeout {1})
@@ -538,6 +622,437 @@ BOOST_AUTO_TEST_CASE(subscribe_after_close, *timeout {1})
     BOOST_CHECK(calledOnSubscribe);
 }
 
+BOOST_AUTO_TEST_CASE(reconnect, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::subscriptionMessages = {
+        "{counter: 1}",
+        "{counter: 2}",
+    };
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    client.SetReconnectPolicy({true, std::chrono::milliseconds {1}});
+    size_t nConnect {0};
+    size_t nSubscribe {0};
+    size_t nMessages {0};
+    auto onSubscribe {[&nSubscribe](auto ec, auto&& id) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        ++nSubscribe;
+    }};
+    auto onMessage {[&nMessages, &client](auto ec, auto&& msg) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        ++nMessages;
+        if (nMessages == 2) {
+            // The server drops the connection.
+            MockWebsocketClientForStomp::triggerDisconnection = true;
+        } else if (nMessages == 4) {
+            client.Close();
+        }
+    }};
+    auto onConnect {[&nConnect, &client, &onSubscribe, &onMessage](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        ++nConnect;
+        client.Subscribe("/passengers", onSubscribe, onMessage);
+    }};
+    auto onDisconnect {[](auto ec) {
+        // The client reconnects on its own.
+        BOOST_CHECK(false);
+    }};
+    client.Connect(username, password, onConnect, nullptr, onDisconnect);
+    ioc.run();
+
+    // The subscription was renewed without notifying the user again.
+    BOOST_CHECK_EQUAL(nConnect, 1);
+    BOOST_CHECK_EQUAL(nSubscribe, 1);
+    BOOST_CHECK_EQUAL(nMessages, 4);
+    const auto stats {client.GetReconnectStats()};
+    BOOST_CHECK_EQUAL(stats.nDisconnections, 1);
+    BOOST_CHECK_EQUAL(stats.nReconnections, 1);
+    BOOST_CHECK_EQUAL(stats.nFailedAttempts, 0);
+    BOOST_CHECK(stats.lastReconnectLatency >= std::chrono::milliseconds {0});
+    BOOST_CHECK(stats.lastGap >= stats.lastReconnectLatency);
+    BOOST_CHECK(stats.totalGap == stats.lastGap);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_give_up, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::subscriptionMessages = {
+        "{counter: 1}",
+    };
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    StompClientReconnectPolicy policy {true, std::chrono::milliseconds {1}};
+    policy.maxAttempts = 2;
+    client.SetReconnectPolicy(policy);
+    auto onMessage {[](auto ec, auto&& msg) {
+        // The server drops the connection, and then refuses new ones.
+        MockWebsocketClientForStomp::triggerDisconnection = true;
+        MockWebsocketClientForStomp::connectEc =
+            boost::asio::error::connection_refused;
+    }};
+    auto onConnect {[&client, &onMessage](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Subscribe("/passengers", nullptr, onMessage);
+    }};
+    bool calledOnDisconnect {false};
+    auto onDisconnect {[&calledOnDisconnect](auto ec) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kWebsocketServerDisconnected);
+        calledOnDisconnect = true;
+    }};
+    client.Connect(username, password, onConnect, nullptr, onDisconnect);
+    ioc.run();
+
+    // The user is only notified when the client gives up.
+    BOOST_CHECK(calledOnDisconnect);
+    const auto stats {client.GetReconnectStats()};
+    BOOST_CHECK_EQUAL(stats.nDisconnections, 1);
+    BOOST_CHECK_EQUAL(stats.nReconnections, 0);
+    BOOST_CHECK_EQUAL(stats.nFailedAttempts, 2);
+}
+
+BOOST_AUTO_TEST_CASE(heart_beat_send, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // The server wants a heart-beat every 50 ms.
+    MockWebsocketClientForStomp::heartBeat = "0,50";
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    client.SetHeartBeat({std::chrono::milliseconds {20}, {}});
+    boost::asio::steady_timer timer {ioc};
+    bool calledOnClose {false};
+    auto onClose {[&calledOnClose](auto ec) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        calledOnClose = true;
+    }};
+    auto onConnect {[&client, &timer, &onClose](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        timer.expires_after(std::chrono::milliseconds {300});
+        timer.async_wait([&client, &onClose](auto ec) {
+            client.Close(onClose);
+        });
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+
+    // We send at the pace of the server, not faster.
+    BOOST_CHECK(calledOnClose);
+    BOOST_CHECK_GE(MockWebsocketClientForStomp::nHeartBeats, 4);
+    BOOST_CHECK_LE(MockWebsocketClientForStomp::nHeartBeats, 7);
+}
+
+BOOST_AUTO_TEST_CASE(heart_beat_timeout, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // The server promises a heart-beat every 50 ms, but it never sends one.
+    MockWebsocketClientForStomp::heartBeat = "50,0";
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    client.SetHeartBeat({{}, std::chrono::milliseconds {20}});
+    std::chrono::steady_clock::time_point connectedAt {};
+    auto onConnect {[&connectedAt](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        connectedAt = std::chrono::steady_clock::now();
+    }};
+    std::chrono::steady_clock::duration detectedIn {};
+    auto onDisconnect {[&connectedAt, &detectedIn](auto ec) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kWebsocketServerDisconnected);
+        detectedIn = std::chrono::steady_clock::now() - connectedAt;
+    }};
+    client.Connect(username, password, onConnect, nullptr, onDisconnect);
+    ioc.run();
+
+    // The dead server is detected after 2 intervals, plus one timer interval.
+    BOOST_CHECK(detectedIn >= std::chrono::milliseconds {100});
+    BOOST_CHECK(detectedIn < std::chrono::milliseconds {200});
+}
+
+BOOST_AUTO_TEST_CASE(heart_beat_not_negotiated, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // The server does not send a heart-beat header.
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    client.SetHeartBeat({
+        std::chrono::milliseconds {20},
+        std::chrono::milliseconds {20}
+    });
+    boost::asio::steady_timer timer {ioc};
+    auto onConnect {[&client, &timer](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        timer.expires_after(std::chrono::milliseconds {200});
+        timer.async_wait([&client](auto ec) {
+            client.Close();
+        });
+    }};
+    auto onDisconnect {[](auto ec) {
+        BOOST_CHECK(false);
+    }};
+    client.Connect(username, password, onConnect, nullptr, onDisconnect);
+    ioc.run();
+
+    // Heart-beating is off in both directions.
+    BOOST_CHECK_EQUAL(MockWebsocketClientForStomp::nHeartBeats, 0);
+}
+
+BOOST_AUTO_TEST_CASE(ack_client_individual, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::subscriptionMessages = std::vector<
+        std::string
+    >(10, "{counter: 1}");
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    StompClientAckPolicy policy {};
+    policy.batchSize = 4;
+    policy.batchDelay = std::chrono::milliseconds {10};
+    client.SetAckPolicy(policy);
+    size_t nMessages {0};
+    boost::asio::steady_timer timer {ioc};
+    auto onMessage {[&nMessages, &client, &timer](auto ec, auto&& msg) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        if (++nMessages < 10) {
+            return;
+        }
+
+        // Leave time for the last, partial batch.
+        timer.expires_after(std::chrono::milliseconds {50});
+        timer.async_wait([&client](auto ec) {
+            client.Close();
+        });
+    }};
+    auto onConnect {[&client, &onMessage](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Subscribe("/passengers", nullptr, onMessage,
+                         StompClientAckMode::kClientIndividual);
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+    BOOST_CHECK_EQUAL(nMessages, 10);
+
+    // Every message is acknowledged, in batches of 4.
+    BOOST_CHECK_EQUAL(MockWebsocketClientForStomp::ackMode,
+                      "client-individual");
+    std::vector<std::string> expected {};
+    for (size_t idx {0}; idx < 10; ++idx) {
+        expected.push_back("ack-" + std::to_string(idx));
+    }
+    const auto& ackIds {MockWebsocketClientForStomp::ackIds};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ackIds.begin(), ackIds.end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(MockWebsocketClientForStomp::nAckMessages, 3);
+    BOOST_CHECK_EQUAL(client.GetUnackedCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ack_client, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::subscriptionMessages = std::vector<
+        std::string
+    >(10, "{counter: 1}");
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    StompClientAckPolicy policy {};
+    policy.batchSize = 4;
+    policy.batchDelay = std::chrono::milliseconds {10};
+    client.SetAckPolicy(policy);
+    size_t nMessages {0};
+    boost::asio::steady_timer timer {ioc};
+    auto onMessage {[&nMessages, &client, &timer](auto ec, auto&& msg) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        if (++nMessages < 10) {
+            return;
+        }
+
+        // Leave time for the last, partial batch.
+        timer.expires_after(std::chrono::milliseconds {50});
+        timer.async_wait([&client](auto ec) {
+            client.Close();
+        });
+    }};
+    auto onConnect {[&client, &onMessage](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Subscribe("/passengers", nullptr, onMessage,
+                         StompClientAckMode::kClient);
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+    BOOST_CHECK_EQUAL(nMessages, 10);
+
+    // One cumulative ACK per batch.
+    BOOST_CHECK_EQUAL(MockWebsocketClientForStomp::ackMode, "client");
+    const std::vector<std::string> expected {"ack-3", "ack-7", "ack-9"};
+    const auto& ackIds {MockWebsocketClientForStomp::ackIds};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ackIds.begin(), ackIds.end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(MockWebsocketClientForStomp::nAckMessages, 3);
+}
+
+BOOST_AUTO_TEST_CASE(ack_max_unacked, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::subscriptionMessages = std::vector<
+        std::string
+    >(20, "{counter: 1}");
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+
+    // The batches never fill up on their own, so the client must stop
+    // reading to stay within the limit.
+    StompClientAckPolicy policy {};
+    policy.batchSize = 100;
+    policy.batchDelay = std::chrono::seconds {10};
+    policy.maxUnacked = 4;
+    client.SetAckPolicy(policy);
+    size_t nMessages {0};
+    size_t maxUnacked {0};
+    auto onMessage {[&nMessages, &maxUnacked, &client](auto ec, auto&& msg) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        maxUnacked = std::max(maxUnacked, client.GetUnackedCount());
+        if (++nMessages == 20) {
+            client.Close();
+        }
+    }};
+    auto onConnect {[&client, &onMessage](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Subscribe("/passengers", nullptr, onMessage,
+                         StompClientAckMode::kClientIndividual);
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+    BOOST_CHECK_EQUAL(nMessages, 20);
+    BOOST_CHECK_GE(MockWebsocketClientForStomp::nPauses, 1);
+    BOOST_CHECK_GE(MockWebsocketClientForStomp::ackIds.size(), 16);
+
+    // The pause takes effect after the message in flight.
+    BOOST_CHECK_LE(maxUnacked, policy.maxUnacked + 1);
+}
+
 BOOST_AUTO_TEST_CASE(send, *timeout {1})
 {
     // Since we use the mock, we do not actually connect to this remote.
@@ -588,6 +1103,212 @@ BOOST_AUTO_TEST_CASE(send, *timeout {1})
     BOOST_CHECK(!calledOnDisconnect);
 }
 
+BOOST_AUTO_TEST_CASE(send_receipt, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    bool calledOnReceipt {false};
+    std::string requestId {};
+    auto onReceipt {[
+        &calledOnReceipt,
+        &requestId,
+        &client
+    ](auto ec, auto&& id, auto rtt) {
+        calledOnReceipt = true;
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        BOOST_CHECK_EQUAL(id, requestId);
+        BOOST_CHECK(rtt.count() > 0);
+        client.Close();
+    }};
+    auto onConnect {[&client, &requestId, &message, &onReceipt](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        requestId = client.Send("/quiet-route", message.dump(), nullptr,
+                                onReceipt);
+        BOOST_CHECK(requestId.size() > 0);
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+    BOOST_CHECK(calledOnReceipt);
+    const auto stats {client.GetReceiptStats()};
+    BOOST_CHECK_EQUAL(stats.nReceipts, 1);
+    BOOST_CHECK_EQUAL(stats.nTimeouts, 0);
+    BOOST_CHECK(stats.lastRtt == stats.totalRtt);
+    BOOST_CHECK(stats.lastRtt == stats.maxRtt);
+}
+
+BOOST_AUTO_TEST_CASE(send_receipt_many, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    const size_t nMessages {3};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Each receipt completes the message it was requested for, and only that
+    // one.
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    std::vector<std::string> requestIds {};
+    std::vector<std::string> receiptIds {};
+    auto onReceipt {[&receiptIds, &client, nMessages](auto ec, auto&& id,
+                                                      auto) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        receiptIds.push_back(id);
+        if (receiptIds.size() == nMessages) {
+            client.Close();
+        }
+    }};
+    auto onConnect {[&client, &requestIds, &onReceipt, nMessages](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        for (size_t idx {0}; idx < nMessages; ++idx) {
+            requestIds.push_back(client.Send(
+                "/quiet-route",
+                "{\"msg\": " + std::to_string(idx) + "}",
+                nullptr,
+                onReceipt
+            ));
+        }
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+    std::sort(requestIds.begin(), requestIds.end());
+    std::sort(receiptIds.begin(), receiptIds.end());
+    BOOST_CHECK_EQUAL(requestIds.size(), nMessages);
+    BOOST_CHECK(std::adjacent_find(
+        requestIds.begin(),
+        requestIds.end()
+    ) == requestIds.end());
+    BOOST_CHECK(receiptIds == requestIds);
+    const auto stats {client.GetReceiptStats()};
+    BOOST_CHECK_EQUAL(stats.nReceipts, nMessages);
+    BOOST_CHECK_EQUAL(stats.nTimeouts, 0);
+}
+
+BOOST_AUTO_TEST_CASE(send_receipt_timeout, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::ignoreReceipts = true;
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    const std::chrono::milliseconds timeout {50};
+    client.SetReceiptTimeout(timeout);
+    size_t nTimeouts {0};
+    std::chrono::steady_clock::duration waited {};
+    auto onReceipt {[&nTimeouts, &waited, &client](auto ec, auto&& id,
+                                                   auto rtt) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kReceiptTimeout);
+        waited = rtt;
+        if (++nTimeouts == 2) {
+            client.Close();
+        }
+    }};
+    auto onConnect {[&client, &message, &onReceipt](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Send("/quiet-route", message.dump(), nullptr, onReceipt);
+        client.Send("/quiet-route", message.dump(), nullptr, onReceipt);
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+    BOOST_CHECK_EQUAL(nTimeouts, 2);
+    BOOST_CHECK_EQUAL(client.GetReceiptStats().nTimeouts, 2);
+
+    // The deadline is never early, and late by a few ticks at most.
+    BOOST_CHECK(waited >= timeout);
+    BOOST_CHECK(waited < timeout + 5 * client.kReceiptTick);
+}
+
+BOOST_AUTO_TEST_CASE(send_receipt_close, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketClientForStomp::ignoreReceipts = true;
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    bool calledOnReceipt {false};
+    auto onReceipt {[&calledOnReceipt](auto ec, auto&& id, auto rtt) {
+        calledOnReceipt = true;
+        BOOST_CHECK_EQUAL(ec, StompClientError::kWebsocketServerDisconnected);
+    }};
+    auto onSend {[&client](auto ec, auto&& id) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        client.Close();
+    }};
+    auto onConnect {[&client, &message, &onSend, &onReceipt](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Send("/quiet-route", message.dump(), onSend, onReceipt);
+    }};
+    client.Connect(username, password, onConnect);
+    ioc.run();
+
+    // An outstanding receipt does not outlive the connection.
+    BOOST_CHECK(calledOnReceipt);
+}
+
 BOOST_AUTO_TEST_CASE(send_fail, *timeout {1})
 {
     // Since we use the mock, we do not actually connect to this remote.
@@ -701,6 +1422,129 @@ BOOST_AUTO_TEST_CASE(receive_message, *timeout {1})
     BOOST_CHECK(!calledOnDisconnect);
 }
 
+BOOST_AUTO_TEST_CASE(receive_batched_messages, *timeout {1})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    const std::string destination {"/msg-destination"};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    std::vector<std::string> messages {};
+    auto onMessage {[&messages, &client](auto ec, auto&& dst, auto&& msg) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        messages.emplace_back(msg);
+        if (messages.size() == 3) {
+            client.Close();
+        }
+    }};
+    auto onConnect {[&destination](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+
+        // The server batches two frames and a heart-beat in one message, then
+        // splits the third frame across two messages.
+        const auto third {MockWebsocketClientForStomp::GetMockSendFrame(
+            destination,
+            "Message 3"
+        )};
+        MockWebsocketClientForStomp::messageQueue.push(
+            MockWebsocketClientForStomp::GetMockSendFrame(
+                destination,
+                "Message 1"
+            ) + "\n" +
+            MockWebsocketClientForStomp::GetMockSendFrame(
+                destination,
+                "Message 2"
+            ) +
+            third.substr(0, 10)
+        );
+        MockWebsocketClientForStomp::messageQueue.push(third.substr(10));
+    }};
+    client.Connect(username, password, onConnect, onMessage, nullptr);
+    ioc.run();
+    BOOST_CHECK_EQUAL(messages.size(), 3);
+    if (messages.size() == 3) {
+        BOOST_CHECK_EQUAL(messages[0], "Message 1");
+        BOOST_CHECK_EQUAL(messages[1], "Message 2");
+        BOOST_CHECK_EQUAL(messages[2], "Message 3");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(close_from_other_thread, *timeout {3})
+{
+    // Since we use the mock, we do not actually connect to this remote.
+    const std::string url {"ltnm.learncppthroughprojects.com"};
+    const std::string endpoint {"/network-events"};
+    const std::string port {"443"};
+    const std::string username {"some_username"};
+    const std::string password {"some_password_123"};
+    const size_t nThreads {4};
+    const size_t nMessages {100};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    for (size_t idx {0}; idx < nMessages; ++idx) {
+        MockWebsocketClientForStomp::subscriptionMessages.emplace_back(
+            "{counter: " + std::to_string(idx) + "}"
+        );
+    }
+
+    // The close comes from a thread other than the one that receives the
+    // messages, while the subscription is still busy.
+    StompClient<MockWebsocketClientForStomp> client {
+        url,
+        endpoint,
+        port,
+        ioc,
+        ctx
+    };
+    std::atomic<size_t> nReceived {0};
+    std::atomic<bool> closed {false};
+    auto onMessage {[&nReceived](auto ec, auto&&) {
+        BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+        ++nReceived;
+    }};
+    auto onSubscribe {[&client, &ioc, &closed](auto ec, auto&&) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        boost::asio::post(ioc, [&client, &closed]() {
+            client.Close([&closed](auto ec) {
+                BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+                closed = true;
+            });
+        });
+    }};
+    auto onConnect {[&client, &onSubscribe, &onMessage](auto ec) {
+        BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+        client.Subscribe("/passengers", onSubscribe, onMessage);
+    }};
+    client.Connect(username, password, onConnect);
+    std::vector<std::thread> threads {};
+    for (size_t idx {0}; idx < nThreads; ++idx) {
+        threads.emplace_back([&ioc]() {
+            ioc.run();
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    BOOST_CHECK(closed);
+    BOOST_CHECK_LE(nReceived, nMessages);
+}
+
 BOOST_AUTO_TEST_CASE(subscribe_to_invalid_endpoint, *timeout {1})
 {
     // Since we use the mock, we do not actually connect to this remote.
@@ -2,12 +2,17 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
+using NetworkMonitor::StompBody;
 using NetworkMonitor::StompCommand;
 using NetworkMonitor::StompError;
 using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompFrameBuilder;
+using NetworkMonitor::StompFrameParser;
 using NetworkMonitor::StompHeader;
 
 using namespace std::string_literals;
@@ -46,6 +51,16 @@ BOOST_AUTO_TEST_CASE(ostream)
     }
 }
 
+BOOST_AUTO_TEST_CASE(to_string_view)
+{
+    BOOST_CHECK_EQUAL(ToStringView(StompCommand::kSend), "SEND");
+    BOOST_CHECK_EQUAL(ToStringView(StompCommand::kUnsubscribe), "UNSUBSCRIBE");
+    BOOST_CHECK_EQUAL(ToStringView(StompCommand::kInvalid),
+                      ToString(StompCommand::kInvalid));
+    BOOST_CHECK_EQUAL(ToStringView(static_cast<StompCommand>(1000)),
+                      ToString(StompCommand::kInvalid));
+}
+
 BOOST_AUTO_TEST_SUITE_END(); // enum_class_StompCommand
 
 BOOST_AUTO_TEST_SUITE(enum_class_StompHeader);
@@ -82,6 +97,15 @@ BOOST_AUTO_TEST_CASE(ostream)
     }
 }
 
+BOOST_AUTO_TEST_CASE(to_string_view)
+{
+    BOOST_CHECK_EQUAL(ToStringView(StompHeader::kId), "id");
+    BOOST_CHECK_EQUAL(ToStringView(StompHeader::kContentLength),
+                      "content-length");
+    BOOST_CHECK_EQUAL(ToStringView(StompHeader::kInvalid),
+                      ToString(StompHeader::kInvalid));
+}
+
 BOOST_AUTO_TEST_SUITE_END(); // enum_class_StompHeader
 
 BOOST_AUTO_TEST_SUITE(enum_class_StompError);
@@ -95,7 +119,9 @@ BOOST_AUTO_TEST_CASE(ostream)
         StompError::kOk,
         StompError::kParsingEmptyHeaderValue,
         StompError::kParsingContentLengthExceedsFrameLength,
+        StompError::kParsingFrameTooLarge,
         StompError::kParsingInvalidContentLength,
+        StompError::kParsingInvalidHeaderEscape,
         StompError::kParsingJunkAfterBody,
         StompError::kParsingMissingBlankLineAfterHeaders,
         StompError::kParsingMissingColonInHeader,
@@ -107,7 +133,9 @@ BOOST_AUTO_TEST_CASE(ostream)
         StompError::kValidationContentLengthMismatch,
         StompError::kValidationInvalidCommand,
         StompError::kValidationInvalidContentLength,
+        StompError::kValidationInvalidHeaderValue,
         StompError::kValidationMissingHeader,
+        StompError::kValidationUnexpectedNullInBody,
     }) {
         std::stringstream ss {};
         ss << error;
@@ -249,6 +277,24 @@ BOOST_AUTO_TEST_CASE(parse_bad_header)
     BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::kInvalid);
 }
 
+BOOST_AUTO_TEST_CASE(parse_bad_header_colon_on_next_line)
+{
+    // The header name runs up to the first colon, even on a later line, so it
+    // is not a valid name.
+    std::string plain {
+        "CONNECT\n"
+        "accept-version:42\n"
+        "login\n"
+        "host:host.com\n"
+        "\n"
+        "Frame body\0"s
+    };
+    StompError error;
+    StompFrame frame {error, std::move(plain)};
+    BOOST_CHECK_EQUAL(error, StompError::kParsingUnrecognizedHeader);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::kInvalid);
+}
+
 BOOST_AUTO_TEST_CASE(parse_missing_body_newline)
 {
     std::string plain {
@@ -293,6 +339,30 @@ BOOST_AUTO_TEST_CASE(parse_unrecognized_header)
     BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::kInvalid);
 }
 
+BOOST_AUTO_TEST_CASE(parse_near_miss_names)
+{
+    // Names that share the length and the first and last characters of a
+    // valid name are rejected.
+    for (const auto& plain: {
+        "SNED\ndestination:/a\n\nFrame body\0"s,
+        "send\ndestination:/a\n\nFrame body\0"s,
+        "StompCommand::kInvalid\ndestination:/a\n\nFrame body\0"s,
+    }) {
+        StompError error;
+        StompFrame frame {error, plain};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingUnrecognizedCommand);
+    }
+    for (const auto& plain: {
+        "SEND\ndestinatoin:/a\n\nFrame body\0"s,
+        "SEND\nDestination:/a\n\nFrame body\0"s,
+        "SEND\nStompHeader::kInvalid:/a\n\nFrame body\0"s,
+    }) {
+        StompError error;
+        StompFrame frame {error, plain};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingUnrecognizedHeader);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(parse_empty_header_value)
 {
     std::string plain {
@@ -309,6 +379,18 @@ BOOST_AUTO_TEST_CASE(parse_empty_header_value)
     BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::kInvalid);
 }
 
+BOOST_AUTO_TEST_CASE(parse_header_colon_at_end)
+{
+    std::string plain {
+        "CONNECT\n"
+        "accept-version:"
+    };
+    StompError error;
+    StompFrame frame {error, std::move(plain)};
+    BOOST_CHECK_EQUAL(error, StompError::kParsingMissingEolAfterHeaderValue);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::kInvalid);
+}
+
 BOOST_AUTO_TEST_CASE(parse_just_command)
 {
     std::string plain {
@@ -357,6 +439,68 @@ BOOST_AUTO_TEST_CASE(parse_double_colon_in_header_line)
                       "42:43");
 }
 
+BOOST_AUTO_TEST_CASE(parse_escaped_headers)
+{
+    std::string plain {
+        "MESSAGE\n"
+        "destination:/a\\cb\\nc\\rd\\\\e\n"
+        "message-id:plain\n"
+        "subscription:\\\\\n"
+        "content-type:text\\cplain\n"
+        "content-length:10\n"
+        "\n"
+        "Frame body\0"s
+    };
+    StompError error;
+    StompFrame frame {error, std::move(plain)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kDestination),
+                      "/a:b\nc\rd\\e");
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kSubscription), "\\");
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kContentType),
+                      "text:plain");
+
+    // Values without escapes are still views into the frame buffer.
+    const auto& buffer {*frame.GetBuffer()};
+    const auto messageId {frame.GetHeaderValue(StompHeader::kMessageId)};
+    BOOST_CHECK_EQUAL(messageId, "plain");
+    BOOST_CHECK(messageId.data() >= buffer.data() &&
+                messageId.data() < buffer.data() + buffer.size());
+
+    // Copies share the decoded values.
+    auto copy {frame};
+    BOOST_CHECK_EQUAL(copy.GetHeaderValue(StompHeader::kDestination).data(),
+                      frame.GetHeaderValue(StompHeader::kDestination).data());
+}
+
+BOOST_AUTO_TEST_CASE(parse_invalid_escape)
+{
+    for (auto plain: {
+        "SEND\ndestination:/a\\tb\n\nFrame body\0"s,
+        "SEND\ndestination:/a\\\n\nFrame body\0"s,
+    }) {
+        StompError error;
+        StompFrame frame {error, std::move(plain)};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingInvalidHeaderEscape);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parse_connect_not_escaped)
+{
+    std::string plain {
+        "CONNECT\n"
+        "accept-version:42\n"
+        "host:host\\c.com\n"
+        "\n"
+        "\0"s
+    };
+    StompError error;
+    StompFrame frame {error, std::move(plain)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kHost),
+                      "host\\c.com");
+}
+
 BOOST_AUTO_TEST_CASE(parse_repeated_headers)
 {
     std::string plain {
@@ -374,6 +518,35 @@ BOOST_AUTO_TEST_CASE(parse_repeated_headers)
     BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kAcceptVersion), "42");
 }
 
+BOOST_AUTO_TEST_CASE(parse_missing_headers)
+{
+    std::string plain {
+        "MESSAGE\n"
+        "destination:/passengers\n"
+        "message-id:42\n"
+        "subscription:43\n"
+        "version:1.2\n"
+        "\n"
+        "Frame body\0"s
+    };
+    StompError error;
+    StompFrame frame {error, std::move(plain)};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    BOOST_CHECK(frame.HasHeader(StompHeader::kDestination));
+    BOOST_CHECK(frame.HasHeader(StompHeader::kVersion));
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kVersion), "1.2");
+    for (const auto& header: {
+        StompHeader::kInvalid,
+        StompHeader::kAcceptVersion,
+        StompHeader::kContentLength,
+        StompHeader::kId,
+        StompHeader::kServer,
+    }) {
+        BOOST_CHECK(!frame.HasHeader(header));
+        BOOST_CHECK_EQUAL(frame.GetHeaderValue(header), "");
+    }
+}
+
 BOOST_AUTO_TEST_CASE(parse_repeated_headers_error_in_second)
 {
     std::string plain {
@@ -645,6 +818,65 @@ BOOST_AUTO_TEST_CASE(constructors)
     }
 }
 
+BOOST_AUTO_TEST_CASE(copy_shares_buffer)
+{
+    std::string plain {
+        "CONNECT\n"
+        "accept-version:42\n"
+        "host:host.com\n"
+        "\n"
+        "Frame body\0"s
+    };
+    StompError error;
+    StompFrame frame {error, std::move(plain)};
+    BOOST_REQUIRE(error == StompError::kOk);
+
+    // The copies point to the same buffer as the original frame.
+    StompFrame copied {frame};
+    StompFrame assigned {};
+    assigned = frame;
+    for (const auto* other: {&copied, &assigned}) {
+        BOOST_CHECK(other->GetBuffer() == frame.GetBuffer());
+        BOOST_CHECK(other->GetBody().data() == frame.GetBody().data());
+        BOOST_CHECK_EQUAL(other->GetHeaderValue(StompHeader::kHost),
+                          "host.com");
+    }
+    // 3 frames plus the pointer returned by GetBuffer().
+    BOOST_CHECK_EQUAL(frame.GetBuffer().use_count(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(constructor_from_shared_buffer)
+{
+    auto plain {std::make_shared<const std::string>(
+        "SEND\n"
+        "destination:/quiet-route\n"
+        "\n"
+        "Frame body\0"s
+    )};
+    StompError error;
+    StompFrame frame {error, plain};
+    BOOST_REQUIRE(error == StompError::kOk);
+    BOOST_CHECK(frame.GetBuffer() == plain);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kDestination),
+                      "/quiet-route");
+    BOOST_CHECK_EQUAL(frame.GetBody(), "Frame body");
+}
+
+// A short frame fits in the small string buffer of std::string. Moving the
+// frame must not leave its views pointing to the moved-from object.
+BOOST_AUTO_TEST_CASE(move_short_frame)
+{
+    std::string plain {"ACK\nid:1\n\nb\0"s};
+    StompError error;
+    auto frame {std::make_unique<StompFrame>(error, std::move(plain))};
+    BOOST_REQUIRE(error == StompError::kOk);
+    StompFrame moved {std::move(*frame)};
+    frame.reset();
+    BOOST_CHECK(moved.GetCommand() == StompCommand::kAck);
+    BOOST_CHECK_EQUAL(moved.GetHeaderValue(StompHeader::kId), "1");
+    BOOST_CHECK_EQUAL(moved.GetBody(), "b");
+}
+
 BOOST_AUTO_TEST_CASE(constructor_from_components_full)
 {
     StompError error;
@@ -723,6 +955,540 @@ BOOST_AUTO_TEST_CASE(to_string)
 
 BOOST_AUTO_TEST_SUITE_END(); // class_StompFrame
 
+BOOST_AUTO_TEST_SUITE(class_StompBody);
+
+BOOST_AUTO_TEST_CASE(default_body)
+{
+    StompBody body {};
+    BOOST_CHECK_EQUAL(body.GetSize(), 0);
+    BOOST_CHECK_EQUAL(body, "");
+}
+
+BOOST_AUTO_TEST_CASE(shares_frame_buffer)
+{
+    std::string plain {
+        "MESSAGE\n"
+        "subscription:sub-0001\n"
+        "message-id:msg-0001\n"
+        "destination:/passengers\n"
+        "\n"
+        "Frame body\0"s
+    };
+    StompBody body {};
+    std::shared_ptr<const std::string> buffer {nullptr};
+    {
+        StompError error;
+        StompFrame frame {error, std::move(plain)};
+        BOOST_REQUIRE(error == StompError::kOk);
+        body = StompBody {frame};
+        buffer = frame.GetBuffer();
+    }
+
+    // The body outlives its frame, and still points into the frame buffer.
+    BOOST_CHECK_EQUAL(body, "Frame body");
+    BOOST_CHECK_EQUAL(body.GetSize(), 10);
+    BOOST_CHECK(body.GetView().data() >= buffer->data());
+    BOOST_CHECK(body.GetView().data() + body.GetSize() <=
+                buffer->data() + buffer->size());
+    BOOST_CHECK_EQUAL(std::string(body), "Frame body");
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_StompBody
+
+BOOST_AUTO_TEST_SUITE(class_StompFrameBuilder);
+
+BOOST_AUTO_TEST_CASE(build)
+{
+    StompError error;
+    StompFrameBuilder builder {StompCommand::kSend};
+    builder.AddHeader(StompHeader::kDestination, "/quiet-route")
+           .AddHeader(StompHeader::kContentLength, "10")
+           .SetBody("Frame body");
+    auto plain {builder.Build(error)};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    const auto expected {
+        "SEND\n"
+        "destination:/quiet-route\n"
+        "content-length:10\n"
+        "\n"
+        "Frame body\0"s
+    };
+    BOOST_CHECK_EQUAL(plain, expected);
+    BOOST_CHECK_EQUAL(builder.GetSize(), expected.size());
+
+    // The output is a valid frame.
+    StompFrame frame {error, plain};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetBody(), "Frame body");
+}
+
+BOOST_AUTO_TEST_CASE(write_to_buffer)
+{
+    StompFrameBuilder builder {StompCommand::kDisconnect};
+    std::string buffer {"prefix"};
+    auto error {builder.WriteTo(buffer)};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(buffer, "prefixDISCONNECT\n\n\0"s);
+}
+
+BOOST_AUTO_TEST_CASE(write_body)
+{
+    StompFrameBuilder builder {StompCommand::kSend};
+    builder.AddHeader(StompHeader::kDestination, "/quiet-route")
+           .AddHeader(StompHeader::kContentLength, "5")
+           .SetBody(5, [](auto& buffer) {
+               buffer += "hello";
+           });
+    StompError error;
+    auto plain {builder.Build(error)};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(plain.size(), builder.GetSize());
+    StompFrame frame {error, plain};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetBody(), "hello");
+
+    // The buffer is left unchanged if the writer does not honor the size.
+    builder.SetBody(5, [](auto& buffer) {
+        buffer += "hi";
+    });
+    std::string buffer {"prefix"};
+    error = builder.WriteTo(buffer);
+    BOOST_CHECK_EQUAL(error, StompError::kValidationContentLengthMismatch);
+    BOOST_CHECK_EQUAL(buffer, "prefix");
+}
+
+BOOST_AUTO_TEST_CASE(write_body_null)
+{
+    // Without a content-length header, a NULL octet would end the frame.
+    StompFrameBuilder builder {StompCommand::kSend};
+    builder.AddHeader(StompHeader::kDestination, "/quiet-route")
+           .SetBody(5, [](auto& buffer) {
+               buffer += "he\0lo"s;
+           });
+    std::string buffer {"prefix"};
+    auto error {builder.WriteTo(buffer)};
+    BOOST_CHECK_EQUAL(error, StompError::kValidationUnexpectedNullInBody);
+    BOOST_CHECK_EQUAL(buffer, "prefix");
+
+    // With a content-length header, the NULL octet is part of the body.
+    builder.AddHeader(StompHeader::kContentLength, "5");
+    auto plain {builder.Build(error)};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    StompFrame frame {error, plain};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetBody(), "he\0lo"s);
+}
+
+BOOST_AUTO_TEST_CASE(repeated_headers)
+{
+    StompFrameBuilder builder {StompCommand::kConnect};
+    builder.AddHeader(StompHeader::kAcceptVersion, "42")
+           .AddHeader(StompHeader::kHost, "host.com")
+           .AddHeader(StompHeader::kAcceptVersion, "43");
+    StompError error;
+    auto plain {builder.Build(error)};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(plain, "CONNECT\naccept-version:42\nhost:host.com\n\n\0"s);
+}
+
+BOOST_AUTO_TEST_CASE(escaped_headers)
+{
+    StompFrameBuilder builder {StompCommand::kSend};
+    builder.AddHeader(StompHeader::kDestination, "/a:b\nc\rd\\e")
+           .AddHeader(StompHeader::kId, "id")
+           .SetBody("Frame body");
+    BOOST_CHECK_EQUAL(builder.Validate(), StompError::kOk);
+    StompError error {};
+    auto plain {builder.Build(error)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(builder.GetSize(), plain.size());
+    BOOST_CHECK_EQUAL(plain, "SEND\n"
+                             "destination:/a\\cb\\nc\\rd\\\\e\n"
+                             "id:id\n"
+                             "\n"
+                             "Frame body\0"s);
+
+    // The value round-trips through the parser.
+    StompFrame frame {error, std::move(plain)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kDestination),
+                      "/a:b\nc\rd\\e");
+
+    // CONNECT frames do not escape header values.
+    StompFrameBuilder connect {StompCommand::kConnect};
+    connect.AddHeader(StompHeader::kAcceptVersion, "42")
+           .AddHeader(StompHeader::kHost, "host.com")
+           .AddHeader(StompHeader::kPasscode, "a:b\\c");
+    BOOST_CHECK_EQUAL(connect.Build(error),
+                      "CONNECT\n"
+                      "accept-version:42\n"
+                      "host:host.com\n"
+                      "passcode:a:b\\c\n"
+                      "\n"
+                      "\0"s);
+}
+
+BOOST_AUTO_TEST_CASE(validation)
+{
+    // Each case is a builder with one problem.
+    StompFrameBuilder invalidCommand {StompCommand::kInvalid};
+    BOOST_CHECK_EQUAL(invalidCommand.Validate(),
+                      StompError::kValidationInvalidCommand);
+
+    StompFrameBuilder missingHeader {StompCommand::kSend};
+    BOOST_CHECK_EQUAL(missingHeader.Validate(),
+                      StompError::kValidationMissingHeader);
+
+    StompFrameBuilder invalidHeader {StompCommand::kDisconnect};
+    invalidHeader.AddHeader(StompHeader::kInvalid, "value");
+    BOOST_CHECK_EQUAL(invalidHeader.Validate(),
+                      StompError::kParsingUnrecognizedHeader);
+
+    StompFrameBuilder emptyValue {StompCommand::kSend};
+    emptyValue.AddHeader(StompHeader::kDestination, "");
+    BOOST_CHECK_EQUAL(emptyValue.Validate(),
+                      StompError::kValidationInvalidHeaderValue);
+
+    // CONNECT frames do not escape header values.
+    StompFrameBuilder newlineInValue {StompCommand::kConnect};
+    newlineInValue.AddHeader(StompHeader::kAcceptVersion, "42")
+                  .AddHeader(StompHeader::kHost, "host\n.com");
+    BOOST_CHECK_EQUAL(newlineInValue.Validate(),
+                      StompError::kValidationInvalidHeaderValue);
+
+    StompFrameBuilder badContentLength {StompCommand::kDisconnect};
+    badContentLength.AddHeader(StompHeader::kContentLength, "abc");
+    BOOST_CHECK_EQUAL(badContentLength.Validate(),
+                      StompError::kValidationInvalidContentLength);
+
+    StompFrameBuilder wrongContentLength {StompCommand::kDisconnect};
+    wrongContentLength.AddHeader(StompHeader::kContentLength, "3")
+                      .SetBody("Frame body");
+    BOOST_CHECK_EQUAL(wrongContentLength.Validate(),
+                      StompError::kValidationContentLengthMismatch);
+
+    const auto bodyWithNull {"Frame\0body"s};
+    StompFrameBuilder nullInBody {StompCommand::kDisconnect};
+    nullInBody.SetBody(bodyWithNull);
+    BOOST_CHECK_EQUAL(nullInBody.Validate(),
+                      StompError::kValidationUnexpectedNullInBody);
+
+    // With a content-length header, the body can contain NULL octets.
+    const auto contentLength {std::to_string(bodyWithNull.size())};
+    nullInBody.AddHeader(StompHeader::kContentLength, contentLength);
+    BOOST_CHECK_EQUAL(nullInBody.Validate(), StompError::kOk);
+
+    // An invalid frame is not written.
+    std::string buffer {};
+    BOOST_CHECK_EQUAL(missingHeader.WriteTo(buffer),
+                      StompError::kValidationMissingHeader);
+    BOOST_CHECK(buffer.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_StompFrameBuilder
+
+BOOST_AUTO_TEST_SUITE(class_StompFrameParser);
+
+BOOST_AUTO_TEST_CASE(one_frame)
+{
+    std::string plain {
+        "SEND\n"
+        "destination:/a\n"
+        "\n"
+        "Frame body\0"s
+    };
+    const auto data {plain.data()};
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    auto error {parser.Parse(std::move(plain), frames)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].GetBody(), "Frame body");
+    BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+
+    // The chunk was moved into the frame.
+    BOOST_CHECK_EQUAL(frames[0].GetBuffer()->data(), data);
+}
+
+BOOST_AUTO_TEST_CASE(batched_frames)
+{
+    const std::string plain {
+        "SEND\n"
+        "destination:/a\n"
+        "\n"
+        "Body 1\0"
+        "\n"
+        "\r\n"
+        "SEND\n"
+        "destination:/b\n"
+        "content-length:7\n"
+        "\n"
+        "Bo\0dy 2\0"
+        "SEND\n"
+        "destination:/c\n"
+        "\n"
+        "Body 3\0"
+        "\n"s
+    };
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    auto error {parser.Parse(plain, frames)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_REQUIRE_EQUAL(frames.size(), 3);
+    BOOST_CHECK_EQUAL(frames[0].GetHeaderValue(StompHeader::kDestination),
+                      "/a");
+    BOOST_CHECK_EQUAL(frames[0].GetBody(), "Body 1");
+    BOOST_CHECK_EQUAL(frames[1].GetHeaderValue(StompHeader::kDestination),
+                      "/b");
+    BOOST_CHECK_EQUAL(frames[1].GetBody(), "Bo\0dy 2"s);
+    BOOST_CHECK_EQUAL(frames[2].GetHeaderValue(StompHeader::kDestination),
+                      "/c");
+    BOOST_CHECK_EQUAL(frames[2].GetBody(), "Body 3");
+    BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+
+    // The frames share the batch buffer, but each prints on its own.
+    BOOST_CHECK(frames[0].GetBuffer() == frames[1].GetBuffer());
+    BOOST_CHECK(frames[1].GetBuffer() == frames[2].GetBuffer());
+    BOOST_CHECK_EQUAL(frames[1].ToString(),
+                      "SEND\n"
+                      "destination:/b\n"
+                      "content-length:7\n"
+                      "\n"
+                      "Bo\0dy 2\0"s);
+}
+
+BOOST_AUTO_TEST_CASE(batched_frames_partial_tail)
+{
+    const std::string plain {
+        "SEND\n"
+        "destination:/a\n"
+        "\n"
+        "Body 1\0"
+        "SEND\n"
+        "destination:/b\n"
+        "\n"
+        "Bo"s
+    };
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    auto error {parser.Parse(std::string {plain}, frames)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].GetBody(), "Body 1");
+    BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 23);
+
+    error = parser.Parse("dy 2\0"s, frames);
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_REQUIRE_EQUAL(frames.size(), 2);
+    BOOST_CHECK_EQUAL(frames[0].GetBody(), "Body 1");
+    BOOST_CHECK_EQUAL(frames[1].GetBody(), "Body 2");
+    BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(split_frames)
+{
+    const std::string plain {
+        "MESSAGE\n"
+        "destination:/a\n"
+        "message-id:1\n"
+        "subscription:2\n"
+        "content-length:7\n"
+        "\n"
+        "Bo\0dy 1\0"
+        "\n"
+        "SEND\n"
+        "destination:/b\n"
+        "\n"
+        "Body 2\0"s
+    };
+
+    // We split the data at every possible point, and then byte by byte.
+    for (size_t split {0}; split <= plain.size(); ++split) {
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(plain.substr(0, split), frames)};
+        BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+        error = parser.Parse(plain.substr(split), frames);
+        BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+        BOOST_REQUIRE_EQUAL(frames.size(), 2);
+        BOOST_CHECK_EQUAL(frames[0].GetBody(), "Bo\0dy 1"s);
+        BOOST_CHECK_EQUAL(frames[1].GetBody(), "Body 2");
+    }
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    for (const auto& byte: plain) {
+        auto error {parser.Parse(std::string_view {&byte, 1}, frames)};
+        BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    }
+    BOOST_REQUIRE_EQUAL(frames.size(), 2);
+    BOOST_CHECK_EQUAL(frames[0].GetBody(), "Bo\0dy 1"s);
+    BOOST_CHECK_EQUAL(frames[1].GetBody(), "Body 2");
+}
+
+BOOST_AUTO_TEST_CASE(partial_frame)
+{
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    auto error {parser.Parse("SEND\ndestination:/a\n\nBody"s, frames)};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frames.size(), 0);
+    BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 25);
+
+    parser.Reset();
+    BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    error = parser.Parse("SEND\ndestination:/b\n\nBody\0"s, frames);
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].GetHeaderValue(StompHeader::kDestination),
+                      "/b");
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    // An unknown command is rejected before the frame is complete.
+    {
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse("SNED\ndestination:/a\n"s, frames)};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingUnrecognizedCommand);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // The frames before an invalid frame are still extracted.
+    {
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(
+            "SEND\ndestination:/a\n\nBody\0"
+            "SEND\ndestination:/b\ncontent-length:2\n\nBody\0"s,
+            frames
+        )};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingMissingNullInBody);
+        BOOST_REQUIRE_EQUAL(frames.size(), 1);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // Invalid content-length
+    {
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(
+            "SEND\ndestination:/a\ncontent-length:x\n\nBody"s,
+            frames
+        )};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingInvalidContentLength);
+    }
+
+    // A content-length that would wrap the body end around
+    {
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(
+            "SEND\ndestination:/a\ncontent-length:18446744073709551615\n\n"
+            "Body\0"s,
+            frames
+        )};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingInvalidContentLength);
+        BOOST_CHECK_EQUAL(frames.size(), 0);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // A content-length out of range is not read as 0.
+    {
+        StompFrameParser parser {};
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(
+            "SEND\ndestination:/a\ncontent-length:99999999999999999999999\n\n"
+            "\0"s,
+            frames
+        )};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingInvalidContentLength);
+        BOOST_CHECK_EQUAL(frames.size(), 0);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(max_frame_size)
+{
+    const std::string frame {"SEND\ndestination:/a\n\nBody\0"s};
+
+    // Frames up to the limit go through, even when they are batched.
+    {
+        StompFrameParser parser {};
+        parser.SetMaxFrameSize(frame.size());
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(frame + frame + frame, frames)};
+        BOOST_CHECK_EQUAL(error, StompError::kOk);
+        BOOST_CHECK_EQUAL(frames.size(), 3);
+    }
+
+    // A complete frame over the limit
+    {
+        StompFrameParser parser {};
+        parser.SetMaxFrameSize(frame.size() - 1);
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(frame, frames)};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingFrameTooLarge);
+        BOOST_CHECK_EQUAL(frames.size(), 0);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // A partial frame that keeps growing is dropped as soon as it goes over
+    // the limit.
+    {
+        StompFrameParser parser {};
+        parser.SetMaxFrameSize(1024);
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse("SEND\ndestination:/a\n"s, frames)};
+        BOOST_CHECK_EQUAL(error, StompError::kOk);
+        const std::string chunk(512, 'x');
+        error = parser.Parse(chunk, frames);
+        BOOST_CHECK_EQUAL(error, StompError::kOk);
+        error = parser.Parse(chunk, frames);
+        BOOST_CHECK_EQUAL(error, StompError::kParsingFrameTooLarge);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // A content-length over the limit fails before the body comes in.
+    {
+        StompFrameParser parser {};
+        parser.SetMaxFrameSize(1024);
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(
+            "SEND\ndestination:/a\ncontent-length:2048\n\nBo"s,
+            frames
+        )};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingFrameTooLarge);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // Even when the content-length would wrap the body end around.
+    {
+        StompFrameParser parser {};
+        parser.SetMaxFrameSize(1024);
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(
+            "SEND\ndestination:/a\ncontent-length:18446744073709551615\n\n"
+            "Body\0"s,
+            frames
+        )};
+        BOOST_CHECK_EQUAL(error, StompError::kParsingFrameTooLarge);
+        BOOST_CHECK_EQUAL(parser.GetBufferedSize(), 0);
+    }
+
+    // The heart-beats between frames do not count.
+    {
+        StompFrameParser parser {};
+        parser.SetMaxFrameSize(frame.size());
+        std::vector<StompFrame> frames {};
+        auto error {parser.Parse(std::string(4096, '\n') + frame, frames)};
+        BOOST_CHECK_EQUAL(error, StompError::kOk);
+        BOOST_CHECK_EQUAL(frames.size(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_StompFrameParser
+
 BOOST_AUTO_TEST_SUITE_END(); // stomp_frame
 
 BOOST_AUTO_TEST_SUITE_END(); // network_monitor
\ No newline at end of file
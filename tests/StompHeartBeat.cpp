@@ -0,0 +1,101 @@
+#include <network-monitor/StompFrame.h>
+#include <network-monitor/StompHeartBeat.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+
+using NetworkMonitor::GetHeartBeatCheckInterval;
+using NetworkMonitor::NegotiateHeartBeat;
+using NetworkMonitor::ParseHeartBeat;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompHeartBeat;
+using std::chrono::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+
+BOOST_AUTO_TEST_SUITE(stomp_heart_beat);
+
+BOOST_AUTO_TEST_SUITE(function_ParseHeartBeat);
+
+BOOST_AUTO_TEST_CASE(valid)
+{
+    StompError error {};
+    auto heartBeat {ParseHeartBeat(error, "1000,2500")};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK(heartBeat == (StompHeartBeat {milliseconds {1000},
+                                              milliseconds {2500}}));
+    BOOST_CHECK_EQUAL(ToString(heartBeat), "1000,2500");
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    StompError error {};
+    auto heartBeat {ParseHeartBeat(error, "")};
+    BOOST_CHECK_EQUAL(error, StompError::kOk);
+    BOOST_CHECK(heartBeat == StompHeartBeat {});
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+    for (const std::string value: {
+        "1000", "1000,", ",1000", "-1,0", "0,1x", "0 ,0", "1,2,3",
+        "99999999999,0",
+    }) {
+        StompError error {};
+        auto heartBeat {ParseHeartBeat(error, value)};
+        BOOST_CHECK_EQUAL(error, StompError::kValidationInvalidHeaderValue);
+        BOOST_CHECK(heartBeat == StompHeartBeat {});
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // function_ParseHeartBeat
+
+BOOST_AUTO_TEST_SUITE(function_NegotiateHeartBeat);
+
+BOOST_AUTO_TEST_CASE(slowest_wins)
+{
+    StompHeartBeat local {milliseconds {1000}, milliseconds {2000}};
+    StompHeartBeat remote {milliseconds {3000}, milliseconds {500}};
+    auto heartBeat {NegotiateHeartBeat(local, remote)};
+    BOOST_CHECK_EQUAL(heartBeat.send.count(), 1000);
+    BOOST_CHECK_EQUAL(heartBeat.receive.count(), 3000);
+}
+
+BOOST_AUTO_TEST_CASE(disabled)
+{
+    StompHeartBeat local {milliseconds {1000}, milliseconds {0}};
+    StompHeartBeat remote {milliseconds {3000}, milliseconds {0}};
+    auto heartBeat {NegotiateHeartBeat(local, remote)};
+    BOOST_CHECK_EQUAL(heartBeat.send.count(), 0);
+    BOOST_CHECK_EQUAL(heartBeat.receive.count(), 0);
+
+    // A missing header is the same as 0,0.
+    heartBeat = NegotiateHeartBeat(local, StompHeartBeat {});
+    BOOST_CHECK(heartBeat == StompHeartBeat {});
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // function_NegotiateHeartBeat
+
+BOOST_AUTO_TEST_SUITE(function_GetHeartBeatCheckInterval);
+
+BOOST_AUTO_TEST_CASE(half_shortest_interval)
+{
+    BOOST_CHECK_EQUAL(GetHeartBeatCheckInterval({}).count(), 0);
+    BOOST_CHECK_EQUAL(GetHeartBeatCheckInterval(
+        {milliseconds {1000}, milliseconds {0}}
+    ).count(), 500);
+    BOOST_CHECK_EQUAL(GetHeartBeatCheckInterval(
+        {milliseconds {1000}, milliseconds {400}}
+    ).count(), 200);
+    BOOST_CHECK_EQUAL(GetHeartBeatCheckInterval(
+        {milliseconds {1}, milliseconds {0}}
+    ).count(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // function_GetHeartBeatCheckInterval
+
+BOOST_AUTO_TEST_SUITE_END(); // stomp_heart_beat
+
+BOOST_AUTO_TEST_SUITE_END(); // network_monitor
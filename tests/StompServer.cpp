@@ -13,6 +13,8 @@
 #include <boost/asio/ssl.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -22,6 +24,8 @@ using NetworkMonitor::BoostWebsocketServer;
 using NetworkMonitor::GetEnvVar;
 using NetworkMonitor::GetMockSendFrame;
 using NetworkMonitor::GetMockStompFrame;
+using NetworkMonitor::GetMockSubscribeFrame;
+using NetworkMonitor::GetMockUnsubscribeFrame;
 using NetworkMonitor::LoadTestServerCertificate;
 using NetworkMonitor::MockWebsocketEvent;
 using NetworkMonitor::MockWebsocketServerForStomp;
@@ -31,8 +35,11 @@ using NetworkMonitor::StompClientError;
 using NetworkMonitor::StompCommand;
 using NetworkMonitor::StompError;
 using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompHeartBeat;
+using NetworkMonitor::StompHeader;
 using NetworkMonitor::StompServer;
 using NetworkMonitor::StompServerError;
+using NetworkMonitor::StompServerLimits;
 
 using namespace std::string_literals;
 
@@ -40,6 +47,21 @@ using namespace std::string_literals;
 // connection.
 using timeout = boost::unit_test::timeout;
 
+// Count the ERROR frames sent by the mock sessions with the given error.
+static size_t CountMockErrorFrames(
+    const StompServerError error
+)
+{
+    return std::count_if(
+        MockWebsocketSession::messages.begin(),
+        MockWebsocketSession::messages.end(),
+        [&error](const auto& message) {
+            return message.rfind("ERROR\n", 0) == 0 &&
+                   message.find(ToString(error)) != std::string::npos;
+        }
+    );
+}
+
 // This fixture is used to re-initialize all mock properties before a test.
 struct StompServerTestFixture {
     StompServerTestFixture()
@@ -48,6 +70,10 @@ struct StompServerTestFixture {
         MockWebsocketServerForStomp::triggerDisconnection = false;
         MockWebsocketServerForStomp::runEc = {};
         MockWebsocketServerForStomp::mockEvents = {};
+        MockWebsocketSession::nHeartBeats = 0;
+        MockWebsocketSession::splitMessages = {};
+        MockWebsocketSession::messages = {};
+        MockWebsocketSession::readingPaused = false;
     }
 };
 
@@ -69,8 +95,17 @@ BOOST_AUTO_TEST_CASE(ostream)
         StompServerError::kCouldNotParseFrame,
         StompServerError::kCouldNotSendMessage,
         StompServerError::kCouldNotStartWebsocketServer,
+        StompServerError::kFrameTooLarge,
+        StompServerError::kHeartBeatTimeout,
         StompServerError::kInvalidHeaderValueAcceptVersion,
+        StompServerError::kInvalidHeaderValueAck,
+        StompServerError::kInvalidHeaderValueHeartBeat,
         StompServerError::kInvalidHeaderValueHost,
+        StompServerError::kSendRateExceeded,
+        StompServerError::kServerBusy,
+        StompServerError::kSubscriptionIdInUse,
+        StompServerError::kTooManyConnections,
+        StompServerError::kUnrecognizedSubscription,
         StompServerError::kUnsupportedFrame,
         StompServerError::kWebsocketSessionDisconnected,
         StompServerError::kWebsocketServerDisconnected,
@@ -789,6 +824,115 @@ BOOST_AUTO_TEST_CASE(send, *timeout {1})
     BOOST_CHECK(messageSent);
 }
 
+BOOST_AUTO_TEST_CASE(send_write_message, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/quiet-route"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    bool messageSent {false};
+    auto onSend = [&messageSent, &server](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK(id.size() > 0);
+        messageSent = true;
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    bool clientDidConnect {false};
+    auto onClientConnect = [
+        &server,
+        &clientDidConnect,
+        &destination,
+        &message,
+        &onSend
+    ](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK(id.size() > 0);
+        clientDidConnect = true;
+
+        MockWebsocketSession::sendEc = {};
+        const auto messageContent {message.dump()};
+
+        // The message writer must append exactly the declared number of
+        // bytes.
+        auto badReqId {server.Send(
+            id,
+            destination,
+            messageContent.size() + 1,
+            [&messageContent](auto& buffer) {
+                buffer += messageContent;
+            },
+            onSend
+        )};
+        BOOST_CHECK(badReqId.empty());
+
+        auto reqId {server.Send(
+            id,
+            destination,
+            messageContent.size(),
+            [&messageContent](auto& buffer) {
+                buffer += messageContent;
+            },
+            onSend
+        )};
+        BOOST_CHECK(reqId.size() > 0);
+    };
+    auto onClientMessage = [](auto, auto, auto, auto, auto&&) {
+        BOOST_CHECK(false);
+    };
+    auto onClientDisconnect = [](auto, auto) {
+        BOOST_CHECK(false);
+    };
+    auto onDisconnect = [](auto) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(
+        onClientConnect,
+        onClientMessage,
+        onClientDisconnect,
+        onDisconnect
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(clientDidConnect);
+    BOOST_CHECK(messageSent);
+}
+
 BOOST_AUTO_TEST_CASE(send_custom_req_id, *timeout {1})
 {
     // Since we use the mock, we do not actually launch a server at this port.
@@ -1239,7 +1383,7 @@ BOOST_AUTO_TEST_CASE(close_then_send, *timeout {1})
     BOOST_CHECK(clientDidConnect);
 }
 
-BOOST_AUTO_TEST_CASE(three_connections, *timeout {1})
+BOOST_AUTO_TEST_CASE(heart_beat_send, *timeout {1})
 {
     // Since we use the mock, we do not actually launch a server at this port.
     const std::string host {"localhost"};
@@ -1249,66 +1393,149 @@ BOOST_AUTO_TEST_CASE(three_connections, *timeout {1})
     boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
     ctx.load_verify_file(TESTS_CACERT_PEM);
 
-    const std::string destination {"/quiet-route"};
-    const nlohmann::json message {
-        {"msg", "Hello world"},
-    };
-
     // Setup the mock.
+    // The client wants a heart-beat every 50 ms.
     MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
         MockWebsocketEvent {
             "connection0",
             MockWebsocketEvent::Type::kConnect,
             // Succeeds
         },
-        MockWebsocketEvent {
-            "connection1",
-            MockWebsocketEvent::Type::kConnect,
-            // Succeeds
-        },
         MockWebsocketEvent {
             "connection0",
             MockWebsocketEvent::Type::kMessage,
             {}, // Succeeds
-            GetMockStompFrame(host)
+            GetMockStompFrame(host, "0,50")
         },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    server.SetHeartBeat({std::chrono::milliseconds {20}, {}});
+    boost::asio::steady_timer timer {ioc};
+    bool clientDidConnect {false};
+    auto onClientConnect = [&clientDidConnect, &server, &timer](auto ec,
+                                                                auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        clientDidConnect = true;
+
+        // This test assumes that Stop works.
+        timer.expires_after(std::chrono::milliseconds {300});
+        timer.async_wait([&server](auto ec) {
+            server.Stop();
+        });
+    };
+    auto onClientDisconnect = [](auto, auto) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(onClientConnect, nullptr, onClientDisconnect)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    // We send at the pace of the client, not faster.
+    BOOST_CHECK(clientDidConnect);
+    BOOST_CHECK_GE(MockWebsocketSession::nHeartBeats, 4);
+    BOOST_CHECK_LE(MockWebsocketSession::nHeartBeats, 7);
+}
+
+BOOST_AUTO_TEST_CASE(heart_beat_timeout, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    // The client promises a heart-beat every 50 ms, but it never sends one.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
         MockWebsocketEvent {
-            "connection2",
+            "connection0",
             MockWebsocketEvent::Type::kConnect,
             // Succeeds
         },
         MockWebsocketEvent {
-            "connection1",
-            MockWebsocketEvent::Type::kDisconnect,
-            boost::asio::error::interrupted,
-        },
-        MockWebsocketEvent {
-            "connection2",
+            "connection0",
             MockWebsocketEvent::Type::kMessage,
             {}, // Succeeds
-            GetMockStompFrame(host)
+            GetMockStompFrame(host, "50,0")
         },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    server.SetHeartBeat({{}, std::chrono::milliseconds {20}});
+    std::string connectionId {};
+    std::chrono::steady_clock::time_point connectedAt {};
+    auto onClientConnect = [&connectionId, &connectedAt](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        connectionId = id;
+        connectedAt = std::chrono::steady_clock::now();
+    };
+    std::chrono::steady_clock::duration detectedIn {};
+    auto onClientDisconnect = [
+        &connectionId,
+        &connectedAt,
+        &detectedIn,
+        &server
+    ](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kHeartBeatTimeout);
+        BOOST_CHECK_EQUAL(id, connectionId);
+        detectedIn = std::chrono::steady_clock::now() - connectedAt;
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    auto ec {server.Run(onClientConnect, nullptr, onClientDisconnect)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    // The dead client is detected after 2 intervals, plus one timer interval.
+    BOOST_CHECK(detectedIn >= std::chrono::milliseconds {100});
+    BOOST_CHECK(detectedIn < std::chrono::milliseconds {200});
+}
+
+BOOST_AUTO_TEST_CASE(heart_beat_timeout_reading_paused, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    // The client promises a heart-beat every 50 ms, but we stopped reading it
+    // because it is too slow.
+    MockWebsocketSession::readingPaused = true;
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
         MockWebsocketEvent {
-            "connection2",
-            MockWebsocketEvent::Type::kMessage,
-            {}, // Succeeds
-            GetMockSendFrame("msg0", destination, message.dump())
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
         },
         MockWebsocketEvent {
             "connection0",
             MockWebsocketEvent::Type::kMessage,
             {}, // Succeeds
-            GetMockSendFrame("msg1", destination, message.dump())
-        },
-        MockWebsocketEvent {
-            "connection0",
-            MockWebsocketEvent::Type::kDisconnect,
-            boost::asio::error::interrupted,
-        },
-        MockWebsocketEvent {
-            "connection2",
-            MockWebsocketEvent::Type::kDisconnect,
-            boost::asio::error::interrupted,
+            GetMockStompFrame(host, "50,0")
         },
     }};
 
@@ -1319,65 +1546,1191 @@ BOOST_AUTO_TEST_CASE(three_connections, *timeout {1})
         ioc,
         ctx
     };
-    size_t connectedClients {0};
-    auto onClientConnect = [&connectedClients](auto ec, auto id) {
-        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
-        BOOST_CHECK(id.size() > 0);
-        ++connectedClients;
-    };
-    size_t receivedMessages {0};
-    auto onClientMessage = [
-        &receivedMessages,
-        &message
-    ](auto ec, auto id, auto dst, auto reqId, auto&& msg) {
+    server.SetHeartBeat({{}, std::chrono::milliseconds {20}});
+    boost::asio::steady_timer timer {ioc};
+    bool clientDidConnect {false};
+    auto onClientConnect = [&clientDidConnect, &server, &timer](auto ec,
+                                                                auto) {
         BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
-        BOOST_CHECK(id.size() > 0);
-        BOOST_CHECK_EQUAL(msg, message.dump());
-        ++receivedMessages;
-    };
-    size_t disconnectedClients {0};
-    auto onClientDisconnect = [
-        &disconnectedClients,
-        &server
-    ](auto ec, auto id) {
-        BOOST_CHECK_EQUAL(ec, StompServerError::kWebsocketSessionDisconnected);
-        BOOST_CHECK(id.size() > 0);
-        ++disconnectedClients;
+        clientDidConnect = true;
 
-        if (disconnectedClients == 2) {
-            // This test assumes that Stop works.
+        // Several sweeps run in the meantime. This test assumes that Stop
+        // works.
+        timer.expires_after(std::chrono::milliseconds {300});
+        timer.async_wait([&server](auto) {
             server.Stop();
-        }
+        });
     };
-    auto onDisconnect = [](auto) {
+    auto onClientDisconnect = [](auto, auto) {
         BOOST_CHECK(false);
     };
-    auto ec {server.Run(
-        onClientConnect,
-        onClientMessage,
-        onClientDisconnect,
-        onDisconnect
-    )};
+    auto ec {server.Run(onClientConnect, nullptr, onClientDisconnect)};
     BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
 
     ioc.run();
 
     // When we get here, the io_context::run function has run out of work to do.
-    BOOST_CHECK_EQUAL(connectedClients, 2);
-    BOOST_CHECK_EQUAL(disconnectedClients, 2);
-    BOOST_CHECK_EQUAL(receivedMessages, 2);
+    BOOST_CHECK(clientDidConnect);
 }
 
-BOOST_AUTO_TEST_SUITE_END(); // class_StompServer
-
-BOOST_AUTO_TEST_SUITE(live);
-
-BOOST_AUTO_TEST_CASE(connect, *timeout {2})
+BOOST_AUTO_TEST_CASE(heart_beat_invalid, *timeout {1})
 {
-    const std::string endpoint {"/quiet-route"};
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
     const std::string ip {"127.0.0.1"};
     const unsigned short port {8042};
-
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host, "fast,slow")
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    server.SetHeartBeat({{}, std::chrono::milliseconds {20}});
+    auto onClientConnect = [](auto ec, auto id) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(onClientConnect)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    // The connection is refused.
+    boost::asio::steady_timer timer {ioc};
+    timer.expires_after(std::chrono::milliseconds {100});
+    timer.async_wait([&server](auto ec) {
+        server.Stop();
+    });
+    ioc.run();
+}
+
+BOOST_AUTO_TEST_CASE(three_connections, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/quiet-route"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kDisconnect,
+            boost::asio::error::interrupted,
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockSendFrame("msg0", destination, message.dump())
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockSendFrame("msg1", destination, message.dump())
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kDisconnect,
+            boost::asio::error::interrupted,
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kDisconnect,
+            boost::asio::error::interrupted,
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    size_t connectedClients {0};
+    auto onClientConnect = [&connectedClients](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK(id.size() > 0);
+        ++connectedClients;
+    };
+    size_t receivedMessages {0};
+    auto onClientMessage = [
+        &receivedMessages,
+        &message
+    ](auto ec, auto id, auto dst, auto reqId, auto&& msg) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK(id.size() > 0);
+        BOOST_CHECK_EQUAL(msg, message.dump());
+        ++receivedMessages;
+    };
+    size_t disconnectedClients {0};
+    auto onClientDisconnect = [
+        &disconnectedClients,
+        &server
+    ](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kWebsocketSessionDisconnected);
+        BOOST_CHECK(id.size() > 0);
+        ++disconnectedClients;
+
+        if (disconnectedClients == 2) {
+            // This test assumes that Stop works.
+            server.Stop();
+        }
+    };
+    auto onDisconnect = [](auto) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(
+        onClientConnect,
+        onClientMessage,
+        onClientDisconnect,
+        onDisconnect
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(connectedClients, 2);
+    BOOST_CHECK_EQUAL(disconnectedClients, 2);
+    BOOST_CHECK_EQUAL(receivedMessages, 2);
+}
+
+BOOST_AUTO_TEST_CASE(publish, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/crowding"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+
+    // Setup the mock.
+    // Two clients subscribe to the same destination, a third one to another
+    // destination.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", destination, "auto", "receipt-a")
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-b", destination)
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", "/other")
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    size_t nSubscribed {0};
+    size_t nPublished {0};
+    auto onClientSubscribe = [
+        &server,
+        &destination,
+        &message,
+        &nSubscribed,
+        &nPublished
+    ](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK(id.size() > 0);
+        if (++nSubscribed < 3) {
+            return;
+        }
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount(destination), 2);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/other"), 1);
+        nPublished = server.Publish(destination, message.dump());
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    auto onClientMessage = [](auto, auto, auto, auto, auto&&) {
+        BOOST_CHECK(false);
+    };
+    auto onClientUnsubscribe = [](auto, auto, auto) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(
+        nullptr,
+        onClientMessage,
+        nullptr,
+        nullptr,
+        onClientSubscribe,
+        onClientUnsubscribe
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSubscribed, 3);
+    BOOST_CHECK_EQUAL(nPublished, 2);
+
+    // The subscribers share the same frame tail. Each one has its own head.
+    const auto& messages {MockWebsocketSession::splitMessages};
+    BOOST_REQUIRE_EQUAL(messages.size(), 2);
+    BOOST_CHECK_EQUAL(messages[0].second, messages[1].second);
+    std::vector<std::string> subscriptionIds {};
+    for (const auto& [head, tail]: messages) {
+        StompError error {};
+        StompFrame frame {error, head + *tail};
+        BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+        BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::kMessage);
+        BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kDestination),
+                          destination);
+        BOOST_CHECK(frame.GetHeaderValue(StompHeader::kMessageId).size() > 0);
+        BOOST_CHECK_EQUAL(frame.GetBody(), message.dump());
+        subscriptionIds.emplace_back(
+            frame.GetHeaderValue(StompHeader::kSubscription)
+        );
+    }
+    std::sort(subscriptionIds.begin(), subscriptionIds.end());
+    BOOST_CHECK_EQUAL(subscriptionIds[0], "sub-a");
+    BOOST_CHECK_EQUAL(subscriptionIds[1], "sub-b");
+}
+
+BOOST_AUTO_TEST_CASE(publish_write_message, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/crowding"};
+    const std::string message {"{\"msg\":\"Hello world\"}"};
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", destination)
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    size_t nWritten {0};
+    auto writeMessage = [&message, &nWritten](auto& buffer) {
+        buffer += message;
+        ++nWritten;
+    };
+    auto onClientSubscribe = [
+        &server,
+        &destination,
+        &message,
+        &writeMessage
+    ](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK_EQUAL(dst, destination);
+
+        // No subscribers, no serialization.
+        BOOST_CHECK_EQUAL(
+            server.Publish("/other", message.size(), writeMessage),
+            0
+        );
+        BOOST_CHECK_EQUAL(
+            server.Publish(destination, message.size(), writeMessage),
+            1
+        );
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    auto ec {server.Run(
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        onClientSubscribe
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nWritten, 1);
+    const auto& messages {MockWebsocketSession::splitMessages};
+    BOOST_REQUIRE_EQUAL(messages.size(), 1);
+    StompError error {};
+    StompFrame frame {error, messages[0].first + *messages[0].second};
+    BOOST_REQUIRE_EQUAL(error, StompError::kOk);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue(StompHeader::kSubscription),
+                      "sub-a");
+    BOOST_CHECK_EQUAL(frame.GetBody(), message);
+}
+
+BOOST_AUTO_TEST_CASE(unsubscribe, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/crowding"};
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", destination) +
+            GetMockUnsubscribeFrame("sub-a")
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    bool didSubscribe {false};
+    auto onClientSubscribe = [&didSubscribe](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        didSubscribe = true;
+    };
+    bool didUnsubscribe {false};
+    auto onClientUnsubscribe = [
+        &server,
+        &destination,
+        &didSubscribe,
+        &didUnsubscribe
+    ](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK(didSubscribe);
+        BOOST_CHECK_EQUAL(dst, destination);
+        didUnsubscribe = true;
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount(destination), 0);
+        BOOST_CHECK_EQUAL(server.Publish(destination, "{}"), 0);
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    auto onClientDisconnect = [](auto, auto) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(
+        nullptr,
+        nullptr,
+        onClientDisconnect,
+        nullptr,
+        onClientSubscribe,
+        onClientUnsubscribe
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(didUnsubscribe);
+    BOOST_CHECK(MockWebsocketSession::splitMessages.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unsubscribe_one_of_many, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    // The subscription IDs share a prefix. Only the exact ID is removed.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub", "/crowding") +
+            GetMockSubscribeFrame("sub-a", "/delays") +
+            GetMockSubscribeFrame("sub-ab", "/closures") +
+            GetMockUnsubscribeFrame("sub-a")
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    std::vector<std::string> unsubscribed {};
+    auto onClientUnsubscribe = [
+        &server,
+        &unsubscribed
+    ](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        unsubscribed.push_back(dst);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/crowding"), 1);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/delays"), 0);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/closures"), 1);
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    auto onClientDisconnect = [](auto, auto) {
+        BOOST_CHECK(false);
+    };
+    auto ec {server.Run(
+        nullptr,
+        nullptr,
+        onClientDisconnect,
+        nullptr,
+        nullptr,
+        onClientUnsubscribe
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    const std::vector<std::string> expected {"/delays"};
+    BOOST_CHECK(unsubscribed == expected);
+}
+
+BOOST_AUTO_TEST_CASE(unsubscribe_on_disconnect, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", "/crowding") +
+            GetMockSubscribeFrame("sub-b", "/delays")
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kDisconnect,
+            boost::asio::error::interrupted,
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    std::vector<std::string> unsubscribed {};
+    auto onClientUnsubscribe = [&unsubscribed](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kWebsocketSessionDisconnected);
+        unsubscribed.push_back(dst);
+    };
+    bool clientDidDisconnect {false};
+    auto onClientDisconnect = [
+        &server,
+        &unsubscribed,
+        &clientDidDisconnect
+    ](auto ec, auto id) {
+        // The subscriptions end before the connection.
+        BOOST_CHECK_EQUAL(unsubscribed.size(), 2);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/crowding"), 0);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/delays"), 0);
+        clientDidDisconnect = true;
+
+        // This test assumes that Stop works.
+        server.Stop();
+    };
+    auto ec {server.Run(
+        nullptr,
+        nullptr,
+        onClientDisconnect,
+        nullptr,
+        nullptr,
+        onClientUnsubscribe
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(clientDidDisconnect);
+    std::sort(unsubscribed.begin(), unsubscribed.end());
+    BOOST_REQUIRE_EQUAL(unsubscribed.size(), 2);
+    BOOST_CHECK_EQUAL(unsubscribed[0], "/crowding");
+    BOOST_CHECK_EQUAL(unsubscribed[1], "/delays");
+}
+
+BOOST_AUTO_TEST_CASE(subscribe_invalid, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    // connection0 asks for client acknowledgements. connection1 re-uses a
+    // subscription ID. connection2 unsubscribes from an unknown subscription.
+    // The server closes all three connections.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", "/crowding", "client-individual")
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSubscribeFrame("sub-a", "/crowding") +
+            GetMockSubscribeFrame("sub-a", "/delays")
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockUnsubscribeFrame("sub-a")
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    size_t nSubscribed {0};
+    auto onClientSubscribe = [&nSubscribed](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(dst, "/crowding");
+        ++nSubscribed;
+    };
+    size_t nUnsubscribed {0};
+    auto onClientUnsubscribe = [&nUnsubscribed](auto ec, auto id, auto dst) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kSubscriptionIdInUse);
+        BOOST_CHECK_EQUAL(dst, "/crowding");
+        ++nUnsubscribed;
+    };
+    auto ec {server.Run(
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        onClientSubscribe,
+        onClientUnsubscribe
+    )};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    // We let the server listen to incoming connections for 100ms.
+    boost::asio::high_resolution_timer timer(ioc);
+    timer.expires_after(std::chrono::milliseconds(100));
+    timer.async_wait([&server](auto ec) {
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/crowding"), 0);
+        BOOST_CHECK_EQUAL(server.GetSubscriberCount("/delays"), 0);
+
+        // This test assumes that Stop() works.
+        server.Stop();
+    });
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSubscribed, 1);
+    BOOST_CHECK_EQUAL(nUnsubscribed, 1);
+}
+
+BOOST_AUTO_TEST_CASE(frame_too_large, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/quiet-route"};
+
+    // Setup the mock.
+    // connection0 sends a frame over the limit. connection1 is not affected.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockSendFrame("msg0", destination, std::string(128, 'x'))
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockSendFrame("msg1", destination, "{}")
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    StompServerLimits limits {};
+    limits.maxFrameSize = 128;
+    server.SetLimits(limits);
+    size_t connectedClients {0};
+    auto onClientConnect = [&connectedClients](auto ec, auto) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        ++connectedClients;
+    };
+    size_t receivedMessages {0};
+    auto onClientMessage = [&receivedMessages](
+        auto ec,
+        auto,
+        auto,
+        auto reqId,
+        auto&&
+    ) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        BOOST_CHECK_EQUAL(reqId, "msg1");
+        ++receivedMessages;
+    };
+    auto ec {server.Run(onClientConnect, onClientMessage)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    // We let the server listen to incoming connections for 100ms.
+    boost::asio::high_resolution_timer timer(ioc);
+    timer.expires_after(std::chrono::milliseconds(100));
+    timer.async_wait([&server](auto) {
+        // This test assumes that Stop() works.
+        server.Stop();
+    });
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(connectedClients, 2);
+    BOOST_CHECK_EQUAL(receivedMessages, 1);
+    BOOST_CHECK_EQUAL(CountMockErrorFrames(StompServerError::kFrameTooLarge), 1);
+}
+
+BOOST_AUTO_TEST_CASE(close_with_error, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    bool clientDidClose {false};
+    auto onClientConnect = [&server, &clientDidClose](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        server.Close(
+            id,
+            StompServerError::kServerBusy,
+            [&server, &clientDidClose](auto ec, auto id) {
+                BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+                clientDidClose = true;
+
+                // This test assumes that Stop works.
+                server.Stop();
+            }
+        );
+    };
+    auto ec {server.Run(onClientConnect)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(clientDidClose);
+    BOOST_CHECK_EQUAL(CountMockErrorFrames(StompServerError::kServerBusy), 1);
+}
+
+BOOST_AUTO_TEST_CASE(max_connections, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    // Setup the mock.
+    // The server accepts 2 connections. connection2 is rejected, even if
+    // connection1 is still pending. connection3 takes the place of
+    // connection0.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection2",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kDisconnect,
+            boost::asio::error::interrupted,
+        },
+        MockWebsocketEvent {
+            "connection3",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection3",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host)
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    StompServerLimits limits {};
+    limits.maxConnections = 2;
+    server.SetLimits(limits);
+    size_t connectedClients {0};
+    auto onClientConnect = [&connectedClients](auto ec, auto id) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        ++connectedClients;
+    };
+    auto ec {server.Run(onClientConnect)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    // We let the server listen to incoming connections for 100ms.
+    boost::asio::high_resolution_timer timer(ioc);
+    timer.expires_after(std::chrono::milliseconds(100));
+    timer.async_wait([&server](auto ec) {
+        // This test assumes that Stop() works.
+        server.Stop();
+    });
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(connectedClients, 3);
+    BOOST_CHECK_EQUAL(server.GetAdmissionStats().nRejectedConnections, 1);
+    BOOST_CHECK_EQUAL(server.GetAdmissionStats().nRateLimitedFrames, 0);
+    BOOST_CHECK_EQUAL(
+        CountMockErrorFrames(StompServerError::kTooManyConnections),
+        1
+    );
+}
+
+BOOST_AUTO_TEST_CASE(send_rate, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/quiet-route"};
+    const std::string message {"{}"};
+
+    // Setup the mock.
+    // Each client can send a burst of 2 frames. connection0 sends 3 frames in
+    // a row and is closed. connection1 is not affected.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSendFrame("msg0", destination, message) +
+            GetMockSendFrame("msg1", destination, message) +
+            GetMockSendFrame("msg2", destination, message)
+        },
+        MockWebsocketEvent {
+            "connection1",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSendFrame("msg3", destination, message) +
+            GetMockSendFrame("msg4", destination, message)
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    StompServerLimits limits {};
+    limits.sendRate = 0.1;
+    limits.sendBurst = 2;
+    server.SetLimits(limits);
+    std::vector<std::string> requestIds {};
+    auto onClientMessage = [&requestIds](
+        auto ec,
+        auto id,
+        auto dst,
+        auto reqId,
+        auto&& msg
+    ) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        requestIds.push_back(reqId);
+    };
+    auto ec {server.Run(nullptr, onClientMessage)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    // We let the server listen to incoming connections for 100ms.
+    boost::asio::high_resolution_timer timer(ioc);
+    timer.expires_after(std::chrono::milliseconds(100));
+    timer.async_wait([&server](auto ec) {
+        // This test assumes that Stop() works.
+        server.Stop();
+    });
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    const std::vector<std::string> expected {"msg0", "msg1", "msg3", "msg4"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        requestIds.begin(), requestIds.end(),
+        expected.begin(), expected.end()
+    );
+    BOOST_CHECK_EQUAL(server.GetAdmissionStats().nRejectedConnections, 0);
+    BOOST_CHECK_EQUAL(server.GetAdmissionStats().nRateLimitedFrames, 1);
+    BOOST_CHECK_EQUAL(
+        CountMockErrorFrames(StompServerError::kSendRateExceeded),
+        1
+    );
+}
+
+BOOST_AUTO_TEST_CASE(send_rate_no_burst, *timeout {1})
+{
+    // Since we use the mock, we do not actually launch a server at this port.
+    const std::string host {"localhost"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+
+    const std::string destination {"/quiet-route"};
+    const std::string message {"{}"};
+
+    // Setup the mock.
+    // A burst of 0 still lets the client send one frame. The second frame in
+    // a row is over the rate.
+    MockWebsocketServerForStomp::mockEvents = std::queue<MockWebsocketEvent> {{
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kConnect,
+            // Succeeds
+        },
+        MockWebsocketEvent {
+            "connection0",
+            MockWebsocketEvent::Type::kMessage,
+            {}, // Succeeds
+            GetMockStompFrame(host) +
+            GetMockSendFrame("msg0", destination, message) +
+            GetMockSendFrame("msg1", destination, message)
+        },
+    }};
+
+    StompServer<MockWebsocketServerForStomp> server {
+        host,
+        ip,
+        port,
+        ioc,
+        ctx
+    };
+    StompServerLimits limits {};
+    limits.sendRate = 0.1;
+    limits.sendBurst = 0;
+    server.SetLimits(limits);
+    std::vector<std::string> requestIds {};
+    auto onClientMessage = [&requestIds](
+        auto ec,
+        auto id,
+        auto dst,
+        auto reqId,
+        auto&& msg
+    ) {
+        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+        requestIds.push_back(reqId);
+    };
+    auto ec {server.Run(nullptr, onClientMessage)};
+    BOOST_REQUIRE_EQUAL(ec, StompServerError::kOk);
+
+    // We let the server listen to incoming connections for 100ms.
+    boost::asio::high_resolution_timer timer(ioc);
+    timer.expires_after(std::chrono::milliseconds(100));
+    timer.async_wait([&server](auto ec) {
+        // This test assumes that Stop() works.
+        server.Stop();
+    });
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    const std::vector<std::string> expected {"msg0"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        requestIds.begin(), requestIds.end(),
+        expected.begin(), expected.end()
+    );
+    BOOST_CHECK_EQUAL(server.GetAdmissionStats().nRateLimitedFrames, 1);
+    BOOST_CHECK_EQUAL(
+        CountMockErrorFrames(StompServerError::kSendRateExceeded),
+        1
+    );
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_StompServer
+
+BOOST_AUTO_TEST_SUITE(live);
+
+BOOST_AUTO_TEST_CASE(connect, *timeout {2})
+{
+    const std::string endpoint {"/quiet-route"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+
     using boost::asio::ssl::context;
 
     boost::asio::io_context ioc {};
@@ -1579,6 +2932,197 @@ BOOST_AUTO_TEST_CASE(exchange_messages, *timeout {2})
     BOOST_CHECK(serverDidConnect);
 }
 
+BOOST_AUTO_TEST_CASE(reentrant_handlers, *timeout {2})
+{
+    const std::string endpoint {"/quiet-route"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+
+    const std::string destination {"/quiet-route"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+
+    using boost::asio::ssl::context;
+
+    boost::asio::io_context ioc {};
+
+    // Server
+    // The onSend handlers send again and close the connection. They run while
+    // the Websocket session is still busy with the frames of the client.
+    boost::asio::ssl::context serverCtx {context::tlsv12_server};
+    serverCtx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(serverCtx);
+    StompServer<BoostWebsocketServer> server {ip, ip, port, ioc, serverCtx};
+    size_t nSent {0};
+    bool serverDidClose {false};
+    {
+        auto onClientMessage {
+            [
+                &destination,
+                &message,
+                &nSent,
+                &serverDidClose,
+                &server
+            ](auto ec, auto id, auto, auto, auto&&) {
+                BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+                auto onClientClose {[&serverDidClose, &server](auto ec, auto) {
+                    BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+                    serverDidClose = true;
+                    server.Stop();
+                }};
+                server.Send(id, destination, message.dump(),
+                    [&, id, onClientClose](auto ec, auto) {
+                        BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+                        ++nSent;
+                        server.Send(id, destination, message.dump(),
+                            [&, id, onClientClose](auto ec, auto) {
+                                BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+                                ++nSent;
+                                server.Close(id, onClientClose);
+                            }
+                        );
+                    }
+                );
+            }
+        };
+        auto onClientDisconnect {
+            [](auto, auto) {
+                BOOST_CHECK(false);
+            }
+        };
+        server.Run(nullptr, onClientMessage, onClientDisconnect);
+    }
+
+    // Client
+    boost::asio::ssl::context clientCtx {context::tlsv12_client};
+    clientCtx.load_verify_file(TESTS_CACERT_PEM);
+    StompClient<BoostWebsocketClient> client {
+        ip, endpoint, std::to_string(port), ioc, clientCtx
+    };
+    size_t nReceived {0};
+    bool clientDidDisconnect {false};
+    {
+        auto onConnect {[&destination, &message, &client](auto ec) {
+            BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+            client.Send(destination, message.dump());
+        }};
+        auto onMessage {[&nReceived](auto ec, auto&&, auto&&) {
+            BOOST_CHECK_EQUAL(ec, StompClientError::kOk);
+            ++nReceived;
+        }};
+        auto onDisconnect {[&clientDidDisconnect](auto) {
+            clientDidDisconnect = true;
+        }};
+        client.Connect("user", "pwd", onConnect, onMessage, onDisconnect);
+    }
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSent, 2);
+    BOOST_CHECK_EQUAL(nReceived, 2);
+    BOOST_CHECK(serverDidClose);
+    BOOST_CHECK(clientDidDisconnect);
+}
+
+BOOST_AUTO_TEST_CASE(subscribe_and_publish, *timeout {2})
+{
+    const std::string endpoint {"/quiet-route"};
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+
+    const std::string destination {"/crowding"};
+    const nlohmann::json message {
+        {"msg", "Hello world"},
+    };
+
+    using boost::asio::ssl::context;
+
+    boost::asio::io_context ioc {};
+
+    // Server
+    // We use the IP as the server hostname because the client will connect to
+    // 127.0.0.1 directly, without host name resolution.
+    boost::asio::ssl::context serverCtx {context::tlsv12_server};
+    serverCtx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(serverCtx);
+    StompServer<BoostWebsocketServer> server {ip, ip, port, ioc, serverCtx};
+    bool serverDidSubscribe {false};
+    {
+        auto onClientSubscribe {
+            [
+                &destination,
+                &serverDidSubscribe
+            ](auto ec, auto id, auto dst) {
+                BOOST_CHECK_EQUAL(ec, StompServerError::kOk);
+                BOOST_CHECK_EQUAL(dst, destination);
+                serverDidSubscribe = true;
+            }
+        };
+        server.Run(
+            nullptr,
+            nullptr,
+            nullptr,
+            nullptr,
+            onClientSubscribe
+        );
+    }
+
+    // Client
+    // The client connects to an IPv4 address directly to prevent the case
+    // where `localhost` is resolved to an IPv6 address.
+    boost::asio::ssl::context clientCtx {context::tlsv12_client};
+    clientCtx.load_verify_file(TESTS_CACERT_PEM);
+    StompClient<BoostWebsocketClient> client {
+        ip, endpoint, std::to_string(port), ioc, clientCtx
+    };
+    bool clientDidSubscribe {false};
+    bool clientReceivedMsg {false};
+    {
+        auto onSubscribe {[
+            &clientDidSubscribe,
+            &destination,
+            &message,
+            &server
+        ](auto ec, auto&& id) {
+            // The server confirms the subscription with a RECEIPT frame.
+            BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+            clientDidSubscribe = true;
+            BOOST_CHECK_EQUAL(server.Publish(destination, message.dump()), 1);
+        }};
+        auto onSubscriptionMessage {[
+            &message,
+            &clientReceivedMsg,
+            &server
+        ](auto ec, auto&& msg) {
+            BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+            BOOST_CHECK_EQUAL(msg, message.dump());
+            clientReceivedMsg = true;
+
+            // This test assumes that Stop works.
+            server.Stop();
+        }};
+        auto onConnect {[
+            &client,
+            &destination,
+            &onSubscribe,
+            &onSubscriptionMessage
+        ](auto ec) {
+            BOOST_REQUIRE_EQUAL(ec, StompClientError::kOk);
+            client.Subscribe(destination, onSubscribe, onSubscriptionMessage);
+        }};
+        client.Connect("user", "pwd", onConnect);
+    }
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(serverDidSubscribe);
+    BOOST_CHECK(clientDidSubscribe);
+    BOOST_CHECK(clientReceivedMsg);
+}
+
 BOOST_AUTO_TEST_CASE(three_connections, *timeout {2})
 {
     const std::string endpoint {"/quiet-route"};
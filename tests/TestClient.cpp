@@ -112,12 +112,12 @@ int main()
         clientDidReceiveResp = true;
         spdlog::info("TestStompClient: Received /quiet-route response");
         try {
-            quietRoute = nlohmann::json::parse(msg);
+            quietRoute = nlohmann::json::parse(msg.GetView());
         } catch (const std::exception& e) {
             spdlog::error("TestStompClient: Failed to parse response: {}",
                           e.what());
             spdlog::error("TestStompClient: Response content:\n{}",
-                          nlohmann::json::parse(msg));
+                          nlohmann::json::parse(msg.GetView()));
             Check(false);
         }
         spdlog::info("TestStompClient: Closing the client connection");
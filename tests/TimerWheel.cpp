@@ -0,0 +1,126 @@
+#include <network-monitor/TimerWheel.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::TimerWheel;
+using std::chrono::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+
+BOOST_AUTO_TEST_SUITE(class_TimerWheel);
+
+BOOST_AUTO_TEST_CASE(expire_in_order)
+{
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 8, start};
+    wheel.Schedule("a", start + milliseconds {25});
+    wheel.Schedule("b", start + milliseconds {10});
+    wheel.Schedule("c", start + milliseconds {50});
+    BOOST_CHECK_EQUAL(wheel.Size(), 3);
+
+    std::vector<std::string> expired {};
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {9}, expired), 0);
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {10}, expired), 1);
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {24}, expired), 0);
+
+    // A deadline never expires early.
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {30}, expired), 1);
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {60}, expired), 1);
+    const std::vector<std::string> expected {"b", "a", "c"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(expired.begin(), expired.end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK(wheel.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(cancel)
+{
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 8, start};
+    wheel.Schedule("a", start + milliseconds {10});
+    wheel.Schedule("b", start + milliseconds {10});
+    BOOST_CHECK(wheel.Cancel("a"));
+    BOOST_CHECK(!wheel.Cancel("a"));
+    BOOST_CHECK_EQUAL(wheel.Size(), 1);
+
+    std::vector<std::string> expired {};
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {10}, expired), 1);
+    BOOST_REQUIRE_EQUAL(expired.size(), 1);
+    BOOST_CHECK_EQUAL(expired[0], "b");
+}
+
+BOOST_AUTO_TEST_CASE(reschedule)
+{
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 8, start};
+    wheel.Schedule("a", start + milliseconds {10});
+    wheel.Schedule("a", start + milliseconds {40});
+    BOOST_CHECK_EQUAL(wheel.Size(), 1);
+
+    std::vector<std::string> expired {};
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {30}, expired), 0);
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {40}, expired), 1);
+}
+
+BOOST_AUTO_TEST_CASE(multiple_revolutions)
+{
+    // One revolution is 40 ms.
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 4, start};
+    wheel.Schedule("far", start + milliseconds {130});
+    wheel.Schedule("near", start + milliseconds {10});
+
+    std::vector<std::string> expired {};
+    for (int ms {10}; ms < 130; ms += 10) {
+        wheel.Advance(start + milliseconds {ms}, expired);
+    }
+    BOOST_REQUIRE_EQUAL(expired.size(), 1);
+    BOOST_CHECK_EQUAL(expired[0], "near");
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {130}, expired), 1);
+    BOOST_CHECK_EQUAL(expired[1], "far");
+}
+
+BOOST_AUTO_TEST_CASE(skip_ticks)
+{
+    // The wheel is advanced well past a full revolution in one go.
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 4, start};
+    for (int ms: {10, 20, 30, 40, 500}) {
+        wheel.Schedule(std::to_string(ms), start + milliseconds {ms});
+    }
+    std::vector<std::string> expired {};
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {100}, expired), 4);
+    BOOST_CHECK_EQUAL(wheel.Size(), 1);
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {500}, expired), 1);
+}
+
+BOOST_AUTO_TEST_CASE(past_deadline)
+{
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 8, start};
+    std::vector<std::string> expired {};
+    wheel.Advance(start + milliseconds {50}, expired);
+
+    // A deadline in the past expires on the next tick.
+    wheel.Schedule("late", start + milliseconds {20});
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {55}, expired), 0);
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {60}, expired), 1);
+}
+
+BOOST_AUTO_TEST_CASE(clear)
+{
+    const auto start {TimerWheel::Clock::now()};
+    TimerWheel wheel {milliseconds {10}, 8, start};
+    wheel.Schedule("a", start + milliseconds {10});
+    wheel.Clear();
+    BOOST_CHECK(wheel.Empty());
+    std::vector<std::string> expired {};
+    BOOST_CHECK_EQUAL(wheel.Advance(start + milliseconds {100}, expired), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // class_TimerWheel
+
+BOOST_AUTO_TEST_SUITE_END(); // network_monitor
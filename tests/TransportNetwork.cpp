@@ -5,6 +5,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <stdexcept>
@@ -346,6 +347,39 @@ BOOST_AUTO_TEST_CASE(basic)
     BOOST_CHECK_EQUAL(nw.GetPassengerCount(station2.id), -1);
 }
 
+BOOST_AUTO_TEST_CASE(copy_passenger_counts)
+{
+    // The old network has 2 stations, the new one has the same 2 stations
+    // plus station_2.
+    TransportNetwork oldNw {};
+    auto ok {oldNw.FromJson(ParseJsonFile(
+        std::filesystem::path(TEST_DATA) / "from_json_1line_1route.json"
+    ))};
+    BOOST_REQUIRE(ok);
+    TransportNetwork newNw {};
+    ok = newNw.FromJson(ParseJsonFile(
+        std::filesystem::path(TEST_DATA) / "from_json_1line_2routes.json"
+    ));
+    BOOST_REQUIRE(ok);
+
+    using EventType = PassengerEvent::Type;
+    ok = true;
+    ok &= oldNw.RecordPassengerEvent({"station_0", EventType::In});
+    ok &= oldNw.RecordPassengerEvent({"station_0", EventType::In});
+    ok &= oldNw.RecordPassengerEvent({"station_1", EventType::Out});
+    ok &= newNw.RecordPassengerEvent({"station_2", EventType::In});
+    BOOST_REQUIRE(ok);
+
+    auto nCopied {newNw.CopyPassengerCounts(oldNw)};
+    BOOST_CHECK_EQUAL(nCopied, 2);
+    BOOST_CHECK_EQUAL(newNw.GetPassengerCount("station_0"), 2);
+    BOOST_CHECK_EQUAL(newNw.GetPassengerCount("station_1"), -1);
+    BOOST_CHECK_EQUAL(newNw.GetPassengerCount("station_2"), 1);
+
+    // The source network is not modified.
+    BOOST_CHECK_EQUAL(oldNw.GetPassengerCount("station_0"), 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END(); // PassengerEvents
 
 BOOST_AUTO_TEST_SUITE(GetRoutesServingStation);
@@ -856,8 +890,114 @@ BOOST_AUTO_TEST_CASE(ltc_path2, *timeout {1})
 
 BOOST_AUTO_TEST_SUITE_END(); // GetFastestTravelRoute
 
+BOOST_AUTO_TEST_SUITE(GetQuietTravelRoute);
+
+BOOST_AUTO_TEST_CASE(dependencies_same_station)
+{
+    auto [nw, resultTravelRoute] = GetTestNetwork(
+        "network_fastest_path_same_station"
+    );
+    std::vector<Id> dependencies {"station_X"};
+    auto travelRoute {nw.GetQuietTravelRoute(
+        "station_A", "station_A", 0.1, 0.1, 20, dependencies
+    )};
+    BOOST_CHECK_EQUAL(travelRoute, resultTravelRoute);
+    BOOST_CHECK(dependencies.empty());
+}
+
+BOOST_AUTO_TEST_CASE(dependencies_ltc, *timeout {10})
+{
+    auto [nw, fastestTravelRoute] = GetTestNetwork("ltc_path2", true);
+    std::vector<Id> dependencies {};
+    auto travelRoute {nw.GetQuietTravelRoute(
+        "station_211", "station_119", 0.1, 0.1, 20, dependencies
+    )};
+    BOOST_CHECK_EQUAL(
+        travelRoute,
+        nw.GetQuietTravelRoute("station_211", "station_119", 0.1, 0.1, 20)
+    );
+
+    // The dependencies are sorted and unique, and they include all the
+    // stations of the fastest and the quiet routes.
+    BOOST_CHECK(std::is_sorted(dependencies.begin(), dependencies.end()));
+    BOOST_CHECK(std::adjacent_find(
+        dependencies.begin(),
+        dependencies.end()
+    ) == dependencies.end());
+    for (const auto* route: {&fastestTravelRoute, &travelRoute}) {
+        for (const auto& step: route->steps) {
+            BOOST_CHECK(std::binary_search(
+                dependencies.begin(),
+                dependencies.end(),
+                step.startStationId
+            ));
+            BOOST_CHECK(std::binary_search(
+                dependencies.begin(),
+                dependencies.end(),
+                step.endStationId
+            ));
+        }
+    }
+
+    // Only a fraction of the network can change this route.
+    const auto layout = ParseJsonFile(TESTS_NETWORK_LAYOUT_JSON);
+    BOOST_CHECK_LT(dependencies.size(), layout.at("stations").size());
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // GetQuietTravelRoute
+
 BOOST_AUTO_TEST_SUITE_END(); // Routes
 
 BOOST_AUTO_TEST_SUITE_END(); // class_TransportNetwork
 
+BOOST_AUTO_TEST_SUITE(struct_TravelRoute);
+
+BOOST_AUTO_TEST_SUITE(WriteJson);
+
+BOOST_AUTO_TEST_CASE(ltc_results)
+{
+    for (const auto& filename: {
+        "ltc_path1.result.json",
+        "ltc_path2.result.json",
+        "ltc_quiet1.result.route_000.json",
+        "ltc_quiet2.result.route_049.json",
+        "network_fastest_path_no_path.result.json",
+    }) {
+        auto travelRouteJson = ParseJsonFile(
+            std::filesystem::path(TEST_DATA) / filename
+        );
+        auto travelRoute {travelRouteJson.get<TravelRoute>()};
+        auto expected {nlohmann::json(travelRoute).dump()};
+
+        // The output is appended to the existing buffer content.
+        std::string buffer {"prefix"};
+        NetworkMonitor::WriteJson(buffer, travelRoute);
+        BOOST_CHECK_EQUAL(buffer, "prefix" + expected);
+        BOOST_CHECK_EQUAL(NetworkMonitor::GetJsonSize(travelRoute),
+                          expected.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(escaped_strings)
+{
+    TravelRoute travelRoute {
+        "station_\"A\"",
+        "station_\\B\n\x01",
+        42,
+        {
+            {"station_\"A\"", "station_\\B\n\x01", "line\t0", "route\r0", 7},
+        },
+    };
+    auto expected {nlohmann::json(travelRoute).dump()};
+    std::string buffer {};
+    NetworkMonitor::WriteJson(buffer, travelRoute);
+    BOOST_CHECK_EQUAL(buffer, expected);
+    BOOST_CHECK_EQUAL(NetworkMonitor::GetJsonSize(travelRoute),
+                      expected.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // WriteJson
+
+BOOST_AUTO_TEST_SUITE_END(); // struct_TravelRoute
+
 BOOST_AUTO_TEST_SUITE_END(); // Websocket_client
\ No newline at end of file
@@ -6,10 +6,14 @@
 #include <boost/asio/ssl.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <functional>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 using NetworkMonitor::BoostWebsocketClient;
 
@@ -31,6 +35,7 @@ struct WebsocketClientTestFixture {
         MockTlsWebsocketStream::readBuffer = "";
         MockTlsWebsocketStream::writeEc = {};
         MockTlsWebsocketStream::closeEc = {};
+        MockTlsWebsocketStream::writtenMessages.clear();
     }
 };
 
@@ -463,6 +468,191 @@ BOOST_AUTO_TEST_CASE(fail, *timeout {1})
     BOOST_CHECK(calledOnSend);
 }
 
+BOOST_AUTO_TEST_CASE(queued_messages, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+    const std::vector<std::string> messages {"Hello", "Websocket", "queue"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    std::vector<size_t> sent {};
+    client.Connect([&client, &messages, &sent](auto ec) {
+        BOOST_REQUIRE(!ec);
+        for (size_t idx {0}; idx < messages.size(); ++idx) {
+            client.Send(messages[idx], [&client, &sent, idx](auto ec) {
+                BOOST_CHECK(!ec);
+                sent.push_back(idx);
+                if (sent.size() == 3) {
+                    // This test assumes that Close() works.
+                    client.Close();
+                }
+            });
+        }
+        BOOST_CHECK_EQUAL(client.GetQueueDepth(), 3);
+        BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 19);
+    });
+    ioc.run();
+
+    // Each message is written on its own, in order.
+    BOOST_CHECK(sent == std::vector<size_t>({0, 1, 2}));
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages == messages);
+    BOOST_CHECK_EQUAL(client.GetQueueDepth(), 0);
+    BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(batched_messages, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+    const std::string large(100, 'x');
+    const std::vector<std::string> messages {"one", "two", "three", large};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    client.SetMaxBatchSize(64);
+    size_t nSent {0};
+    client.Connect([&client, &messages, &nSent](auto ec) {
+        BOOST_REQUIRE(!ec);
+        for (const auto& message: messages) {
+            client.Send(message, [&client, &nSent](auto ec) {
+                BOOST_CHECK(!ec);
+                if (++nSent == 4) {
+                    // This test assumes that Close() works.
+                    client.Close();
+                }
+            });
+        }
+    });
+    ioc.run();
+
+    // The first message is written as soon as it is queued. The two messages
+    // queued in the meantime fit in one batch. The large one goes on its own.
+    BOOST_CHECK_EQUAL(nSent, 4);
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages ==
+                std::vector<std::string>({"one", "twothree", large}));
+    BOOST_CHECK_EQUAL(client.GetQueueDepth(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(send_then_close, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+    const std::string message {"Hello Websocket"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    bool calledOnSend {false};
+    bool calledOnClose {false};
+    client.Connect([&](auto ec) {
+        BOOST_REQUIRE(!ec);
+        client.Send(message, [&calledOnSend, &calledOnClose](auto ec) {
+            BOOST_CHECK(!ec);
+            BOOST_CHECK(!calledOnClose);
+            calledOnSend = true;
+        });
+        client.Close([&calledOnClose](auto ec) {
+            BOOST_CHECK(!ec);
+            calledOnClose = true;
+        });
+    });
+    ioc.run();
+
+    // The connection is only closed after the queued message is sent.
+    BOOST_CHECK(calledOnSend);
+    BOOST_CHECK(calledOnClose);
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages ==
+                std::vector<std::string>({message}));
+}
+
+BOOST_AUTO_TEST_CASE(fail_queued_messages, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    // Set the expected error codes.
+    using error = boost::beast::websocket::error;
+    MockTlsWebsocketStream::writeEc = error::bad_data_frame;
+
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    size_t nFailed {0};
+    client.Connect([&client, &nFailed](auto ec) {
+        BOOST_REQUIRE(!ec);
+        for (size_t idx {0}; idx < 3; ++idx) {
+            client.Send("Hello Websocket", [&client, &nFailed](auto ec) {
+                BOOST_CHECK(ec == error::bad_data_frame);
+                if (++nFailed == 3) {
+                    // This test assumes that Close() works.
+                    client.Close();
+                }
+            });
+        }
+    });
+    ioc.run();
+
+    // A failed write fails the messages queued behind it.
+    BOOST_CHECK_EQUAL(nFailed, 3);
+    BOOST_CHECK_EQUAL(client.GetQueueDepth(), 0);
+    BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(send_after_close, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+    const std::string message {"Hello Websocket"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    bool calledOnSend {false};
+    bool calledOnClose {false};
+    client.Connect([&](auto ec) {
+        BOOST_REQUIRE(!ec);
+        client.Close([&calledOnClose](auto ec) {
+            BOOST_CHECK(!ec);
+            calledOnClose = true;
+        });
+        client.Send(message, [&calledOnSend](auto ec) {
+            BOOST_CHECK(ec == boost::asio::error::operation_aborted);
+            calledOnSend = true;
+        });
+    });
+    ioc.run();
+
+    // The message is not written after the close frame.
+    BOOST_CHECK(calledOnSend);
+    BOOST_CHECK(calledOnClose);
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages.empty());
+    BOOST_CHECK_EQUAL(client.GetQueueDepth(), 0);
+    BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END(); // Send
 
 BOOST_FIXTURE_TEST_SUITE(Close, WebsocketClientTestFixture);
@@ -501,6 +691,133 @@ BOOST_AUTO_TEST_CASE(close, *timeout {1})
     BOOST_CHECK(calledOnClose);
 }
 
+BOOST_AUTO_TEST_CASE(connect_after_close, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    size_t nConnect {0};
+    size_t nClose {0};
+    auto onClose {[&nClose](auto ec) {
+        ++nClose;
+        BOOST_CHECK(!ec);
+    }};
+    auto onConnect {[&nConnect, &client, &onClose](auto ec) {
+        ++nConnect;
+        BOOST_REQUIRE(!ec);
+        client.Close(onClose);
+    }};
+    client.Connect(onConnect);
+    ioc.run();
+
+    // The client connects again on a fresh stream.
+    ioc.restart();
+    client.Connect(onConnect);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nConnect, 2);
+    BOOST_CHECK_EQUAL(nClose, 2);
+}
+
+BOOST_AUTO_TEST_CASE(connect_twice, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+
+    // The second attempt replaces the first one before it resolves. The first
+    // attempt must not report anything on the new connection.
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    size_t nConnect {0};
+    auto onConnect {[&nConnect, &client](auto ec) {
+        ++nConnect;
+        BOOST_CHECK(!ec);
+        client.Close();
+    }};
+    client.Connect(onConnect);
+    client.Connect(onConnect);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nConnect, 1);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_from_other_strand, *timeout {3})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string url {"some.echo-server.com"};
+    const std::string endpoint {"/"};
+    const std::string port {"443"};
+    const size_t nThreads {4};
+    const size_t nMessages {100};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+
+    // Like in StompClient, the client reconnects from a strand of its own,
+    // while the other threads that run the io_context keep sending. Each
+    // message either goes out or fails, exactly once.
+    TestWebsocketClient client {url, endpoint, port, ioc, ctx};
+    auto strand {boost::asio::make_strand(ioc)};
+    std::atomic<size_t> nConnect {0};
+    std::atomic<size_t> nSent {0};
+    std::function<void (boost::system::error_code)> onConnect {};
+    onConnect = [&](auto ec) {
+        if (ec || ++nConnect > 1) {
+            client.Close();
+            return;
+        }
+        client.Close([&](auto) {
+            boost::asio::post(strand, [&]() {
+                client.Connect(onConnect);
+            });
+            for (size_t idx {0}; idx < nMessages; ++idx) {
+                boost::asio::post(ioc, [&]() {
+                    client.Send("Hello Websocket", [&nSent](auto) {
+                        ++nSent;
+                    });
+                });
+            }
+        });
+    };
+    client.Connect(onConnect);
+    std::vector<std::thread> threads {};
+    for (size_t idx {0}; idx < nThreads; ++idx) {
+        threads.emplace_back([&ioc]() {
+            ioc.run();
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nConnect, 2);
+    BOOST_CHECK_EQUAL(nSent, nMessages);
+    BOOST_CHECK_EQUAL(client.GetQueueDepth(), 0);
+    BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(close_before_connect, *timeout {1})
 {
     // We use the mock client so we don't really connect to the target.
@@ -10,11 +10,13 @@
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using NetworkMonitor::StompFrame;
 using NetworkMonitor::MockWebsocketClient;
 using NetworkMonitor::MockWebsocketClientForStomp;
+using NetworkMonitor::WebsocketCompressionOptions;
 
 // MockWebsocketClient
 
@@ -29,6 +31,8 @@ std::function<
 > MockWebsocketClient::respondToSend = [](auto msg) {
     return false;
 };
+size_t MockWebsocketClient::nPauses = 0;
+WebsocketCompressionOptions MockWebsocketClient::compression = {};
 
 MockWebsocketClient::MockWebsocketClient(
     const std::string& url,
@@ -138,6 +142,46 @@ void MockWebsocketClient::Close(
     }
 }
 
+void MockWebsocketClient::PauseReading()
+{
+    boost::asio::post(
+        context_,
+        [this]() {
+            ++nPauses;
+            ++readPauses_;
+        }
+    );
+}
+
+void MockWebsocketClient::ResumeReading()
+{
+    boost::asio::post(
+        context_,
+        [this]() {
+            --readPauses_;
+        }
+    );
+}
+
+void MockWebsocketClient::Abort()
+{
+    // Mock a dropped connection. The disconnection is reported to the
+    // onDisconnect handler.
+    boost::asio::post(
+        context_,
+        [this]() {
+            connected_ = false;
+        }
+    );
+}
+
+void MockWebsocketClient::SetCompression(
+    const WebsocketCompressionOptions& options
+)
+{
+    compression = options;
+}
+
 // Private methods
 
 void MockWebsocketClient::MockIncomingMessages(
@@ -163,7 +207,7 @@ void MockWebsocketClient::MockIncomingMessages(
     boost::asio::post(
         context_,
         [this, onMessage, onDisconnect]() {
-            if (!messageQueue.empty()) {
+            if (!messageQueue.empty() && readPauses_ <= 0) {
                 auto message {messageQueue.front()};
                 messageQueue.pop();
                 if (onMessage) {
@@ -182,6 +226,13 @@ std::string MockWebsocketClientForStomp::endpoint = "";
 std::string MockWebsocketClientForStomp::username = "";
 std::string MockWebsocketClientForStomp::password = "";
 std::vector<std::string> MockWebsocketClientForStomp::subscriptionMessages = {};
+bool MockWebsocketClientForStomp::batchSubscriptionMessages = false;
+std::string MockWebsocketClientForStomp::heartBeat = "";
+size_t MockWebsocketClientForStomp::nHeartBeats = 0;
+std::string MockWebsocketClientForStomp::ackMode = "";
+std::vector<std::string> MockWebsocketClientForStomp::ackIds = {};
+size_t MockWebsocketClientForStomp::nAckMessages = 0;
+bool MockWebsocketClientForStomp::ignoreReceipts = false;
 
 // Public methods
 
@@ -232,14 +283,18 @@ std::string MockWebsocketClientForStomp::GetMockSendFrame(
 
 StompFrame MockWebsocketClientForStomp::MakeConnectedFrame()
 {
+    std::unordered_map<StompHeader, std::string> headers {
+        {StompHeader::kVersion, "1.2"},
+        {StompHeader::kSession, "42"},
+    };
+    if (!heartBeat.empty()) {
+        headers[StompHeader::kHeartBeat] = heartBeat;
+    }
     StompError error;
     StompFrame frame {
         error,
         StompCommand::kConnected,
-        {
-            {StompHeader::kVersion, "1.2"},
-            {StompHeader::kSession, "42"},
-        }
+        headers
     };
     if (error != StompError::kOk) {
         throw std::runtime_error("Unexpected: Invalid mock STOMP frame: " +
@@ -295,7 +350,7 @@ StompFrame MockWebsocketClientForStomp::MakeMessageFrame(
     const std::string& message
 )
 {
-    static const long long int counter {0};
+    const auto counter {std::to_string(messageCounter_++)};
 
     StompError error;
     StompFrame frame {
@@ -303,7 +358,8 @@ StompFrame MockWebsocketClientForStomp::MakeMessageFrame(
         StompCommand::kMessage,
         {
             {StompHeader::kSubscription, subscriptionId},
-            {StompHeader::kMessageId, std::to_string(counter)},
+            {StompHeader::kMessageId, counter},
+            {StompHeader::kAck, "ack-" + counter},
             {StompHeader::kDestination, destination},
             {StompHeader::kContentLength,
              std::to_string(message.size())},
@@ -356,12 +412,30 @@ std::pair<
 
 void MockWebsocketClientForStomp::OnMessage(const std::string& msg)
 {
-    StompError error;
-    StompFrame frame {error, msg};
-    if (error != StompError::kOk) {
+    if (msg == "\n") {
+        ++nHeartBeats;
+        return;
+    }
+
+    // The client may batch frames, like ACKs, in one message.
+    StompFrameParser parser {};
+    std::vector<StompFrame> frames {};
+    auto error {parser.Parse(msg, frames)};
+    if (error != StompError::kOk || frames.empty() ||
+        parser.GetBufferedSize() > 0) {
         triggerDisconnection = true;
         return;
     }
+    if (frames.front().GetCommand() == StompCommand::kAck) {
+        ++nAckMessages;
+    }
+    for (const auto& frame: frames) {
+        OnFrame(frame);
+    }
+}
+
+void MockWebsocketClientForStomp::OnFrame(const StompFrame& frame)
+{
     spdlog::info("MockStompServer: OnMessage: {}", frame.GetCommand());
     switch (frame.GetCommand()) {
         case StompCommand::kStomp:
@@ -376,7 +450,19 @@ void MockWebsocketClientForStomp::OnMessage(const std::string& msg)
             }
             break;
         }
+        case StompCommand::kAck: {
+            ackIds.emplace_back(frame.GetHeaderValue(StompHeader::kId));
+            break;
+        }
+        case StompCommand::kSend: {
+            std::string receiptId {frame.GetHeaderValue(StompHeader::kReceipt)};
+            if (!receiptId.empty() && !ignoreReceipts) {
+                messageQueue.push(MakeReceiptFrame(receiptId).ToString());
+            }
+            break;
+        }
         case StompCommand::kSubscribe: {
+            ackMode = frame.GetHeaderValue(StompHeader::kAck);
             auto [receiptId, subscriptionId] = CheckSubscription(frame);
             if (subscriptionId != "") {
                 if (receiptId != "") {
@@ -388,12 +474,21 @@ void MockWebsocketClientForStomp::OnMessage(const std::string& msg)
                     "subscription messages",
                     subscriptionMessages.size()
                 );
+                std::string batch {};
                 for (const auto& message: subscriptionMessages) {
-                    messageQueue.push(MakeMessageFrame(
+                    auto frame {MakeMessageFrame(
                         endpoint,
                         subscriptionId,
                         message
-                    ).ToString());
+                    ).ToString()};
+                    if (batchSubscriptionMessages) {
+                        batch += frame;
+                    } else {
+                        messageQueue.push(std::move(frame));
+                    }
+                }
+                if (!batch.empty()) {
+                    messageQueue.push(std::move(batch));
                 }
             } else {
                 spdlog::info("MockStompServer: OnMessage: Error: Subscribe");
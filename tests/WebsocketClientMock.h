@@ -2,6 +2,7 @@
 #define NETWORK_MONITOR_TESTS_WEBSOCKET_CLIENT_MOCK_H
 
 #include <network-monitor/StompFrame.h>
+#include <network-monitor/WebsocketCompression.h>
 #include <network-monitor/WebsocketClient.h>
 
 #include <boost/asio.hpp>
@@ -31,6 +32,8 @@ public:
     static bool triggerDisconnection;
     static std::queue<std::string> messageQueue;
     static std::function<void (const std::string&)> respondToSend;
+    static size_t nPauses; // Times the client paused reading
+    static WebsocketCompressionOptions compression; // Last SetCompression
 
     /*! \brief Mock constructor.
      */
@@ -68,6 +71,24 @@ public:
         std::function<void (boost::system::error_code)> onClose = nullptr
     );
 
+    /*! \brief Mock pause reading.
+     */
+    void PauseReading();
+
+    /*! \brief Mock resume reading.
+     */
+    void ResumeReading();
+
+    /*! \brief Mock abort.
+     */
+    void Abort();
+
+    /*! \brief Mock compression settings.
+     */
+    void SetCompression(
+        const WebsocketCompressionOptions& options
+    );
+
 private:
     // This strand handles all the user callbacks.
     // We leave it uninitialized because it does not support a default
@@ -76,6 +97,7 @@ private:
 
     bool connected_ {false};
     bool closed_ {false};
+    int readPauses_ {0};
 
     void MockIncomingMessages(
         std::function<void (boost::system::error_code,
@@ -99,6 +121,13 @@ public:
     static std::string username;
     static std::string password;
     static std::vector<std::string> subscriptionMessages;
+    static bool batchSubscriptionMessages; // Send them in one message
+    static std::string heartBeat; // The CONNECTED heart-beat, if not empty
+    static size_t nHeartBeats; // Heart-beats received from the client
+    static std::string ackMode; // From the last SUBSCRIBE frame
+    static std::vector<std::string> ackIds; // From the ACK frames, in order
+    static size_t nAckMessages; // Websocket messages with ACK frames
+    static bool ignoreReceipts; // Do not answer the receipt requests of SEND
 
     /*! \brief Mock constructor.
      */
@@ -143,6 +172,12 @@ private:
     void OnMessage(
         const std::string& msg
     );
+
+    void OnFrame(
+        const StompFrame& frame
+    );
+
+    size_t messageCounter_ {0};
 };
 
 } // namespace NetworkMonitor
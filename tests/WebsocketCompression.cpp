@@ -0,0 +1,176 @@
+#include <network-monitor/WebsocketCompression.h>
+
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/version.hpp>
+
+#include <string>
+#include <vector>
+
+using NetworkMonitor::ToPermessageDeflate;
+using NetworkMonitor::WebsocketCompressionOptions;
+using NetworkMonitor::WebsocketCompressionReport;
+using NetworkMonitor::WebsocketCompressionStats;
+
+// A message that repeats the same keys, like a quiet-route response.
+static std::string GetRepetitiveMessage()
+{
+    std::string message {"["};
+    for (size_t idx {0}; idx < 50; ++idx) {
+        message += "{\"start_station_id\":\"station_" + std::to_string(idx) +
+                   "\",\"end_station_id\":\"station_" +
+                   std::to_string(idx + 1) + "\",\"line_id\":\"line_0\","
+                   "\"route_id\":\"route_0\",\"travel_time\":1},";
+    }
+    message.back() = ']';
+    return message;
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+
+BOOST_AUTO_TEST_SUITE(websocket_compression);
+
+BOOST_AUTO_TEST_CASE(to_permessage_deflate)
+{
+    WebsocketCompressionOptions options {};
+    auto pmd {ToPermessageDeflate(options)};
+    BOOST_CHECK(!pmd.client_enable);
+    BOOST_CHECK(!pmd.server_enable);
+
+    options.enabled = true;
+    options.windowBits = 10;
+    options.memLevel = 2;
+    options.compressionLevel = 3;
+    pmd = ToPermessageDeflate(options);
+    BOOST_CHECK(pmd.client_enable);
+    BOOST_CHECK(pmd.server_enable);
+    BOOST_CHECK_EQUAL(pmd.client_max_window_bits, 10);
+    BOOST_CHECK_EQUAL(pmd.server_max_window_bits, 10);
+    BOOST_CHECK_EQUAL(pmd.memLevel, 2);
+    BOOST_CHECK_EQUAL(pmd.compLevel, 3);
+}
+
+BOOST_AUTO_TEST_CASE(to_permessage_deflate_clamp)
+{
+    WebsocketCompressionOptions options {};
+    options.windowBits = 20;
+    options.memLevel = 0;
+    options.compressionLevel = -1;
+    auto pmd {ToPermessageDeflate(options)};
+    BOOST_CHECK_EQUAL(pmd.client_max_window_bits, 15);
+    BOOST_CHECK_EQUAL(pmd.server_max_window_bits, 15);
+    BOOST_CHECK_EQUAL(pmd.memLevel, 1);
+    BOOST_CHECK_EQUAL(pmd.compLevel, 0);
+
+    options.windowBits = 8;
+    pmd = ToPermessageDeflate(options);
+    BOOST_CHECK_EQUAL(pmd.server_max_window_bits, 9);
+}
+
+BOOST_AUTO_TEST_CASE(empty_report)
+{
+    WebsocketCompressionReport report {};
+    BOOST_CHECK_EQUAL(report.GetRatio(), 1.0);
+    BOOST_CHECK_EQUAL(report.GetCpuTimePerMessage().count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ratio)
+{
+    WebsocketCompressionOptions options {};
+    options.enabled = true;
+    WebsocketCompressionStats stats {options};
+    const auto message {GetRepetitiveMessage()};
+    stats.RecordMessage({boost::asio::buffer(message)});
+
+    const auto report {stats.GetReport()};
+    BOOST_CHECK_EQUAL(report.nMessages, 1);
+    BOOST_CHECK_EQUAL(report.nCompressible, 1);
+    BOOST_CHECK_EQUAL(report.nSampled, 1);
+    BOOST_CHECK_EQUAL(report.sampledBytes, message.size());
+    BOOST_CHECK_GT(report.sampledCompressedBytes, 0);
+    BOOST_CHECK_LT(report.GetRatio(), 0.2);
+    BOOST_CHECK_GT(report.sampledCpuTime.count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(smaller_window)
+{
+    // The message repeats a 2 KB block. A 32 KB window finds the repetition,
+    // a 512-byte one does not.
+    std::string block {};
+    unsigned int seed {42};
+    for (size_t idx {0}; idx < 2048; ++idx) {
+        seed = seed * 1103515245 + 12345;
+        block += static_cast<char>('a' + (seed >> 16) % 26);
+    }
+    const auto message {block + block};
+    WebsocketCompressionOptions options {};
+    options.enabled = true;
+    WebsocketCompressionStats largeWindow {options};
+    largeWindow.RecordMessage({boost::asio::buffer(message)});
+    options.windowBits = 9;
+    WebsocketCompressionStats smallWindow {options};
+    smallWindow.RecordMessage({boost::asio::buffer(message)});
+    BOOST_CHECK_LT(largeWindow.GetReport().GetRatio(), 0.5);
+    BOOST_CHECK_GT(smallWindow.GetReport().GetRatio(), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_sequence)
+{
+    // A message split in many buffers compresses like a single buffer.
+    const auto message {GetRepetitiveMessage()};
+    const auto half {message.size() / 2};
+    WebsocketCompressionOptions options {};
+    options.enabled = true;
+    WebsocketCompressionStats single {options};
+    single.RecordMessage({boost::asio::buffer(message)});
+    WebsocketCompressionStats split {options};
+    split.RecordMessage({
+        boost::asio::buffer(message.data(), half),
+        boost::asio::buffer(message.data() + half, message.size() - half),
+    });
+    BOOST_CHECK_EQUAL(split.GetReport().sampledBytes, message.size());
+    BOOST_CHECK_EQUAL(split.GetReport().sampledCompressedBytes,
+                      single.GetReport().sampledCompressedBytes);
+}
+
+BOOST_AUTO_TEST_CASE(sample_every)
+{
+    WebsocketCompressionOptions options {};
+    options.enabled = true;
+    WebsocketCompressionStats stats {options, 3};
+    const auto message {GetRepetitiveMessage()};
+    for (size_t idx {0}; idx < 7; ++idx) {
+        stats.RecordMessage({boost::asio::buffer(message)});
+    }
+    const auto report {stats.GetReport()};
+    BOOST_CHECK_EQUAL(report.nMessages, 7);
+    BOOST_CHECK_EQUAL(report.nCompressible, 7);
+    BOOST_CHECK_EQUAL(report.nSampled, 3);
+    BOOST_CHECK_EQUAL(report.sampledBytes, 3 * message.size());
+}
+
+BOOST_AUTO_TEST_CASE(min_message_size)
+{
+    WebsocketCompressionOptions options {};
+    options.enabled = true;
+    options.minMessageSize = 64;
+    WebsocketCompressionStats stats {options};
+    const std::string small {"ACK\nid:42\n\n"};
+    const auto large {GetRepetitiveMessage()};
+    stats.RecordMessage({boost::asio::buffer(small)});
+    stats.RecordMessage({boost::asio::buffer(large)});
+    const auto report {stats.GetReport()};
+    BOOST_CHECK_EQUAL(report.nMessages, 2);
+#if BOOST_VERSION >= 107700
+    BOOST_CHECK_EQUAL(report.nCompressible, 1);
+    BOOST_CHECK_EQUAL(report.sampledBytes, large.size());
+#else
+    // Older Boost.Beast versions compress all the messages.
+    BOOST_CHECK_EQUAL(report.nCompressible, 2);
+    BOOST_CHECK_EQUAL(report.sampledBytes, small.size() + large.size());
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // websocket_compression
+
+BOOST_AUTO_TEST_SUITE_END(); // network_monitor
@@ -1,15 +1,20 @@
 #include "BoostMock.h"
 #include <network-monitor/WebsocketServer.h>
 #include <network-monitor/TestServerCertificate.h>
+#include <network-monitor/WebsocketCompression.h>
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 using NetworkMonitor::BoostWebsocketClient;
 using NetworkMonitor::BoostWebsocketServer;
@@ -18,7 +23,10 @@ using NetworkMonitor::MockAcceptor;
 using NetworkMonitor::MockTcpStream;
 using NetworkMonitor::MockTlsStream;
 using NetworkMonitor::MockTlsWebsocketStream;
+using NetworkMonitor::SlowConsumerPolicy;
 using NetworkMonitor::TestWebsocketServer;
+using NetworkMonitor::WebsocketCompressionOptions;
+using NetworkMonitor::WebsocketCompressionStats;
 using NetworkMonitor::WebsocketSession;
 
 // This fixture is used to re-initialize all mock properties before a test.
@@ -36,6 +44,8 @@ struct WebsocketServerTestFixture {
         MockTlsWebsocketStream::readBuffer = "";
         MockTlsWebsocketStream::writeEc = {};
         MockTlsWebsocketStream::closeEc = {};
+        MockTlsWebsocketStream::writtenMessages.clear();
+        MockTlsWebsocketStream::maxWritesInFlight = 0;
     }
 };
 
@@ -430,6 +440,70 @@ BOOST_AUTO_TEST_CASE(Close_after_Stop, *timeout {1})
     BOOST_CHECK(closed);
 }
 
+BOOST_AUTO_TEST_CASE(Close_twice, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+
+    // The message queued before the first close is still sent. The second
+    // close and the message sent after the first close are aborted.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    std::shared_ptr<
+        WebsocketSession<MockTlsWebsocketStream>
+    > wsSession {nullptr};
+    bool sentBefore {false};
+    bool sentAfter {false};
+    bool closed {false};
+    bool closedAgain {false};
+    auto onConnect {[&](auto ec, auto session) {
+        BOOST_REQUIRE(!ec);
+        BOOST_REQUIRE(session != nullptr);
+        wsSession = session;
+        session->Send("before", [&sentBefore](auto ec) {
+            BOOST_CHECK(!ec);
+            sentBefore = true;
+        });
+        session->Close([&server, &closed](auto ec) {
+            BOOST_CHECK(!ec);
+            closed = true;
+            server.Stop();
+        });
+        session->Close([&closedAgain](auto ec) {
+            BOOST_CHECK_EQUAL(ec, boost::asio::error::operation_aborted);
+            closedAgain = true;
+        });
+        session->Send("after", [&sentAfter](auto ec) {
+            BOOST_CHECK_EQUAL(ec, boost::asio::error::operation_aborted);
+            sentAfter = true;
+        });
+    }};
+    auto ec {server.Run(onConnect)};
+    BOOST_REQUIRE(!ec);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(sentBefore);
+    BOOST_CHECK(sentAfter);
+    BOOST_CHECK(closed);
+    BOOST_CHECK(closedAgain);
+    BOOST_REQUIRE(wsSession != nullptr);
+    BOOST_CHECK_EQUAL(wsSession->GetQueueDepth(), 0);
+    BOOST_CHECK_EQUAL(wsSession->GetQueuedBytes(), 0);
+    const std::vector<std::string> expected {"before"};
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages == expected);
+}
+
 BOOST_AUTO_TEST_CASE(Send, *timeout {1})
 {
     // We use the mock client so we don't really connect to the target.
@@ -514,6 +588,316 @@ BOOST_AUTO_TEST_CASE(Send_fail, *timeout {1})
     BOOST_CHECK(calledOnSend);
 }
 
+BOOST_AUTO_TEST_CASE(Send_in_order, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    const std::vector<std::string> messages {"one", "two", "three"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+
+    // The messages are sent back to back, so they queue up behind the first
+    // write. The close waits for all of them.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    size_t nSent {0};
+    auto onConnect {[&server, &nSent, &messages](auto ec, auto session) {
+        BOOST_REQUIRE(!ec);
+        BOOST_REQUIRE(session != nullptr);
+        for (const auto& message: messages) {
+            session->Send(message, [&nSent](auto ec) {
+                BOOST_CHECK(!ec);
+                ++nSent;
+            });
+        }
+        BOOST_CHECK_EQUAL(session->GetQueueDepth(), messages.size());
+        session->Close([&server, &nSent, &messages](auto ec) {
+            BOOST_CHECK(!ec);
+            BOOST_CHECK_EQUAL(nSent, messages.size());
+            server.Stop();
+        });
+    }};
+    auto ec {server.Run(onConnect)};
+    BOOST_REQUIRE(!ec);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSent, messages.size());
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages == messages);
+}
+
+BOOST_AUTO_TEST_CASE(Send_from_many_threads, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    const size_t nThreads {4};
+    const size_t nMessages {100};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+
+    // The messages are sent from all the threads that run the io_context. The
+    // session must still keep a single write in flight.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    std::atomic<size_t> nSent {0};
+    auto onConnect {[&ioc, &server, &nSent, nMessages](auto ec, auto session) {
+        BOOST_REQUIRE(!ec);
+        BOOST_REQUIRE(session != nullptr);
+        for (size_t idx {0}; idx < nMessages; ++idx) {
+            boost::asio::post(ioc, [&server, &nSent, nMessages, session]() {
+                session->Send("message", [&, session](auto ec) {
+                    BOOST_CHECK(!ec);
+                    if (++nSent == nMessages) {
+                        session->Close();
+                        server.Stop();
+                    }
+                });
+            });
+        }
+    }};
+    auto ec {server.Run(onConnect)};
+    BOOST_REQUIRE(!ec);
+    std::vector<std::thread> threads {};
+    threads.reserve(nThreads);
+    for (size_t idx {0}; idx < nThreads; ++idx) {
+        threads.emplace_back([&ioc]() {
+            ioc.run();
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSent, nMessages);
+    BOOST_CHECK_EQUAL(MockTlsWebsocketStream::writtenMessages.size(),
+                      nMessages);
+    BOOST_CHECK_EQUAL(MockTlsWebsocketStream::maxWritesInFlight, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Send_batch, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    const std::vector<std::string> messages {"one", "two", "three", "four"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+
+    // The first message goes out on its own. The ones queued behind it are
+    // gathered in one write.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    server.SetMaxBatchSize(64);
+    size_t nSent {0};
+    auto onConnect {[&server, &nSent, &messages](auto ec, auto session) {
+        BOOST_REQUIRE(!ec);
+        BOOST_REQUIRE(session != nullptr);
+        for (const auto& message: messages) {
+            session->Send(message, [&nSent](auto ec) {
+                BOOST_CHECK(!ec);
+                ++nSent;
+            });
+        }
+        session->Close([&server](auto ec) {
+            BOOST_CHECK(!ec);
+            server.Stop();
+        });
+    }};
+    auto ec {server.Run(onConnect)};
+    BOOST_REQUIRE(!ec);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSent, messages.size());
+    const std::vector<std::string> expected {"one", "twothreefour"};
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages == expected);
+}
+
+BOOST_AUTO_TEST_CASE(Send_head_and_tail, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+
+    // Each message is written with its own head, and the tail is shared.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    const auto tail {std::make_shared<const std::string>("tail")};
+    size_t nSent {0};
+    auto onConnect {[&server, &nSent, &tail](auto ec, auto session) {
+        BOOST_REQUIRE(!ec);
+        BOOST_REQUIRE(session != nullptr);
+        for (const auto& head: {"one-", "two-"}) {
+            session->Send(
+                std::make_shared<const std::string>(head),
+                tail,
+                [&nSent](auto ec) {
+                    BOOST_CHECK(!ec);
+                    ++nSent;
+                }
+            );
+        }
+        BOOST_CHECK_EQUAL(session->GetQueuedBytes(), 16);
+        session->Close([&server](auto ec) {
+            BOOST_CHECK(!ec);
+            server.Stop();
+        });
+    }};
+    auto ec {server.Run(onConnect)};
+    BOOST_REQUIRE(!ec);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nSent, 2);
+    const std::vector<std::string> expected {"one-tail", "two-tail"};
+    BOOST_CHECK(MockTlsWebsocketStream::writtenMessages == expected);
+    BOOST_CHECK_EQUAL(tail.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Send_high_water_mark_pause, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    const std::string reply {"Hello Websocket"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+    MockTlsWebsocketStream::readBuffer = "first";
+
+    // The first request gets three replies, which go above the high-water
+    // mark. The second request is only read once all the replies are out.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    server.SetHighWaterMark(10, SlowConsumerPolicy::kPauseReading);
+    size_t nSent {0};
+    size_t nReceived {0};
+    auto onMessage {
+        [&server, &nSent, &nReceived, &reply](
+            auto ec,
+            auto session,
+            auto&& msg
+        ) {
+            BOOST_REQUIRE(!ec);
+            ++nReceived;
+            if (msg == "first") {
+                for (size_t idx {0}; idx < 3; ++idx) {
+                    session->Send(reply, [&nSent](auto ec) {
+                        BOOST_CHECK(!ec);
+                        ++nSent;
+                    });
+                }
+                MockTlsWebsocketStream::readBuffer = "second";
+                return;
+            }
+            BOOST_CHECK_EQUAL(msg, "second");
+            BOOST_CHECK_EQUAL(nSent, 3);
+            BOOST_CHECK_EQUAL(session->GetQueuedBytes(), 0);
+            session->Close([&server](auto ec) {
+                BOOST_CHECK(!ec);
+                server.Stop();
+            });
+        }
+    };
+    auto ec {server.Run(nullptr, onMessage)};
+    BOOST_REQUIRE(!ec);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(nReceived, 2);
+}
+
+BOOST_AUTO_TEST_CASE(Send_high_water_mark_disconnect, *timeout {1})
+{
+    // We use the mock client so we don't really connect to the target.
+    const std::string ip {"127.0.0.1"};
+    const unsigned short port {8042};
+    const std::string message {"Hello Websocket"};
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_server};
+    ctx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(ctx);
+    boost::asio::io_context ioc {};
+
+    // We don't set any error code because we expect the connection to succeed.
+    MockAcceptor::acceptEc = std::queue<boost::system::error_code> {{
+        boost::system::error_code {}, // One successful connection
+    }};
+
+    // The first message fits under the high-water mark. The second one does
+    // not: It fails, and so does every message after it.
+    TestWebsocketServer server {ip, port, ioc, ctx};
+    server.SetHighWaterMark(20, SlowConsumerPolicy::kDisconnect);
+    std::vector<boost::system::error_code> sendEcs {};
+    auto onConnect {[&sendEcs, &message](auto ec, auto session) {
+        BOOST_REQUIRE(!ec);
+        BOOST_REQUIRE(session != nullptr);
+        for (size_t idx {0}; idx < 3; ++idx) {
+            session->Send(message, [&sendEcs](auto ec) {
+                sendEcs.push_back(ec);
+            });
+        }
+    }};
+    bool calledOnDisconnect {false};
+    auto onDisconnect {[&server, &calledOnDisconnect](auto ec, auto session) {
+        calledOnDisconnect = true;
+        BOOST_CHECK_EQUAL(session->GetQueuedBytes(), 0);
+        server.Stop();
+    }};
+    auto ec {server.Run(onConnect, nullptr, onDisconnect)};
+    BOOST_REQUIRE(!ec);
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK(calledOnDisconnect);
+    const std::vector<boost::system::error_code> expected {
+        boost::asio::error::no_buffer_space,
+        boost::asio::error::no_buffer_space,
+        {},
+    };
+    BOOST_CHECK(sendEcs == expected);
+    BOOST_CHECK_EQUAL(MockTlsWebsocketStream::writtenMessages.size(), 1);
+}
+
 BOOST_AUTO_TEST_CASE(OnMessage, *timeout {1})
 {
     // We use the mock client so we don't really connect to the target.
@@ -702,6 +1086,109 @@ BOOST_AUTO_TEST_CASE(client_and_server, *timeout {2})
     BOOST_CHECK_EQUAL(serverMessageReceived, clientMessageSent);
 }
 
+BOOST_AUTO_TEST_CASE(client_and_server_compression, *timeout {2})
+{
+    const std::string ip {"127.0.0.1"};
+    const std::string endpoint {"/"};
+    const unsigned short port {8042};
+
+    using boost::asio::ssl::context;
+
+    boost::asio::io_context ioc {};
+
+    // Both sides enable permessage-deflate, with a smaller window than the
+    // default.
+    WebsocketCompressionOptions compression {};
+    compression.enabled = true;
+    compression.windowBits = 10;
+    auto serverStats {
+        std::make_shared<WebsocketCompressionStats>(compression)
+    };
+    auto clientStats {
+        std::make_shared<WebsocketCompressionStats>(compression)
+    };
+
+    // The messages are large and repetitive, so they compress well.
+    std::string serverMessageSent {};
+    std::string clientMessageSent {};
+    for (size_t idx {0}; idx < 100; ++idx) {
+        serverMessageSent += "{\"station_id\":\"station_" +
+                             std::to_string(idx) + "\"}";
+        clientMessageSent += "{\"passenger_event\":\"in\"}";
+    }
+
+    // Server
+    boost::asio::ssl::context serverCtx {context::tlsv12_server};
+    serverCtx.load_verify_file(TESTS_CACERT_PEM);
+    LoadTestServerCertificate(serverCtx);
+    BoostWebsocketServer server {ip, port, ioc, serverCtx};
+    compression.stats = serverStats;
+    server.SetCompression(compression);
+    std::string serverMessageReceived {};
+    {
+        auto onConnect {[&serverMessageSent](auto ec, auto session) {
+            BOOST_REQUIRE(!ec);
+            BOOST_REQUIRE(session != nullptr);
+            session->Send(serverMessageSent);
+        }};
+        auto onReceive {
+            [
+                &server,
+                &serverMessageReceived
+            ](auto ec, auto session, auto&& received) {
+                BOOST_CHECK(!ec);
+                BOOST_REQUIRE(session != nullptr);
+                serverMessageReceived = std::move(received);
+                session->Close([&server](auto ec) {
+                    BOOST_CHECK(!ec);
+                    server.Stop();
+                });
+            }
+        };
+        auto ec {server.Run(onConnect, onReceive)};
+        BOOST_REQUIRE(!ec);
+    }
+
+    // Client
+    boost::asio::ssl::context clientCtx {context::tlsv12_client};
+    clientCtx.load_verify_file(TESTS_CACERT_PEM);
+    BoostWebsocketClient client {
+        ip, endpoint, std::to_string(port), ioc, clientCtx
+    };
+    compression.stats = clientStats;
+    client.SetCompression(compression);
+    std::string clientMessageReceived {};
+    {
+        auto onConnect {[&client, &clientMessageSent](auto ec) {
+            BOOST_CHECK(!ec);
+            if (!ec) {
+                client.Send(clientMessageSent);
+            }
+        }};
+        auto onReceive {
+            [&client, &clientMessageReceived](auto ec, auto&& received) {
+                BOOST_CHECK(!ec);
+                clientMessageReceived = std::move(received);
+                client.Close();
+            }
+        };
+        client.Connect(onConnect, onReceive);
+    }
+
+    ioc.run();
+
+    // When we get here, the io_context::run function has run out of work to do.
+    BOOST_CHECK_EQUAL(clientMessageReceived, serverMessageSent);
+    BOOST_CHECK_EQUAL(serverMessageReceived, clientMessageSent);
+    const auto serverReport {serverStats->GetReport()};
+    BOOST_CHECK_EQUAL(serverReport.nMessages, 1);
+    BOOST_CHECK_EQUAL(serverReport.nSampled, 1);
+    BOOST_CHECK_LT(serverReport.GetRatio(), 0.5);
+    const auto clientReport {clientStats->GetReport()};
+    BOOST_CHECK_EQUAL(clientReport.nMessages, 1);
+    BOOST_CHECK_LT(clientReport.GetRatio(), 0.5);
+}
+
 BOOST_AUTO_TEST_SUITE_END(); // live
 
 BOOST_AUTO_TEST_SUITE_END(); // class_WebsocketServer
@@ -12,9 +12,12 @@
 #include <spdlog/fmt/ostr.h>
 
 #include <functional>
+#include <mutex>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using NetworkMonitor::MockWebsocketEvent;
@@ -22,21 +25,27 @@ using NetworkMonitor::MockWebsocketServer;
 using NetworkMonitor::MockWebsocketServerForStomp;
 using NetworkMonitor::MockWebsocketSession;
 using NetworkMonitor::StompFrame;
+using NetworkMonitor::WebsocketCompressionOptions;
 
 // Free functions
 
 std::string NetworkMonitor::GetMockStompFrame(
-    const std::string& host
+    const std::string& host,
+    const std::string& heartBeat
 )
 {
+    std::unordered_map<StompHeader, std::string> headers {
+        {StompHeader::kAcceptVersion, "1.2"},
+        {StompHeader::kHost, host},
+    };
+    if (!heartBeat.empty()) {
+        headers[StompHeader::kHeartBeat] = heartBeat;
+    }
     StompError error;
     StompFrame frame {
         error,
         StompCommand::kStomp,
-        {
-            {StompHeader::kAcceptVersion, "1.2"},
-            {StompHeader::kHost, host},
-        }
+        headers
     };
     if (error != StompError::kOk) {
         throw std::runtime_error("Unexpected: Invalid mock STOMP frame: " +
@@ -70,10 +79,66 @@ std::string NetworkMonitor::GetMockSendFrame(
     return frame.ToString();
 }
 
+std::string NetworkMonitor::GetMockSubscribeFrame(
+    const std::string& id,
+    const std::string& destination,
+    const std::string& ack,
+    const std::string& receipt
+)
+{
+    std::unordered_map<StompHeader, std::string> headers {
+        {StompHeader::kId, id},
+        {StompHeader::kDestination, destination},
+        {StompHeader::kAck, ack},
+    };
+    if (!receipt.empty()) {
+        headers[StompHeader::kReceipt] = receipt;
+    }
+    StompError error;
+    StompFrame frame {
+        error,
+        StompCommand::kSubscribe,
+        headers
+    };
+    if (error != StompError::kOk) {
+        throw std::runtime_error("Unexpected: Invalid mock STOMP frame: " +
+                                 ToString(error));
+    }
+    return frame.ToString();
+}
+
+std::string NetworkMonitor::GetMockUnsubscribeFrame(
+    const std::string& id
+)
+{
+    StompError error;
+    StompFrame frame {
+        error,
+        StompCommand::kUnsubscribe,
+        {
+            {StompHeader::kId, id},
+        }
+    };
+    if (error != StompError::kOk) {
+        throw std::runtime_error("Unexpected: Invalid mock STOMP frame: " +
+                                 ToString(error));
+    }
+    return frame.ToString();
+}
+
 // MockWebsocketSession
 
 // Static member variables definition.
 boost::system::error_code MockWebsocketSession::sendEc = {};
+size_t MockWebsocketSession::nHeartBeats = 0;
+std::vector<std::string> MockWebsocketSession::messages = {};
+bool MockWebsocketSession::readingPaused = false;
+
+// The sessions may send from many threads.
+static std::mutex gMessagesMutex {};
+std::vector<
+    std::pair<std::string, std::shared_ptr<const std::string>>
+> MockWebsocketSession::splitMessages = {};
 
 MockWebsocketSession::MockWebsocketSession(
     boost::asio::io_context& ioc
@@ -90,6 +155,30 @@ void MockWebsocketSession::Send(
 )
 {
     spdlog::info("MockWebsocketSession::Send");
+    if (message == "\n") {
+        ++nHeartBeats;
+    } else {
+        std::lock_guard<std::mutex> lock {gMessagesMutex};
+        messages.push_back(message);
+    }
+    if (onSend) {
+        boost::asio::post(
+            context_,
+            [onSend]() {
+                onSend(sendEc);
+            }
+        );
+    }
+}
+
+void MockWebsocketSession::Send(
+    std::shared_ptr<const std::string> head,
+    std::shared_ptr<const std::string> tail,
+    std::function<void (boost::system::error_code)> onSend
+)
+{
+    spdlog::info("MockWebsocketSession::Send");
+    splitMessages.emplace_back(head == nullptr ? "" : *head, tail);
     if (onSend) {
         boost::asio::post(
             context_,
@@ -100,6 +189,11 @@ void MockWebsocketSession::Send(
     }
 }
 
+bool MockWebsocketSession::IsReadingPaused() const
+{
+    return readingPaused;
+}
+
 void MockWebsocketSession::Close(
     std::function<void (boost::system::error_code)> onClose
 )
@@ -121,6 +215,7 @@ void MockWebsocketSession::Close(
 bool MockWebsocketServer::triggerDisconnection = false;
 boost::system::error_code MockWebsocketServer::runEc = {};
 std::queue<MockWebsocketEvent> MockWebsocketServer::mockEvents = {};
+WebsocketCompressionOptions MockWebsocketServer::compression = {};
 
 MockWebsocketServer::MockWebsocketServer(
     const std::string& ip,
@@ -159,6 +254,13 @@ void MockWebsocketServer::Stop()
     stopped_ = true;
 }
 
+void MockWebsocketServer::SetCompression(
+    const WebsocketCompressionOptions& options
+)
+{
+    compression = options;
+}
+
 void MockWebsocketServer::ListenToMockConnections(
     MockWebsocketServer::Session::Handler onSessionConnect,
     MockWebsocketServer::Session::MsgHandler onSessionMessage,
@@ -2,6 +2,7 @@
 #define NETWORK_MONITOR_TESTS_WEBSOCKET_SERVER_MOCK_H
 
 #include <network-monitor/StompFrame.h>
+#include <network-monitor/WebsocketCompression.h>
 #include <network-monitor/WebsocketServer.h>
 
 #include <boost/asio.hpp>
@@ -14,13 +15,18 @@
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace NetworkMonitor {
 
 /*! \brief Craft a mock STOMP frame.
+ *
+ *  \param heartBeat The heart-beat header value. If empty, the frame has no
+ *                   heart-beat header.
  */
 std::string GetMockStompFrame(
-    const std::string& host
+    const std::string& host,
+    const std::string& heartBeat = ""
 );
 
 /*! \brief Craft a mock SEND frame.
@@ -31,6 +37,24 @@ std::string GetMockSendFrame(
     const std::string& payload
 );
 
+/*! \brief Craft a mock SUBSCRIBE frame.
+ *
+ *  \param receipt The receipt header value. If empty, the frame has no
+ *                 receipt header.
+ */
+std::string GetMockSubscribeFrame(
+    const std::string& id,
+    const std::string& destination,
+    const std::string& ack = "auto",
+    const std::string& receipt = ""
+);
+
+/*! \brief Craft a mock UNSUBSCRIBE frame.
+ */
+std::string GetMockUnsubscribeFrame(
+    const std::string& id
+);
+
 /*! \brief Mock a Websocket event.
  *
  *  A test can specify a sequence of mock events for a given Websocket session.
@@ -62,6 +86,14 @@ public:
     // Use these static members in a test to set the error codes returned by
     // the mock.
     static boost::system::error_code sendEc;
+    static size_t nHeartBeats; // Heart-beats sent to the client
+    static std::vector<std::string> messages; // Other messages sent
+    static bool readingPaused; // As if the client was too slow
+
+    // The head and the shared tail of the messages sent in two parts.
+    static std::vector<
+        std::pair<std::string, std::shared_ptr<const std::string>>
+    > splitMessages;
 
     /*! \brief Mock handler type for MockWebsocketSession.
      */
@@ -100,6 +132,18 @@ public:
         std::function<void (boost::system::error_code)> onSend = nullptr
     );
 
+    /*! \brief Send a mock message made of two parts.
+     */
+    void Send(
+        std::shared_ptr<const std::string> head,
+        std::shared_ptr<const std::string> tail,
+        std::function<void (boost::system::error_code)> onSend = nullptr
+    );
+
+    /*! \brief Mock read pause.
+     */
+    bool IsReadingPaused() const;
+
     /*! \brief Mock close.
      */
     void Close(
@@ -133,6 +177,7 @@ public:
     static bool triggerDisconnection;
     static boost::system::error_code runEc;
     static std::queue<MockWebsocketEvent> mockEvents;
+    static WebsocketCompressionOptions compression; // Last SetCompression
 
     /*! \brief Mock session type.
      */
@@ -164,6 +209,12 @@ public:
      */
     void Stop();
 
+    /*! \brief Mock compression settings.
+     */
+    void SetCompression(
+        const WebsocketCompressionOptions& options
+    );
+
 private:
     // We leave it uninitialized because it does not support a default
     // constructor.